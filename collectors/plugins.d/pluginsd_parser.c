@@ -478,23 +478,37 @@ static void inflight_functions_insert_callback(const DICTIONARY_ITEM *item, void
     pf->code = HTTP_RESP_GATEWAY_TIMEOUT;
 
     // send the command to the plugin
-    int ret = fprintf(fp, "FUNCTION %s %d \"%s\"\n",
-            dictionary_acquired_item_name(item),
-            pf->timeout,
-            string2str(pf->function));
+    int ret;
+    if(parser->send_function) {
+        // the parser has its own writer, that serializes this with the other commands it sends
+        BUFFER *wb = buffer_create(100);
+        buffer_sprintf(wb, "FUNCTION %s %d \"%s\"\n",
+                       dictionary_acquired_item_name(item),
+                       pf->timeout,
+                       string2str(pf->function));
+
+        ret = parser->send_function(parser, buffer_tostring(wb)) ? (int)wb->len : -1;
+        buffer_free(wb);
+    }
+    else
+        ret = fprintf(fp, "FUNCTION %s %d \"%s\"\n",
+                dictionary_acquired_item_name(item),
+                pf->timeout,
+                string2str(pf->function));
 
     pf->sent_ut = now_realtime_usec();
 
     if(ret < 0) {
-        error("FUNCTION: failed to send function to plugin, fprintf() returned error %d", ret);
+        error("FUNCTION: failed to send function to plugin, returned error %d", ret);
         rrd_call_function_error(pf->destination_wb, "Failed to communicate with collector", HTTP_RESP_BACKEND_FETCH_FAILED);
     }
     else {
-        fflush(fp);
+        if(!parser->send_function)
+            fflush(fp);
 
         internal_error(LOG_FUNCTIONS,
                        "FUNCTION '%s' with transaction '%s' sent to collector (%d bytes, fd %d, in %llu usec)",
-                       string2str(pf->function), dictionary_acquired_item_name(item), ret, fileno(fp),
+                       string2str(pf->function), dictionary_acquired_item_name(item), ret, fp ? fileno(fp) : -1,
                        pf->sent_ut - pf->started_ut);
     }
 }
@@ -11,9 +11,11 @@
 #define WORKER_JOB_HEARTBEAT          4
 #define WORKER_JOB_STRINGS            5
 #define WORKER_JOB_DICTIONARIES       6
+#define WORKER_JOB_STREAMING          7
+#define WORKER_JOB_WEB_SERVER         8
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 7
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 5
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 9
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 9
 #endif
 
 static struct global_statistics {
@@ -502,6 +504,113 @@ static void global_statistics_charts(void) {
 
     // ----------------------------------------------------------------
 
+    QUERY_CACHE_STATISTICS qcs;
+    query_cache_get_statistics(&qcs);
+
+    if(qcs.hits || qcs.partial_hits || qcs.misses) {
+        static RRDSET *st_query_cache = NULL;
+        static RRDDIM *rd_hits = NULL;
+        static RRDDIM *rd_partial_hits = NULL;
+        static RRDDIM *rd_misses = NULL;
+
+        if (unlikely(!st_query_cache)) {
+            st_query_cache = rrdset_create_localhost(
+                    "netdata"
+                    , "query_cache"
+                    , NULL
+                    , "queries"
+                    , NULL
+                    , "Netdata API Query Cache"
+                    , "queries/s"
+                    , "netdata"
+                    , "stats"
+                    , 131002
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_STACKED
+            );
+
+            rd_hits = rrddim_add(st_query_cache, "hits", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_partial_hits = rrddim_add(st_query_cache, "partial hits", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_misses = rrddim_add(st_query_cache, "misses", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+        else
+            rrdset_next(st_query_cache);
+
+        rrddim_set_by_pointer(st_query_cache, rd_hits, (collected_number)qcs.hits);
+        rrddim_set_by_pointer(st_query_cache, rd_partial_hits, (collected_number)qcs.partial_hits);
+        rrddim_set_by_pointer(st_query_cache, rd_misses, (collected_number)qcs.misses);
+
+        rrdset_done(st_query_cache);
+
+        // ----------------------------------------------------------------
+
+        static RRDSET *st_query_cache_memory = NULL;
+        static RRDDIM *rd_memory = NULL;
+        static RRDDIM *rd_entries = NULL;
+
+        if (unlikely(!st_query_cache_memory)) {
+            st_query_cache_memory = rrdset_create_localhost(
+                    "netdata"
+                    , "query_cache_memory"
+                    , NULL
+                    , "queries"
+                    , NULL
+                    , "Netdata API Query Cache Memory"
+                    , "KiB"
+                    , "netdata"
+                    , "stats"
+                    , 131003
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_AREA
+            );
+
+            rd_memory = rrddim_add(st_query_cache_memory, "memory", NULL, 1, 1024, RRD_ALGORITHM_ABSOLUTE);
+            rd_entries = rrddim_add(st_query_cache_memory, "entries", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            rrddim_option_set(rd_entries, RRDDIM_OPTION_HIDDEN);
+        }
+        else
+            rrdset_next(st_query_cache_memory);
+
+        rrddim_set_by_pointer(st_query_cache_memory, rd_memory, (collected_number)qcs.memory);
+        rrddim_set_by_pointer(st_query_cache_memory, rd_entries, (collected_number)qcs.entries);
+
+        rrdset_done(st_query_cache_memory);
+    }
+
+    // ----------------------------------------------------------------
+
+    if(rrdcalc_windows_enabled) {
+        static RRDSET *st_health_windows_memory = NULL;
+        static RRDDIM *rd_windows_memory = NULL;
+
+        if (unlikely(!st_health_windows_memory)) {
+            st_health_windows_memory = rrdset_create_localhost(
+                    "netdata"
+                    , "health_incremental_lookups_memory"
+                    , NULL
+                    , "health"
+                    , NULL
+                    , "Netdata Health Incremental Lookups Memory"
+                    , "KiB"
+                    , "netdata"
+                    , "stats"
+                    , 131004
+                    , localhost->rrd_update_every
+                    , RRDSET_TYPE_AREA
+            );
+
+            rd_windows_memory = rrddim_add(st_health_windows_memory, "memory", NULL, 1, 1024, RRD_ALGORITHM_ABSOLUTE);
+        }
+        else
+            rrdset_next(st_health_windows_memory);
+
+        rrddim_set_by_pointer(st_health_windows_memory, rd_windows_memory, (collected_number)rrdcalc_windows_memory_used());
+
+        rrdset_done(st_health_windows_memory);
+    }
+
+    // ----------------------------------------------------------------
+
     if(gs.sqlite3_queries_made) {
         static RRDSET *st_sqlite3_queries = NULL;
         static RRDDIM *rd_queries = NULL;
@@ -706,7 +815,7 @@ static void dbengine_statistics_charts(void) {
                     }
 
                     ++dbengine_contexts;
-                    rrdeng_get_37_statistics((struct rrdengine_instance *)host->storage_instance[tier], local_stats_array);
+                    rrdeng_get_39_statistics((struct rrdengine_instance *)host->storage_instance[tier], local_stats_array);
                     for (i = 0; i < RRDENG_NR_STATS; ++i) {
                         /* aggregate statistics across hosts */
                         stats_array[i] += local_stats_array[i];
@@ -822,6 +931,8 @@ static void dbengine_statistics_charts(void) {
                 static RRDDIM *rd_backfills = NULL;
                 static RRDDIM *rd_evictions = NULL;
                 static RRDDIM *rd_used_by_collectors = NULL;
+                static RRDDIM *rd_ghost_hits = NULL;
+                static RRDDIM *rd_promotions = NULL;
 
                 if (unlikely(!st_pg_cache_pages)) {
                     st_pg_cache_pages = rrdset_create_localhost(
@@ -845,6 +956,8 @@ static void dbengine_statistics_charts(void) {
                     rd_evictions = rrddim_add(st_pg_cache_pages, "evictions", NULL, -1, 1, RRD_ALGORITHM_INCREMENTAL);
                     rd_used_by_collectors =
                         rrddim_add(st_pg_cache_pages, "used_by_collectors", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+                    rd_ghost_hits = rrddim_add(st_pg_cache_pages, "ghost_hits", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+                    rd_promotions = rrddim_add(st_pg_cache_pages, "promotions", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
                 } else
                     rrdset_next(st_pg_cache_pages);
 
@@ -854,6 +967,8 @@ static void dbengine_statistics_charts(void) {
                 rrddim_set_by_pointer(st_pg_cache_pages, rd_backfills, (collected_number)stats_array[9]);
                 rrddim_set_by_pointer(st_pg_cache_pages, rd_evictions, (collected_number)stats_array[10]);
                 rrddim_set_by_pointer(st_pg_cache_pages, rd_used_by_collectors, (collected_number)stats_array[0]);
+                rrddim_set_by_pointer(st_pg_cache_pages, rd_ghost_hits, (collected_number)stats_array[37]);
+                rrddim_set_by_pointer(st_pg_cache_pages, rd_promotions, (collected_number)stats_array[38]);
                 rrdset_done(st_pg_cache_pages);
             }
 
@@ -2375,6 +2490,8 @@ void *global_statistics_main(void *ptr)
     worker_register_job_name(WORKER_JOB_DBENGINE, "dbengine");
     worker_register_job_name(WORKER_JOB_STRINGS, "strings");
     worker_register_job_name(WORKER_JOB_DICTIONARIES, "dictionaries");
+    worker_register_job_name(WORKER_JOB_STREAMING, "streaming");
+    worker_register_job_name(WORKER_JOB_WEB_SERVER, "web server");
 
     netdata_thread_cleanup_push(global_statistics_cleanup, ptr);
 
@@ -2415,6 +2532,12 @@ void *global_statistics_main(void *ptr)
 
         worker_is_busy(WORKER_JOB_DICTIONARIES);
         dictionary_statistics();
+
+        worker_is_busy(WORKER_JOB_STREAMING);
+        rrdpush_receiver_ingestion_charts();
+
+        worker_is_busy(WORKER_JOB_WEB_SERVER);
+        web_server_threads_charts();
     }
 
     netdata_thread_cleanup_pop(1);
@@ -52,6 +52,9 @@ void netdata_cleanup_and_exit(int ret) {
 #endif
         cancel_main_threads();
 
+        // the web server threads have stopped, no queries are running
+        web_client_api_v1_stop_query_workers();
+
         // free the database
         info("EXIT: freeing database memory...");
 #ifdef ENABLE_DBENGINE
@@ -993,9 +996,12 @@ int main(int argc, char **argv) {
                             }
                             default_rrdpush_enabled = 0;
                             if(run_all_mockup_tests()) return 1;
+                            if(unit_test_query_cache()) return 1;
+                            if(unit_test_rrdcalc_windows()) return 1;
                             if(unit_test_storage()) return 1;
 #ifdef ENABLE_DBENGINE
                             if(test_dbengine()) return 1;
+                            if(gorilla_unittest()) return 1;
 #endif
                             if(test_sqlite()) return 1;
                             if(string_unittest(10000)) return 1;
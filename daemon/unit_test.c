@@ -1572,6 +1572,205 @@ int test_sqlite(void) {
     return 1;
 }
 
+// a relative query is served partially from the query cache, after new points have been collected
+// its rows and values have to match the same query run without the cache
+static void unit_test_query_cache_feed(RRDSET *st, RRDDIM *rd, collected_number *value, int points) {
+    for(int i = 0; i < points ; i++) {
+        if(st->counter_done)
+            st->usec_since_last_update = USEC_PER_SEC;
+
+        rrddim_set_by_pointer(st, rd, (*value)++);
+        rrdset_done(st);
+    }
+}
+
+static RRDR *unit_test_query_cache_query(ONEWAYALLOC *owa, RRDSET *st, long points, RRDR_OPTIONS options) {
+    return rrd2rrdr(owa, st, points, -points, 0, RRDR_GROUPING_AVERAGE, 0,
+                    options | RRDR_OPTION_NATURAL_POINTS, NULL, NULL, NULL, 0, 0);
+}
+
+int unit_test_query_cache(void) {
+    fprintf(stderr, "%s() running...\n", __FUNCTION__ );
+
+    const long points = 20;
+    int errors = 0;
+
+    default_rrd_memory_mode = RRD_MEMORY_MODE_ALLOC;
+    default_rrd_update_every = 1;
+
+    RRDSET *st = rrdset_create_localhost("netdata", "unittest-query-cache", NULL, "netdata", NULL, "Unit Testing",
+                                         "a value", "unittest", NULL, 1, 1, RRDSET_TYPE_LINE);
+    RRDDIM *rd = rrddim_add(st, "dim1", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    collected_number value = 1;
+    unit_test_query_cache_feed(st, rd, &value, 60);
+
+    QUERY_CACHE_STATISTICS before, after;
+    query_cache_get_statistics(&before);
+
+    // cache the result, then collect a few more points
+    ONEWAYALLOC *owa = onewayalloc_create(0);
+    RRDR *r = unit_test_query_cache_query(owa, st, points, RRDR_OPTION_INTERNAL_CACHE);
+    if(r) rrdr_free(owa, r);
+    onewayalloc_destroy(owa);
+
+    unit_test_query_cache_feed(st, rd, &value, 5);
+
+    owa = onewayalloc_create(0);
+    RRDR *cached = unit_test_query_cache_query(owa, st, points, RRDR_OPTION_INTERNAL_CACHE);
+    RRDR *fresh = unit_test_query_cache_query(owa, st, points, 0);
+
+    query_cache_get_statistics(&after);
+
+    if(!cached || !fresh) {
+        fprintf(stderr, "    query cache: the query returned no result ### E R R O R ###\n");
+        errors++;
+        goto cleanup;
+    }
+
+    if(after.partial_hits <= before.partial_hits) {
+        fprintf(stderr, "    query cache: the second query was not a partial hit ### E R R O R ###\n");
+        errors++;
+    }
+
+    if(rrdr_rows(cached) != rrdr_rows(fresh) || rrdr_rows(cached) != points) {
+        fprintf(stderr, "    query cache: the cached query returned %ld rows, the query without the cache %ld, expected %ld ### E R R O R ###\n",
+                rrdr_rows(cached), rrdr_rows(fresh), points);
+        errors++;
+        goto cleanup;
+    }
+
+    for(long i = 0; i < rrdr_rows(cached) ; i++) {
+        if(cached->t[i] != fresh->t[i] || cached->v[i * cached->d] != fresh->v[i * fresh->d]) {
+            fprintf(stderr, "    query cache: row %ld is at %ld with value " NETDATA_DOUBLE_FORMAT
+                            ", but it should be at %ld with value " NETDATA_DOUBLE_FORMAT " ### E R R O R ###\n",
+                    i, (long)cached->t[i], cached->v[i * cached->d], (long)fresh->t[i], fresh->v[i * fresh->d]);
+            errors++;
+        }
+    }
+
+cleanup:
+    if(cached) rrdr_free(owa, cached);
+    if(fresh) rrdr_free(owa, fresh);
+    onewayalloc_destroy(owa);
+
+    fprintf(stderr, "query cache test %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
+
+static int unit_test_rrdcalc_windows_compare(RRDCALC *rc) {
+    NETDATA_DOUBLE window_value = NAN, db_value = NAN;
+    time_t window_after = 0, window_before = 0, db_after = 0, db_before = 0;
+    int window_is_null = 0, db_is_null = 0;
+
+    if(!rrdcalc_window_lookup(rc, &window_value, &window_after, &window_before, &window_is_null)) {
+        fprintf(stderr, "    rrdcalc windows: %s did not use the window ### E R R O R ###\n", group_method2string(rc->group));
+        return 1;
+    }
+
+    // the same lookup, on the timeframe the window returned
+    int ret = rrdset2value_api_v1(rc->rrdset, NULL, &db_value, NULL, 1,
+                                  window_after, window_before, rc->group, NULL,
+                                  0, rc->options,
+                                  &db_after, &db_before,
+                                  NULL, NULL, NULL,
+                                  &db_is_null, NULL, 0, 0);
+
+    if(ret != 200 || db_after != window_after || db_before != window_before || db_is_null != window_is_null ||
+       fabsndd(db_value - window_value) > 0.0001) {
+        fprintf(stderr, "    rrdcalc windows: %s gave " NETDATA_DOUBLE_FORMAT " (null %d) for %ld to %ld, "
+                        "the database " NETDATA_DOUBLE_FORMAT " (null %d) for %ld to %ld ### E R R O R ###\n",
+                group_method2string(rc->group), window_value, window_is_null, (long)window_after, (long)window_before,
+                db_value, db_is_null, (long)db_after, (long)db_before);
+        return 1;
+    }
+
+    return 0;
+}
+
+int unit_test_rrdcalc_windows(void) {
+    fprintf(stderr, "%s() running...\n", __FUNCTION__ );
+
+    RRDR_GROUPING groups[] = { RRDR_GROUPING_AVERAGE, RRDR_GROUPING_MIN, RRDR_GROUPING_MAX, RRDR_GROUPING_SUM };
+    RRDCALC *alarms[sizeof(groups) / sizeof(groups[0])];
+    size_t alarms_count = sizeof(alarms) / sizeof(alarms[0]);
+    int errors = 0;
+
+    int windows_enabled = rrdcalc_windows_enabled;
+    rrdcalc_windows_enabled = CONFIG_BOOLEAN_YES;
+    size_t memory = rrdcalc_windows_memory_used();
+
+    default_rrd_memory_mode = RRD_MEMORY_MODE_ALLOC;
+    default_rrd_update_every = 1;
+
+    RRDSET *st = rrdset_create_localhost("netdata", "unittest-rrdcalc-windows", NULL, "netdata", NULL, "Unit Testing",
+                                         "a value", "unittest", NULL, 1, 1, RRDSET_TYPE_LINE);
+    RRDDIM *rd1 = rrddim_add(st, "dim1", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    RRDDIM *rd2 = rrddim_add(st, "dim2", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    // the alarms of the chart, like the ones of "lookup: METHOD -10s unaligned"
+    for(size_t i = 0; i < alarms_count ; i++) {
+        RRDCALC *rc = alarms[i] = callocz(1, sizeof(RRDCALC));
+        rc->group = groups[i];
+        rc->after = -10;
+        rc->before = 0;
+        rc->options = (RRDCALC_OPTIONS)RRDR_OPTION_NOT_ALIGNED;
+        rc->rrdset = st;
+
+        netdata_rwlock_wrlock(&st->alerts.rwlock);
+        rrdcalc_window_create(rc, st);
+        if(rc->window)
+            st->alerts.windows++;
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(st->alerts.base, rc, prev, next);
+        netdata_rwlock_unlock(&st->alerts.rwlock);
+
+        if(!rc->window) {
+            fprintf(stderr, "    rrdcalc windows: %s got no window ### E R R O R ###\n", group_method2string(rc->group));
+            errors++;
+        }
+    }
+
+    // positive and negative values, so that min and max compare their absolute values
+    for(int i = 0; i < 40 && !errors ; i++) {
+        if(st->counter_done)
+            st->usec_since_last_update = USEC_PER_SEC;
+
+        rrddim_set_by_pointer(st, rd1, (collected_number)((i * 37) % 101 - 50));
+        rrddim_set_by_pointer(st, rd2, (collected_number)((i * 13) % 29));
+        rrdset_done(st);
+
+        // the windows answer once they have seen 10 points, and every point after that
+        if(i < 12) continue;
+
+        for(size_t a = 0; a < alarms_count ; a++)
+            errors += unit_test_rrdcalc_windows_compare(alarms[a]);
+    }
+
+    for(size_t i = 0; i < alarms_count ; i++) {
+        RRDCALC *rc = alarms[i];
+
+        netdata_rwlock_wrlock(&st->alerts.rwlock);
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(st->alerts.base, rc, prev, next);
+        if(rc->window)
+            st->alerts.windows--;
+        netdata_rwlock_unlock(&st->alerts.rwlock);
+
+        rrdcalc_window_free(rc->window);
+        freez(rc);
+    }
+
+    if(rrdcalc_windows_memory_used() != memory) {
+        fprintf(stderr, "    rrdcalc windows: %zu bytes are still accounted after freeing the windows ### E R R O R ###\n",
+                rrdcalc_windows_memory_used() - memory);
+        errors++;
+    }
+
+    rrdcalc_windows_enabled = windows_enabled;
+
+    fprintf(stderr, "rrdcalc windows test %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
+
 int unit_test_bitmap256(void) {
     fprintf(stderr, "%s() running...\n", __FUNCTION__ );
 
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "rrdengine.h"
+
+/*
+ * Extent compression of the database engine.
+ *
+ * Everything here runs on the event loop thread of the instance, so the zstd
+ * contexts and the dictionary training samples of the worker need no locking.
+ */
+
+const char *rrdeng_compression_algorithm_name(uint8_t algorithm)
+{
+    switch (algorithm) {
+        case RRD_NO_COMPRESSION:
+            return "none";
+        case RRD_LZ4:
+            return "lz4";
+        case RRD_ZSTD:
+            return "zstd";
+        default:
+            return "unknown";
+    }
+}
+
+size_t rrdeng_compress_bound(uint8_t algorithm, size_t size)
+{
+    switch (algorithm) {
+#ifdef ENABLE_ZSTD
+        case RRD_ZSTD:
+            return ZSTD_compressBound(size);
+#endif
+        default:
+            fatal_assert(size < LZ4_MAX_INPUT_SIZE);
+            return (size_t)LZ4_compressBound((int)size);
+    }
+}
+
+/*
+ * Returns the compressed size, or 0 when the extent could not be compressed.
+ */
+int rrdeng_compress_extent(struct rrdengine_worker_config *wc, struct rrdengine_datafile *datafile,
+                           uint8_t algorithm, const void *src, size_t src_size, void *dst, size_t dst_capacity)
+{
+    switch (algorithm) {
+#ifdef ENABLE_ZSTD
+        case RRD_ZSTD: {
+            size_t ret;
+
+            if (unlikely(!wc->zstd_cctx)) {
+                wc->zstd_cctx = ZSTD_createCCtx();
+                if (unlikely(!wc->zstd_cctx)) {
+                    error("DBENGINE: cannot create zstd compression context.");
+                    return 0;
+                }
+            }
+            if (datafile->zstd_cdict)
+                ret = ZSTD_compress_usingCDict(wc->zstd_cctx, dst, dst_capacity, src, src_size, datafile->zstd_cdict);
+            else
+                ret = ZSTD_compressCCtx(wc->zstd_cctx, dst, dst_capacity, src, src_size, wc->ctx->compression_level);
+
+            if (unlikely(ZSTD_isError(ret))) {
+                error("DBENGINE: zstd compression of %zu bytes failed: %s", src_size, ZSTD_getErrorName(ret));
+                return 0;
+            }
+            return (int)ret;
+        }
+#endif
+        default:
+            UNUSED(wc);
+            UNUSED(datafile);
+            return LZ4_compress_default(src, dst, (int)src_size, (int)dst_capacity);
+    }
+}
+
+/*
+ * Returns the decompressed size, or a negative number on error.
+ */
+int rrdeng_decompress_extent(struct rrdengine_worker_config *wc, struct rrdengine_datafile *datafile,
+                             uint8_t algorithm, const void *src, size_t src_size, void *dst, size_t dst_capacity)
+{
+    switch (algorithm) {
+        case RRD_LZ4:
+            return LZ4_decompress_safe(src, dst, (int)src_size, (int)dst_capacity);
+#ifdef ENABLE_ZSTD
+        case RRD_ZSTD: {
+            size_t ret;
+
+            if (unlikely(!wc->zstd_dctx)) {
+                wc->zstd_dctx = ZSTD_createDCtx();
+                if (unlikely(!wc->zstd_dctx)) {
+                    error("DBENGINE: cannot create zstd decompression context.");
+                    return -1;
+                }
+            }
+            /* frames compressed without a dictionary ignore it */
+            ret = ZSTD_decompress_usingDDict(wc->zstd_dctx, dst, dst_capacity, src, src_size, datafile->zstd_ddict);
+            if (unlikely(ZSTD_isError(ret))) {
+                error("DBENGINE: zstd decompression of %zu bytes failed: %s", src_size, ZSTD_getErrorName(ret));
+                return -1;
+            }
+            return (int)ret;
+        }
+#endif
+        default:
+            UNUSED(wc);
+            UNUSED(datafile);
+            UNUSED(dst_capacity);
+            error("DBENGINE: cannot decompress extent with compression algorithm %u (%s).",
+                  algorithm, rrdeng_compression_algorithm_name(algorithm));
+            return -1;
+    }
+}
+
+/*
+ * Keeps a copy of a page that is being flushed, to train the dictionary of the next data file.
+ */
+void rrdeng_compression_add_sample(struct rrdengine_worker_config *wc, const void *page, size_t size)
+{
+#ifdef ENABLE_ZSTD
+    struct rrdengine_instance *ctx = wc->ctx;
+    struct rrdeng_zstd_samples *samples = &wc->zstd_samples;
+
+    if (RRD_ZSTD != ctx->global_compress_alg || !ctx->compression_dictionary)
+        return;
+
+    if (samples->count >= RRDENG_ZSTD_SAMPLES_MAX || samples->bytes + size > RRDENG_ZSTD_SAMPLES_MAX_BYTES)
+        return;
+
+    if (unlikely(!samples->buffer))
+        samples->buffer = mallocz(RRDENG_ZSTD_SAMPLES_MAX_BYTES);
+
+    memcpy(samples->buffer + samples->bytes, page, size);
+    samples->sizes[samples->count++] = size;
+    samples->bytes += size;
+#else
+    UNUSED(wc);
+    UNUSED(page);
+    UNUSED(size);
+#endif
+}
+
+void rrdeng_compression_worker_cleanup(struct rrdengine_worker_config *wc)
+{
+#ifdef ENABLE_ZSTD
+    ZSTD_freeCCtx(wc->zstd_cctx);
+    wc->zstd_cctx = NULL;
+    ZSTD_freeDCtx(wc->zstd_dctx);
+    wc->zstd_dctx = NULL;
+    freez(wc->zstd_samples.buffer);
+    memset(&wc->zstd_samples, 0, sizeof(wc->zstd_samples));
+#else
+    UNUSED(wc);
+#endif
+}
+
+/*
+ * Trains a dictionary from the pages flushed to the previous data file and stores it in the
+ * super-block of a new data file. Nothing is stored when too few pages have been collected.
+ */
+void rrdeng_compression_train_dictionary(struct rrdengine_datafile *datafile, struct rrdeng_df_sb *superblock)
+{
+#ifdef ENABLE_ZSTD
+    struct rrdengine_instance *ctx = datafile->ctx;
+    struct rrdeng_zstd_samples *samples = &ctx->worker_config.zstd_samples;
+    size_t ret;
+
+    if (RRD_ZSTD != ctx->global_compress_alg || !ctx->compression_dictionary)
+        return;
+
+    if (samples->count < RRDENG_ZSTD_SAMPLES_MIN) {
+        info("DBENGINE: not enough pages (%u) to train a zstd dictionary for tier %d.", samples->count, ctx->tier);
+        return;
+    }
+
+    ret = ZDICT_trainFromBuffer(superblock->dict, RRDENG_DF_SB_DICT_SZ, samples->buffer, samples->sizes, samples->count);
+    samples->count = 0;
+    samples->bytes = 0;
+    if (ZDICT_isError(ret)) {
+        error("DBENGINE: failed to train a zstd dictionary for tier %d: %s", ctx->tier, ZDICT_getErrorName(ret));
+        return;
+    }
+
+    datafile->zstd_cdict = ZSTD_createCDict(superblock->dict, ret, ctx->compression_level);
+    datafile->zstd_ddict = ZSTD_createDDict(superblock->dict, ret);
+    if (unlikely(!datafile->zstd_cdict || !datafile->zstd_ddict)) {
+        /* the data file is written and read without a dictionary */
+        error("DBENGINE: cannot create the zstd dictionaries of tier %d, not using a dictionary.", ctx->tier);
+        rrdeng_compression_free_dictionary(datafile);
+        memset(superblock->dict, 0, RRDENG_DF_SB_DICT_SZ);
+        return;
+    }
+
+    superblock->dict_size = (uint16_t)ret;
+    info("DBENGINE: trained a zstd dictionary of %zu bytes for tier %d.", ret, ctx->tier);
+#else
+    UNUSED(datafile);
+    UNUSED(superblock);
+#endif
+}
+
+/*
+ * Only the decompression dictionary is created for existing data files; new extents
+ * are written to them without a dictionary until the next data file is created.
+ */
+void rrdeng_compression_load_dictionary(struct rrdengine_datafile *datafile, struct rrdeng_df_sb *superblock)
+{
+#ifdef ENABLE_ZSTD
+    if (!superblock->dict_size)
+        return;
+
+    if (superblock->dict_size > RRDENG_DF_SB_DICT_SZ) {
+        error("DBENGINE: data file %u-%u has an invalid zstd dictionary size %u, ignoring it.",
+              datafile->tier, datafile->fileno, (unsigned)superblock->dict_size);
+        return;
+    }
+    datafile->zstd_ddict = ZSTD_createDDict(superblock->dict, superblock->dict_size);
+    if (unlikely(!datafile->zstd_ddict))
+        error("DBENGINE: cannot create the zstd dictionary of data file %u-%u, its extents cannot be decompressed.",
+              datafile->tier, datafile->fileno);
+#else
+    if (superblock->dict_size)
+        error("DBENGINE: data file %u-%u has a zstd dictionary, but zstd is not supported by this build.",
+              datafile->tier, datafile->fileno);
+#endif
+}
+
+void rrdeng_compression_free_dictionary(struct rrdengine_datafile *datafile)
+{
+#ifdef ENABLE_ZSTD
+    ZSTD_freeCDict(datafile->zstd_cdict);
+    datafile->zstd_cdict = NULL;
+    ZSTD_freeDDict(datafile->zstd_ddict);
+    datafile->zstd_ddict = NULL;
+#else
+    UNUSED(datafile);
+#endif
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_RRDENG_COMPRESSION_H
+#define NETDATA_RRDENG_COMPRESSION_H
+
+#include "rrdengine.h"
+
+/* Forward declarations */
+struct rrdengine_worker_config;
+struct rrdengine_datafile;
+
+#define RRDENG_ZSTD_DEFAULT_LEVEL (3)
+
+/* pages kept for training the zstd dictionary of the next data file */
+#define RRDENG_ZSTD_SAMPLES_MAX_BYTES (1048576)
+#define RRDENG_ZSTD_SAMPLES_MAX (1024)
+#define RRDENG_ZSTD_SAMPLES_MIN (64)
+
+#ifdef ENABLE_ZSTD
+struct rrdeng_zstd_samples {
+    uint8_t *buffer;
+    size_t bytes;
+    size_t sizes[RRDENG_ZSTD_SAMPLES_MAX];
+    unsigned count;
+};
+#endif
+
+extern const char *rrdeng_compression_algorithm_name(uint8_t algorithm);
+extern size_t rrdeng_compress_bound(uint8_t algorithm, size_t size);
+extern int rrdeng_compress_extent(struct rrdengine_worker_config *wc, struct rrdengine_datafile *datafile,
+                                  uint8_t algorithm, const void *src, size_t src_size, void *dst, size_t dst_capacity);
+extern int rrdeng_decompress_extent(struct rrdengine_worker_config *wc, struct rrdengine_datafile *datafile,
+                                    uint8_t algorithm, const void *src, size_t src_size, void *dst, size_t dst_capacity);
+extern void rrdeng_compression_add_sample(struct rrdengine_worker_config *wc, const void *page, size_t size);
+extern void rrdeng_compression_worker_cleanup(struct rrdengine_worker_config *wc);
+extern void rrdeng_compression_train_dictionary(struct rrdengine_datafile *datafile, struct rrdeng_df_sb *superblock);
+extern void rrdeng_compression_load_dictionary(struct rrdengine_datafile *datafile, struct rrdeng_df_sb *superblock);
+extern void rrdeng_compression_free_dictionary(struct rrdengine_datafile *datafile);
+
+#endif /* NETDATA_RRDENG_COMPRESSION_H */
@@ -47,6 +47,10 @@ static void datafile_init(struct rrdengine_datafile *datafile, struct rrdengine_
     datafile->journalfile = NULL;
     datafile->next = NULL;
     datafile->ctx = ctx;
+#ifdef ENABLE_ZSTD
+    datafile->zstd_cdict = NULL;
+    datafile->zstd_ddict = NULL;
+#endif
 }
 
 void generate_datafilepath(struct rrdengine_datafile *datafile, char *str, size_t maxlen)
@@ -63,6 +67,7 @@ int close_data_file(struct rrdengine_datafile *datafile)
     char path[RRDENG_PATH_MAX];
 
     generate_datafilepath(datafile, path, sizeof(path));
+    rrdeng_compression_free_dictionary(datafile);
 
     ret = uv_fs_close(NULL, &req, datafile->file, NULL);
     if (ret < 0) {
@@ -105,6 +110,7 @@ int destroy_data_file(struct rrdengine_datafile *datafile)
     char path[RRDENG_PATH_MAX];
 
     generate_datafilepath(datafile, path, sizeof(path));
+    rrdeng_compression_free_dictionary(datafile);
 
     ret = uv_fs_ftruncate(NULL, &req, datafile->file, 0, NULL);
     if (ret < 0) {
@@ -163,6 +169,7 @@ int create_data_file(struct rrdengine_datafile *datafile)
     (void) strncpy(superblock->magic_number, RRDENG_DF_MAGIC, RRDENG_MAGIC_SZ);
     (void) strncpy(superblock->version, RRDENG_DF_VER, RRDENG_VER_SZ);
     superblock->tier = 1;
+    rrdeng_compression_train_dictionary(datafile, superblock);
 
     iov = uv_buf_init((void *)superblock, sizeof(*superblock));
 
@@ -187,7 +194,7 @@ int create_data_file(struct rrdengine_datafile *datafile)
     return 0;
 }
 
-static int check_data_file_superblock(uv_file file)
+static int check_data_file_superblock(struct rrdengine_datafile *datafile, uv_file file)
 {
     int ret;
     struct rrdeng_df_sb *superblock;
@@ -215,6 +222,7 @@ static int check_data_file_superblock(uv_file file)
         error("File has invalid superblock.");
         ret = UV_EINVAL;
     } else {
+        rrdeng_compression_load_dictionary(datafile, superblock);
         ret = 0;
     }
     error:
@@ -245,7 +253,7 @@ static int load_data_file(struct rrdengine_datafile *datafile)
         goto error;
     file_size = ALIGN_BYTES_CEILING(file_size);
 
-    ret = check_data_file_superblock(file);
+    ret = check_data_file_superblock(datafile, file);
     if (ret)
         goto error;
     ctx->stats.io_read_bytes += sizeof(struct rrdeng_df_sb);
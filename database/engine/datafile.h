@@ -45,6 +45,11 @@ struct rrdengine_datafile {
     struct rrdengine_df_extents extents;
     struct rrdengine_journalfile *journalfile;
     struct rrdengine_datafile *next;
+#ifdef ENABLE_ZSTD
+    /* the dictionary of the RRD_ZSTD extents, when one is stored in the super-block */
+    ZSTD_CDict *zstd_cdict;
+    ZSTD_DDict *zstd_ddict;
+#endif
 };
 
 struct rrdengine_datafile_list {
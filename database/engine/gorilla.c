@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "rrdengine.h"
+
+static inline uint32_t gorilla_mask(uint32_t nbits) {
+    return (nbits >= 32) ? 0xFFFFFFFFU : ((1U << nbits) - 1);
+}
+
+/*
+ * Appends the nbits least significant bits of value.
+ * Words are always initialized before being published, so that
+ * concurrent readers of already written bits never see them change.
+ */
+static inline void gorilla_write_bits(uint32_t *words, uint32_t *pos, uint32_t value, uint32_t nbits) {
+    uint32_t idx = *pos / 32;
+    uint32_t used = *pos % 32;
+    uint32_t avail = 32 - used;
+
+    value &= gorilla_mask(nbits);
+
+    if (!used)
+        words[idx] = 0;
+
+    if (nbits <= avail)
+        words[idx] |= value << (avail - nbits);
+    else {
+        uint32_t spill = nbits - avail;
+        words[idx] |= value >> spill;
+        words[idx + 1] = value << (32 - spill);
+    }
+
+    *pos += nbits;
+}
+
+static inline uint32_t gorilla_read_bits(const uint32_t *words, uint32_t *pos, uint32_t nbits) {
+    uint32_t idx = *pos / 32;
+    uint32_t used = *pos % 32;
+    uint32_t avail = 32 - used;
+    uint32_t value;
+
+    if (nbits <= avail)
+        value = (words[idx] >> (avail - nbits)) & gorilla_mask(nbits);
+    else {
+        uint32_t spill = nbits - avail;
+        value = ((words[idx] & gorilla_mask(avail)) << spill) | (words[idx + 1] >> (32 - spill));
+    }
+
+    *pos += nbits;
+    return value;
+}
+
+void gorilla_writer_init(struct gorilla_writer *gw, uint32_t *words, uint32_t capacity_words) {
+    memset(gw, 0, sizeof(*gw));
+    gw->words = words;
+    gw->capacity_bits = capacity_words * 32;
+}
+
+/* Returns false when there is no room for another value */
+bool gorilla_writer_write(struct gorilla_writer *gw, uint32_t value) {
+    if (unlikely(!gorilla_writer_has_room(gw)))
+        return false;
+
+    if (unlikely(!gw->entries)) {
+        gorilla_write_bits(gw->words, &gw->nbits, value, 32);
+        gw->prev_value = value;
+        gw->entries++;
+        return true;
+    }
+
+    uint32_t xor_value = value ^ gw->prev_value;
+    if (!xor_value) {
+        gorilla_write_bits(gw->words, &gw->nbits, 0, 1);
+        gw->entries++;
+        return true;
+    }
+
+    uint32_t leading_zeros = __builtin_clz(xor_value);
+    uint32_t trailing_zeros = __builtin_ctz(xor_value);
+    uint32_t meaningful_bits = 32 - leading_zeros - trailing_zeros;
+    uint32_t prev_meaningful_bits = 32 - gw->prev_leading_zeros - gw->prev_trailing_zeros;
+
+    // reuse the previous window only when it is cheaper than describing a new one
+    if (leading_zeros >= gw->prev_leading_zeros && trailing_zeros >= gw->prev_trailing_zeros &&
+        2 + prev_meaningful_bits <= 12 + meaningful_bits) {
+        gorilla_write_bits(gw->words, &gw->nbits, 0x2, 2);
+        gorilla_write_bits(gw->words, &gw->nbits, xor_value >> gw->prev_trailing_zeros, prev_meaningful_bits);
+    }
+    else {
+        gorilla_write_bits(gw->words, &gw->nbits, 0x3, 2);
+        gorilla_write_bits(gw->words, &gw->nbits, leading_zeros, 5);
+        gorilla_write_bits(gw->words, &gw->nbits, meaningful_bits - 1, 5);
+        gorilla_write_bits(gw->words, &gw->nbits, xor_value >> trailing_zeros, meaningful_bits);
+
+        gw->prev_leading_zeros = (uint8_t)leading_zeros;
+        gw->prev_trailing_zeros = (uint8_t)trailing_zeros;
+    }
+
+    gw->prev_value = value;
+    gw->entries++;
+    return true;
+}
+
+void gorilla_reader_init(struct gorilla_reader *gr, const uint32_t *words) {
+    memset(gr, 0, sizeof(*gr));
+    gr->words = words;
+}
+
+/* The caller is responsible for not reading more values than the ones written */
+uint32_t gorilla_reader_read(struct gorilla_reader *gr) {
+    if (unlikely(!gr->position)) {
+        gr->prev_value = gorilla_read_bits(gr->words, &gr->nbits, 32);
+        gr->position++;
+        return gr->prev_value;
+    }
+
+    gr->position++;
+
+    if (!gorilla_read_bits(gr->words, &gr->nbits, 1))
+        return gr->prev_value;
+
+    if (gorilla_read_bits(gr->words, &gr->nbits, 1)) {
+        gr->prev_leading_zeros = (uint8_t)gorilla_read_bits(gr->words, &gr->nbits, 5);
+        uint32_t meaningful_bits = gorilla_read_bits(gr->words, &gr->nbits, 5) + 1;
+        gr->prev_trailing_zeros = (uint8_t)(32 - gr->prev_leading_zeros - meaningful_bits);
+    }
+
+    uint32_t meaningful_bits = 32 - gr->prev_leading_zeros - gr->prev_trailing_zeros;
+    uint32_t xor_value = gorilla_read_bits(gr->words, &gr->nbits, meaningful_bits) << gr->prev_trailing_zeros;
+
+    gr->prev_value ^= xor_value;
+    return gr->prev_value;
+}
+
+int gorilla_unittest(void) {
+    uint32_t words[RRDENG_BLOCK_SIZE / sizeof(uint32_t)];
+    uint32_t values[4096];
+    size_t i, n;
+    int errors = 0;
+
+    fprintf(stderr, "\n\nGORILLA unittest\n");
+
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        switch (i % 7) {
+            case 0:
+            case 1:
+                values[i] = pack_storage_number(42.0, SN_DEFAULT_FLAGS);
+                break;
+            case 2:
+                values[i] = pack_storage_number((NETDATA_DOUBLE)i, SN_DEFAULT_FLAGS);
+                break;
+            case 3:
+                values[i] = SN_EMPTY_SLOT;
+                break;
+            case 4:
+                values[i] = (uint32_t)random();
+                break;
+            case 5:
+                values[i] = 0;
+                break;
+            default:
+                values[i] = 0xFFFFFFFFU;
+                break;
+        }
+    }
+
+    memset(words, 0xAA, sizeof(words)); // pages allocated with malloc are not zeroed
+    struct gorilla_writer gw;
+    gorilla_writer_init(&gw, words, sizeof(words) / sizeof(words[0]));
+    for (n = 0; n < sizeof(values) / sizeof(values[0]); n++) {
+        if (!gorilla_writer_write(&gw, values[n]))
+            break;
+    }
+
+    if (!n || n != gw.entries) {
+        fprintf(stderr, "GORILLA: wrote %zu values, but the writer reports %u entries\n", n, gw.entries);
+        errors++;
+    }
+
+    struct gorilla_reader gr;
+    gorilla_reader_init(&gr, words);
+    for (i = 0; i < n; i++) {
+        uint32_t v = gorilla_reader_read(&gr);
+        if (v != values[i]) {
+            fprintf(stderr, "GORILLA: value %zu was written as 0x%08x but read as 0x%08x\n", i, values[i], v);
+            errors++;
+            break;
+        }
+    }
+
+    if (gr.nbits != gw.nbits) {
+        fprintf(stderr, "GORILLA: the reader consumed %u bits, but the writer wrote %u bits\n", gr.nbits, gw.nbits);
+        errors++;
+    }
+    uint32_t mixed_bytes = gorilla_writer_bytes(&gw);
+
+    // a constant series should need about one bit per value
+    gorilla_writer_init(&gw, words, sizeof(words) / sizeof(words[0]));
+    while (gorilla_writer_write(&gw, values[0]))
+        ;
+
+    if (gw.entries < (sizeof(words) * 8) - 2 * GORILLA_MAX_BITS_PER_VALUE) {
+        fprintf(stderr, "GORILLA: a page of constant values holds only %u entries\n", gw.entries);
+        errors++;
+    }
+
+    fprintf(stderr, "GORILLA: %zu mixed values in %u bytes, %u constant values in a page: %s\n",
+            n, mixed_bytes, gw.entries, errors ? "FAILED" : "OK");
+
+    return errors;
+}
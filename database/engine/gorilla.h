@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_GORILLA_H
+#define NETDATA_GORILLA_H
+
+#include "rrdengine.h"
+
+/*
+ * Gorilla-style XOR compression of 32-bit values.
+ *
+ * Timestamps are implicit (dbengine pages are evenly spaced), so only the values are encoded:
+ * - the first value is stored verbatim (32 bits)
+ * - '0' means the value is equal to the previous one
+ * - '10' + meaningful bits, when the XOR with the previous value fits in the previous leading/trailing zeros window
+ * - '11' + 5 bits leading zeros + 5 bits (meaningful bits - 1) + meaningful bits, otherwise
+ *
+ * Bits are packed MSB first in 32-bit words.
+ */
+
+#define GORILLA_MAX_BITS_PER_VALUE (1 + 1 + 5 + 5 + 32)
+
+struct gorilla_writer {
+    uint32_t *words;
+    uint32_t capacity_bits;
+    uint32_t nbits;
+    uint32_t entries;
+
+    uint32_t prev_value;
+    uint8_t prev_leading_zeros;
+    uint8_t prev_trailing_zeros;
+};
+
+struct gorilla_reader {
+    const uint32_t *words;
+    uint32_t nbits;
+    uint32_t position;
+
+    uint32_t prev_value;
+    uint8_t prev_leading_zeros;
+    uint8_t prev_trailing_zeros;
+};
+
+extern void gorilla_writer_init(struct gorilla_writer *gw, uint32_t *words, uint32_t capacity_words);
+extern bool gorilla_writer_write(struct gorilla_writer *gw, uint32_t value);
+extern void gorilla_reader_init(struct gorilla_reader *gr, const uint32_t *words);
+extern uint32_t gorilla_reader_read(struct gorilla_reader *gr);
+extern int gorilla_unittest(void);
+
+static inline bool gorilla_writer_has_room(struct gorilla_writer *gw) {
+    return gw->nbits + GORILLA_MAX_BITS_PER_VALUE <= gw->capacity_bits;
+}
+
+/* the number of bytes of the words array that have been written so far */
+static inline uint32_t gorilla_writer_bytes(struct gorilla_writer *gw) {
+    return ((gw->nbits + 31) / 32) * (uint32_t)sizeof(uint32_t);
+}
+
+#endif /* NETDATA_GORILLA_H */
@@ -1,26 +1,34 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 #include "rrdengine.h"
 
-static void flush_transaction_buffer_cb(uv_fs_t* req)
+static void flush_transaction_buffer_complete(struct rrdengine_worker_config* wc, void *data, int result)
 {
-    struct generic_io_descriptor *io_descr = req->data;
-    struct rrdengine_worker_config* wc = req->loop->data;
+    struct generic_io_descriptor *io_descr = data;
     struct rrdengine_instance *ctx = wc->ctx;
 
     debug(D_RRDENGINE, "%s: Journal block was written to disk.", __func__);
-    if (req->result < 0) {
+    if (result < 0) {
         ++ctx->stats.io_errors;
         rrd_stat_atomic_add(&global_io_errors, 1);
-        error("%s: uv_fs_write: %s", __func__, uv_strerror((int)req->result));
+        error("%s: write: %s", __func__, uv_strerror(result));
     } else {
         debug(D_RRDENGINE, "%s: Journal block was written to disk.", __func__);
     }
 
-    uv_fs_req_cleanup(req);
     free(io_descr->buf);
     freez(io_descr);
 }
 
+static void flush_transaction_buffer_cb(uv_fs_t* req)
+{
+    struct generic_io_descriptor *io_descr = req->data;
+    struct rrdengine_worker_config* wc = req->loop->data;
+    int result = (int)req->result;
+
+    uv_fs_req_cleanup(req);
+    flush_transaction_buffer_complete(wc, io_descr, result);
+}
+
 /* Careful to always call this before creating a new journal file */
 void wal_flush_transaction_buffer(struct rrdengine_worker_config* wc)
 {
@@ -49,10 +57,14 @@ void wal_flush_transaction_buffer(struct rrdengine_worker_config* wc)
     io_descr->req.data = io_descr;
     io_descr->completion = NULL;
 
-    io_descr->iov = uv_buf_init((void *)io_descr->buf, size);
-    ret = uv_fs_write(wc->loop, &io_descr->req, journalfile->file, &io_descr->iov, 1,
-                      journalfile->pos, flush_transaction_buffer_cb);
-    fatal_assert(-1 != ret);
+    ret = rrdeng_uring_write(wc, journalfile->file, io_descr->buf, size, journalfile->pos, -1,
+                             flush_transaction_buffer_complete, io_descr);
+    if (ret) {
+        io_descr->iov = uv_buf_init((void *)io_descr->buf, size);
+        ret = uv_fs_write(wc->loop, &io_descr->req, journalfile->file, &io_descr->iov, 1,
+                          journalfile->pos, flush_transaction_buffer_cb);
+        fatal_assert(-1 != ret);
+    }
     journalfile->pos += RRDENG_BLOCK_SIZE;
     ctx->disk_space += RRDENG_BLOCK_SIZE;
     ctx->commit_log.buf = NULL;
@@ -276,7 +288,6 @@ static void restore_extent_metadata(struct rrdengine_instance *ctx, struct rrden
                                     void *buf, unsigned max_size)
 {
     static BITMAP256 page_error_map;
-    struct page_cache *pg_cache = &ctx->pg_cache;
     unsigned i, count, payload_length, descr_size, valid_pages;
     struct rrdeng_page_descr *descr;
     struct extent_info *extent;
@@ -300,7 +311,6 @@ static void restore_extent_metadata(struct rrdengine_instance *ctx, struct rrden
 
     for (i = 0, valid_pages = 0 ; i < count ; ++i) {
         uuid_t *temp_id;
-        Pvoid_t *PValue;
         struct pg_cache_page_index *page_index = NULL;
         uint8_t page_type = jf_metric_data->descr[i].type;
 
@@ -319,7 +329,7 @@ static void restore_extent_metadata(struct rrdengine_instance *ctx, struct rrden
             continue;
         }
 
-        if (unlikely(start_time == end_time)) {
+        if (unlikely(start_time == end_time && page_type != PAGE_GORILLA_METRICS)) {
             size_t entries = jf_metric_data->descr[i].page_length / page_type_size[page_type];
             if (unlikely(entries > 1)) {
                 error("Invalid page encountered, start time %"PRIu64" = end time but %zu entries were found", start_time, entries);
@@ -329,22 +339,7 @@ static void restore_extent_metadata(struct rrdengine_instance *ctx, struct rrden
 
         temp_id = (uuid_t *)jf_metric_data->descr[i].uuid;
 
-        uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-        PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, temp_id, sizeof(uuid_t));
-        if (likely(NULL != PValue)) {
-            page_index = *PValue;
-        }
-        uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-        if (NULL == PValue) {
-            /* First time we see the UUID */
-            uv_rwlock_wrlock(&pg_cache->metrics_index.lock);
-            PValue = JudyHSIns(&pg_cache->metrics_index.JudyHS_array, temp_id, sizeof(uuid_t), PJE0);
-            fatal_assert(NULL == *PValue); /* TODO: figure out concurrency model */
-            *PValue = page_index = create_page_index(temp_id);
-            page_index->prev = pg_cache->metrics_index.last_page_index;
-            pg_cache->metrics_index.last_page_index = page_index;
-            uv_rwlock_wrunlock(&pg_cache->metrics_index.lock);
-        }
+        page_index = pg_cache_find_or_create_page_index(ctx, temp_id);
 
         descr = pg_cache_create_descr();
         descr->page_length = jf_metric_data->descr[i].page_length;
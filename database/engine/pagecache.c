@@ -48,30 +48,95 @@ bool rrdeng_page_descr_is_mmap(void) {
 }
 
 /* Forward declarations */
-static int pg_cache_try_evict_one_page_unsafe(struct rrdengine_instance *ctx);
+static int pg_cache_try_evict_one_page(struct rrdengine_instance *ctx);
+
+/*
+ * Eviction policies
+ *
+ * The LRU policy keeps the populated pages of a shard in the hot queue, and moves them to its tail on every hit.
+ *
+ * The 2Q policy (Johnson and Shasha, 1994) keeps a page in the probation queue until it is hit twice. Pages
+ * that are hit again are promoted to the hot queue, which is an LRU. The probation queue is a FIFO that is
+ * evicted first while it holds more than PG_CACHE_2Q_PROBATION_PERCENT of the pages of the shard, so the pages
+ * of a long query that are read once pass through it without flushing the working set of the hot queue.
+ * The first hit of a page is not enough for a promotion, since queries preload the pages they are about to hit.
+ * Pages evicted from the probation queue are remembered as ghosts, and pages that are read again while they are
+ * still ghosts go directly to the hot queue.
+ */
+
+static inline Word_t pg_cache_ghost_key(struct rrdeng_page_descr *descr)
+{
+    uint64_t words[2];
+
+    memcpy(words, descr->id, sizeof(words));
+    return (Word_t)(words[0] ^ words[1] ^ (descr->start_time * 0x9E3779B97F4A7C15ULL));
+}
+
+/* The caller must hold the replaceQ lock */
+static void pg_cache_ghost_add_unsafe(struct pg_cache_shard *shard, struct rrdeng_page_descr *descr)
+{
+    struct pg_cache_ghosts *ghosts = &shard->replaceQ.ghosts;
+    Pvoid_t *PValue;
+    Word_t key = pg_cache_ghost_key(descr), old_key;
+
+    if (unlikely(!ghosts->size))
+        return;
+
+    /* forget the oldest ghost, unless it has been remembered again since */
+    old_key = ghosts->ring[ghosts->next];
+    PValue = JudyLGet(ghosts->JudyL_array, old_key, PJE0);
+    if (PValue && (Word_t)*PValue == ghosts->next + 1)
+        (void)JudyLDel(&ghosts->JudyL_array, old_key, PJE0);
+
+    ghosts->ring[ghosts->next] = key;
+    PValue = JudyLIns(&ghosts->JudyL_array, key, PJE0);
+    fatal_assert(NULL != PValue);
+    *PValue = (void *)(ghosts->next + 1);
+    ghosts->next = (ghosts->next + 1) % ghosts->size;
+}
+
+/*
+ * The caller must hold the replaceQ lock.
+ * Returns 1 if the page was a ghost and forgets it.
+ */
+static int pg_cache_ghost_del_unsafe(struct pg_cache_shard *shard, struct rrdeng_page_descr *descr)
+{
+    struct pg_cache_ghosts *ghosts = &shard->replaceQ.ghosts;
+
+    if (likely(NULL == ghosts->JudyL_array))
+        return 0;
+
+    /* the slot in the ring is left behind, it never matches the position stored in the JudyL array again */
+    return JudyLDel(&ghosts->JudyL_array, pg_cache_ghost_key(descr), PJE0);
+}
 
 /* always inserts into tail */
-static inline void pg_cache_replaceQ_insert_unsafe(struct rrdengine_instance *ctx,
-                                                   struct rrdeng_page_descr *descr)
+static inline void pg_cache_replaceQ_insert_unsafe(struct pg_cache_shard *shard, struct rrdeng_page_descr *descr,
+                                                   uint8_t queue)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
     struct page_cache_descr *pg_cache_descr = descr->pg_cache_descr;
+    struct pg_cache_queue *q = (PG_CACHE_QUEUE_PROBATION == queue) ? &shard->replaceQ.probation : &shard->replaceQ.hot;
 
-    if (likely(NULL != pg_cache->replaceQ.tail)) {
-        pg_cache_descr->prev = pg_cache->replaceQ.tail;
-        pg_cache->replaceQ.tail->next = pg_cache_descr;
+    if (likely(NULL != q->tail)) {
+        pg_cache_descr->prev = q->tail;
+        q->tail->next = pg_cache_descr;
     }
-    if (unlikely(NULL == pg_cache->replaceQ.head)) {
-        pg_cache->replaceQ.head = pg_cache_descr;
+    if (unlikely(NULL == q->head)) {
+        q->head = pg_cache_descr;
     }
-    pg_cache->replaceQ.tail = pg_cache_descr;
+    q->tail = pg_cache_descr;
+    ++q->count;
+    pg_cache_descr->queue = queue;
 }
 
-static inline void pg_cache_replaceQ_delete_unsafe(struct rrdengine_instance *ctx,
-                                                   struct rrdeng_page_descr *descr)
+static inline void pg_cache_replaceQ_delete_unsafe(struct pg_cache_shard *shard, struct rrdeng_page_descr *descr)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
     struct page_cache_descr *pg_cache_descr = descr->pg_cache_descr, *prev, *next;
+    struct pg_cache_queue *q;
+
+    if (unlikely(PG_CACHE_QUEUE_NONE == pg_cache_descr->queue))
+        return;
+    q = (PG_CACHE_QUEUE_PROBATION == pg_cache_descr->queue) ? &shard->replaceQ.probation : &shard->replaceQ.hot;
 
     prev = pg_cache_descr->prev;
     next = pg_cache_descr->next;
@@ -82,43 +147,66 @@ static inline void pg_cache_replaceQ_delete_unsafe(struct rrdengine_instance *ct
     if (likely(NULL != next)) {
         next->prev = prev;
     }
-    if (unlikely(pg_cache_descr == pg_cache->replaceQ.head)) {
-        pg_cache->replaceQ.head = next;
+    if (unlikely(pg_cache_descr == q->head)) {
+        q->head = next;
     }
-    if (unlikely(pg_cache_descr == pg_cache->replaceQ.tail)) {
-        pg_cache->replaceQ.tail = prev;
+    if (unlikely(pg_cache_descr == q->tail)) {
+        q->tail = prev;
     }
     pg_cache_descr->prev = pg_cache_descr->next = NULL;
+    --q->count;
+    pg_cache_descr->queue = PG_CACHE_QUEUE_NONE;
+    pg_cache_descr->referenced = 0;
 }
 
+/* Inserts a page that has just been populated or flushed to the disk */
 void pg_cache_replaceQ_insert(struct rrdengine_instance *ctx,
                               struct rrdeng_page_descr *descr)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
-
-    uv_rwlock_wrlock(&pg_cache->replaceQ.lock);
-    pg_cache_replaceQ_insert_unsafe(ctx, descr);
-    uv_rwlock_wrunlock(&pg_cache->replaceQ.lock);
+    struct pg_cache_shard *shard = pg_cache_metric_shard(pg_cache, descr->id);
+    uint8_t queue = PG_CACHE_QUEUE_HOT;
+
+    uv_rwlock_wrlock(&shard->replaceQ.lock);
+    if (PG_CACHE_EVICTION_2Q == pg_cache->eviction_policy) {
+        if (pg_cache_ghost_del_unsafe(shard, descr))
+            rrd_stat_atomic_add(&ctx->stats.pg_cache_ghost_hits, 1);
+        else
+            queue = PG_CACHE_QUEUE_PROBATION;
+    }
+    pg_cache_replaceQ_insert_unsafe(shard, descr, queue);
+    uv_rwlock_wrunlock(&shard->replaceQ.lock);
 }
 
 void pg_cache_replaceQ_delete(struct rrdengine_instance *ctx,
                               struct rrdeng_page_descr *descr)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, descr->id);
 
-    uv_rwlock_wrlock(&pg_cache->replaceQ.lock);
-    pg_cache_replaceQ_delete_unsafe(ctx, descr);
-    uv_rwlock_wrunlock(&pg_cache->replaceQ.lock);
+    uv_rwlock_wrlock(&shard->replaceQ.lock);
+    pg_cache_replaceQ_delete_unsafe(shard, descr);
+    uv_rwlock_wrunlock(&shard->replaceQ.lock);
 }
+
+/* Marks a page as hit */
 void pg_cache_replaceQ_set_hot(struct rrdengine_instance *ctx,
                                struct rrdeng_page_descr *descr)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, descr->id);
+    struct page_cache_descr *pg_cache_descr = descr->pg_cache_descr;
 
-    uv_rwlock_wrlock(&pg_cache->replaceQ.lock);
-    pg_cache_replaceQ_delete_unsafe(ctx, descr);
-    pg_cache_replaceQ_insert_unsafe(ctx, descr);
-    uv_rwlock_wrunlock(&pg_cache->replaceQ.lock);
+    uv_rwlock_wrlock(&shard->replaceQ.lock);
+    if (PG_CACHE_QUEUE_PROBATION == pg_cache_descr->queue) {
+        if (!pg_cache_descr->referenced) {
+            pg_cache_descr->referenced = 1;
+            uv_rwlock_wrunlock(&shard->replaceQ.lock);
+            return;
+        }
+        rrd_stat_atomic_add(&ctx->stats.pg_cache_promotions, 1);
+    }
+    pg_cache_replaceQ_delete_unsafe(shard, descr);
+    pg_cache_replaceQ_insert_unsafe(shard, descr, PG_CACHE_QUEUE_HOT);
+    uv_rwlock_wrunlock(&shard->replaceQ.lock);
 }
 
 struct rrdeng_page_descr *pg_cache_create_descr(void)
@@ -127,6 +215,7 @@ struct rrdeng_page_descr *pg_cache_create_descr(void)
 
     descr = rrdeng_page_descr_mallocz();
     descr->page_length = 0;
+    descr->entries = 0;
     descr->start_time = INVALID_TIME;
     descr->end_time = INVALID_TIME;
     descr->id = NULL;
@@ -260,21 +349,31 @@ void pg_cache_put(struct rrdengine_instance *ctx, struct rrdeng_page_descr *desc
     rrdeng_page_descr_mutex_unlock(ctx, descr);
 }
 
-/* The caller must hold the page cache lock */
-static void pg_cache_release_pages_unsafe(struct rrdengine_instance *ctx, unsigned number)
+static void pg_cache_release_pages(struct rrdengine_instance *ctx, struct pg_cache_shard *shard, unsigned number)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
 
-    pg_cache->populated_pages -= number;
+    rrd_atomic_fetch_add(&pg_cache->populated_pages, -(unsigned long)number);
+    if (shard)
+        rrd_atomic_fetch_add(&shard->populated_pages, -(unsigned long)number);
 }
 
-static void pg_cache_release_pages(struct rrdengine_instance *ctx, unsigned number)
+/*
+ * Accounts #number populated pages, as long as the total stays within limit.
+ * Returns 1 on success and 0 on failure.
+ */
+static int pg_cache_try_account_pages(struct page_cache *pg_cache, unsigned number, unsigned long limit)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    unsigned long old_populated, populated = pg_cache->populated_pages;
 
-    uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
-    pg_cache_release_pages_unsafe(ctx, number);
-    uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+    do {
+        if (populated + number >= limit + 1)
+            return 0;
+        old_populated = populated;
+        populated = ulong_compare_and_swap(&pg_cache->populated_pages, old_populated, old_populated + number);
+    } while (populated != old_populated);
+
+    return 1;
 }
 
 /*
@@ -304,11 +403,16 @@ unsigned long pg_cache_committed_hard_limit(struct rrdengine_instance *ctx)
     return ctx->cache_pages_low_watermark + (unsigned long)ctx->metric_API_max_producers;
 }
 
+static inline void pg_cache_account_shard_pages(struct pg_cache_shard *shard, unsigned number)
+{
+    rrd_atomic_fetch_add(&shard->populated_pages, number);
+}
+
 /*
- * This function will block until it reserves #number populated pages.
+ * This function will block until it reserves #number populated pages in the shard.
  * It will trigger evictions or dirty page flushing if the pg_cache_hard_limit() limit is hit.
  */
-static void pg_cache_reserve_pages(struct rrdengine_instance *ctx, unsigned number)
+static void pg_cache_reserve_pages(struct rrdengine_instance *ctx, struct pg_cache_shard *shard, unsigned number)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
     unsigned failures = 0;
@@ -317,19 +421,17 @@ static void pg_cache_reserve_pages(struct rrdengine_instance *ctx, unsigned numb
 
     assert(number < ctx->max_cache_pages);
 
-    uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
     if (pg_cache->populated_pages + number >= pg_cache_hard_limit(ctx) + 1)
         debug(D_RRDENGINE, "==Page cache full. Reserving %u pages.==",
                 number);
-    while (pg_cache->populated_pages + number >= pg_cache_hard_limit(ctx) + 1) {
+    while (!pg_cache_try_account_pages(pg_cache, number, pg_cache_hard_limit(ctx))) {
 
-        if (!pg_cache_try_evict_one_page_unsafe(ctx)) {
+        if (!pg_cache_try_evict_one_page(ctx)) {
             /* failed to evict */
             struct completion compl;
             struct rrdeng_cmd cmd;
 
             ++failures;
-            uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
 
             completion_init(&compl);
             cmd.opcode = RRDENG_FLUSH_PAGES;
@@ -351,98 +453,146 @@ static void pg_cache_reserve_pages(struct rrdengine_instance *ctx, unsigned numb
 
                 (void)sleep_usec(usecs_to_sleep);
             }
-            uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
         }
     }
-    pg_cache->populated_pages += number;
-    uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+    pg_cache_account_shard_pages(shard, number);
 }
 
 /*
- * This function will attempt to reserve #number populated pages.
+ * This function will attempt to reserve #number populated pages in the shard.
  * It may trigger evictions if the pg_cache_soft_limit() limit is hit.
  * Returns 0 on failure and 1 on success.
  */
-static int pg_cache_try_reserve_pages(struct rrdengine_instance *ctx, unsigned number)
+static int pg_cache_try_reserve_pages(struct rrdengine_instance *ctx, struct pg_cache_shard *shard, unsigned number)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
     unsigned count = 0;
-    int ret = 0;
 
     assert(number < ctx->max_cache_pages);
 
-    uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
     if (pg_cache->populated_pages + number >= pg_cache_soft_limit(ctx) + 1) {
         debug(D_RRDENGINE,
               "==Page cache full. Trying to reserve %u pages.==",
               number);
         do {
-            if (!pg_cache_try_evict_one_page_unsafe(ctx))
+            if (!pg_cache_try_evict_one_page(ctx))
                 break;
             ++count;
         } while (pg_cache->populated_pages + number >= pg_cache_soft_limit(ctx) + 1);
         debug(D_RRDENGINE, "Evicted %u pages.", count);
     }
 
-    if (pg_cache->populated_pages + number < pg_cache_hard_limit(ctx) + 1) {
-        pg_cache->populated_pages += number;
-        ret = 1; /* success */
-    }
-    uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+    if (!pg_cache_try_account_pages(pg_cache, number, pg_cache_hard_limit(ctx)))
+        return 0;
 
-    return ret;
+    pg_cache_account_shard_pages(shard, number);
+    return 1; /* success */
 }
 
-/* The caller must hold the page cache and the page descriptor locks in that order */
-static void pg_cache_evict_unsafe(struct rrdengine_instance *ctx, struct rrdeng_page_descr *descr)
+/* The caller must hold the page descriptor lock or an exclusive page reference */
+static void pg_cache_evict_unsafe(struct rrdengine_instance *ctx, struct pg_cache_shard *shard,
+                                  struct rrdeng_page_descr *descr)
 {
     struct page_cache_descr *pg_cache_descr = descr->pg_cache_descr;
 
     dbengine_page_free(pg_cache_descr->page);
     pg_cache_descr->page = NULL;
     pg_cache_descr->flags &= ~RRD_PAGE_POPULATED;
-    pg_cache_release_pages_unsafe(ctx, 1);
-    ++ctx->stats.pg_cache_evictions;
+    pg_cache_release_pages(ctx, shard, 1);
+    rrd_stat_atomic_add(&ctx->stats.pg_cache_evictions, 1);
 }
 
 /*
- * The caller must hold the page cache lock.
- * Lock order: page cache -> replaceQ -> page descriptor
- * This function iterates all pages and tries to evict one.
- * If it fails it sets in_flight_descr to the oldest descriptor that has write-back in progress,
- * or it sets it to NULL if no write-back is in progress.
+ * The caller must hold the replaceQ lock.
+ * Lock order: replaceQ -> page descriptor
+ * This function iterates the pages of a queue of the shard and tries to evict one.
  *
- * Returns 1 on success and 0 on failure.
+ * Returns the evicted page descriptor, or NULL on failure.
  */
-static int pg_cache_try_evict_one_page_unsafe(struct rrdengine_instance *ctx)
+static struct rrdeng_page_descr *pg_cache_try_evict_one_page_from_queue_unsafe(struct rrdengine_instance *ctx,
+                                                                               struct pg_cache_shard *shard,
+                                                                               struct pg_cache_queue *q)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
     unsigned long old_flags;
     struct rrdeng_page_descr *descr;
     struct page_cache_descr *pg_cache_descr = NULL;
 
-    uv_rwlock_wrlock(&pg_cache->replaceQ.lock);
-    for (pg_cache_descr = pg_cache->replaceQ.head ; NULL != pg_cache_descr ; pg_cache_descr = pg_cache_descr->next) {
+    for (pg_cache_descr = q->head ; NULL != pg_cache_descr ; pg_cache_descr = pg_cache_descr->next) {
         descr = pg_cache_descr->descr;
 
         rrdeng_page_descr_mutex_lock(ctx, descr);
         old_flags = pg_cache_descr->flags;
         if ((old_flags & RRD_PAGE_POPULATED) && !(old_flags & RRD_PAGE_DIRTY) && pg_cache_try_get_unsafe(descr, 1)) {
             /* must evict */
-            pg_cache_evict_unsafe(ctx, descr);
+            if (PG_CACHE_QUEUE_PROBATION == pg_cache_descr->queue)
+                pg_cache_ghost_add_unsafe(shard, descr);
+            pg_cache_evict_unsafe(ctx, shard, descr);
             pg_cache_put_unsafe(descr);
-            pg_cache_replaceQ_delete_unsafe(ctx, descr);
+            pg_cache_replaceQ_delete_unsafe(shard, descr);
 
             rrdeng_page_descr_mutex_unlock(ctx, descr);
-            uv_rwlock_wrunlock(&pg_cache->replaceQ.lock);
+            return descr;
+        }
+        rrdeng_page_descr_mutex_unlock(ctx, descr);
+    }
+
+    /* failed to evict */
+    return NULL;
+}
+
+/*
+ * Lock order: replaceQ -> page descriptor
+ * This function iterates the pages of the shard and tries to evict one.
+ *
+ * Returns 1 on success and 0 on failure.
+ */
+static int pg_cache_try_evict_one_page_from_shard(struct rrdengine_instance *ctx, struct pg_cache_shard *shard)
+{
+    struct pg_cache_replaceQ *replaceQ = &shard->replaceQ;
+    struct pg_cache_queue *first = &replaceQ->hot, *second = &replaceQ->probation;
+    struct rrdeng_page_descr *descr;
+
+    uv_rwlock_wrlock(&replaceQ->lock);
+    if (replaceQ->probation.count * 100 > (replaceQ->probation.count + replaceQ->hot.count) * PG_CACHE_2Q_PROBATION_PERCENT ||
+        0 == replaceQ->hot.count) {
+        first = &replaceQ->probation;
+        second = &replaceQ->hot;
+    }
+    descr = pg_cache_try_evict_one_page_from_queue_unsafe(ctx, shard, first);
+    if (NULL == descr)
+        descr = pg_cache_try_evict_one_page_from_queue_unsafe(ctx, shard, second);
+    uv_rwlock_wrunlock(&replaceQ->lock);
+
+    if (NULL == descr) {
+        /* failed to evict */
+        return 0;
+    }
+    rrdeng_try_deallocate_pg_cache_descr(ctx, descr);
+    return 1;
+}
 
-            rrdeng_try_deallocate_pg_cache_descr(ctx, descr);
+/*
+ * Tries to evict one page, starting from the shard with the most populated pages,
+ * so that the shards stay balanced and evictions approximate a global LRU.
+ *
+ * Returns 1 on success and 0 on failure.
+ */
+static int pg_cache_try_evict_one_page(struct rrdengine_instance *ctx)
+{
+    struct page_cache *pg_cache = &ctx->pg_cache;
+    unsigned i, fullest = 0;
 
+    for (i = 1 ; i < PG_CACHE_SHARDS ; ++i) {
+        if (pg_cache->shards[i].populated_pages > pg_cache->shards[fullest].populated_pages)
+            fullest = i;
+    }
+    if (pg_cache_try_evict_one_page_from_shard(ctx, &pg_cache->shards[fullest]))
+        return 1;
+
+    for (i = 0 ; i < PG_CACHE_SHARDS ; ++i) {
+        if (i != fullest && pg_cache_try_evict_one_page_from_shard(ctx, &pg_cache->shards[i]))
             return 1;
-        }
-        rrdeng_page_descr_mutex_unlock(ctx, descr);
     }
-    uv_rwlock_wrunlock(&pg_cache->replaceQ.lock);
 
     /* failed to evict */
     return 0;
@@ -463,17 +613,14 @@ uint8_t pg_cache_punch_hole(struct rrdengine_instance *ctx, struct rrdeng_page_d
                          uint8_t is_exclusive_holder, uuid_t *metric_id)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(pg_cache, descr->id);
     struct page_cache_descr *pg_cache_descr = NULL;
-    Pvoid_t *PValue;
     struct pg_cache_page_index *page_index = NULL;
     int ret;
     uint8_t can_delete_metric = 0;
 
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, descr->id, sizeof(uuid_t));
-    fatal_assert(NULL != PValue);
-    page_index = *PValue;
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
+    page_index = pg_cache_find_page_index(ctx, descr->id);
+    fatal_assert(NULL != page_index);
 
     uv_rwlock_wrlock(&page_index->lock);
     ret = JudyLDel(&page_index->JudyL_array, (Word_t)(descr->start_time / USEC_PER_SEC), PJE0);
@@ -494,10 +641,8 @@ uint8_t pg_cache_punch_hole(struct rrdengine_instance *ctx, struct rrdeng_page_d
     uv_rwlock_wrunlock(&page_index->lock);
     fatal_assert(1 == ret);
 
-    uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
-    ++ctx->stats.pg_cache_deletions;
-    --pg_cache->page_descriptors;
-    uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+    rrd_stat_atomic_add(&ctx->stats.pg_cache_deletions, 1);
+    rrd_atomic_fetch_add(&pg_cache->page_descriptors, -1UL);
 
     rrdeng_page_descr_mutex_lock(ctx, descr);
     pg_cache_descr = descr->pg_cache_descr;
@@ -526,10 +671,7 @@ uint8_t pg_cache_punch_hole(struct rrdengine_instance *ctx, struct rrdeng_page_d
     if (pg_cache_descr->flags & RRD_PAGE_POPULATED) {
         /* only after locking can it be safely deleted from LRU */
         pg_cache_replaceQ_delete(ctx, descr);
-
-        uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
-        pg_cache_evict_unsafe(ctx, descr);
-        uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+        pg_cache_evict_unsafe(ctx, shard, descr);
     }
     pg_cache_put(ctx, descr);
     rrdeng_try_deallocate_pg_cache_descr(ctx, descr);
@@ -652,18 +794,15 @@ void pg_cache_insert(struct rrdengine_instance *ctx, struct pg_cache_page_index
 
         fatal_assert(pg_cache_descr_state & PG_CACHE_DESCR_ALLOCATED);
         if (pg_cache_descr->flags & RRD_PAGE_POPULATED) {
-            pg_cache_reserve_pages(ctx, 1);
+            pg_cache_reserve_pages(ctx, pg_cache_metric_shard(pg_cache, descr->id), 1);
             if (!(pg_cache_descr->flags & RRD_PAGE_DIRTY))
                 pg_cache_replaceQ_insert(ctx, descr);
         }
     }
 
     if (unlikely(NULL == index)) {
-        uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-        PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, descr->id, sizeof(uuid_t));
-        fatal_assert(NULL != PValue);
-        page_index = *PValue;
-        uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
+        page_index = pg_cache_find_page_index(ctx, descr->id);
+        fatal_assert(NULL != page_index);
     } else {
         page_index = index;
     }
@@ -675,26 +814,17 @@ void pg_cache_insert(struct rrdengine_instance *ctx, struct pg_cache_page_index
     pg_cache_add_new_metric_time(page_index, descr);
     uv_rwlock_wrunlock(&page_index->lock);
 
-    uv_rwlock_wrlock(&pg_cache->pg_cache_rwlock);
-    ++ctx->stats.pg_cache_insertions;
-    ++pg_cache->page_descriptors;
-    uv_rwlock_wrunlock(&pg_cache->pg_cache_rwlock);
+    rrd_stat_atomic_add(&ctx->stats.pg_cache_insertions, 1);
+    rrd_atomic_fetch_add(&pg_cache->page_descriptors, 1);
 }
 
 usec_t pg_cache_oldest_time_in_range(struct rrdengine_instance *ctx, uuid_t *id, usec_t start_time, usec_t end_time)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
     struct rrdeng_page_descr *descr = NULL;
-    Pvoid_t *PValue;
-    struct pg_cache_page_index *page_index = NULL;
+    struct pg_cache_page_index *page_index;
 
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, id, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-    if (NULL == PValue) {
+    page_index = pg_cache_find_page_index(ctx, id);
+    if (NULL == page_index) {
         return INVALID_TIME;
     }
 
@@ -760,22 +890,16 @@ void pg_cache_get_filtered_info_prev(struct rrdengine_instance *ctx, struct pg_c
 struct rrdeng_page_descr *pg_cache_lookup_unpopulated_and_lock(struct rrdengine_instance *ctx, uuid_t *id,
                                                                usec_t start_time)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, id);
     struct rrdeng_page_descr *descr = NULL;
     struct page_cache_descr *pg_cache_descr = NULL;
     unsigned long flags;
     Pvoid_t *PValue;
-    struct pg_cache_page_index *page_index = NULL;
+    struct pg_cache_page_index *page_index;
     Word_t Index;
 
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, id, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-
-    if ((NULL == PValue) || !pg_cache_try_reserve_pages(ctx, 1)) {
+    page_index = pg_cache_find_page_index(ctx, id);
+    if ((NULL == page_index) || !pg_cache_try_reserve_pages(ctx, shard, 1)) {
         /* Failed to find page or failed to reserve a spot in the cache */
         return NULL;
     }
@@ -790,7 +914,7 @@ struct rrdeng_page_descr *pg_cache_lookup_unpopulated_and_lock(struct rrdengine_
         /* Failed to find non-empty page */
         uv_rwlock_rdunlock(&page_index->lock);
 
-        pg_cache_release_pages(ctx, 1);
+        pg_cache_release_pages(ctx, shard, 1);
         return NULL;
     }
 
@@ -803,7 +927,7 @@ struct rrdeng_page_descr *pg_cache_lookup_unpopulated_and_lock(struct rrdengine_
         /* Failed to get reference or page is already populated */
         rrdeng_page_descr_mutex_unlock(ctx, descr);
 
-        pg_cache_release_pages(ctx, 1);
+        pg_cache_release_pages(ctx, shard, 1);
         return NULL;
     }
     /* success */
@@ -824,30 +948,31 @@ struct rrdeng_page_descr *pg_cache_lookup_unpopulated_and_lock(struct rrdengine_
  *        with the time range [start_time,end_time]. The caller must free (*page_info_arrayp) with freez().
  *        If page_info_arrayp is set to NULL nothing was allocated.
  * @param ret_page_indexp Sets the page index pointer (*ret_page_indexp) for the given UUID.
- * @return the number of pages that overlap with the time range [start_time,end_time].
+ * @param preload_end_timep If not NULL, it is set to the time up to which pages have been preloaded. It is smaller
+ *        than end_time when the preloading stopped after PAGE_CACHE_MAX_PRELOAD_PAGES pages.
+ * @return the number of pages that overlap with the time range [start_time,end_time], or with
+ *         [start_time,*preload_end_timep] when preload_end_timep is not NULL.
  */
 unsigned pg_cache_preload(struct rrdengine_instance *ctx, uuid_t *id, usec_t start_time, usec_t end_time,
-                          struct rrdeng_page_info **page_info_arrayp, struct pg_cache_page_index **ret_page_indexp)
+                          struct rrdeng_page_info **page_info_arrayp, struct pg_cache_page_index **ret_page_indexp,
+                          usec_t *preload_end_timep)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, id);
     struct rrdeng_page_descr *descr = NULL, *preload_array[PAGE_CACHE_MAX_PRELOAD_PAGES];
     struct page_cache_descr *pg_cache_descr = NULL;
     unsigned i, j, k, preload_count, count, page_info_array_max_size;
     unsigned long flags;
     Pvoid_t *PValue;
-    struct pg_cache_page_index *page_index = NULL;
+    struct pg_cache_page_index *page_index;
     Word_t Index;
     uint8_t failed_to_reserve;
 
     fatal_assert(NULL != ret_page_indexp);
 
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, id, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        *ret_page_indexp = page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-    if (NULL == PValue) {
+    if (preload_end_timep)
+        *preload_end_timep = end_time;
+    *ret_page_indexp = page_index = pg_cache_find_page_index(ctx, id);
+    if (NULL == page_index) {
         debug(D_RRDENGINE, "%s: No page was found to attempt preload.", __func__);
         *ret_page_indexp = NULL;
         return 0;
@@ -902,6 +1027,8 @@ unsigned pg_cache_preload(struct rrdengine_instance *ctx, uuid_t *id, usec_t sta
             preload_array[preload_count++] = descr;
             if (PAGE_CACHE_MAX_PRELOAD_PAGES == preload_count) {
                 rrdeng_page_descr_mutex_unlock(ctx, descr);
+                if (preload_end_timep && descr->end_time < end_time)
+                    *preload_end_timep = descr->end_time;
                 break;
             }
         }
@@ -919,7 +1046,7 @@ unsigned pg_cache_preload(struct rrdengine_instance *ctx, uuid_t *id, usec_t sta
         if (NULL == descr) {
             continue;
         }
-        if (!pg_cache_try_reserve_pages(ctx, 1)) {
+        if (!pg_cache_try_reserve_pages(ctx, shard, 1)) {
             failed_to_reserve = 1;
             break;
         }
@@ -934,7 +1061,7 @@ unsigned pg_cache_preload(struct rrdengine_instance *ctx, uuid_t *id, usec_t sta
             }
             if (descr->extent == next->extent) {
                 /* same extent, consolidate */
-                if (!pg_cache_try_reserve_pages(ctx, 1)) {
+                if (!pg_cache_try_reserve_pages(ctx, shard, 1)) {
                     failed_to_reserve = 1;
                     break;
                 }
@@ -977,6 +1104,7 @@ struct rrdeng_page_descr *
                         usec_t point_in_time)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard;
     struct rrdeng_page_descr *descr = NULL;
     struct page_cache_descr *pg_cache_descr = NULL;
     unsigned long flags;
@@ -986,19 +1114,15 @@ struct rrdeng_page_descr *
     uint8_t page_not_in_cache;
 
     if (unlikely(NULL == index)) {
-        uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-        PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, id, sizeof(uuid_t));
-        if (likely(NULL != PValue)) {
-            page_index = *PValue;
-        }
-        uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-        if (NULL == PValue) {
+        page_index = pg_cache_find_page_index(ctx, id);
+        if (NULL == page_index) {
             return NULL;
         }
     } else {
         page_index = index;
     }
-    pg_cache_reserve_pages(ctx, 1);
+    shard = pg_cache_metric_shard(pg_cache, &page_index->id);
+    pg_cache_reserve_pages(ctx, shard, 1);
 
     page_not_in_cache = 0;
     uv_rwlock_rdlock(&page_index->lock);
@@ -1015,7 +1139,7 @@ struct rrdeng_page_descr *
             /* non-empty page not found */
             uv_rwlock_rdunlock(&page_index->lock);
 
-            pg_cache_release_pages(ctx, 1);
+            pg_cache_release_pages(ctx, shard, 1);
             return NULL;
         }
         rrdeng_page_descr_mutex_lock(ctx, descr);
@@ -1066,7 +1190,7 @@ struct rrdeng_page_descr *
 
     if (!(flags & RRD_PAGE_DIRTY))
         pg_cache_replaceQ_set_hot(ctx, descr);
-    pg_cache_release_pages(ctx, 1);
+    pg_cache_release_pages(ctx, shard, 1);
     if (page_not_in_cache)
         rrd_stat_atomic_add(&ctx->stats.pg_cache_misses, 1);
     else
@@ -1084,27 +1208,23 @@ pg_cache_lookup_next(struct rrdengine_instance *ctx, struct pg_cache_page_index
                      usec_t start_time, usec_t end_time)
 {
     struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard;
     struct rrdeng_page_descr *descr = NULL;
     struct page_cache_descr *pg_cache_descr = NULL;
     unsigned long flags;
-    Pvoid_t *PValue;
     struct pg_cache_page_index *page_index = NULL;
     uint8_t page_not_in_cache;
 
     if (unlikely(NULL == index)) {
-        uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-        PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, id, sizeof(uuid_t));
-        if (likely(NULL != PValue)) {
-            page_index = *PValue;
-        }
-        uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-        if (NULL == PValue) {
+        page_index = pg_cache_find_page_index(ctx, id);
+        if (NULL == page_index) {
             return NULL;
         }
     } else {
         page_index = index;
     }
-    pg_cache_reserve_pages(ctx, 1);
+    shard = pg_cache_metric_shard(pg_cache, &page_index->id);
+    pg_cache_reserve_pages(ctx, shard, 1);
 
     page_not_in_cache = 0;
     uv_rwlock_rdlock(&page_index->lock);
@@ -1117,7 +1237,7 @@ pg_cache_lookup_next(struct rrdengine_instance *ctx, struct pg_cache_page_index
                 error_report("Page cache timeout while waiting for page %p : returning FAIL", descr);
             uv_rwlock_rdunlock(&page_index->lock);
 
-            pg_cache_release_pages(ctx, 1);
+            pg_cache_release_pages(ctx, shard, 1);
             return NULL;
         }
         rrdeng_page_descr_mutex_lock(ctx, descr);
@@ -1172,7 +1292,7 @@ pg_cache_lookup_next(struct rrdengine_instance *ctx, struct pg_cache_page_index
 
     if (!(flags & RRD_PAGE_DIRTY))
         pg_cache_replaceQ_set_hot(ctx, descr);
-    pg_cache_release_pages(ctx, 1);
+    pg_cache_release_pages(ctx, shard, 1);
     if (page_not_in_cache)
         rrd_stat_atomic_add(&ctx->stats.pg_cache_misses, 1);
     else
@@ -1197,22 +1317,72 @@ struct pg_cache_page_index *create_page_index(uuid_t *id)
     return page_index;
 }
 
-static void init_metrics_index(struct rrdengine_instance *ctx)
+/* Returns the page index of the metric, or NULL if the metric has no pages */
+struct pg_cache_page_index *pg_cache_find_page_index(struct rrdengine_instance *ctx, uuid_t *id)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, id);
+    struct pg_cache_page_index *page_index = NULL;
+    Pvoid_t *PValue;
 
-    pg_cache->metrics_index.JudyHS_array = (Pvoid_t) NULL;
-    pg_cache->metrics_index.last_page_index = NULL;
-    fatal_assert(0 == uv_rwlock_init(&pg_cache->metrics_index.lock));
+    uv_rwlock_rdlock(&shard->metrics_index.lock);
+    PValue = JudyHSGet(shard->metrics_index.JudyHS_array, id, sizeof(uuid_t));
+    if (likely(NULL != PValue)) {
+        page_index = *PValue;
+    }
+    uv_rwlock_rdunlock(&shard->metrics_index.lock);
+
+    return page_index;
 }
 
-static void init_replaceQ(struct rrdengine_instance *ctx)
+/* Returns the page index of the metric, creating it the first time the metric is seen */
+struct pg_cache_page_index *pg_cache_find_or_create_page_index(struct rrdengine_instance *ctx, uuid_t *id)
 {
-    struct page_cache *pg_cache = &ctx->pg_cache;
+    struct pg_cache_shard *shard = pg_cache_metric_shard(&ctx->pg_cache, id);
+    struct pg_cache_page_index *page_index;
+    Pvoid_t *PValue;
+
+    page_index = pg_cache_find_page_index(ctx, id);
+    if (likely(NULL != page_index))
+        return page_index;
 
-    pg_cache->replaceQ.head = NULL;
-    pg_cache->replaceQ.tail = NULL;
-    fatal_assert(0 == uv_rwlock_init(&pg_cache->replaceQ.lock));
+    uv_rwlock_wrlock(&shard->metrics_index.lock);
+    PValue = JudyHSIns(&shard->metrics_index.JudyHS_array, id, sizeof(uuid_t), PJE0);
+    if (NULL == *PValue) {
+        *PValue = page_index = create_page_index(id);
+        page_index->prev = shard->metrics_index.last_page_index;
+        shard->metrics_index.last_page_index = page_index;
+    } else {
+        /* another thread created it in the meantime */
+        page_index = *PValue;
+    }
+    uv_rwlock_wrunlock(&shard->metrics_index.lock);
+
+    return page_index;
+}
+
+static void init_metrics_index(struct pg_cache_shard *shard)
+{
+    shard->metrics_index.JudyHS_array = (Pvoid_t) NULL;
+    shard->metrics_index.last_page_index = NULL;
+    fatal_assert(0 == uv_rwlock_init(&shard->metrics_index.lock));
+}
+
+static void init_replaceQ(struct rrdengine_instance *ctx, struct pg_cache_shard *shard)
+{
+    struct pg_cache_replaceQ *replaceQ = &shard->replaceQ;
+
+    memset(&replaceQ->probation, 0, sizeof(replaceQ->probation));
+    memset(&replaceQ->hot, 0, sizeof(replaceQ->hot));
+
+    replaceQ->ghosts.JudyL_array = (Pvoid_t) NULL;
+    replaceQ->ghosts.next = 0;
+    replaceQ->ghosts.size = 0;
+    replaceQ->ghosts.ring = NULL;
+    if (PG_CACHE_EVICTION_2Q == ctx->pg_cache.eviction_policy) {
+        replaceQ->ghosts.size = ctx->max_cache_pages * PG_CACHE_2Q_GHOSTS_PERCENT / 100 / PG_CACHE_SHARDS + 1;
+        replaceQ->ghosts.ring = callocz(replaceQ->ghosts.size, sizeof(*replaceQ->ghosts.ring));
+    }
+    fatal_assert(0 == uv_rwlock_init(&replaceQ->lock));
 }
 
 static void init_committed_page_index(struct rrdengine_instance *ctx)
@@ -1231,10 +1401,14 @@ void init_page_cache(struct rrdengine_instance *ctx)
 
     pg_cache->page_descriptors = 0;
     pg_cache->populated_pages = 0;
-    fatal_assert(0 == uv_rwlock_init(&pg_cache->pg_cache_rwlock));
 
-    init_metrics_index(ctx);
-    init_replaceQ(ctx);
+    for (unsigned i = 0 ; i < PG_CACHE_SHARDS ; ++i) {
+        struct pg_cache_shard *shard = &pg_cache->shards[i];
+
+        shard->populated_pages = 0;
+        init_metrics_index(shard);
+        init_replaceQ(ctx, shard);
+    }
     init_committed_page_index(ctx);
 }
 
@@ -1255,47 +1429,59 @@ void free_page_cache(struct rrdengine_instance *ctx)
     if (netdata_exit)
         return;
 #endif
-    Word_t metrics_index_bytes = 0, pages_index_bytes = 0, pages_dirty_index_bytes = 0;
+    Word_t metrics_index_bytes = 0, pages_index_bytes = 0, pages_dirty_index_bytes = 0, ghosts_bytes = 0;
 
     /* Free committed page index */
     pages_dirty_index_bytes = JudyLFreeArray(&pg_cache->committed_page_index.JudyL_array, PJE0);
     fatal_assert(NULL == pg_cache->committed_page_index.JudyL_array);
 
-    for (page_index = pg_cache->metrics_index.last_page_index ;
-         page_index != NULL ;
-         page_index = prev_page_index) {
+    for (unsigned i = 0 ; i < PG_CACHE_SHARDS ; ++i) {
+        struct pg_cache_shard *shard = &pg_cache->shards[i];
 
-        prev_page_index = page_index->prev;
+        for (page_index = shard->metrics_index.last_page_index ;
+             page_index != NULL ;
+             page_index = prev_page_index) {
 
-        /* Find first page in range */
-        Index = (Word_t) 0;
-        PValue = JudyLFirst(page_index->JudyL_array, &Index, PJE0);
-        descr = unlikely(NULL == PValue) ? NULL : *PValue;
+            prev_page_index = page_index->prev;
 
-        while (descr != NULL) {
-            /* Iterate all page descriptors of this metric */
+            /* Find first page in range */
+            Index = (Word_t) 0;
+            PValue = JudyLFirst(page_index->JudyL_array, &Index, PJE0);
+            descr = unlikely(NULL == PValue) ? NULL : *PValue;
 
-            if (descr->pg_cache_descr_state & PG_CACHE_DESCR_ALLOCATED) {
-                /* Check rrdenglocking.c */
-                pg_cache_descr = descr->pg_cache_descr;
-                if (pg_cache_descr->flags & RRD_PAGE_POPULATED) {
-                    dbengine_page_free(pg_cache_descr->page);
+            while (descr != NULL) {
+                /* Iterate all page descriptors of this metric */
+
+                if (descr->pg_cache_descr_state & PG_CACHE_DESCR_ALLOCATED) {
+                    /* Check rrdenglocking.c */
+                    pg_cache_descr = descr->pg_cache_descr;
+                    if (pg_cache_descr->flags & RRD_PAGE_POPULATED) {
+                        dbengine_page_free(pg_cache_descr->page);
+                    }
+                    rrdeng_destroy_pg_cache_descr(ctx, pg_cache_descr);
                 }
-                rrdeng_destroy_pg_cache_descr(ctx, pg_cache_descr);
+                rrdeng_page_descr_freez(descr);
+
+                PValue = JudyLNext(page_index->JudyL_array, &Index, PJE0);
+                descr = unlikely(NULL == PValue) ? NULL : *PValue;
             }
-            rrdeng_page_descr_freez(descr);
 
-            PValue = JudyLNext(page_index->JudyL_array, &Index, PJE0);
-            descr = unlikely(NULL == PValue) ? NULL : *PValue;
+            /* Free page index */
+            pages_index_bytes += JudyLFreeArray(&page_index->JudyL_array, PJE0);
+            fatal_assert(NULL == page_index->JudyL_array);
+            freez(page_index);
         }
-
-        /* Free page index */
-        pages_index_bytes += JudyLFreeArray(&page_index->JudyL_array, PJE0);
-        fatal_assert(NULL == page_index->JudyL_array);
-        freez(page_index);
+        /* Free metrics index */
+        metrics_index_bytes += JudyHSFreeArray(&shard->metrics_index.JudyHS_array, PJE0);
+        fatal_assert(NULL == shard->metrics_index.JudyHS_array);
+
+        /* Free ghosts */
+        ghosts_bytes += JudyLFreeArray(&shard->replaceQ.ghosts.JudyL_array, PJE0);
+        ghosts_bytes += shard->replaceQ.ghosts.size * sizeof(*shard->replaceQ.ghosts.ring);
+        freez(shard->replaceQ.ghosts.ring);
+        shard->replaceQ.ghosts.ring = NULL;
+        shard->replaceQ.ghosts.size = 0;
     }
-    /* Free metrics index */
-    metrics_index_bytes = JudyHSFreeArray(&pg_cache->metrics_index.JudyHS_array, PJE0);
-    fatal_assert(NULL == pg_cache->metrics_index.JudyHS_array);
-    info("Freed %lu bytes of memory from page cache.", pages_dirty_index_bytes + pages_index_bytes + metrics_index_bytes);
+    info("Freed %lu bytes of memory from page cache.",
+         pages_dirty_index_bytes + pages_index_bytes + metrics_index_bytes + ghosts_bytes);
 }
@@ -29,7 +29,9 @@ struct page_cache_descr {
     struct page_cache_descr *next; /* LRU */
 
     unsigned refcnt;
-    uv_mutex_t mutex; /* always take it after the page cache lock or after the commit lock */
+    uint8_t queue; /* the replaceQ queue of the page, protected by the replaceQ lock */
+    uint8_t referenced; /* set by the first hit of a page in the probation queue, protected by the replaceQ lock */
+    uv_mutex_t mutex; /* always take it after the replaceQ lock or after the commit lock */
     uv_cond_t cond;
     unsigned waiters;
 };
@@ -64,6 +66,7 @@ struct rrdeng_page_descr {
     usec_t end_time;
     uint32_t page_length;
     uint8_t type;
+    uint16_t entries; /* the points of PAGE_GORILLA_METRICS pages, 0 until their page header has been seen */
 };
 
 #define PAGE_INFO_SCRATCH_SZ (8)
@@ -130,6 +133,41 @@ struct pg_cache_committed_page_index {
     unsigned nr_committed_pages;
 };
 
+/* Page cache eviction policies */
+typedef enum {
+    PG_CACHE_EVICTION_LRU = 0,  /* a single LRU queue */
+    PG_CACHE_EVICTION_2Q,       /* scan-resistant 2Q, see pagecache.c */
+} PG_CACHE_EVICTION_POLICY;
+
+/* replaceQ queues */
+#define PG_CACHE_QUEUE_NONE         (0)
+#define PG_CACHE_QUEUE_PROBATION    (1) /* 2Q A1in: pages that have not been hit twice yet, FIFO */
+#define PG_CACHE_QUEUE_HOT          (2) /* 2Q Am, or the only queue of the LRU policy */
+
+/* percentage of the replaceQ pages that the probation queue may hold before it is evicted first */
+#define PG_CACHE_2Q_PROBATION_PERCENT (25)
+/* percentage of the page cache size remembered in the ghost queues of the shards */
+#define PG_CACHE_2Q_GHOSTS_PERCENT (50)
+
+struct pg_cache_queue {
+    struct page_cache_descr *head; /* LRU */
+    struct page_cache_descr *tail; /* MRU */
+    unsigned long count;
+};
+
+/*
+ * The 2Q A1out queue: remembers the pages recently evicted from the probation queue,
+ * by a hash of their metric UUID and start time, so that it does not depend on the
+ * page descriptors being there. It is a ring buffer of hashes, indexed by a JudyL
+ * array that maps the hashes to their position in the ring plus one.
+ */
+struct pg_cache_ghosts {
+    Pvoid_t JudyL_array;
+    Word_t *ring;
+    unsigned long size;
+    unsigned long next;
+};
+
 /*
  * Gathers populated pages to be evicted.
  * Relies on page cache descriptors being there as it uses their memory.
@@ -137,21 +175,50 @@ struct pg_cache_committed_page_index {
 struct pg_cache_replaceQ {
     uv_rwlock_t lock; /* LRU lock */
 
-    struct page_cache_descr *head; /* LRU */
-    struct page_cache_descr *tail; /* MRU */
+    struct pg_cache_queue probation;
+    struct pg_cache_queue hot;
+    struct pg_cache_ghosts ghosts;
 };
 
-struct page_cache { /* TODO: add statistics */
-    uv_rwlock_t pg_cache_rwlock; /* page cache lock */
+/* must be a power of 2 */
+#define PG_CACHE_SHARDS (16)
 
+/*
+ * The metrics and the populated pages of a shard.
+ * Metrics are assigned to shards by the hash of their UUID, so that lookups, insertions and
+ * evictions of metrics in different shards never contend for the same locks.
+ */
+struct pg_cache_shard {
     struct pg_cache_metrics_index metrics_index;
-    struct pg_cache_committed_page_index committed_page_index;
     struct pg_cache_replaceQ replaceQ;
 
-    unsigned page_descriptors;
-    unsigned populated_pages;
+    unsigned long populated_pages; /* atomically updated, evictions start from the shard with the most pages */
+};
+
+struct page_cache {
+    PG_CACHE_EVICTION_POLICY eviction_policy;
+    struct pg_cache_shard shards[PG_CACHE_SHARDS];
+    struct pg_cache_committed_page_index committed_page_index;
+
+    /* totals of all shards, the page cache limits apply to all shards together */
+    volatile unsigned long page_descriptors; /* atomically updated */
+    volatile unsigned long populated_pages; /* atomically updated */
 };
 
+/* UUIDs are random, so folding them is enough to spread the metrics evenly */
+static inline struct pg_cache_shard *pg_cache_metric_shard(struct page_cache *pg_cache, uuid_t *id)
+{
+    uint64_t words[2];
+    uint64_t hash;
+
+    memcpy(words, id, sizeof(words));
+    hash = words[0] ^ words[1];
+    hash ^= hash >> 32;
+    hash ^= hash >> 16;
+
+    return &pg_cache->shards[hash & (PG_CACHE_SHARDS - 1)];
+}
+
 extern void pg_cache_wake_up_waiters_unsafe(struct rrdeng_page_descr *descr);
 extern void pg_cache_wake_up_waiters(struct rrdengine_instance *ctx, struct rrdeng_page_descr *descr);
 extern void pg_cache_wait_event_unsafe(struct rrdeng_page_descr *descr);
@@ -179,7 +246,8 @@ extern struct rrdeng_page_descr *pg_cache_lookup_unpopulated_and_lock(struct rrd
                                                                       usec_t start_time);
 extern unsigned
         pg_cache_preload(struct rrdengine_instance *ctx, uuid_t *id, usec_t start_time, usec_t end_time,
-                         struct rrdeng_page_info **page_info_arrayp, struct pg_cache_page_index **ret_page_indexp);
+                         struct rrdeng_page_info **page_info_arrayp, struct pg_cache_page_index **ret_page_indexp,
+                         usec_t *preload_end_timep);
 extern struct rrdeng_page_descr *
         pg_cache_lookup(struct rrdengine_instance *ctx, struct pg_cache_page_index *index, uuid_t *id,
                         usec_t point_in_time);
@@ -187,6 +255,8 @@ extern struct rrdeng_page_descr *
         pg_cache_lookup_next(struct rrdengine_instance *ctx, struct pg_cache_page_index *index, uuid_t *id,
                      usec_t start_time, usec_t end_time);
 extern struct pg_cache_page_index *create_page_index(uuid_t *id);
+extern struct pg_cache_page_index *pg_cache_find_page_index(struct rrdengine_instance *ctx, uuid_t *id);
+extern struct pg_cache_page_index *pg_cache_find_or_create_page_index(struct rrdengine_instance *ctx, uuid_t *id);
 extern void init_page_cache(struct rrdengine_instance *ctx);
 extern void free_page_cache(struct rrdengine_instance *ctx);
 extern void pg_cache_add_new_metric_time(struct pg_cache_page_index *page_index, struct rrdeng_page_descr *descr);
@@ -241,4 +311,59 @@ static inline void pg_cache_atomic_set_pg_info(struct rrdeng_page_descr *descr,
     descr->end_time = end_time; /* mark end of uncertainty period */
 }
 
+/* Like pg_cache_atomic_get_pg_info(), for pages that keep their number of entries in the page header */
+static inline void pg_cache_atomic_get_gorilla_pg_info(struct rrdeng_page_descr *descr, usec_t *end_timep,
+                                                       uint32_t *page_lengthp, uint32_t *entriesp)
+{
+    struct rrdeng_gorilla_page_header *header = descr->pg_cache_descr->page;
+    usec_t end_time, old_end_time;
+    uint32_t page_length, entries;
+
+    if (NULL == descr->extent) {
+        /* this page is currently being modified, get consistent info locklessly */
+        do {
+            end_time = descr->end_time;
+            __sync_synchronize();
+            old_end_time = end_time;
+            page_length = descr->page_length;
+            entries = header->entries;
+            __sync_synchronize();
+            end_time = descr->end_time;
+            __sync_synchronize();
+        } while ((end_time != old_end_time || (end_time & 1) != 0));
+
+        *end_timep = end_time;
+        *page_lengthp = page_length;
+        *entriesp = entries;
+    } else {
+        *end_timep = descr->end_time;
+        *page_lengthp = descr->page_length;
+        *entriesp = header->entries;
+    }
+}
+
+/* Like pg_cache_atomic_set_pg_info(), for pages that keep their number of entries in the page header */
+static inline void pg_cache_atomic_set_gorilla_pg_info(struct rrdeng_page_descr *descr, usec_t end_time,
+                                                       uint32_t page_length, uint32_t entries)
+{
+    struct rrdeng_gorilla_page_header *header = descr->pg_cache_descr->page;
+
+    fatal_assert(!(end_time & 1));
+    __sync_synchronize();
+    descr->end_time |= 1; /* mark start of uncertainty period by adding 1 microsecond */
+    __sync_synchronize();
+    descr->page_length = page_length;
+    header->entries = entries;
+    descr->entries = (uint16_t)entries;
+    __sync_synchronize();
+    descr->end_time = end_time; /* mark end of uncertainty period */
+}
+
+/* Keeps the number of entries of a page read from disk in its descriptor, for when the page is evicted */
+static inline void pg_cache_set_gorilla_pg_entries(struct rrdeng_page_descr *descr, void *page)
+{
+    if (PAGE_GORILLA_METRICS == descr->type)
+        descr->entries = (uint16_t)((struct rrdeng_gorilla_page_header *)page)->entries;
+}
+
 #endif /* NETDATA_PAGECACHE_H */
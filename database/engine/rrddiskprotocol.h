@@ -19,24 +19,43 @@
 
 #define RRD_NO_COMPRESSION (0)
 #define RRD_LZ4 (1)
+#define RRD_ZSTD (2)
 
-#define RRDENG_DF_SB_PADDING_SZ (RRDENG_BLOCK_SIZE - (RRDENG_MAGIC_SZ + RRDENG_VER_SZ + sizeof(uint8_t)))
+#define RRDENG_DF_SB_DICT_SZ (4000)
+#define RRDENG_DF_SB_PADDING_SZ (RRDENG_BLOCK_SIZE - (RRDENG_MAGIC_SZ + RRDENG_VER_SZ + sizeof(uint8_t) + \
+                                 sizeof(uint16_t) + RRDENG_DF_SB_DICT_SZ))
 /*
  * Data file persistent super-block
+ *
+ * When dict_size is not zero, the RRD_ZSTD extents of the data file have been
+ * compressed with the zstd dictionary stored in dict. Older data files have
+ * zeros there, so they are read without a dictionary.
  */
 struct rrdeng_df_sb {
     char magic_number[RRDENG_MAGIC_SZ];
     char version[RRDENG_VER_SZ];
     uint8_t tier;
+    uint16_t dict_size;
+    uint8_t dict[RRDENG_DF_SB_DICT_SZ];
     uint8_t padding[RRDENG_DF_SB_PADDING_SZ];
 } __attribute__ ((packed));
 
 /*
  * Page types
  */
-#define PAGE_METRICS    (0)
-#define PAGE_TIER       (1)
-#define PAGE_TYPE_MAX   1   // Maximum page type (inclusive)
+#define PAGE_METRICS            (0)
+#define PAGE_TIER               (1)
+#define PAGE_GORILLA_METRICS    (2)
+#define PAGE_TYPE_MAX           2   // Maximum page type (inclusive)
+
+/*
+ * Gorilla metrics page: the number of entries followed by the
+ * XOR compressed storage_number values of the page (see gorilla.h)
+ */
+struct rrdeng_gorilla_page_header {
+    uint32_t entries;
+    uint32_t data[];
+};
 
 /*
  * Data file page descriptor
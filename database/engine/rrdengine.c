@@ -47,6 +47,10 @@ static void sanity_check(void)
 
     /* Data file super-block cannot be larger than RRDENG_BLOCK_SIZE */
     BUILD_BUG_ON(RRDENG_DF_SB_PADDING_SZ < 0);
+    BUILD_BUG_ON(sizeof(struct rrdeng_df_sb) != RRDENG_BLOCK_SIZE);
+
+    /* the zstd dictionary size must fit in the super-block */
+    BUILD_BUG_ON(RRDENG_DF_SB_DICT_SZ > UINT16_MAX);
 
     BUILD_BUG_ON(sizeof(uuid_t) != UUID_SZ); /* check UUID size */
 
@@ -215,6 +219,7 @@ void read_cached_extent_cb(struct rrdengine_worker_config* wc, unsigned idx, str
         }
         /* care, we don't hold the descriptor mutex */
        (void) memcpy(page, wc->xt_cache.extent_array[idx].pages + page_offset, descr->page_length);
+        pg_cache_set_gorilla_pg_entries(descr, page);
 
         rrdeng_page_descr_mutex_lock(ctx, descr);
         pg_cache_descr = descr->pg_cache_descr;
@@ -261,6 +266,16 @@ static void fill_page_with_nulls(void *page, uint32_t page_length, uint8_t type)
         }
         break;
 
+        case PAGE_GORILLA_METRICS: {
+            // the number of points of the lost page is unknown, a single empty point is stored
+            struct rrdeng_gorilla_page_header *header = page;
+            struct gorilla_writer gw;
+            gorilla_writer_init(&gw, header->data, (RRDENG_BLOCK_SIZE - sizeof(*header)) / sizeof(uint32_t));
+            gorilla_writer_write(&gw, pack_storage_number(NAN, SN_FLAG_NONE));
+            header->entries = gw.entries;
+        }
+        break;
+
         default: {
             static bool logged = false;
             if(!logged) {
@@ -272,11 +287,10 @@ static void fill_page_with_nulls(void *page, uint32_t page_length, uint8_t type)
     }
 }
 
-void read_extent_cb(uv_fs_t* req)
+static void read_extent_complete(struct rrdengine_worker_config* wc, void *data, int result)
 {
-    struct rrdengine_worker_config* wc = req->loop->data;
     struct rrdengine_instance *ctx = wc->ctx;
-    struct extent_io_descriptor *xt_io_descr;
+    struct extent_io_descriptor *xt_io_descr = data;
     struct rrdeng_page_descr *descr;
     struct page_cache_descr *pg_cache_descr;
     int ret;
@@ -289,21 +303,20 @@ void read_extent_cb(uv_fs_t* req)
     struct rrdeng_df_extent_trailer *trailer;
     uLong crc;
 
-    xt_io_descr = req->data;
     header = xt_io_descr->buf;
     payload_length = header->payload_length;
     count = header->number_of_pages;
     payload_offset = sizeof(*header) + sizeof(header->descr[0]) * count;
     trailer = xt_io_descr->buf + xt_io_descr->bytes - sizeof(*trailer);
 
-    if (req->result < 0) {
+    if (result < 0) {
         struct rrdengine_datafile *datafile = xt_io_descr->descr_array[0]->extent->datafile;
 
         ++ctx->stats.io_errors;
         rrd_stat_atomic_add(&global_io_errors, 1);
         have_read_error = 1;
-        error("%s: uv_fs_read - %s - extent at offset %"PRIu64"(%u) in datafile %u-%u.", __func__,
-              uv_strerror((int)req->result), xt_io_descr->pos, xt_io_descr->bytes, datafile->tier, datafile->fileno);
+        error("%s: read - %s - extent at offset %"PRIu64"(%u) in datafile %u-%u.", __func__,
+              uv_strerror(result), xt_io_descr->pos, xt_io_descr->bytes, datafile->tier, datafile->fileno);
         goto after_crc_check;
     }
     crc = crc32(0L, Z_NULL, 0);
@@ -328,16 +341,30 @@ void read_extent_cb(uv_fs_t* req)
 
 after_crc_check:
     if (!have_read_error && RRD_NO_COMPRESSION != header->compression_algorithm) {
+        struct rrdengine_datafile *datafile = xt_io_descr->descr_array[0]->extent->datafile;
+
         uncompressed_payload_length = 0;
         for (i = 0 ; i < count ; ++i) {
             uncompressed_payload_length += header->descr[i].page_length;
         }
         uncompressed_buf = mallocz(uncompressed_payload_length);
-        ret = LZ4_decompress_safe(xt_io_descr->buf + payload_offset, uncompressed_buf,
-                                  payload_length, uncompressed_payload_length);
-        ctx->stats.before_decompress_bytes += payload_length;
-        ctx->stats.after_decompress_bytes += ret;
-        debug(D_RRDENGINE, "LZ4 decompressed %u bytes to %d bytes.", payload_length, ret);
+        ret = rrdeng_decompress_extent(wc, datafile, header->compression_algorithm, xt_io_descr->buf + payload_offset,
+                                       payload_length, uncompressed_buf, uncompressed_payload_length);
+        if (unlikely(ret != (int)uncompressed_payload_length)) {
+            ++ctx->stats.io_errors;
+            rrd_stat_atomic_add(&global_io_errors, 1);
+            have_read_error = 1;
+            error("%s: Extent at offset %"PRIu64"(%u) of datafile %u-%u failed to decompress (%s).", __func__,
+                  xt_io_descr->pos, xt_io_descr->bytes, datafile->tier, datafile->fileno,
+                  rrdeng_compression_algorithm_name(header->compression_algorithm));
+            freez(uncompressed_buf);
+            uncompressed_buf = NULL;
+        } else {
+            ctx->stats.before_decompress_bytes += payload_length;
+            ctx->stats.after_decompress_bytes += ret;
+            debug(D_RRDENGINE, "%s decompressed %u bytes to %d bytes.",
+                  rrdeng_compression_algorithm_name(header->compression_algorithm), payload_length, ret);
+        }
         /* care, we don't hold the descriptor mutex */
     }
     {
@@ -402,6 +429,7 @@ void read_extent_cb(uv_fs_t* req)
         } else {
             (void) memcpy(page, uncompressed_buf + page_offset, descr->page_length);
         }
+        pg_cache_set_gorilla_pg_entries(descr, page);
         rrdeng_page_descr_mutex_lock(ctx, descr);
         pg_cache_descr = descr->pg_cache_descr;
         pg_cache_descr->page = page;
@@ -416,16 +444,23 @@ void read_extent_cb(uv_fs_t* req)
             pg_cache_wake_up_waiters(ctx, descr);
         }
     }
-    if (!have_read_error && RRD_NO_COMPRESSION != header->compression_algorithm) {
-        freez(uncompressed_buf);
-    }
+    freez(uncompressed_buf);
     if (xt_io_descr->completion)
         completion_mark_complete(xt_io_descr->completion);
-    uv_fs_req_cleanup(req);
     free(xt_io_descr->buf);
     freez(xt_io_descr);
 }
 
+void read_extent_cb(uv_fs_t* req)
+{
+    struct rrdengine_worker_config* wc = req->loop->data;
+    struct extent_io_descriptor *xt_io_descr = req->data;
+    int result = (int)req->result;
+
+    uv_fs_req_cleanup(req);
+    read_extent_complete(wc, xt_io_descr, result);
+}
+
 
 static void do_read_extent(struct rrdengine_worker_config* wc,
                            struct rrdeng_page_descr **descr,
@@ -490,9 +525,12 @@ static void do_read_extent(struct rrdengine_worker_config* wc,
     return;*/
     }
     real_io_size = ALIGN_BYTES_CEILING(size_bytes);
-    xt_io_descr->iov = uv_buf_init((void *)xt_io_descr->buf, real_io_size);
-    ret = uv_fs_read(wc->loop, &xt_io_descr->req, datafile->file, &xt_io_descr->iov, 1, pos, read_extent_cb);
-    fatal_assert(-1 != ret);
+    ret = rrdeng_uring_read(wc, datafile->file, xt_io_descr->buf, real_io_size, pos, read_extent_complete, xt_io_descr);
+    if (ret) {
+        xt_io_descr->iov = uv_buf_init((void *)xt_io_descr->buf, real_io_size);
+        ret = uv_fs_read(wc->loop, &xt_io_descr->req, datafile->file, &xt_io_descr->iov, 1, pos, read_extent_cb);
+        fatal_assert(-1 != ret);
+    }
     ctx->stats.io_read_bytes += real_io_size;
     ++ctx->stats.io_read_requests;
     ctx->stats.io_read_extent_bytes += real_io_size;
@@ -656,21 +694,19 @@ void rrdeng_invalidate_oldest_committed(struct rrdengine_worker_config* wc)
     }
 }
 
-void flush_pages_cb(uv_fs_t* req)
+static void flush_pages_complete(struct rrdengine_worker_config* wc, void *data, int result)
 {
-    struct rrdengine_worker_config* wc = req->loop->data;
     struct rrdengine_instance *ctx = wc->ctx;
     struct page_cache *pg_cache = &ctx->pg_cache;
-    struct extent_io_descriptor *xt_io_descr;
+    struct extent_io_descriptor *xt_io_descr = data;
     struct rrdeng_page_descr *descr;
     struct page_cache_descr *pg_cache_descr;
     unsigned i, count;
 
-    xt_io_descr = req->data;
-    if (req->result < 0) {
+    if (result < 0) {
         ++ctx->stats.io_errors;
         rrd_stat_atomic_add(&global_io_errors, 1);
-        error("%s: uv_fs_write: %s", __func__, uv_strerror((int)req->result));
+        error("%s: write: %s", __func__, uv_strerror(result));
     }
 #ifdef NETDATA_INTERNAL_CHECKS
     {
@@ -695,8 +731,10 @@ void flush_pages_cb(uv_fs_t* req)
     }
     if (xt_io_descr->completion)
         completion_mark_complete(xt_io_descr->completion);
-    uv_fs_req_cleanup(req);
-    free(xt_io_descr->buf);
+    if (xt_io_descr->write_buffer >= 0)
+        rrdeng_uring_put_write_buffer(wc, xt_io_descr->write_buffer);
+    else
+        free(xt_io_descr->buf);
     freez(xt_io_descr);
 
     uv_rwlock_wrlock(&pg_cache->committed_page_index.lock);
@@ -705,6 +743,16 @@ void flush_pages_cb(uv_fs_t* req)
     wc->inflight_dirty_pages -= count;
 }
 
+void flush_pages_cb(uv_fs_t* req)
+{
+    struct rrdengine_worker_config* wc = req->loop->data;
+    struct extent_io_descriptor *xt_io_descr = req->data;
+    int result = (int)req->result;
+
+    uv_fs_req_cleanup(req);
+    flush_pages_complete(wc, xt_io_descr, result);
+}
+
 /*
  * completion must be NULL or valid.
  * Returns 0 when no flushing can take place.
@@ -784,16 +832,19 @@ static int do_flush_pages(struct rrdengine_worker_config* wc, int force, struct
         size_bytes = payload_offset + uncompressed_payload_length + sizeof(*trailer);
         break;
     default: /* Compress */
-        fatal_assert(uncompressed_payload_length < LZ4_MAX_INPUT_SIZE);
-        max_compressed_size = LZ4_compressBound(uncompressed_payload_length);
+        max_compressed_size = (int)rrdeng_compress_bound(compression_algorithm, uncompressed_payload_length);
         compressed_buf = mallocz(max_compressed_size);
         size_bytes = payload_offset + MAX(uncompressed_payload_length, (unsigned)max_compressed_size) + sizeof(*trailer);
         break;
     }
-    ret = posix_memalign((void *)&xt_io_descr->buf, RRDFILE_ALIGNMENT, ALIGN_BYTES_CEILING(size_bytes));
-    if (unlikely(ret)) {
-        fatal("posix_memalign:%s", strerror(ret));
-        /* freez(xt_io_descr);*/
+    xt_io_descr->write_buffer = -1;
+    xt_io_descr->buf = rrdeng_uring_get_write_buffer(wc, ALIGN_BYTES_CEILING(size_bytes), &xt_io_descr->write_buffer);
+    if (!xt_io_descr->buf) {
+        ret = posix_memalign((void *)&xt_io_descr->buf, RRDFILE_ALIGNMENT, ALIGN_BYTES_CEILING(size_bytes));
+        if (unlikely(ret)) {
+            fatal("posix_memalign:%s", strerror(ret));
+            /* freez(xt_io_descr);*/
+        }
     }
     memset(xt_io_descr->buf, 0, ALIGN_BYTES_CEILING(size_bytes));
     (void) memcpy(xt_io_descr->descr_array, eligible_pages, sizeof(struct rrdeng_page_descr *) * count);
@@ -828,6 +879,7 @@ static int do_flush_pages(struct rrdengine_worker_config* wc, int force, struct
         descr = xt_io_descr->descr_array[i];
         /* care, we don't hold the descriptor mutex */
         (void) memcpy(xt_io_descr->buf + pos, descr->pg_cache_descr->page, descr->page_length);
+        rrdeng_compression_add_sample(wc, xt_io_descr->buf + pos, descr->page_length);
         descr->extent = extent;
         extent->pages[i] = descr;
 
@@ -840,11 +892,20 @@ static int do_flush_pages(struct rrdengine_worker_config* wc, int force, struct
         header->payload_length = uncompressed_payload_length;
         break;
     default: /* Compress */
-        compressed_size = LZ4_compress_default(xt_io_descr->buf + payload_offset, compressed_buf,
-                                               uncompressed_payload_length, max_compressed_size);
+        compressed_size = rrdeng_compress_extent(wc, datafile, compression_algorithm, xt_io_descr->buf + payload_offset,
+                                                 uncompressed_payload_length, compressed_buf, max_compressed_size);
+        if (unlikely(compressed_size <= 0)) {
+            /* store the extent uncompressed, it is already in place */
+            header->compression_algorithm = RRD_NO_COMPRESSION;
+            header->payload_length = uncompressed_payload_length;
+            size_bytes = payload_offset + uncompressed_payload_length + sizeof(*trailer);
+            freez(compressed_buf);
+            break;
+        }
         ctx->stats.before_compress_bytes += uncompressed_payload_length;
         ctx->stats.after_compress_bytes += compressed_size;
-        debug(D_RRDENGINE, "LZ4 compressed %"PRIu32" bytes to %d bytes.", uncompressed_payload_length, compressed_size);
+        debug(D_RRDENGINE, "%s compressed %"PRIu32" bytes to %d bytes.",
+              rrdeng_compression_algorithm_name(compression_algorithm), uncompressed_payload_length, compressed_size);
         (void) memcpy(xt_io_descr->buf + payload_offset, compressed_buf, compressed_size);
         freez(compressed_buf);
         size_bytes = payload_offset + compressed_size + sizeof(*trailer);
@@ -863,9 +924,13 @@ static int do_flush_pages(struct rrdengine_worker_config* wc, int force, struct
     crc32set(trailer->checksum, crc);
 
     real_io_size = ALIGN_BYTES_CEILING(size_bytes);
-    xt_io_descr->iov = uv_buf_init((void *)xt_io_descr->buf, real_io_size);
-    ret = uv_fs_write(wc->loop, &xt_io_descr->req, datafile->file, &xt_io_descr->iov, 1, datafile->pos, flush_pages_cb);
-    fatal_assert(-1 != ret);
+    ret = rrdeng_uring_write(wc, datafile->file, xt_io_descr->buf, real_io_size, datafile->pos,
+                             xt_io_descr->write_buffer, flush_pages_complete, xt_io_descr);
+    if (ret) {
+        xt_io_descr->iov = uv_buf_init((void *)xt_io_descr->buf, real_io_size);
+        ret = uv_fs_write(wc->loop, &xt_io_descr->req, datafile->file, &xt_io_descr->iov, 1, datafile->pos, flush_pages_cb);
+        fatal_assert(-1 != ret);
+    }
     ctx->stats.io_write_bytes += real_io_size;
     ++ctx->stats.io_write_requests;
     ctx->stats.io_write_extent_bytes += real_io_size;
@@ -1244,6 +1309,8 @@ void rrdeng_worker(void* arg)
     }
     timer_req.data = wc;
 
+    rrdeng_uring_init(wc);
+
     wc->error = 0;
     /* wake up initialization thread */
     completion_mark_complete(&ctx->rrdengine_completion);
@@ -1325,6 +1392,9 @@ void rrdeng_worker(void* arg)
                 break;
             }
         } while (opcode != RRDENG_NOOP);
+
+        /* submit the disk I/O of the whole batch of commands at once */
+        rrdeng_uring_submit(wc);
     }
 
     /* cleanup operations of the event loop */
@@ -1341,7 +1411,9 @@ void rrdeng_worker(void* arg)
         ; /* Force flushing of all committed pages. */
     }
     wal_flush_transaction_buffer(wc);
+    rrdeng_uring_shutdown(wc);
     uv_run(loop, UV_RUN_DEFAULT);
+    rrdeng_compression_worker_cleanup(wc);
 
     info("Shutting down RRD engine event loop for tier %d complete", ctx->tier);
     /* TODO: don't let the API block by waiting to enqueue commands */
@@ -8,6 +8,10 @@
 #endif
 #include <fcntl.h>
 #include <lz4.h>
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
 #include <Judy.h>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
@@ -21,6 +25,9 @@
 #include "rrdengineapi.h"
 #include "pagecache.h"
 #include "rrdenglocking.h"
+#include "gorilla.h"
+#include "compression.h"
+#include "uring.h"
 
 #ifdef NETDATA_RRD_INTERNALS
 
@@ -33,6 +40,9 @@ struct rrdengine_instance;
 
 #define MAX_PAGES_PER_EXTENT (64) /* TODO: can go higher only when journal supports bigger than 4KiB transactions */
 
+/* caps the history a gorilla page can hold, so that it is not kept in memory unflushed for too long */
+#define GORILLA_PAGE_MAX_ENTRIES (4 * RRDENG_BLOCK_SIZE / sizeof(storage_number))
+
 #define RRDENG_FILE_NUMBER_SCAN_TMPL "%1u-%10u"
 #define RRDENG_FILE_NUMBER_PRINT_TMPL "%1.1u-%10.10u"
 
@@ -43,6 +53,10 @@ struct rrdeng_collect_handle {
     struct rrdengine_instance *ctx;
     // set to 1 when this dimension is not page aligned with the other dimensions in the chart
     uint8_t unaligned_page;
+    // the number of points stored in the current page
+    uint32_t page_entries;
+    // the encoder of the current page, for PAGE_GORILLA_METRICS
+    struct gorilla_writer gorilla;
 };
 
 struct rrdeng_query_handle {
@@ -60,6 +74,13 @@ struct rrdeng_query_handle {
     uint32_t page_length;
     usec_t dt;
     time_t dt_sec;
+    // the decoder of the current page, for PAGE_GORILLA_METRICS
+    struct gorilla_reader gorilla;
+    storage_number gorilla_value;
+    // read-ahead, the pages up to preload_end_time have been requested from the disk
+    usec_t preload_end_time;
+    unsigned preload_pages;
+    unsigned preload_consumed;
 };
 
 typedef enum {
@@ -117,6 +138,7 @@ struct extent_io_descriptor {
     struct completion *completion;
     unsigned descr_count;
     int release_descr;
+    int write_buffer; /* the registered io_uring buffer of a flush, or -1 */
     struct rrdeng_page_descr *descr_array[MAX_PAGES_PER_EXTENT];
     Word_t descr_commit_idx_array[MAX_PAGES_PER_EXTENT];
     struct extent_io_descriptor *next; /* multiple requests to be served by the same cached extent */
@@ -177,6 +199,15 @@ struct rrdengine_worker_config {
 
     struct extent_cache xt_cache;
 
+    struct rrdeng_uring uring;
+
+#ifdef ENABLE_ZSTD
+    /* created on first use, see compression.c */
+    ZSTD_CCtx *zstd_cctx;
+    ZSTD_DCtx *zstd_dctx;
+    struct rrdeng_zstd_samples zstd_samples;
+#endif
+
     int error;
 };
 
@@ -193,6 +224,8 @@ struct rrdengine_statistics {
     rrdeng_stats_t pg_cache_misses;
     rrdeng_stats_t pg_cache_backfills;
     rrdeng_stats_t pg_cache_evictions;
+    rrdeng_stats_t pg_cache_ghost_hits;
+    rrdeng_stats_t pg_cache_promotions;
     rrdeng_stats_t before_decompress_bytes;
     rrdeng_stats_t after_decompress_bytes;
     rrdeng_stats_t before_compress_bytes;
@@ -237,6 +270,8 @@ struct rrdengine_instance {
     struct page_cache pg_cache;
     uint8_t drop_metrics_under_page_cache_pressure; /* boolean */
     uint8_t global_compress_alg;
+    int compression_level; /* zstd compression level */
+    uint8_t compression_dictionary; /* boolean, train a zstd dictionary for every new datafile */
     struct transaction_commit_log commit_log;
     struct rrdengine_datafile_list datafiles;
     RRDHOST *host; /* the legacy host, or NULL for multi-host DB */
@@ -12,11 +12,17 @@ struct rrdengine_instance multidb_ctx_storage_tier4;
 #endif
 struct rrdengine_instance *multidb_ctx[RRD_STORAGE_TIERS];
 uint8_t tier_page_type[RRD_STORAGE_TIERS] = {PAGE_METRICS, PAGE_TIER, PAGE_TIER, PAGE_TIER, PAGE_TIER};
-
-#if PAGE_TYPE_MAX != 1
-#error PAGE_TYPE_MAX is not 1 - you need to add allocations here
+uint8_t tier_compression_algorithm[RRD_STORAGE_TIERS] = {RRD_LZ4, RRD_LZ4, RRD_LZ4, RRD_LZ4, RRD_LZ4};
+int tier_compression_level[RRD_STORAGE_TIERS] = {
+    RRDENG_ZSTD_DEFAULT_LEVEL, RRDENG_ZSTD_DEFAULT_LEVEL, RRDENG_ZSTD_DEFAULT_LEVEL,
+    RRDENG_ZSTD_DEFAULT_LEVEL, RRDENG_ZSTD_DEFAULT_LEVEL};
+uint8_t tier_compression_dictionary[RRD_STORAGE_TIERS] = {0, 0, 0, 0, 0};
+
+#if PAGE_TYPE_MAX != 2
+#error PAGE_TYPE_MAX is not 2 - you need to add allocations here
 #endif
-size_t page_type_size[256] = {sizeof(storage_number), sizeof(storage_number_tier1_t)};
+// gorilla pages are variable length, their size here is the size of an uncompressed point (used for page alignment)
+size_t page_type_size[256] = {sizeof(storage_number), sizeof(storage_number_tier1_t), sizeof(storage_number)};
 
 __attribute__((constructor)) void initialize_multidb_ctx(void) {
     multidb_ctx[0] = &multidb_ctx_storage_tier0;
@@ -34,6 +40,12 @@ int default_rrdeng_disk_quota_mb = 256;
 int default_multidb_disk_quota_mb = 256;
 /* Default behaviour is to unblock data collection if the page cache is full of dirty pages by dropping metrics */
 uint8_t rrdeng_drop_metrics_under_page_cache_pressure = 1;
+/* Default is the scan-resistant policy, so that long queries do not evict the pages of dashboards and alarms */
+uint8_t rrdeng_page_cache_eviction_policy = PG_CACHE_EVICTION_2Q;
+/* io_uring is used when the kernel supports it, see uring.c */
+uint8_t rrdeng_use_io_uring = 1;
+/* queries request the extents of their next pages while they consume the preloaded ones */
+uint8_t rrdeng_query_read_ahead = 1;
 
 static inline struct rrdengine_instance *get_rrdeng_ctx_from_host(RRDHOST *host, int tier) {
     if(tier < 0 || tier >= RRD_STORAGE_TIERS) tier = 0;
@@ -88,45 +100,22 @@ void rrdeng_metric_free(STORAGE_METRIC_HANDLE *db_metric_handle) {
 
 STORAGE_METRIC_HANDLE *rrdeng_metric_init(RRDDIM *rd, STORAGE_INSTANCE *db_instance) {
     struct rrdengine_instance *ctx = (struct rrdengine_instance *)db_instance;
-    struct page_cache *pg_cache;
     uuid_t legacy_uuid;
     uuid_t multihost_legacy_uuid;
-    Pvoid_t *PValue;
     struct pg_cache_page_index *page_index = NULL;
     int is_multihost_child = 0;
     RRDHOST *host = rd->rrdset->rrdhost;
 
-    pg_cache = &ctx->pg_cache;
-
     rrdeng_generate_legacy_uuid(rrddim_id(rd), (char *)rrdset_id(rd->rrdset), &legacy_uuid);
     if (host != localhost && is_storage_engine_shared((STORAGE_INSTANCE *)ctx))
         is_multihost_child = 1;
 
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, &legacy_uuid, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-    if (is_multihost_child || NULL == PValue) {
+    page_index = pg_cache_find_page_index(ctx, &legacy_uuid);
+    if (is_multihost_child || NULL == page_index) {
         /* First time we see the legacy UUID or metric belongs to child host in multi-host DB.
          * Drop legacy support, normal path */
 
-        uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-        PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, &rd->metric_uuid, sizeof(uuid_t));
-        if (likely(NULL != PValue)) {
-            page_index = *PValue;
-        }
-        uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
-        if (NULL == PValue) {
-            uv_rwlock_wrlock(&pg_cache->metrics_index.lock);
-            PValue = JudyHSIns(&pg_cache->metrics_index.JudyHS_array, &rd->metric_uuid, sizeof(uuid_t), PJE0);
-            fatal_assert(NULL == *PValue); /* TODO: figure out concurrency model */
-            *PValue = page_index = create_page_index(&rd->metric_uuid);
-            page_index->prev = pg_cache->metrics_index.last_page_index;
-            pg_cache->metrics_index.last_page_index = page_index;
-            uv_rwlock_wrunlock(&pg_cache->metrics_index.lock);
-        }
+        page_index = pg_cache_find_or_create_page_index(ctx, &rd->metric_uuid);
     } else {
         /* There are legacy UUIDs in the database, implement backward compatibility */
 
@@ -197,6 +186,17 @@ static int page_has_only_empty_metrics(struct rrdeng_page_descr *descr)
         }
         break;
 
+        case PAGE_GORILLA_METRICS: {
+            struct rrdeng_gorilla_page_header *header = descr->pg_cache_descr->page;
+            struct gorilla_reader gr;
+            gorilla_reader_init(&gr, header->data);
+            for (uint32_t i = 0 ; i < header->entries; ++i) {
+                if(does_storage_number_exist(gorilla_reader_read(&gr)))
+                    return 0;
+            }
+        }
+        break;
+
         default: {
             static bool logged = false;
             if(!logged) {
@@ -239,6 +239,15 @@ void rrdeng_store_metric_flush_current_page(STORAGE_COLLECT_HANDLE *collection_h
         rrdeng_page_descr_freez(descr);
     }
     handle->descr = NULL;
+    handle->page_entries = 0;
+}
+
+static inline bool rrdeng_collect_page_is_full(struct rrdeng_collect_handle *handle, struct rrdeng_page_descr *descr)
+{
+    if (descr->type == PAGE_GORILLA_METRICS)
+        return handle->page_entries >= GORILLA_PAGE_MAX_ENTRIES || !gorilla_writer_has_room(&handle->gorilla);
+
+    return descr->page_length + PAGE_POINT_SIZE_BYTES(descr) > RRDENG_BLOCK_SIZE;
 }
 
 void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
@@ -261,14 +270,15 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
     uint8_t must_flush_unaligned_page = 0, perfect_page_alignment = 0;
 
     if (descr) {
-        /* Make alignment decisions */
+        /* Make alignment decisions, based on the number of points in the page */
+        size_t aligned_length = handle->page_entries * PAGE_POINT_SIZE_BYTES(descr);
 
-        if (descr->page_length == rd->rrdset->rrddim_page_alignment) {
+        if (aligned_length == rd->rrdset->rrddim_page_alignment) {
             /* this is the leading dimension that defines chart alignment */
             perfect_page_alignment = 1;
         }
         /* is the metric far enough out of alignment with the others? */
-        if (unlikely(descr->page_length + PAGE_POINT_SIZE_BYTES(descr) < rd->rrdset->rrddim_page_alignment)) {
+        if (unlikely(aligned_length + PAGE_POINT_SIZE_BYTES(descr) < rd->rrdset->rrddim_page_alignment)) {
             handle->unaligned_page = 1;
             debug(D_RRDENGINE, "Metric page is not aligned with chart:");
             if (unlikely(debug_flags & D_RRDENGINE))
@@ -283,7 +293,7 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
         }
     }
     if (unlikely(NULL == descr ||
-                 descr->page_length + PAGE_POINT_SIZE_BYTES(descr) > RRDENG_BLOCK_SIZE ||
+                 rrdeng_collect_page_is_full(handle, descr) ||
                  must_flush_unaligned_page)) {
         rrdeng_store_metric_flush_current_page(collection_handle);
 
@@ -291,6 +301,14 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
         fatal_assert(page);
 
         handle->descr = descr;
+        handle->page_entries = 0;
+
+        if (descr->type == PAGE_GORILLA_METRICS) {
+            struct rrdeng_gorilla_page_header *header = page;
+            header->entries = 0;
+            gorilla_writer_init(&handle->gorilla, header->data,
+                                (RRDENG_BLOCK_SIZE - sizeof(*header)) / sizeof(uint32_t));
+        }
 
         handle->page_correlation_id = rrd_atomic_fetch_add(&pg_cache->committed_page_index.latest_corr_id, 1);
 
@@ -308,6 +326,12 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
         }
         break;
 
+        case PAGE_GORILLA_METRICS: {
+            // there is always room for one more value, rrdeng_collect_page_is_full() has checked it
+            gorilla_writer_write(&handle->gorilla, pack_storage_number(n, flags));
+        }
+        break;
+
         case PAGE_TIER: {
             storage_number_tier1_t number_tier1;
             number_tier1.sum_value = (float)n;
@@ -329,10 +353,17 @@ void rrdeng_store_metric_next(STORAGE_COLLECT_HANDLE *collection_handle,
         break;
     }
 
-    pg_cache_atomic_set_pg_info(descr, point_in_time, descr->page_length + PAGE_POINT_SIZE_BYTES(descr));
+    handle->page_entries++;
+
+    if (descr->type == PAGE_GORILLA_METRICS)
+        pg_cache_atomic_set_gorilla_pg_info(descr, point_in_time,
+                                            (uint32_t)sizeof(struct rrdeng_gorilla_page_header) + gorilla_writer_bytes(&handle->gorilla),
+                                            handle->gorilla.entries);
+    else
+        pg_cache_atomic_set_pg_info(descr, point_in_time, descr->page_length + PAGE_POINT_SIZE_BYTES(descr));
 
     if (perfect_page_alignment)
-        rd->rrdset->rrddim_page_alignment = descr->page_length;
+        rd->rrdset->rrddim_page_alignment = handle->page_entries * PAGE_POINT_SIZE_BYTES(descr);
     if (unlikely(INVALID_TIME == descr->start_time)) {
         unsigned long new_metric_API_producers, old_metric_API_max_producers, ret_metric_API_max_producers;
         descr->start_time = point_in_time;
@@ -420,10 +451,36 @@ void rrdeng_load_metric_init(STORAGE_METRIC_HANDLE *db_metric_handle, struct rrd
     handle->descr = NULL;
     rrdimm_handle->handle = (STORAGE_QUERY_HANDLE *)handle;
     pages_nr = pg_cache_preload(ctx, metric_handle->rrdeng_uuid, start_time * USEC_PER_SEC, end_time * USEC_PER_SEC,
-                                NULL, &handle->page_index);
+                                NULL, &handle->page_index, rrdeng_query_read_ahead ? &handle->preload_end_time : NULL);
     if (unlikely(NULL == handle->page_index || 0 == pages_nr))
         // there are no metrics to load
         handle->next_page_time = INVALID_TIME;
+    handle->preload_pages = pages_nr;
+    handle->preload_consumed = 0;
+}
+
+/*
+ * The first call of pg_cache_preload() stops after PAGE_CACHE_MAX_PRELOAD_PAGES pages have to be read from the disk.
+ * Once half of the preloaded pages have been consumed, the extents of the next pages are requested all together,
+ * so that the query does not have to wait for them one page at a time.
+ */
+static void rrdeng_load_read_ahead(struct rrddim_query_handle *rrdimm_handle)
+{
+    struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)rrdimm_handle->handle;
+    struct pg_cache_page_index *page_index;
+    usec_t end_time = rrdimm_handle->end_time * USEC_PER_SEC;
+
+    if (likely(!handle->preload_end_time || handle->preload_end_time >= end_time))
+        return;
+
+    if (++handle->preload_consumed < handle->preload_pages / 2)
+        return;
+
+    handle->preload_pages = pg_cache_preload(handle->ctx, &handle->page_index->id, handle->preload_end_time + 1,
+                                             end_time, NULL, &page_index, &handle->preload_end_time);
+    handle->preload_consumed = 0;
+    if (!handle->preload_pages)
+        handle->preload_end_time = end_time;
 }
 
 static int rrdeng_load_page_next(struct rrddim_query_handle *rrdimm_handle) {
@@ -432,7 +489,7 @@ static int rrdeng_load_page_next(struct rrddim_query_handle *rrdimm_handle) {
     struct rrdengine_instance *ctx = handle->ctx;
     struct rrdeng_page_descr *descr = handle->descr;
 
-    uint32_t page_length;
+    uint32_t page_length, entries;
     usec_t page_end_time;
     unsigned position;
 
@@ -451,6 +508,8 @@ static int rrdeng_load_page_next(struct rrddim_query_handle *rrdimm_handle) {
             return 1;
     }
 
+    rrdeng_load_read_ahead(rrdimm_handle);
+
     usec_t next_page_time = handle->next_page_time * USEC_PER_SEC;
     descr = pg_cache_lookup_next(ctx, handle->page_index, &handle->page_index->id, next_page_time, rrdimm_handle->end_time * USEC_PER_SEC);
     if (NULL == descr)
@@ -461,13 +520,17 @@ static int rrdeng_load_page_next(struct rrddim_query_handle *rrdimm_handle) {
 #endif
 
     handle->descr = descr;
-    pg_cache_atomic_get_pg_info(descr, &page_end_time, &page_length);
-    if (unlikely(INVALID_TIME == descr->start_time || INVALID_TIME == page_end_time))
+    if (descr->type == PAGE_GORILLA_METRICS)
+        pg_cache_atomic_get_gorilla_pg_info(descr, &page_end_time, &page_length, &entries);
+    else {
+        pg_cache_atomic_get_pg_info(descr, &page_end_time, &page_length);
+        entries = page_length / PAGE_POINT_SIZE_BYTES(descr);
+    }
+    if (unlikely(INVALID_TIME == descr->start_time || INVALID_TIME == page_end_time || !entries))
         return 1;
 
     if (unlikely(descr->start_time != page_end_time && next_page_time > descr->start_time)) {
         // we're in the middle of the page somewhere
-        unsigned entries = page_length / PAGE_POINT_SIZE_BYTES(descr);
         position = ((uint64_t)(next_page_time - descr->start_time)) * (entries - 1) /
                    (page_end_time - descr->start_time);
     }
@@ -477,7 +540,10 @@ static int rrdeng_load_page_next(struct rrddim_query_handle *rrdimm_handle) {
     handle->page_end_time = page_end_time;
     handle->page_length = page_length;
     handle->page = descr->pg_cache_descr->page;
-    usec_t entries = handle->entries = page_length / PAGE_POINT_SIZE_BYTES(descr);
+    handle->entries = entries;
+    if (descr->type == PAGE_GORILLA_METRICS)
+        gorilla_reader_init(&handle->gorilla, ((struct rrdeng_gorilla_page_header *)handle->page)->data);
+
     if (likely(entries > 1))
         handle->dt = (page_end_time - descr->start_time) / (entries - 1);
     else {
@@ -543,6 +609,19 @@ STORAGE_POINT rrdeng_load_metric_next(struct rrddim_query_handle *rrdimm_handle)
         }
         break;
 
+        case PAGE_GORILLA_METRICS: {
+            // values can only be decoded sequentially, positions never go backwards within a page
+            while (handle->gorilla.position <= position)
+                handle->gorilla_value = gorilla_reader_read(&handle->gorilla);
+
+            storage_number n = handle->gorilla_value;
+            sp.min = sp.max = sp.sum = unpack_storage_number(n);
+            sp.flags = n & SN_USER_FLAGS;
+            sp.count = 1;
+            sp.anomaly_count = is_storage_number_anomalous(n) ? 1 : 0;
+        }
+        break;
+
         case PAGE_TIER: {
             tier1_value = ((storage_number_tier1_t *)handle->page)[position];
             sp.flags = tier1_value.anomaly_count ? SN_FLAG_NONE : SN_FLAG_NOT_ANOMALOUS;
@@ -574,6 +653,61 @@ STORAGE_POINT rrdeng_load_metric_next(struct rrddim_query_handle *rrdimm_handle)
     return sp;
 }
 
+/*
+ * Loads up to max points, stopping when the query is finished. The points of a PAGE_METRICS page are
+ * unpacked in a single loop, everything else goes through rrdeng_load_metric_next().
+ * Returns the number of points loaded.
+ */
+size_t rrdeng_load_metric_next_batch(struct rrddim_query_handle *rrdimm_handle, STORAGE_POINT *points, size_t max)
+{
+    struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)rrdimm_handle->handle;
+    size_t count = 0;
+
+    while (count < max && INVALID_TIME != handle->next_page_time) {
+        struct rrdeng_page_descr *descr = handle->descr;
+        unsigned position = handle->position + 1;
+
+        if (unlikely(!descr || PAGE_METRICS != descr->type || position >= handle->entries)) {
+            points[count++] = rrdeng_load_metric_next(rrdimm_handle);
+            continue;
+        }
+
+        unsigned last = handle->entries;
+        if (last - position > max - count)
+            last = position + (unsigned)(max - count);
+
+        time_t dt_sec = handle->dt_sec;
+        time_t now = handle->now;
+        time_t end_time = rrdimm_handle->end_time;
+        storage_number *page = handle->page;
+
+        for ( ; position < last ; ++position) {
+            STORAGE_POINT *sp = &points[count++];
+            storage_number n = page[position];
+
+            now += dt_sec;
+            sp->start_time = now - dt_sec;
+            sp->end_time = now;
+            sp->min = sp->max = sp->sum = unpack_storage_number(n);
+            sp->flags = n & SN_USER_FLAGS;
+            sp->count = 1;
+            sp->anomaly_count = is_storage_number_anomalous(n) ? 1 : 0;
+
+            if (unlikely(now >= end_time)) {
+                // next calls will not load any more metrics
+                handle->next_page_time = INVALID_TIME;
+                ++position;
+                break;
+            }
+        }
+
+        handle->position = position - 1;
+        handle->now = now;
+    }
+
+    return count;
+}
+
 int rrdeng_load_metric_is_finished(struct rrddim_query_handle *rrdimm_handle)
 {
     struct rrdeng_query_handle *handle = (struct rrdeng_query_handle *)rrdimm_handle->handle;
@@ -616,9 +750,7 @@ time_t rrdeng_metric_oldest_time(STORAGE_METRIC_HANDLE *db_metric_handle) {
 
 int rrdeng_metric_latest_time_by_uuid(uuid_t *dim_uuid, time_t *first_entry_t, time_t *last_entry_t, int tier)
 {
-    struct page_cache *pg_cache;
     struct rrdengine_instance *ctx;
-    Pvoid_t *PValue;
     struct pg_cache_page_index *page_index = NULL;
 
     ctx = get_rrdeng_ctx_from_host(localhost, tier);
@@ -626,14 +758,7 @@ int rrdeng_metric_latest_time_by_uuid(uuid_t *dim_uuid, time_t *first_entry_t, t
         error("Failed to fetch multidb context");
         return 1;
     }
-    pg_cache = &ctx->pg_cache;
-
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, dim_uuid, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
+    page_index = pg_cache_find_page_index(ctx, dim_uuid);
 
     if (likely(page_index)) {
         *first_entry_t = page_index->oldest_time / USEC_PER_SEC;
@@ -646,9 +771,7 @@ int rrdeng_metric_latest_time_by_uuid(uuid_t *dim_uuid, time_t *first_entry_t, t
 
 int rrdeng_metric_retention_by_uuid(STORAGE_INSTANCE *si, uuid_t *dim_uuid, time_t *first_entry_t, time_t *last_entry_t)
 {
-    struct page_cache *pg_cache;
     struct rrdengine_instance *ctx;
-    Pvoid_t *PValue;
     struct pg_cache_page_index *page_index = NULL;
 
     ctx = (struct rrdengine_instance *)si;
@@ -656,14 +779,7 @@ int rrdeng_metric_retention_by_uuid(STORAGE_INSTANCE *si, uuid_t *dim_uuid, time
         error("DBENGINE: invalid STORAGE INSTANCE to %s()", __FUNCTION__);
         return 1;
     }
-    pg_cache = &ctx->pg_cache;
-
-    uv_rwlock_rdlock(&pg_cache->metrics_index.lock);
-    PValue = JudyHSGet(pg_cache->metrics_index.JudyHS_array, dim_uuid, sizeof(uuid_t));
-    if (likely(NULL != PValue)) {
-        page_index = *PValue;
-    }
-    uv_rwlock_rdunlock(&pg_cache->metrics_index.lock);
+    page_index = pg_cache_find_page_index(ctx, dim_uuid);
 
     if (likely(page_index)) {
         *first_entry_t = page_index->oldest_time / USEC_PER_SEC;
@@ -790,7 +906,7 @@ void *rrdeng_get_page(struct rrdengine_instance *ctx, uuid_t *id, usec_t point_i
  * You must not change the indices of the statistics or user code will break.
  * You must not exceed RRDENG_NR_STATS or it will crash.
  */
-void rrdeng_get_37_statistics(struct rrdengine_instance *ctx, unsigned long long *array)
+void rrdeng_get_39_statistics(struct rrdengine_instance *ctx, unsigned long long *array)
 {
     if (ctx == NULL)
         return;
@@ -834,7 +950,9 @@ void rrdeng_get_37_statistics(struct rrdengine_instance *ctx, unsigned long long
     array[34] = (uint64_t)global_pg_cache_over_half_dirty_events;
     array[35] = (uint64_t)ctx->stats.flushing_pressure_page_deletions;
     array[36] = (uint64_t)global_flushing_pressure_page_deletions;
-    fatal_assert(RRDENG_NR_STATS == 37);
+    array[37] = (uint64_t)ctx->stats.pg_cache_ghost_hits;
+    array[38] = (uint64_t)ctx->stats.pg_cache_promotions;
+    fatal_assert(RRDENG_NR_STATS == 39);
 }
 
 /* Releases reference to page */
@@ -877,7 +995,9 @@ int rrdeng_init(RRDHOST *host, struct rrdengine_instance **ctxp, char *dbfiles_p
     }
     ctx->tier = tier;
     ctx->page_type = tier_page_type[tier];
-    ctx->global_compress_alg = RRD_LZ4;
+    ctx->global_compress_alg = tier_compression_algorithm[tier];
+    ctx->compression_level = tier_compression_level[tier];
+    ctx->compression_dictionary = tier_compression_dictionary[tier];
     if (page_cache_mb < RRDENG_MIN_PAGE_CACHE_SIZE_MB)
         page_cache_mb = RRDENG_MIN_PAGE_CACHE_SIZE_MB;
     ctx->max_cache_pages = page_cache_mb * (1048576LU / RRDENG_BLOCK_SIZE);
@@ -901,6 +1021,7 @@ int rrdeng_init(RRDHOST *host, struct rrdengine_instance **ctxp, char *dbfiles_p
 
     memset(&ctx->worker_config, 0, sizeof(ctx->worker_config));
     ctx->worker_config.ctx = ctx;
+    ctx->pg_cache.eviction_policy = rrdeng_page_cache_eviction_policy;
     init_page_cache(ctx);
     init_commit_log(ctx);
     error = init_rrd_files(ctx);
@@ -988,10 +1109,12 @@ void rrdeng_prepare_exit(struct rrdengine_instance *ctx)
 RRDENG_SIZE_STATS rrdeng_size_statistics(struct rrdengine_instance *ctx) {
     RRDENG_SIZE_STATS stats = { 0 };
 
-    for(struct pg_cache_page_index *page_index = ctx->pg_cache.metrics_index.last_page_index;
-        page_index != NULL ;page_index = page_index->prev) {
-        stats.metrics++;
-        stats.metrics_pages += page_index->page_count;
+    for(int shard = 0; shard < PG_CACHE_SHARDS ;shard++) {
+        for(struct pg_cache_page_index *page_index = ctx->pg_cache.shards[shard].metrics_index.last_page_index;
+            page_index != NULL ;page_index = page_index->prev) {
+            stats.metrics++;
+            stats.metrics_pages += page_index->page_count;
+        }
     }
 
     for(struct rrdengine_datafile *df = ctx->datafiles.first; df ;df = df->next) {
@@ -1005,8 +1128,20 @@ RRDENG_SIZE_STATS rrdeng_size_statistics(struct rrdengine_instance *ctx) {
                 struct rrdeng_page_descr *descr = ei->pages[p];
 
                 usec_t update_every_usec;
+                size_t points;
 
-                size_t points = descr->page_length / PAGE_POINT_SIZE_BYTES(descr);
+                if(descr->type == PAGE_GORILLA_METRICS) {
+                    // the number of points is in the page header, which the descriptor keeps once it has been seen
+                    points = descr->entries;
+
+                    if(unlikely(!points)) {
+                        // the page has not been read since the agent started, estimate it from the default granularity
+                        usec_t default_update_every_usec = default_rrd_update_every * get_tier_grouping(ctx->tier) * USEC_PER_SEC;
+                        points = (descr->end_time - descr->start_time) / default_update_every_usec + 1;
+                    }
+                }
+                else
+                    points = descr->page_length / PAGE_POINT_SIZE_BYTES(descr);
 
                 if(likely(points > 1))
                     update_every_usec = (descr->end_time - descr->start_time) / (points - 1);
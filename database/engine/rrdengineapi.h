@@ -8,7 +8,7 @@
 #define RRDENG_MIN_PAGE_CACHE_SIZE_MB (8)
 #define RRDENG_MIN_DISK_SPACE_MB (64)
 
-#define RRDENG_NR_STATS (37)
+#define RRDENG_NR_STATS (39)
 
 #define RRDENG_FD_BUDGET_PER_INSTANCE (50)
 
@@ -19,7 +19,14 @@ extern int default_rrdeng_page_cache_mb;
 extern int default_rrdeng_disk_quota_mb;
 extern int default_multidb_disk_quota_mb;
 extern uint8_t rrdeng_drop_metrics_under_page_cache_pressure;
+extern uint8_t rrdeng_page_cache_eviction_policy;
+extern uint8_t rrdeng_use_io_uring;
+extern uint8_t rrdeng_query_read_ahead;
 extern struct rrdengine_instance *multidb_ctx[RRD_STORAGE_TIERS];
+extern uint8_t tier_page_type[RRD_STORAGE_TIERS];
+extern uint8_t tier_compression_algorithm[RRD_STORAGE_TIERS];
+extern int tier_compression_level[RRD_STORAGE_TIERS];
+extern uint8_t tier_compression_dictionary[RRD_STORAGE_TIERS];
 extern size_t page_type_size[];
 
 #define PAGE_POINT_SIZE_BYTES(x) page_type_size[(x)->type]
@@ -61,13 +68,14 @@ extern unsigned rrdeng_variable_step_boundaries(RRDSET *st, time_t start_time, t
 extern void rrdeng_load_metric_init(STORAGE_METRIC_HANDLE *db_metric_handle, struct rrddim_query_handle *rrdimm_handle,
                                     time_t start_time, time_t end_time, TIER_QUERY_FETCH tier_query_fetch_type);
 extern STORAGE_POINT rrdeng_load_metric_next(struct rrddim_query_handle *rrdimm_handle);
+extern size_t rrdeng_load_metric_next_batch(struct rrddim_query_handle *rrdimm_handle, STORAGE_POINT *points, size_t max);
 
 extern int rrdeng_load_metric_is_finished(struct rrddim_query_handle *rrdimm_handle);
 extern void rrdeng_load_metric_finalize(struct rrddim_query_handle *rrdimm_handle);
 extern time_t rrdeng_metric_latest_time(STORAGE_METRIC_HANDLE *db_metric_handle);
 extern time_t rrdeng_metric_oldest_time(STORAGE_METRIC_HANDLE *db_metric_handle);
 
-extern void rrdeng_get_37_statistics(struct rrdengine_instance *ctx, unsigned long long *array);
+extern void rrdeng_get_39_statistics(struct rrdengine_instance *ctx, unsigned long long *array);
 
 /* must call once before using anything */
 extern int rrdeng_init(RRDHOST *host, struct rrdengine_instance **ctxp, char *dbfiles_path, unsigned page_cache_mb,
@@ -143,6 +143,8 @@ char *get_rrdeng_statistics(struct rrdengine_instance *ctx, char *str, size_t si
               "page_cache_misses: %ld\n"
               "page_cache_backfills: %ld\n"
               "page_cache_evictions: %ld\n"
+              "page_cache_ghost_hits: %ld\n"
+              "page_cache_promotions: %ld\n"
               "compress_before_bytes: %ld\n"
               "compress_after_bytes: %ld\n"
               "decompress_before_bytes: %ld\n"
@@ -180,6 +182,8 @@ char *get_rrdeng_statistics(struct rrdengine_instance *ctx, char *str, size_t si
               (long)ctx->stats.pg_cache_misses,
               (long)ctx->stats.pg_cache_backfills,
               (long)ctx->stats.pg_cache_evictions,
+              (long)ctx->stats.pg_cache_ghost_hits,
+              (long)ctx->stats.pg_cache_promotions,
               (long)ctx->stats.before_compress_bytes,
               (long)ctx->stats.after_compress_bytes,
               (long)ctx->stats.before_decompress_bytes,
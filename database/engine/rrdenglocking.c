@@ -11,6 +11,8 @@ struct page_cache_descr *rrdeng_create_pg_cache_descr(struct rrdengine_instance
     pg_cache_descr->flags = 0;
     pg_cache_descr->prev = pg_cache_descr->next = NULL;
     pg_cache_descr->refcnt = 0;
+    pg_cache_descr->queue = PG_CACHE_QUEUE_NONE;
+    pg_cache_descr->referenced = 0;
     pg_cache_descr->waiters = 0;
     fatal_assert(0 == uv_cond_init(&pg_cache_descr->cond));
     fatal_assert(0 == uv_mutex_init(&pg_cache_descr->mutex));
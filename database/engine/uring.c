@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "rrdengine.h"
+
+/*
+ * io_uring submission path of the database engine.
+ *
+ * Requests are prepared while the event loop serves a batch of commands and are submitted together by
+ * rrdeng_uring_submit(), so that the extent reads of a query cost a single system call instead of a
+ * threadpool hop per extent. Completions are signaled through an eventfd that is polled by the event
+ * loop, so the completion callbacks run on the event loop thread like the libuv ones.
+ *
+ * Every function that prepares a request returns -1 when io_uring cannot take it, and the caller must
+ * use libuv instead. This happens when the build or the kernel lacks io_uring, or when the ring is full.
+ */
+
+#ifdef ENABLE_LIBURING
+
+struct rrdeng_uring_request {
+    rrdeng_uring_cb_t *cb;
+    void *data;
+};
+
+static void rrdeng_uring_reap(struct rrdengine_worker_config *wc, int wait)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    struct io_uring_cqe *cqe;
+    struct rrdeng_uring_request *req;
+    int ret, result;
+
+    while (uring->inflight) {
+        ret = wait ? io_uring_wait_cqe(&uring->ring, &cqe) : io_uring_peek_cqe(&uring->ring, &cqe);
+        if (-EINTR == ret)
+            continue;
+        if (ret < 0) {
+            if (-EAGAIN != ret)
+                error("DBENGINE: io_uring failed to get completions: %s", strerror(-ret));
+            break;
+        }
+        req = io_uring_cqe_get_data(cqe);
+        result = cqe->res;
+        io_uring_cqe_seen(&uring->ring, cqe);
+        --uring->inflight;
+
+        req->cb(wc, req->data, result);
+        freez(req);
+    }
+}
+
+static void rrdeng_uring_poll_cb(uv_poll_t *handle, int status, int events)
+{
+    struct rrdengine_worker_config *wc = handle->data;
+    eventfd_t value;
+
+    UNUSED(events);
+    if (unlikely(status < 0))
+        error("DBENGINE: io_uring eventfd poll failed: %s", uv_strerror(status));
+
+    /* clear the eventfd before reaping, so that new completions wake up the loop again */
+    (void)eventfd_read(wc->uring.eventfd, &value);
+    rrdeng_uring_reap(wc, 0);
+}
+
+static void rrdeng_uring_register_write_buffers(struct rrdeng_uring *uring)
+{
+    struct iovec iov[RRDENG_URING_WRITE_BUFFERS];
+    unsigned i;
+    int ret;
+
+    for (i = 0 ; i < RRDENG_URING_WRITE_BUFFERS ; ++i) {
+        ret = posix_memalign(&uring->write_buffers[i], RRDFILE_ALIGNMENT, RRDENG_URING_WRITE_BUFFER_SIZE);
+        if (unlikely(ret))
+            fatal("posix_memalign:%s", strerror(ret));
+        iov[i].iov_base = uring->write_buffers[i];
+        iov[i].iov_len = RRDENG_URING_WRITE_BUFFER_SIZE;
+    }
+
+    ret = io_uring_register_buffers(&uring->ring, iov, RRDENG_URING_WRITE_BUFFERS);
+    if (ret < 0) {
+        /* usually RLIMIT_MEMLOCK is too low, flushes will use regular buffers */
+        info("DBENGINE: io_uring cannot register write buffers: %s", strerror(-ret));
+        for (i = 0 ; i < RRDENG_URING_WRITE_BUFFERS ; ++i) {
+            free(uring->write_buffers[i]);
+            uring->write_buffers[i] = NULL;
+        }
+        return;
+    }
+    uring->write_buffers_free = (1U << RRDENG_URING_WRITE_BUFFERS) - 1;
+}
+
+void rrdeng_uring_init(struct rrdengine_worker_config *wc)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    int ret;
+
+    memset(uring, 0, sizeof(*uring));
+    uring->eventfd = -1;
+    if (!rrdeng_use_io_uring)
+        return;
+
+    ret = io_uring_queue_init(RRDENG_URING_DEPTH, &uring->ring, 0);
+    if (ret < 0) {
+        info("DBENGINE: io_uring is not available (%s), using libuv for disk I/O of tier %d.",
+             strerror(-ret), wc->ctx->tier);
+        return;
+    }
+
+    uring->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (uring->eventfd < 0) {
+        error("DBENGINE: cannot create eventfd for io_uring, using libuv for disk I/O of tier %d.", wc->ctx->tier);
+        goto error_after_queue_init;
+    }
+    ret = io_uring_register_eventfd(&uring->ring, uring->eventfd);
+    if (ret < 0) {
+        error("DBENGINE: cannot register eventfd to io_uring (%s), using libuv for disk I/O of tier %d.",
+              strerror(-ret), wc->ctx->tier);
+        goto error_after_eventfd;
+    }
+    ret = uv_poll_init(wc->loop, &uring->poll, uring->eventfd);
+    if (ret) {
+        error("uv_poll_init(): %s", uv_strerror(ret));
+        goto error_after_eventfd;
+    }
+    uring->poll.data = wc;
+    fatal_assert(0 == uv_poll_start(&uring->poll, UV_READABLE, rrdeng_uring_poll_cb));
+
+    rrdeng_uring_register_write_buffers(uring);
+    uring->enabled = 1;
+    info("DBENGINE: using io_uring for disk I/O of tier %d.", wc->ctx->tier);
+    return;
+
+error_after_eventfd:
+    close(uring->eventfd);
+    uring->eventfd = -1;
+error_after_queue_init:
+    io_uring_queue_exit(&uring->ring);
+}
+
+/* Waits for all in-flight requests, must be called before the last run of the event loop */
+void rrdeng_uring_shutdown(struct rrdengine_worker_config *wc)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    unsigned i;
+
+    if (!uring->enabled)
+        return;
+
+    rrdeng_uring_submit(wc);
+    rrdeng_uring_reap(wc, 1);
+
+    uv_poll_stop(&uring->poll);
+    uv_close((uv_handle_t *)&uring->poll, NULL);
+    io_uring_queue_exit(&uring->ring);
+    close(uring->eventfd);
+    uring->eventfd = -1;
+    for (i = 0 ; i < RRDENG_URING_WRITE_BUFFERS ; ++i) {
+        free(uring->write_buffers[i]);
+        uring->write_buffers[i] = NULL;
+    }
+    uring->write_buffers_free = 0;
+    uring->enabled = 0;
+}
+
+void rrdeng_uring_submit(struct rrdengine_worker_config *wc)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    int ret;
+
+    if (!uring->enabled || !uring->unsubmitted)
+        return;
+
+    do {
+        ret = io_uring_submit(&uring->ring);
+    } while (-EINTR == ret);
+    if (ret < 0)
+        fatal("DBENGINE: io_uring failed to submit %u requests: %s", uring->unsubmitted, strerror(-ret));
+    uring->unsubmitted = 0;
+}
+
+static struct io_uring_sqe *rrdeng_uring_get_sqe(struct rrdengine_worker_config *wc, rrdeng_uring_cb_t *cb, void *data)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    struct io_uring_sqe *sqe;
+    struct rrdeng_uring_request *req;
+
+    /* never have more requests in flight than the completion queue can hold */
+    if (!uring->enabled || uring->inflight >= RRDENG_URING_DEPTH)
+        return NULL;
+
+    sqe = io_uring_get_sqe(&uring->ring);
+    if (unlikely(!sqe))
+        return NULL;
+
+    req = mallocz(sizeof(*req));
+    req->cb = cb;
+    req->data = data;
+    io_uring_sqe_set_data(sqe, req);
+    ++uring->inflight;
+    ++uring->unsubmitted;
+
+    return sqe;
+}
+
+/* Returns 0 on success and -1 when the caller must use libuv */
+int rrdeng_uring_read(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                      rrdeng_uring_cb_t *cb, void *data)
+{
+    struct io_uring_sqe *sqe = rrdeng_uring_get_sqe(wc, cb, data);
+
+    if (!sqe)
+        return -1;
+    io_uring_prep_read(sqe, file, buf, size, pos);
+    return 0;
+}
+
+/*
+ * write_buffer is the index returned by rrdeng_uring_get_write_buffer() when buf is a registered buffer, or -1.
+ * Returns 0 on success and -1 when the caller must use libuv.
+ */
+int rrdeng_uring_write(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                       int write_buffer, rrdeng_uring_cb_t *cb, void *data)
+{
+    struct io_uring_sqe *sqe = rrdeng_uring_get_sqe(wc, cb, data);
+
+    if (!sqe)
+        return -1;
+    if (write_buffer >= 0)
+        io_uring_prep_write_fixed(sqe, file, buf, size, pos, write_buffer);
+    else
+        io_uring_prep_write(sqe, file, buf, size, pos);
+    return 0;
+}
+
+/*
+ * Returns a registered buffer of at least size bytes and sets write_buffer to its index,
+ * or returns NULL when there is none available.
+ */
+void *rrdeng_uring_get_write_buffer(struct rrdengine_worker_config *wc, size_t size, int *write_buffer)
+{
+    struct rrdeng_uring *uring = &wc->uring;
+    int i;
+
+    if (!uring->write_buffers_free || size > RRDENG_URING_WRITE_BUFFER_SIZE)
+        return NULL;
+
+    i = __builtin_ctz(uring->write_buffers_free);
+    uring->write_buffers_free &= ~(1U << i);
+    *write_buffer = i;
+    return uring->write_buffers[i];
+}
+
+void rrdeng_uring_put_write_buffer(struct rrdengine_worker_config *wc, int write_buffer)
+{
+    wc->uring.write_buffers_free |= 1U << write_buffer;
+}
+
+#else /* ENABLE_LIBURING */
+
+void rrdeng_uring_init(struct rrdengine_worker_config *wc)
+{
+    wc->uring.enabled = 0;
+}
+
+void rrdeng_uring_shutdown(struct rrdengine_worker_config *wc)
+{
+    UNUSED(wc);
+}
+
+void rrdeng_uring_submit(struct rrdengine_worker_config *wc)
+{
+    UNUSED(wc);
+}
+
+int rrdeng_uring_read(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                      rrdeng_uring_cb_t *cb, void *data)
+{
+    UNUSED(wc);
+    UNUSED(file);
+    UNUSED(buf);
+    UNUSED(size);
+    UNUSED(pos);
+    UNUSED(cb);
+    UNUSED(data);
+    return -1;
+}
+
+int rrdeng_uring_write(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                       int write_buffer, rrdeng_uring_cb_t *cb, void *data)
+{
+    UNUSED(wc);
+    UNUSED(file);
+    UNUSED(buf);
+    UNUSED(size);
+    UNUSED(pos);
+    UNUSED(write_buffer);
+    UNUSED(cb);
+    UNUSED(data);
+    return -1;
+}
+
+void *rrdeng_uring_get_write_buffer(struct rrdengine_worker_config *wc, size_t size, int *write_buffer)
+{
+    UNUSED(wc);
+    UNUSED(size);
+    UNUSED(write_buffer);
+    return NULL;
+}
+
+void rrdeng_uring_put_write_buffer(struct rrdengine_worker_config *wc, int write_buffer)
+{
+    UNUSED(wc);
+    UNUSED(write_buffer);
+}
+
+#endif /* ENABLE_LIBURING */
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_RRDENG_URING_H
+#define NETDATA_RRDENG_URING_H
+
+#include "rrdengine.h"
+
+#ifdef ENABLE_LIBURING
+#include <liburing.h>
+#include <sys/eventfd.h>
+#endif
+
+/* Forward declarations */
+struct rrdengine_worker_config;
+
+/* maximum number of in-flight io_uring requests per dbengine instance */
+#define RRDENG_URING_DEPTH (256)
+
+/* registered buffers for extent flushes, large enough for an uncompressible extent */
+#define RRDENG_URING_WRITE_BUFFERS (4)
+#define RRDENG_URING_WRITE_BUFFER_SIZE ((MAX_PAGES_PER_EXTENT + 2) * RRDENG_BLOCK_SIZE)
+
+/* called on the event loop thread with the number of bytes transferred, or a negative errno */
+typedef void rrdeng_uring_cb_t(struct rrdengine_worker_config *wc, void *data, int result);
+
+struct rrdeng_uring {
+#ifdef ENABLE_LIBURING
+    struct io_uring ring;
+    uv_poll_t poll; /* polls eventfd for completions */
+    int eventfd;
+    unsigned inflight; /* prepared and not completed yet */
+    unsigned unsubmitted; /* prepared and not submitted yet */
+
+    void *write_buffers[RRDENG_URING_WRITE_BUFFERS];
+    unsigned write_buffers_free; /* bitmap of the registered buffers not in use */
+#endif
+    uint8_t enabled; /* boolean */
+};
+
+extern void rrdeng_uring_init(struct rrdengine_worker_config *wc);
+extern void rrdeng_uring_shutdown(struct rrdengine_worker_config *wc);
+extern void rrdeng_uring_submit(struct rrdengine_worker_config *wc);
+extern int rrdeng_uring_read(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                             rrdeng_uring_cb_t *cb, void *data);
+extern int rrdeng_uring_write(struct rrdengine_worker_config *wc, uv_file file, void *buf, unsigned size, uint64_t pos,
+                              int write_buffer, rrdeng_uring_cb_t *cb, void *data);
+extern void *rrdeng_uring_get_write_buffer(struct rrdengine_worker_config *wc, size_t size, int *write_buffer);
+extern void rrdeng_uring_put_write_buffer(struct rrdengine_worker_config *wc, int write_buffer);
+
+#endif /* NETDATA_RRDENG_URING_H */
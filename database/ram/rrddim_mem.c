@@ -198,6 +198,15 @@ STORAGE_POINT rrddim_query_next_metric(struct rrddim_query_handle *handle) {
     return sp;
 }
 
+size_t rrddim_query_next_metrics(struct rrddim_query_handle *handle, STORAGE_POINT *points, size_t max) {
+    size_t count = 0;
+
+    while(count < max && !rrddim_query_is_finished(handle))
+        points[count++] = rrddim_query_next_metric(handle);
+
+    return count;
+}
+
 int rrddim_query_is_finished(struct rrddim_query_handle *handle) {
     struct mem_query_handle* h = (struct mem_query_handle*)handle->handle;
     return (h->next_timestamp > handle->end_time);
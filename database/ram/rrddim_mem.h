@@ -35,6 +35,7 @@ extern int rrddim_collect_finalize(STORAGE_COLLECT_HANDLE *collection_handle);
 
 extern void rrddim_query_init(STORAGE_METRIC_HANDLE *db_metric_handle, struct rrddim_query_handle *handle, time_t start_time, time_t end_time, TIER_QUERY_FETCH tier_query_fetch_type);
 extern STORAGE_POINT rrddim_query_next_metric(struct rrddim_query_handle *handle);
+extern size_t rrddim_query_next_metrics(struct rrddim_query_handle *handle, STORAGE_POINT *points, size_t max);
 extern int rrddim_query_is_finished(struct rrddim_query_handle *handle);
 extern void rrddim_query_finalize(struct rrddim_query_handle *handle);
 extern time_t rrddim_query_latest_time(STORAGE_METRIC_HANDLE *db_metric_handle);
@@ -47,6 +47,7 @@ struct pg_cache_page_index;
 #include "rrddimvar.h"
 #include "rrdcalc.h"
 #include "rrdcalctemplate.h"
+#include "rrdcalcwindow.h"
 #include "streaming/rrdpush.h"
 #include "aclk/aclk_rrdhost_state.h"
 #include "sqlite/sqlite_health.h"
@@ -268,6 +269,7 @@ struct rrddim {
 
     bool updated;                                   // 1 when the dimension has been updated since the last processing
     bool exposed;                                   // 1 when set what have sent this dimension to the central netdata
+    uint32_t upstream_slot;                         // the slot of this dimension in binary streaming frames
 
     collected_number multiplier;                    // the multiplier of the collected values
     collected_number divisor;                       // the divider of the collected values
@@ -422,6 +424,11 @@ struct rrddim_query_ops {
     // run this to load each metric number from the database
     STORAGE_POINT (*next_metric)(struct rrddim_query_handle *handle);
 
+    // run this to load up to max metric numbers from the database at once
+    // it stops early when the query is finished, and returns the number of points loaded
+    // optional, when it is NULL next_metric() is used
+    size_t (*next_metrics)(struct rrddim_query_handle *handle, STORAGE_POINT *points, size_t max);
+
     // run this to test if the series of next_metric() database queries is finished
     int (*is_finished)(struct rrddim_query_handle *handle);
 
@@ -500,6 +507,7 @@ typedef enum rrdset_flags {
 
     RRDSET_FLAG_ANOMALY_RATE_CHART      = (1 << 21), // the rrdset is for storing anomaly rates for all dimensions
     RRDSET_FLAG_PENDING_HEALTH_INITIALIZATION = (1 << 22),
+    RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS = (1 << 23), // the parent replicates the history of this chart, do not stream its metrics
 } RRDSET_FLAGS;
 
 #define rrdset_flag_check(st, flag) (__atomic_load_n(&((st)->flags), __ATOMIC_SEQ_CST) & (flag))
@@ -588,6 +596,7 @@ struct rrdset {
     // data collection - streaming to parents, temp variables
 
     time_t upstream_resync_time;                    // the timestamp up to which we should resync clock upstream
+    uint32_t upstream_slot;                         // the slot of this chart in binary streaming frames, 0 = unset or sent as text
 
     // ------------------------------------------------------------------------
     // context queries temp variables
@@ -642,6 +651,7 @@ struct rrdset {
     struct {
         netdata_rwlock_t rwlock;                    // protection for RRDCALC *base
         RRDCALC *base;                              // double linked list of RRDCALC related to this RRDSET
+        size_t windows;                             // the number of RRDCALCs in base with a sliding window
     } alerts;
 };
 
@@ -1251,6 +1261,7 @@ extern void rrddim_isnot_obsolete(RRDSET *st, RRDDIM *rd);
 
 extern collected_number rrddim_set_by_pointer(RRDSET *st, RRDDIM *rd, collected_number value);
 extern collected_number rrddim_set(RRDSET *st, const char *id, collected_number value);
+extern void rrddim_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n, SN_FLAGS flags);
 #ifdef ENABLE_ACLK
 extern time_t calc_dimension_liveness(RRDDIM *rd, time_t now);
 #endif
@@ -179,6 +179,9 @@ static void rrdcalc_link_to_rrdset(RRDSET *st, RRDCALC *rc) {
     rc->rrdset = st;
 
     netdata_rwlock_wrlock(&st->alerts.rwlock);
+    rrdcalc_window_create(rc, st);
+    if(rc->window)
+        st->alerts.windows++;
     DOUBLE_LINKED_LIST_APPEND_UNSAFE(st->alerts.base, rc, prev, next);
     netdata_rwlock_unlock(&st->alerts.rwlock);
 
@@ -326,9 +329,17 @@ static void rrdcalc_unlink_from_rrdset(RRDCALC *rc, bool having_ll_wrlock) {
 
     DOUBLE_LINKED_LIST_REMOVE_UNSAFE(st->alerts.base, rc, prev, next);
 
+    // nobody can be using the window while we hold the write lock
+    struct rrdcalc_window *window = rc->window;
+    rc->window = NULL;
+    if(window)
+        st->alerts.windows--;
+
     if(!having_ll_wrlock)
         netdata_rwlock_unlock(&st->alerts.rwlock);
 
+    rrdcalc_window_free(window);
+
     rc->rrdset = NULL;
 
     rrdvar_release_and_del(st->rrdvars, rc->rrdvar_local);
@@ -343,6 +354,11 @@ static void rrdcalc_unlink_from_rrdset(RRDCALC *rc, bool having_ll_wrlock) {
     rrdvar_release_and_del(host->rrdvars, rc->rrdvar_host_chart_name);
     rc->rrdvar_host_chart_name = NULL;
 
+    // the expressions keep the variables of the chart acquired
+    expression_release_variables(rc->calculation);
+    expression_release_variables(rc->warning);
+    expression_release_variables(rc->critical);
+
     // RRDCALC will remain in RRDHOST
     // so that if the matching chart is found in the future
     // it will be applied automatically
@@ -148,6 +148,8 @@ struct rrdcalc {
     size_t labels_version;
     struct rrdset *rrdset;
 
+    struct rrdcalc_window *window;  // the sliding window aggregates of the lookup, when eligible
+
     struct rrdcalc *next;
     struct rrdcalc *prev;
 };
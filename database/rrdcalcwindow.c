@@ -0,0 +1,593 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrd.h"
+
+// ----------------------------------------------------------------------------
+// sliding window aggregates of alarm lookups
+//
+// Every eligible RRDCALC gets a ring of the last points of each dimension
+// it needs, indexed by (point time / update every) % points. The collectors
+// feed the rings from rrddim_store_metric(), keeping a running sum and count
+// for average and sum, and a monotonic deque for min and max, so that the
+// health thread gets the value of the lookup in O(dimensions).
+//
+// The value is calculated the way rrd2rrdr() and rrdr2value() do it for the
+// same lookup. When a ring cannot answer (it has not seen the whole window
+// yet, or points were stored out of order, e.g. by replication), the lookup
+// falls back to the database.
+//
+// The rings of all the alarms share a memory budget. A dimension that does
+// not fit in it gets no ring, and its alarms keep querying the database.
+
+int rrdcalc_windows_enabled = CONFIG_BOOLEAN_NO;
+long rrdcalc_windows_max_points = 3600;
+size_t rrdcalc_windows_max_memory = 32 * 1024 * 1024;
+
+static size_t rrdcalc_windows_memory = 0;       // the bytes of all the rings, updated atomically
+
+size_t rrdcalc_windows_memory_used(void) {
+    return __atomic_load_n(&rrdcalc_windows_memory, __ATOMIC_RELAXED);
+}
+
+#define RRDCALC_WINDOW_SUPPORTED_OPTIONS (RRDR_OPTION_NOT_ALIGNED | RRDR_OPTION_ABSOLUTE | RRDR_OPTION_PERCENTAGE | \
+                                          RRDR_OPTION_MIN2MAX | RRDR_OPTION_MATCH_IDS | RRDR_OPTION_MATCH_NAMES)
+
+struct rrdcalc_window_dim {
+    RRDDIM *rd;
+    bool tracked;                   // false when the dimension does not participate in the lookup
+
+    time_t first_t;                 // the first point in the ring since the last reset, 0 when empty
+    time_t last_t;                  // the last point fed to the ring
+
+    NETDATA_DOUBLE *values;         // the ring of points, NAN for gaps
+
+    NETDATA_DOUBLE sum;             // the sum of the numbers in the ring
+    size_t count;                   // the number of numbers in the ring
+    size_t evictions;               // evictions since sum was recalculated
+
+    time_t *deque;                  // the times of the min or max candidates, oldest first
+    size_t deque_head;
+    size_t deque_len;
+
+    // the grouped value of the last lookup
+    NETDATA_DOUBLE result;
+    bool result_empty;
+    bool result_hidden;
+
+    struct rrdcalc_window_dim *next;
+};
+
+struct rrdcalc_window {
+    netdata_mutex_t mutex;
+
+    RRDR_GROUPING group;
+    RRDR_OPTIONS options;
+    int update_every;               // the update every of the chart when the window was created
+    size_t points;                  // the points of the window
+
+    SIMPLE_PATTERN *pattern;        // the dimensions of the lookup, or NULL for all the visible ones
+    bool match_ids;
+    bool match_names;
+
+    struct rrdcalc_window_dim *dims;
+    struct rrdcalc_window_dim *hint; // the dimension fed last, to find the next one quickly
+};
+
+// the number of points rrd2rrdr() groups for a relative unaligned lookup with 1 point
+static inline size_t rrdcalc_window_points(int after, int update_every) {
+    time_t duration = -after - 1;
+    if(duration % update_every)
+        duration += update_every - duration % update_every;
+
+    long points = (duration + 1) / update_every;
+    return (points > 0) ? (size_t)points : 1;
+}
+
+static inline bool rrdcalc_window_is_eligible(RRDCALC *rc, RRDSET *st) {
+    if(!rrdcalc_windows_enabled)
+        return false;
+
+    if(rc->before != 0 || rc->after >= 0)
+        return false;
+
+    if(!(rc->options & RRDR_OPTION_NOT_ALIGNED))
+        return false;
+
+    if(rc->options & ~(RRDCALC_WINDOW_SUPPORTED_OPTIONS | RRDCALC_ALL_OPTIONS_EXCLUDING_THE_RRDR_ONES))
+        return false;
+
+    switch(rc->group) {
+        case RRDR_GROUPING_AVERAGE:
+        case RRDR_GROUPING_MIN:
+        case RRDR_GROUPING_MAX:
+        case RRDR_GROUPING_SUM:
+            break;
+
+        default:
+            return false;
+    }
+
+    if(st->update_every <= 0 || st->rrd_memory_mode == RRD_MEMORY_MODE_NONE)
+        return false;
+
+    return rrdcalc_window_points(rc->after, st->update_every) <= (size_t)rrdcalc_windows_max_points;
+}
+
+void rrdcalc_window_create(RRDCALC *rc, RRDSET *st) {
+    if(!rrdcalc_window_is_eligible(rc, st))
+        return;
+
+    struct rrdcalc_window *w = callocz(1, sizeof(struct rrdcalc_window));
+    netdata_mutex_init(&w->mutex);
+    w->group = rc->group;
+    w->options = (RRDR_OPTIONS)(rc->options & ~RRDCALC_ALL_OPTIONS_EXCLUDING_THE_RRDR_ONES);
+    w->update_every = st->update_every;
+    w->points = rrdcalc_window_points(rc->after, st->update_every);
+
+    const char *dimensions = rrdcalc_dimensions(rc);
+    if(dimensions && *dimensions) {
+        w->pattern = simple_pattern_create(dimensions, ",|\t\r\n\f\v", SIMPLE_PATTERN_EXACT);
+        w->match_ids = (rc->options & RRDR_OPTION_MATCH_IDS);
+        w->match_names = (rc->options & RRDR_OPTION_MATCH_NAMES);
+        if(!w->match_ids && !w->match_names)
+            w->match_ids = w->match_names = true;
+    }
+
+    rc->window = w;
+}
+
+static inline size_t rrdcalc_window_dim_memory(struct rrdcalc_window *w) {
+    size_t bytes = w->points * sizeof(NETDATA_DOUBLE);
+
+    if(w->group == RRDR_GROUPING_MIN || w->group == RRDR_GROUPING_MAX)
+        bytes += w->points * sizeof(time_t);
+
+    return bytes;
+}
+
+static void rrdcalc_window_dim_free(struct rrdcalc_window *w, struct rrdcalc_window_dim *d) {
+    if(d->values)
+        __atomic_sub_fetch(&rrdcalc_windows_memory, rrdcalc_window_dim_memory(w), __ATOMIC_RELAXED);
+
+    freez(d->values);
+    freez(d->deque);
+    freez(d);
+}
+
+void rrdcalc_window_free(struct rrdcalc_window *w) {
+    if(!w) return;
+
+    while(w->dims) {
+        struct rrdcalc_window_dim *d = w->dims;
+        w->dims = d->next;
+        rrdcalc_window_dim_free(w, d);
+    }
+
+    simple_pattern_free(w->pattern);
+    netdata_mutex_destroy(&w->mutex);
+    freez(w);
+}
+
+// ----------------------------------------------------------------------------
+// the ring of a dimension
+
+// the dimensions rrd2rrdr() hides are not needed, unless the lookup is a percentage of all of them
+static inline bool rrdcalc_window_dim_is_hidden(struct rrdcalc_window *w, RRDDIM *rd) {
+    if(w->pattern)
+        return !((w->match_ids && simple_pattern_matches(w->pattern, rrddim_id(rd))) ||
+                 (w->match_names && simple_pattern_matches(w->pattern, rrddim_name(rd))));
+
+    return rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN);
+}
+
+static inline bool rrdcalc_window_dim_is_needed(struct rrdcalc_window *w, bool hidden) {
+    return !hidden || (w->options & RRDR_OPTION_PERCENTAGE);
+}
+
+static struct rrdcalc_window_dim *rrdcalc_window_dim_find(struct rrdcalc_window *w, RRDDIM *rd) {
+    // the collectors store the dimensions in the same order every time,
+    // so the one we need is usually the one after the last one
+    struct rrdcalc_window_dim *d;
+    if(likely(w->hint)) {
+        d = w->hint->next ? w->hint->next : w->dims;
+        if(likely(d->rd == rd))
+            return (w->hint = d);
+    }
+
+    for(d = w->dims; d ; d = d->next)
+        if(d->rd == rd)
+            return (w->hint = d);
+
+    return NULL;
+}
+
+static struct rrdcalc_window_dim *rrdcalc_window_dim_add(struct rrdcalc_window *w, RRDDIM *rd) {
+    struct rrdcalc_window_dim *d = callocz(1, sizeof(struct rrdcalc_window_dim));
+    d->rd = rd;
+    d->tracked = rrdcalc_window_dim_is_needed(w, rrdcalc_window_dim_is_hidden(w, rd));
+
+    // keep the order of the collectors
+    struct rrdcalc_window_dim **last = &w->dims;
+    while(*last) last = &(*last)->next;
+    *last = d;
+
+    return (w->hint = d);
+}
+
+static void rrdcalc_window_dim_reset(struct rrdcalc_window *w, struct rrdcalc_window_dim *d) {
+    if(d->values) {
+        for(size_t i = 0; i < w->points; i++)
+            d->values[i] = NAN;
+    }
+
+    d->first_t = 0;
+    d->sum = 0.0;
+    d->count = 0;
+    d->evictions = 0;
+    d->deque_head = 0;
+    d->deque_len = 0;
+}
+
+// returns false when the ring does not fit in the memory of the windows
+static inline bool rrdcalc_window_dim_allocate(struct rrdcalc_window *w, struct rrdcalc_window_dim *d) {
+    size_t bytes = rrdcalc_window_dim_memory(w);
+
+    size_t memory = __atomic_add_fetch(&rrdcalc_windows_memory, bytes, __ATOMIC_RELAXED);
+    if(unlikely(memory > rrdcalc_windows_max_memory)) {
+        __atomic_sub_fetch(&rrdcalc_windows_memory, bytes, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    d->values = mallocz(w->points * sizeof(NETDATA_DOUBLE));
+
+    if(w->group == RRDR_GROUPING_MIN || w->group == RRDR_GROUPING_MAX)
+        d->deque = mallocz(w->points * sizeof(time_t));
+
+    rrdcalc_window_dim_reset(w, d);
+    return true;
+}
+
+static inline size_t rrdcalc_window_slot(struct rrdcalc_window *w, time_t t) {
+    return (size_t)(t / w->update_every) % w->points;
+}
+
+// remove the point that is at the position of time t from the ring
+static inline void rrdcalc_window_dim_evict(struct rrdcalc_window *w, struct rrdcalc_window_dim *d, time_t t) {
+    NETDATA_DOUBLE *v = &d->values[rrdcalc_window_slot(w, t)];
+
+    if(netdata_double_isnumber(*v)) {
+        d->sum -= *v;
+        d->count--;
+
+        // recalculate the sum once in a while, so that rounding errors do not accumulate
+        if(unlikely(++d->evictions >= w->points)) {
+            *v = NAN;
+            d->sum = 0.0;
+            for(size_t i = 0; i < w->points; i++)
+                if(netdata_double_isnumber(d->values[i]))
+                    d->sum += d->values[i];
+            d->evictions = 0;
+        }
+    }
+
+    *v = NAN;
+}
+
+// move the end of the ring to time t, evicting all the points that are older than the window
+static void rrdcalc_window_dim_advance(struct rrdcalc_window *w, struct rrdcalc_window_dim *d, time_t t) {
+    if(unlikely(!d->first_t))
+        return;
+
+    time_t update_every = w->update_every;
+    time_t duration = (time_t)w->points * update_every;
+
+    if(unlikely(t - d->last_t >= duration)) {
+        // the whole ring is older than the window
+        time_t first_t = d->first_t;
+        rrdcalc_window_dim_reset(w, d);
+        d->first_t = first_t;
+    }
+    else {
+        for(time_t s = d->last_t + update_every; s <= t; s += update_every)
+            rrdcalc_window_dim_evict(w, d, s);
+    }
+
+    // the min and max candidates that fell out of the window
+    while(d->deque_len && d->deque[d->deque_head] <= t - duration) {
+        d->deque_head = (d->deque_head + 1) % w->points;
+        d->deque_len--;
+    }
+
+    d->last_t = t;
+}
+
+// rrd2rrdr() compares absolute values for min and max, keeping the oldest on ties
+static inline void rrdcalc_window_dim_deque_push(struct rrdcalc_window *w, struct rrdcalc_window_dim *d, time_t t, NETDATA_DOUBLE n) {
+    NETDATA_DOUBLE an = fabsndd(n);
+
+    while(d->deque_len) {
+        size_t last = (d->deque_head + d->deque_len - 1) % w->points;
+        NETDATA_DOUBLE av = fabsndd(d->values[rrdcalc_window_slot(w, d->deque[last])]);
+
+        if(w->group == RRDR_GROUPING_MAX ? (av < an) : (av > an))
+            d->deque_len--;
+        else
+            break;
+    }
+
+    d->deque[(d->deque_head + d->deque_len) % w->points] = t;
+    d->deque_len++;
+}
+
+static void rrdcalc_window_dim_store(struct rrdcalc_window *w, struct rrdcalc_window_dim *d, time_t t, NETDATA_DOUBLE n) {
+    if(unlikely(t % w->update_every)) {
+        if(d->first_t)
+            rrdcalc_window_dim_reset(w, d);
+        return;
+    }
+
+    if(unlikely(d->first_t && t <= d->last_t)) {
+        // a point older than the ones we have, the database has points we do not know
+        rrdcalc_window_dim_reset(w, d);
+        return;
+    }
+
+    if(unlikely(!d->first_t)) {
+        if(t <= d->last_t)
+            return;
+
+        d->first_t = t;
+    }
+    else
+        rrdcalc_window_dim_advance(w, d, t);
+
+    d->last_t = t;
+
+    if(netdata_double_isnumber(n)) {
+        d->values[rrdcalc_window_slot(w, t)] = n;
+        d->sum += n;
+        d->count++;
+
+        if(d->deque)
+            rrdcalc_window_dim_deque_push(w, d, t, n);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// feeding the windows, called by the collectors for every point they store
+
+static inline void rrdcalc_window_store_metric(struct rrdcalc_window *w, RRDDIM *rd, time_t t, NETDATA_DOUBLE n) {
+    netdata_mutex_lock(&w->mutex);
+
+    struct rrdcalc_window_dim *d = rrdcalc_window_dim_find(w, rd);
+    if(unlikely(!d))
+        d = rrdcalc_window_dim_add(w, rd);
+
+    if(likely(d->tracked)) {
+        if(unlikely(!d->values && !rrdcalc_window_dim_allocate(w, d))) {
+            // without a ring the lookup queries the database
+            d->tracked = false;
+        }
+        else if(unlikely(rd->update_every != w->update_every))
+            rrdcalc_window_dim_reset(w, d);
+        else
+            rrdcalc_window_dim_store(w, d, t, n);
+    }
+
+    netdata_mutex_unlock(&w->mutex);
+}
+
+void rrdcalc_windows_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n, SN_FLAGS flags) {
+    RRDSET *st = rd->rrdset;
+
+    // the windows need the value as the database will return it
+    storage_number sn = pack_storage_number(n, flags);
+    n = does_storage_number_exist(sn) ? unpack_storage_number(sn) : NAN;
+
+    time_t t = (time_t)(point_end_time_ut / USEC_PER_SEC);
+
+    RRDCALC *rc;
+    netdata_rwlock_rdlock(&st->alerts.rwlock);
+    DOUBLE_LINKED_LIST_FOREACH_FORWARD(st->alerts.base, rc, prev, next) {
+        if(rc->window)
+            rrdcalc_window_store_metric(rc->window, rd, t, n);
+    }
+    netdata_rwlock_unlock(&st->alerts.rwlock);
+}
+
+void rrdcalc_windows_delete_rrddim(RRDDIM *rd) {
+    RRDSET *st = rd->rrdset;
+    if(!st->alerts.windows)
+        return;
+
+    RRDCALC *rc;
+    netdata_rwlock_rdlock(&st->alerts.rwlock);
+    DOUBLE_LINKED_LIST_FOREACH_FORWARD(st->alerts.base, rc, prev, next) {
+        struct rrdcalc_window *w = rc->window;
+        if(!w) continue;
+
+        netdata_mutex_lock(&w->mutex);
+        struct rrdcalc_window_dim *d, *last = NULL;
+        for(d = w->dims; d ; last = d, d = d->next) {
+            if(d->rd != rd) continue;
+
+            if(last) last->next = d->next;
+            else w->dims = d->next;
+
+            if(w->hint == d) w->hint = NULL;
+
+            rrdcalc_window_dim_free(w, d);
+            break;
+        }
+        netdata_mutex_unlock(&w->mutex);
+    }
+    netdata_rwlock_unlock(&st->alerts.rwlock);
+}
+
+// ----------------------------------------------------------------------------
+// the lookup, called by the health thread
+
+static inline NETDATA_DOUBLE rrdcalc_window_dim_value(struct rrdcalc_window *w, struct rrdcalc_window_dim *d, bool *empty) {
+    *empty = false;
+
+    switch(w->group) {
+        case RRDR_GROUPING_AVERAGE:
+            if(d->count)
+                return d->sum / (NETDATA_DOUBLE)d->count;
+            break;
+
+        case RRDR_GROUPING_SUM:
+            if(d->count)
+                return d->sum;
+            break;
+
+        case RRDR_GROUPING_MIN:
+        case RRDR_GROUPING_MAX:
+            if(d->deque_len)
+                return d->values[rrdcalc_window_slot(w, d->deque[d->deque_head])];
+            break;
+
+        default:
+            break;
+    }
+
+    *empty = true;
+    return 0.0;
+}
+
+// returns false when the window cannot give the value and the database has to be queried
+static bool rrdcalc_window_dims_group(struct rrdcalc_window *w, RRDSET *st, time_t before) {
+    time_t after = before - (time_t)(w->points - 1) * w->update_every;
+    bool ok = true;
+
+    RRDDIM *rd;
+    for(rd = st->dimensions; rd ; rd = rd->next) {
+        bool hidden = rrdcalc_window_dim_is_hidden(w, rd);
+        struct rrdcalc_window_dim *d = rrdcalc_window_dim_find(w, rd);
+
+        if(!rrdcalc_window_dim_is_needed(w, hidden)) {
+            if(d) d->result_hidden = true;
+            continue;
+        }
+
+        if(unlikely(!d || !d->tracked)) {
+            // a dimension that became visible, or the collector has not stored it yet
+            if(d) d->tracked = true;
+            ok = false;
+            continue;
+        }
+
+        if(unlikely(!d->first_t || d->first_t > after || d->last_t > before)) {
+            ok = false;
+            continue;
+        }
+
+        if(d->last_t < before)
+            rrdcalc_window_dim_advance(w, d, before);
+
+        d->result = rrdcalc_window_dim_value(w, d, &d->result_empty);
+        d->result_hidden = hidden;
+    }
+
+    return ok;
+}
+
+bool rrdcalc_window_lookup(RRDCALC *rc, NETDATA_DOUBLE *value, time_t *db_after, time_t *db_before, int *value_is_null) {
+    RRDSET *st = rc->rrdset;
+    if(!st || !rc->window)
+        return false;
+
+    time_t before = rrdset_last_entry_t(st);
+
+    bool ret = false;
+
+    rrdset_rdlock(st);
+    netdata_rwlock_rdlock(&st->alerts.rwlock);
+
+    struct rrdcalc_window *w = rc->window;
+    if(unlikely(!w || w->update_every != st->update_every || before <= 0))
+        goto cleanup;
+
+    netdata_mutex_lock(&w->mutex);
+
+    before -= before % w->update_every;
+    if(!rrdcalc_window_dims_group(w, st, before)) {
+        netdata_mutex_unlock(&w->mutex);
+        goto cleanup;
+    }
+
+    // combine the dimensions, the way rrdr2value() does it
+    RRDR_OPTIONS options = w->options;
+    NETDATA_DOUBLE sum = 0, min = 0, max = 0, total = 1;
+    bool all_null = true, init = true;
+    RRDDIM *rd;
+
+    if(unlikely(options & RRDR_OPTION_PERCENTAGE)) {
+        total = 0;
+        for(rd = st->dimensions; rd ; rd = rd->next) {
+            struct rrdcalc_window_dim *d = rrdcalc_window_dim_find(w, rd);
+            NETDATA_DOUBLE n = d->result;
+
+            if((options & RRDR_OPTION_ABSOLUTE) && n < 0)
+                n = -n;
+
+            total += n;
+        }
+        // prevent a division by zero
+        if(total == 0) total = 1;
+    }
+
+    for(rd = st->dimensions; rd ; rd = rd->next) {
+        struct rrdcalc_window_dim *d = rrdcalc_window_dim_find(w, rd);
+        if(!d || d->result_hidden) continue;
+
+        NETDATA_DOUBLE n = d->result;
+
+        if((options & RRDR_OPTION_ABSOLUTE) && n < 0)
+            n = -n;
+
+        if(unlikely(options & RRDR_OPTION_PERCENTAGE))
+            n = n * 100 / total;
+
+        if(unlikely(init)) {
+            if(n > 0) {
+                min = 0;
+                max = n;
+            }
+            else {
+                min = n;
+                max = 0;
+            }
+            init = false;
+        }
+
+        if(!d->result_empty) {
+            all_null = false;
+            sum += n;
+        }
+
+        if(n < min) min = n;
+        if(n > max) max = n;
+    }
+
+    netdata_mutex_unlock(&w->mutex);
+
+    *db_before = before;
+    *db_after = before - (time_t)(w->points - 1) * w->update_every;
+
+    if(all_null) {
+        *value_is_null = 1;
+        *value = 0;
+    }
+    else {
+        *value_is_null = 0;
+        *value = (options & RRDR_OPTION_MIN2MAX) ? max - min : sum;
+    }
+
+    ret = true;
+
+cleanup:
+    netdata_rwlock_unlock(&st->alerts.rwlock);
+    rrdset_unlock(st);
+    return ret;
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_RRDCALCWINDOW_H
+#define NETDATA_RRDCALCWINDOW_H 1
+
+#include "rrd.h"
+
+// sliding window aggregates of alarm lookups
+// Alarms with a lookup on a relative window that ends at the last collected
+// point (like "average -10m unaligned") are fed with the points the
+// collectors store, so that the health thread can get their value without
+// querying the database.
+
+extern int rrdcalc_windows_enabled;
+extern long rrdcalc_windows_max_points;
+extern size_t rrdcalc_windows_max_memory;
+
+extern size_t rrdcalc_windows_memory_used(void);
+
+extern void rrdcalc_window_create(RRDCALC *rc, RRDSET *st);
+extern void rrdcalc_window_free(struct rrdcalc_window *w);
+
+extern void rrdcalc_windows_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n, SN_FLAGS flags);
+extern void rrdcalc_windows_delete_rrddim(RRDDIM *rd);
+
+extern bool rrdcalc_window_lookup(RRDCALC *rc, NETDATA_DOUBLE *value, time_t *db_after, time_t *db_before, int *value_is_null);
+
+#endif //NETDATA_RRDCALCWINDOW_H
@@ -199,6 +199,7 @@ static void rrddim_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
     }
 
     rrddimvar_delete_all(rd);
+    rrdcalc_windows_delete_rrddim(rd);
 
     // free(rd->annotations);
     //#ifdef ENABLE_ACLK
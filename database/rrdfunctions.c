@@ -340,6 +340,14 @@ void rrd_collector_finished(void) {
     thread_rrd_collector = NULL;
 }
 
+// makes rdc the collector of the calling thread and returns the one it had,
+// for threads that serve multiple collectors, each with its own structure
+struct rrd_collector *rrd_collector_switch(struct rrd_collector *rdc) {
+    struct rrd_collector *old = thread_rrd_collector;
+    thread_rrd_collector = rdc;
+    return old;
+}
+
 static struct rrd_collector *rrd_collector_acquire(void) {
     __atomic_add_fetch(&thread_rrd_collector->refcount, 1, __ATOMIC_SEQ_CST);
     return thread_rrd_collector;
@@ -6,8 +6,11 @@
 extern void rrdfunctions_init(RRDHOST *host);
 extern void rrdfunctions_destroy(RRDHOST *host);
 
+struct rrd_collector;
+
 extern void rrd_collector_started(void);
 extern void rrd_collector_finished(void);
+extern struct rrd_collector *rrd_collector_switch(struct rrd_collector *rdc);
 
 typedef void (*function_data_ready_callback)(BUFFER *wb, int code, void *callback_data);
 
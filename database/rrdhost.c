@@ -220,6 +220,7 @@ static void rrdhost_initialize_rrdpush_sender(RRDHOST *host,
 
         host->rrdpush_send_destination = strdupz(rrdpush_destination);
         rrdpush_destinations_init(host);
+        sender_fan_out_init(host);
 
         host->rrdpush_send_api_key = strdupz(rrdpush_api_key);
         host->rrdpush_send_charts_matching = simple_pattern_create(rrdpush_send_charts_matching, NULL, SIMPLE_PATTERN_EXACT);
@@ -754,6 +755,35 @@ inline int rrdhost_should_be_removed(RRDHOST *host, RRDHOST *protected_host, tim
 // ----------------------------------------------------------------------------
 // RRDHOST global / startup initialization
 
+#ifdef ENABLE_DBENGINE
+// tiers above 0 default to the compression settings of tier 0
+static void rrdeng_load_tier_compression_config(int tier) {
+    char key[200 + 1];
+
+    if(tier == 0) snprintfz(key, 200, "dbengine compression");
+    else snprintfz(key, 200, "dbengine tier %d compression", tier);
+    const char *algorithm = config_get(CONFIG_SECTION_DB, key, rrdeng_compression_algorithm_name(tier_compression_algorithm[0]));
+    if(strcmp(algorithm, "lz4") == 0) tier_compression_algorithm[tier] = RRD_LZ4;
+    else if(strcmp(algorithm, "none") == 0) tier_compression_algorithm[tier] = RRD_NO_COMPRESSION;
+#ifdef ENABLE_ZSTD
+    else if(strcmp(algorithm, "zstd") == 0) tier_compression_algorithm[tier] = RRD_ZSTD;
+#endif
+    else {
+        error("DBENGINE: compression '%s' is not supported, assuming 'lz4'", algorithm);
+        config_set(CONFIG_SECTION_DB, key, "lz4");
+        tier_compression_algorithm[tier] = RRD_LZ4;
+    }
+
+    if(tier == 0) snprintfz(key, 200, "dbengine compression level");
+    else snprintfz(key, 200, "dbengine tier %d compression level", tier);
+    tier_compression_level[tier] = (int)config_get_number(CONFIG_SECTION_DB, key, tier_compression_level[0]);
+
+    if(tier == 0) snprintfz(key, 200, "dbengine compression dictionary");
+    else snprintfz(key, 200, "dbengine tier %d compression dictionary", tier);
+    tier_compression_dictionary[tier] = (uint8_t)config_get_boolean(CONFIG_SECTION_DB, key, tier_compression_dictionary[0]);
+}
+#endif
+
 int rrd_init(char *hostname, struct rrdhost_system_info *system_info) {
     rrdhost_init();
 
@@ -802,6 +832,27 @@ int rrd_init(char *hostname, struct rrdhost_system_info *system_info) {
     else
         rrdeng_page_descr_use_malloc();
 
+    const char *page_type = config_get(CONFIG_SECTION_DB, "dbengine page type", tier_page_type[0] == PAGE_GORILLA_METRICS ? "gorilla" : "raw");
+    if(strcmp(page_type, "gorilla") == 0) tier_page_type[0] = PAGE_GORILLA_METRICS;
+    else if(strcmp(page_type, "raw") == 0) tier_page_type[0] = PAGE_METRICS;
+    else {
+        error("DBENGINE: unknown page type '%s', assuming 'raw'", page_type);
+        config_set(CONFIG_SECTION_DB, "dbengine page type", "raw");
+        tier_page_type[0] = PAGE_METRICS;
+    }
+
+    rrdeng_use_io_uring = config_get_boolean(CONFIG_SECTION_DB, "dbengine use io_uring", rrdeng_use_io_uring) ? 1 : 0;
+    rrdeng_query_read_ahead = config_get_boolean(CONFIG_SECTION_DB, "dbengine query read ahead", rrdeng_query_read_ahead) ? 1 : 0;
+
+    const char *eviction_policy = config_get(CONFIG_SECTION_DB, "dbengine page cache eviction policy", rrdeng_page_cache_eviction_policy == PG_CACHE_EVICTION_2Q ? "2q" : "lru");
+    if(strcmp(eviction_policy, "2q") == 0) rrdeng_page_cache_eviction_policy = PG_CACHE_EVICTION_2Q;
+    else if(strcmp(eviction_policy, "lru") == 0) rrdeng_page_cache_eviction_policy = PG_CACHE_EVICTION_LRU;
+    else {
+        error("DBENGINE: unknown page cache eviction policy '%s', assuming '2q'", eviction_policy);
+        config_set(CONFIG_SECTION_DB, "dbengine page cache eviction policy", "2q");
+        rrdeng_page_cache_eviction_policy = PG_CACHE_EVICTION_2Q;
+    }
+
     int created_tiers = 0;
     char dbenginepath[FILENAME_MAX + 1];
     char dbengineconfig[200 + 1];
@@ -851,6 +902,7 @@ int rrd_init(char *hostname, struct rrdhost_system_info *system_info) {
 
         storage_tiers_grouping_iterations[tier] = grouping_iterations;
         storage_tiers_backfill[tier] = backfill;
+        rrdeng_load_tier_compression_config(tier);
 
         if(tier > 0 && get_tier_grouping(tier) > 65535) {
             storage_tiers_grouping_iterations[tier] = 1;
@@ -1015,7 +1067,9 @@ void stop_streaming_sender(RRDHOST *host)
         return;
 
     rrdpush_sender_thread_stop(host); // stop a possibly running thread
+    sender_fan_out_free(host->sender);
     cbuffer_free(host->sender->buffer);
+    sender_free_chunks(host->sender);
 #ifdef ENABLE_COMPRESSION
     if (host->sender->compressor)
         host->sender->compressor->destroy(&host->sender->compressor);
@@ -1028,8 +1082,15 @@ void stop_streaming_receiver(RRDHOST *host)
 {
     netdata_mutex_lock(&host->receiver_lock);
     if (host->receiver) {
-        if (!host->receiver->exited)
-            netdata_thread_cancel(host->receiver->thread);
+        if (!host->receiver->exited) {
+            // a receivers pool thread serves other children too, so it cannot be cancelled
+            if (host->receiver->pool) {
+                host->receiver->shutdown = 1;
+                shutdown(host->receiver->fd, SHUT_RDWR);
+            }
+            else
+                netdata_thread_cancel(host->receiver->thread);
+        }
         netdata_mutex_unlock(&host->receiver_lock);
         struct receiver_state *rpt = host->receiver;
         while (host->receiver && !rpt->exited)
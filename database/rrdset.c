@@ -1051,7 +1051,7 @@ void store_metric_at_tier(RRDDIM *rd, struct rrddim_tier *t, STORAGE_POINT sp, u
     }
 }
 
-static void store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n, SN_FLAGS flags) {
+void rrddim_store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n, SN_FLAGS flags) {
 
     // store the metric on tier 0
     rd->tiers[0]->collect_ops.store_metric(rd->tiers[0]->db_collection_handle, point_end_time_ut, n, 0, 0, 1, 0, flags);
@@ -1084,6 +1084,10 @@ static void store_metric(RRDDIM *rd, usec_t point_end_time_ut, NETDATA_DOUBLE n,
         store_metric_at_tier(rd, t, sp, point_end_time_ut);
     }
 
+    // feed the sliding windows of the alarms of this chart
+    if(unlikely(rd->rrdset->alerts.windows))
+        rrdcalc_windows_store_metric(rd, point_end_time_ut, n, flags);
+
     rrdcontext_collected_rrddim(rd);
 }
 
@@ -1241,7 +1245,7 @@ static inline size_t rrdset_done_interpolate(
 
             if(unlikely(!store_this_entry)) {
                 (void) ml_is_anomalous(rd, 0, false);
-                store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
+                rrddim_store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
                 continue;
             }
 
@@ -1253,7 +1257,7 @@ static inline size_t rrdset_done_interpolate(
                     dim_storage_flags &= ~((storage_number)SN_FLAG_NOT_ANOMALOUS);
                 }
 
-                store_metric(rd, next_store_ut, new_value, dim_storage_flags);
+                rrddim_store_metric(rd, next_store_ut, new_value, dim_storage_flags);
                 rd->last_stored_value = new_value;
             }
             else {
@@ -1263,7 +1267,7 @@ static inline size_t rrdset_done_interpolate(
                 rrdset_debug(st, "%s: STORE[%ld] = NON EXISTING ", rrddim_name(rd), current_entry);
                 #endif
 
-                store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
+                rrddim_store_metric(rd, next_store_ut, NAN, SN_FLAG_NONE);
                 rd->last_stored_value = NAN;
             }
 
@@ -210,35 +210,42 @@ NETDATA_DOUBLE rrdvar2number(const RRDVAR_ACQUIRED *rva) {
     }
 }
 
-int health_variable_lookup(STRING *variable, RRDCALC *rc, NETDATA_DOUBLE *result) {
+// the variables of an alarm are looked up in its chart, its family and its host
+// any change to these indexes changes the version, so that eval() looks them up again
+size_t health_variable_lookup_version(RRDCALC *rc, const void **scope) {
     RRDSET *st = rc->rrdset;
+    *scope = st;
     if(!st) return 0;
 
-    RRDHOST *host = st->rrdhost;
-    const RRDVAR_ACQUIRED *rva;
+    return dictionary_version(st->rrdvars)
+           + dictionary_version(rrdfamily_rrdvars_dict(st->rrdfamily))
+           + dictionary_version(st->rrdhost->rrdvars);
+}
 
-    rva = rrdvar_get_and_acquire(st->rrdvars, variable);
-    if(rva) {
-        *result = rrdvar2number(rva);
-        dictionary_acquired_item_release(st->rrdvars, (const DICTIONARY_ITEM *)rva);
-        return 1;
-    }
+DICT_ITEM_CONST DICTIONARY_ITEM *health_variable_acquire(STRING *variable, RRDCALC *rc, DICTIONARY **dict) {
+    RRDSET *st = rc->rrdset;
+    if(!st) return NULL;
 
-    rva = rrdvar_get_and_acquire(rrdfamily_rrdvars_dict(st->rrdfamily), variable);
-    if(rva) {
-        *result = rrdvar2number(rva);
-        dictionary_acquired_item_release(rrdfamily_rrdvars_dict(st->rrdfamily), (const DICTIONARY_ITEM *)rva);
-        return 1;
-    }
+    DICTIONARY *dicts[] = {
+        st->rrdvars,
+        rrdfamily_rrdvars_dict(st->rrdfamily),
+        st->rrdhost->rrdvars,
+    };
 
-    rva = rrdvar_get_and_acquire(host->rrdvars, variable);
-    if(rva) {
-        *result = rrdvar2number(rva);
-        dictionary_acquired_item_release(host->rrdvars, (const DICTIONARY_ITEM *)rva);
-        return 1;
+    size_t i;
+    for(i = 0; i < sizeof(dicts) / sizeof(dicts[0]) ;i++) {
+        const RRDVAR_ACQUIRED *rva = rrdvar_get_and_acquire(dicts[i], variable);
+        if(rva) {
+            *dict = dicts[i];
+            return (DICT_ITEM_CONST DICTIONARY_ITEM *)rva;
+        }
     }
 
-    return 0;
+    return NULL;
+}
+
+NETDATA_DOUBLE health_variable_value(DICT_ITEM_CONST DICTIONARY_ITEM *item) {
+    return rrdvar2number((const RRDVAR_ACQUIRED *)item);
 }
 
 // ----------------------------------------------------------------------------
@@ -1651,6 +1651,7 @@ static RRDDIM *create_rrdim_entry(ONEWAYALLOC *owa, RRDSET *st, char *id, char *
         rd->tiers[tier]->mode = RRD_MEMORY_MODE_DBENGINE;
         rd->tiers[tier]->query_ops.init = rrdeng_load_metric_init;
         rd->tiers[tier]->query_ops.next_metric = rrdeng_load_metric_next;
+        rd->tiers[tier]->query_ops.next_metrics = rrdeng_load_metric_next_batch;
         rd->tiers[tier]->query_ops.is_finished = rrdeng_load_metric_is_finished;
         rd->tiers[tier]->query_ops.finalize = rrdeng_load_metric_finalize;
         rd->tiers[tier]->query_ops.latest_time = rrdeng_metric_latest_time;
@@ -16,6 +16,7 @@
 #define im_query_ops { \
     .init = rrddim_query_init, \
     .next_metric = rrddim_query_next_metric, \
+    .next_metrics = rrddim_query_next_metrics, \
     .is_finished = rrddim_query_is_finished, \
     .finalize = rrddim_query_finalize, \
     .latest_time = rrddim_query_latest_time, \
@@ -89,6 +90,7 @@ static STORAGE_ENGINE engines[] = {
             .query_ops = {
                 .init = rrdeng_load_metric_init,
                 .next_metric = rrdeng_load_metric_next,
+                .next_metrics = rrdeng_load_metric_next_batch,
                 .is_finished = rrdeng_load_metric_is_finished,
                 .finalize = rrdeng_load_metric_finalize,
                 .latest_time = rrdeng_metric_latest_time,
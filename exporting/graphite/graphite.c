@@ -180,16 +180,16 @@ int format_dimension_stored_graphite_plaintext(struct instance *instance, RRDDIM
 
     buffer_sprintf(
         instance->buffer,
-        "%s.%s.%s.%s%s%s%s " NETDATA_DOUBLE_FORMAT " %llu\n",
+        "%s.%s.%s.%s%s%s%s ",
         instance->config.prefix,
         (host == localhost) ? instance->config.hostname : rrdhost_hostname(host),
         chart_name,
         dimension_name,
         (host->tags) ? ";" : "",
         (host->tags) ? rrdhost_tags(host) : "",
-        (instance->labels_buffer) ? buffer_tostring(instance->labels_buffer) : "",
-        value,
-        (unsigned long long)last_t);
+        (instance->labels_buffer) ? buffer_tostring(instance->labels_buffer) : "");
+    buffer_print_netdata_double_fixed(instance->buffer, value);
+    buffer_sprintf(instance->buffer, " %llu\n", (unsigned long long)last_t);
 
     return 0;
 }
@@ -266,9 +266,7 @@ int format_dimension_stored_json_plaintext(struct instance *instance, RRDDIM *rd
 
         "\"id\":\"%s\","
         "\"name\":\"%s\","
-        "\"value\":" NETDATA_DOUBLE_FORMAT ","
-
-        "\"timestamp\": %llu}",
+        "\"value\":",
 
         instance->config.prefix,
         (host == localhost) ? instance->config.hostname : rrdhost_hostname(host),
@@ -284,10 +282,9 @@ int format_dimension_stored_json_plaintext(struct instance *instance, RRDDIM *rd
         rrdset_parts_type(st),
         rrdset_units(st),
         rrddim_id(rd),
-        rrddim_name(rd),
-        value,
-
-        (unsigned long long)last_t);
+        rrddim_name(rd));
+    buffer_print_netdata_double_fixed(instance->buffer, value);
+    buffer_sprintf(instance->buffer, ",\"timestamp\": %llu}", (unsigned long long)last_t);
 
     if (instance->config.type != EXPORTING_CONNECTOR_TYPE_JSON_HTTP) {
         buffer_strcat(instance->buffer, "\n");
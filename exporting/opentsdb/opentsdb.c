@@ -234,12 +234,15 @@ int format_dimension_stored_opentsdb_telnet(struct instance *instance, RRDDIM *r
 
     buffer_sprintf(
         instance->buffer,
-        "put %s.%s.%s %llu " NETDATA_DOUBLE_FORMAT " host=%s%s%s%s\n",
+        "put %s.%s.%s %llu ",
         instance->config.prefix,
         chart_name,
         dimension_name,
-        (unsigned long long)last_t,
-        value,
+        (unsigned long long)last_t);
+    buffer_print_netdata_double_fixed(instance->buffer, value);
+    buffer_sprintf(
+        instance->buffer,
+        " host=%s%s%s%s\n",
         (host == localhost) ? instance->config.hostname : rrdhost_hostname(host),
         (host->tags) ? " " : "",
         (host->tags) ? rrdhost_tags(host) : "",
@@ -382,16 +385,19 @@ int format_dimension_stored_opentsdb_http(struct instance *instance, RRDDIM *rd)
         "{"
         "\"metric\":\"%s.%s.%s\","
         "\"timestamp\":%llu,"
-        "\"value\":" NETDATA_DOUBLE_FORMAT ","
+        "\"value\":",
+        instance->config.prefix,
+        chart_name,
+        dimension_name,
+        (unsigned long long)last_t);
+    buffer_print_netdata_double_fixed(instance->buffer, value);
+    buffer_sprintf(
+        instance->buffer,
+        ","
         "\"tags\":{"
         "\"host\":\"%s%s%s\"%s"
         "}"
         "}",
-        instance->config.prefix,
-        chart_name,
-        dimension_name,
-        (unsigned long long)last_t,
-        value,
         (host == localhost) ? instance->config.hostname : rrdhost_hostname(host),
         (host->tags) ? " " : "",
         (host->tags) ? rrdhost_tags(host) : "",
@@ -381,27 +381,13 @@ static int print_host_variables_callback(const DICTIONARY_ITEM *item __maybe_unu
 
         prometheus_name_copy(opts->name, rrdvar_name(rv), sizeof(opts->name));
 
+        buffer_sprintf(opts->wb, "%s_%s%s%s%s ", opts->prefix, opts->name, label_pre, opts->labels, label_post);
+        buffer_print_netdata_double_fixed(opts->wb, value);
+
         if (opts->output_options & PROMETHEUS_OUTPUT_TIMESTAMPS)
-            buffer_sprintf(
-                opts->wb,
-                "%s_%s%s%s%s " NETDATA_DOUBLE_FORMAT " %llu\n",
-                opts->prefix,
-                opts->name,
-                label_pre,
-                opts->labels,
-                label_post,
-                value,
-                opts->now * 1000ULL);
+            buffer_sprintf(opts->wb, " %llu\n", opts->now * 1000ULL);
         else
-            buffer_sprintf(
-                opts->wb,
-                "%s_%s%s%s%s " NETDATA_DOUBLE_FORMAT "\n",
-                opts->prefix,
-                opts->name,
-                label_pre,
-                opts->labels,
-                label_post,
-                value);
+            buffer_strcat(opts->wb, "\n");
 
         return 1;
     }
@@ -482,9 +468,8 @@ static void generate_as_collected_prom_metric(BUFFER *wb, struct gen_parameters
     buffer_sprintf(wb, "%s} ", p->labels);
 
     if (prometheus_collector)
-        buffer_sprintf(
+        buffer_print_netdata_double_fixed(
             wb,
-            NETDATA_DOUBLE_FORMAT,
             (NETDATA_DOUBLE)p->rd->last_collected_value * (NETDATA_DOUBLE)p->rd->multiplier /
                 (NETDATA_DOUBLE)p->rd->divisor);
     else
@@ -569,6 +554,7 @@ static void rrd_stats_api_v1_charts_allmetrics_prometheus(
     // for each chart
     RRDSET *st;
     rrdset_foreach_read(st, host) {
+        buffer_stream_checkpoint(wb);
 
         if (likely(can_send_rrdset(instance, st, filter))) {
             char chart[PROMETHEUS_ELEMENT_MAX + 1];
@@ -714,35 +700,23 @@ static void rrd_stats_api_v1_charts_allmetrics_prometheus(
                             if (unlikely(output_options & PROMETHEUS_OUTPUT_TYPES))
                                 buffer_sprintf(wb, "# TYPE %s_%s%s%s gauge\n", prefix, context, units, suffix);
 
+                            buffer_sprintf(
+                                wb,
+                                "%s_%s%s%s{chart=\"%s\",family=\"%s\",dimension=\"%s\"%s} ",
+                                prefix,
+                                context,
+                                units,
+                                suffix,
+                                chart,
+                                family,
+                                dimension,
+                                labels);
+                            buffer_print_netdata_double_fixed(wb, value);
+
                             if (output_options & PROMETHEUS_OUTPUT_TIMESTAMPS)
-                                buffer_sprintf(
-                                    wb,
-                                    "%s_%s%s%s{chart=\"%s\",family=\"%s\",dimension=\"%s\"%s} " NETDATA_DOUBLE_FORMAT
-                                    " %llu\n",
-                                    prefix,
-                                    context,
-                                    units,
-                                    suffix,
-                                    chart,
-                                    family,
-                                    dimension,
-                                    labels,
-                                    value,
-                                    last_time * MSEC_PER_SEC);
+                                buffer_sprintf(wb, " %llu\n", last_time * MSEC_PER_SEC);
                             else
-                                buffer_sprintf(
-                                    wb,
-                                    "%s_%s%s%s{chart=\"%s\",family=\"%s\",dimension=\"%s\"%s} " NETDATA_DOUBLE_FORMAT
-                                    "\n",
-                                    prefix,
-                                    context,
-                                    units,
-                                    suffix,
-                                    chart,
-                                    family,
-                                    dimension,
-                                    labels,
-                                    value);
+                                buffer_strcat(wb, "\n");
                         }
                     }
                 }
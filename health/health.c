@@ -12,9 +12,10 @@
 #define WORKER_HEALTH_JOB_ALARM_LOG_PROCESS     7
 #define WORKER_HEALTH_JOB_DELAYED_INIT_RRDSET   8
 #define WORKER_HEALTH_JOB_DELAYED_INIT_RRDDIM   9
+#define WORKER_HEALTH_JOB_WINDOW_LOOKUP        10
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 10
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 10
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 11
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 11
 #endif
 
 
@@ -22,7 +23,8 @@ unsigned int default_health_enabled = 1;
 char *silencers_filename;
 
 // the queue of executed alarm notifications that haven't been waited for yet
-static struct {
+// each health thread waits for the notifications it executed
+static __thread struct {
     ALARM_ENTRY *head; // oldest
     ALARM_ENTRY *tail; // latest
 } alarm_notifications_in_progress = {NULL, NULL};
@@ -148,6 +150,14 @@ void health_init(void) {
         return;
     }
 
+    rrdcalc_windows_enabled = config_get_boolean(CONFIG_SECTION_HEALTH, "incremental lookups", rrdcalc_windows_enabled);
+    rrdcalc_windows_max_points = config_get_number(CONFIG_SECTION_HEALTH, "incremental lookups max points", rrdcalc_windows_max_points);
+    if(rrdcalc_windows_max_points < 1) rrdcalc_windows_max_points = 1;
+
+    long long mb = config_get_number(CONFIG_SECTION_HEALTH, "incremental lookups max memory MB", (long long)(rrdcalc_windows_max_memory / 1024 / 1024));
+    if(mb < 0) mb = 0;
+    rrdcalc_windows_max_memory = (size_t)mb * 1024 * 1024;
+
     health_silencers_init();
 }
 
@@ -304,7 +314,7 @@ static inline void health_alarm_execute(RRDHOST *host, ALARM_ENTRY *ae) {
         goto done;
     }
 
-    static char command_to_run[ALARM_EXEC_COMMAND_LENGTH + 1];
+    static __thread char command_to_run[ALARM_EXEC_COMMAND_LENGTH + 1];
 
     const char *exec      = (ae->exec)      ? ae_exec(ae)      : string2str(host->health_default_exec);
     const char *recipient = (ae->recipient) ? ae_recipient(ae) : string2str(host->health_default_recipient);
@@ -398,7 +408,7 @@ static inline void health_alarm_execute(RRDHOST *host, ALARM_ENTRY *ae) {
               ae_new_value_string(ae),
               ae_old_value_string(ae),
               (expr && expr->source)?expr->source:"NOSOURCE",
-              (expr && expr->error_msg)?buffer_tostring(expr->error_msg):"NOERRMSG",
+              (expr && expr->error_msg)?expression_error_msg(expr):"NOERRMSG",
               n_warn,
               n_crit,
               buffer_tostring(warn_alarms),
@@ -593,6 +603,8 @@ static inline int check_if_resumed_from_suspension(void) {
     return ret;
 }
 
+static void health_workers_stop(void);
+
 static void health_main_cleanup(void *ptr) {
     worker_unregister();
 
@@ -601,6 +613,8 @@ static void health_main_cleanup(void *ptr) {
 
     info("cleaning up...");
 
+    health_workers_stop();
+
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
 }
 
@@ -733,17 +747,50 @@ static void health_execute_delayed_initializations(RRDHOST *host) {
     rrdset_foreach_done(st);
 }
 
-/**
- * Health Main
- *
- * The main thread of the health system. In this function all the alarms will be processed.
- *
- * @param ptr is a pointer to the netdata_static_thread structure.
- *
- * @return It always returns NULL
- */
+// ----------------------------------------------------------------------------
+// health threads
+//
+// Every run, the hosts are shared by the health thread and the helper threads.
+// Each host is run by a single thread, so the alarm log of each host keeps
+// its order, and the run ends when all the threads have finished their hosts.
+
+struct health_run {
+    time_t now;
+    unsigned int loop;
+    int cleanup_sql_every_loop;
+    int apply_hibernation_delay;
+    time_t hibernation_delay;
+    time_t first_next_run;          // the next run when no alarm needs to run earlier
+
+    RRDHOST **hosts;
+    size_t hosts_count;
+    size_t next_host;               // the next host to be claimed, atomic
+
+    time_t next_run;                // the earliest next run of the helpers, protected by health_workers.mutex
+};
 
-void *health_main(void *ptr) {
+static struct {
+    size_t threads;                 // the helper threads, 0 when the health thread runs all the hosts
+    bool started;
+
+    netdata_mutex_t mutex;
+    pthread_cond_t cond;            // wakes up the helpers for a new run
+    pthread_cond_t done;            // wakes up the health thread when the helpers finish
+
+    // protected by mutex
+    struct health_run *run;
+    size_t helpers_wanted;
+    size_t helpers_running;
+} health_workers = {
+    .threads = 0,
+    .started = false,
+    .mutex = NETDATA_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .run = NULL,
+};
+
+static void health_worker_register(void) {
     worker_register("HEALTH");
     worker_register_job_name(WORKER_HEALTH_JOB_RRD_LOCK, "rrd lock");
     worker_register_job_name(WORKER_HEALTH_JOB_HOST_LOCK, "host lock");
@@ -755,526 +802,709 @@ void *health_main(void *ptr) {
     worker_register_job_name(WORKER_HEALTH_JOB_ALARM_LOG_PROCESS, "alarm log process");
     worker_register_job_name(WORKER_HEALTH_JOB_DELAYED_INIT_RRDSET, "rrdset init");
     worker_register_job_name(WORKER_HEALTH_JOB_DELAYED_INIT_RRDDIM, "rrddim init");
+    worker_register_job_name(WORKER_HEALTH_JOB_WINDOW_LOOKUP, "window lookup");
+}
 
-    netdata_thread_cleanup_push(health_main_cleanup, ptr);
+/**
+ * Run host
+ *
+ * Evaluate all the alarms of a host and process its alarm log.
+ *
+ * @param host the host to run.
+ * @param run the parameters of this run.
+ * @param next_run the earliest time an alarm has to run again.
+ *
+ * @return next_run, updated with the alarms of this host.
+ */
+static time_t health_run_host(RRDHOST *host, struct health_run *run, time_t next_run) {
+    time_t now = run->now;
+    unsigned int loop = run->loop;
+    int cleanup_sql_every_loop = run->cleanup_sql_every_loop;
+    int apply_hibernation_delay = run->apply_hibernation_delay;
+    time_t hibernation_delay = run->hibernation_delay;
+    int runnable = 0;
+    RRDCALC *rc;
 
-    int min_run_every = (int)config_get_number(CONFIG_SECTION_HEALTH, "run at least every seconds", 10);
-    if(min_run_every < 1) min_run_every = 1;
+    if (unlikely(!host->health_enabled))
+        return next_run;
 
-    int cleanup_sql_every_loop = 7200 / min_run_every;
+    if (unlikely(apply_hibernation_delay)) {
+        info(
+            "Postponing health checks for %"PRId64" seconds, on host '%s'.",
+            (int64_t)hibernation_delay,
+            rrdhost_hostname(host));
 
-    time_t now                = now_realtime_sec();
-    time_t hibernation_delay  = config_get_number(CONFIG_SECTION_HEALTH, "postpone alarms during hibernation for seconds", 60);
+        host->health_delay_up_to = now + hibernation_delay;
+    }
 
-    rrdcalc_delete_alerts_not_matching_host_labels_from_all_hosts();
+    if (unlikely(host->health_delay_up_to)) {
+        if (unlikely(now < host->health_delay_up_to))
+            return next_run;
 
-    unsigned int loop = 0;
+        info("Resuming health checks on host '%s'.", rrdhost_hostname(host));
+        host->health_delay_up_to = 0;
+    }
+
+    // wait until cleanup of obsolete charts on children is complete
+    if (host != localhost)
+        if (unlikely(host->trigger_chart_obsoletion_check == 1))
+            return next_run;
+
+    if(likely(!host->health_log_fp) && (loop == 1 || loop % cleanup_sql_every_loop == 0))
+        sql_health_alarm_log_cleanup(host);
+
+    health_execute_delayed_initializations(host);
+
+    worker_is_busy(WORKER_HEALTH_JOB_HOST_LOCK);
+
+    // the first loop is to lookup values from the db
+    foreach_rrdcalc_in_rrdhost_read(host, rc) {
+
+        rrdcalc_update_info_using_rrdset_labels(rc);
+
+        if (update_disabled_silenced(host, rc))
+            continue;
+
+        // create an alert removed event if the chart is obsolete and
+        // has stopped being collected for 60 seconds
+        if (unlikely(rc->rrdset && rc->status != RRDCALC_STATUS_REMOVED &&
+                     rrdset_flag_check(rc->rrdset, RRDSET_FLAG_OBSOLETE) &&
+                     now > (rc->rrdset->last_collected_time.tv_sec + 60))) {
+            if (!rrdcalc_isrepeating(rc)) {
+                worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
+                time_t now = now_realtime_sec();
+
+                ALARM_ENTRY *ae = health_create_alarm_entry(
+                    host,
+                    rc->id,
+                    rc->next_event_id++,
+                    rc->config_hash_id,
+                    now,
+                    rc->name,
+                    rc->rrdset->id,
+                    rc->rrdset->context,
+                    rc->rrdset->family,
+                    rc->classification,
+                    rc->component,
+                    rc->type,
+                    rc->exec,
+                    rc->recipient,
+                    now - rc->last_status_change,
+                    rc->value,
+                    NAN,
+                    rc->status,
+                    RRDCALC_STATUS_REMOVED,
+                    rc->source,
+                    rc->units,
+                    rc->info,
+                    0,
+                    rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0);
+
+                if (ae) {
+                    health_alarm_log_add_entry(host, ae);
+                    rc->old_status = rc->status;
+                    rc->status = RRDCALC_STATUS_REMOVED;
+                    rc->last_status_change = now;
+                    rc->last_updated = now;
+                    rc->value = NAN;
 #ifdef ENABLE_ACLK
-    unsigned int marked_aclk_reload_loop = 0;
+                    if (netdata_cloud_setting && likely(!aclk_alert_reloaded))
+                        sql_queue_alarm_to_aclk(host, ae, 1);
 #endif
-    while(!netdata_exit) {
-        loop++;
-        debug(D_HEALTH, "Health monitoring iteration no %u started", loop);
+                }
+            }
+        }
 
-        int runnable = 0, apply_hibernation_delay = 0;
-        time_t next_run = now + min_run_every;
-        RRDCALC *rc;
+        if (unlikely(!rrdcalc_isrunnable(rc, now, &next_run))) {
+            if (unlikely(rc->run_flags & RRDCALC_FLAG_RUNNABLE))
+                rc->run_flags &= ~RRDCALC_FLAG_RUNNABLE;
+            continue;
+        }
 
-        if (unlikely(check_if_resumed_from_suspension())) {
-            apply_hibernation_delay = 1;
+        runnable++;
+        rc->old_value = rc->value;
+        rc->run_flags |= RRDCALC_FLAG_RUNNABLE;
 
-            info(
-                "Postponing alarm checks for %"PRId64" seconds, "
-                "because it seems that the system was just resumed from suspension.",
-                (int64_t)hibernation_delay);
-        }
+        // ------------------------------------------------------------
+        // if there is database lookup, do it
 
-        if (unlikely(silencers->all_alarms && silencers->stype == STYPE_DISABLE_ALARMS)) {
-            static int logged=0;
-            if (!logged) {
-                info("Skipping health checks, because all alarms are disabled via a %s command.",
-                     HEALTH_CMDAPI_CMD_DISABLEALL);
-                logged = 1;
+        if (unlikely(RRDCALC_HAS_DB_LOOKUP(rc))) {
+            worker_is_busy(WORKER_HEALTH_JOB_WINDOW_LOOKUP);
+
+            /* time_t old_db_timestamp = rc->db_before; */
+            int value_is_null = 0;
+            int ret = 200;
+
+            // use the sliding window of the alarm, when it can give the value
+            if (!rrdcalc_window_lookup(rc, &rc->value, &rc->db_after, &rc->db_before, &value_is_null)) {
+                worker_is_busy(WORKER_HEALTH_JOB_DB_QUERY);
+
+                ret = rrdset2value_api_v1(rc->rrdset, NULL, &rc->value, rrdcalc_dimensions(rc), 1,
+                                          rc->after, rc->before, rc->group, NULL,
+                                          0, rc->options,
+                                          &rc->db_after,&rc->db_before,
+                                          NULL, NULL, NULL,
+                                          &value_is_null, NULL, 0, 0);
+            }
+
+            if (unlikely(ret != 200)) {
+                // database lookup failed
+                rc->value = NAN;
+                rc->run_flags |= RRDCALC_FLAG_DB_ERROR;
+
+                debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup returned error %d",
+                      rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), ret
+                );
+            } else
+                rc->run_flags &= ~RRDCALC_FLAG_DB_ERROR;
+
+            /* - RRDCALC_FLAG_DB_STALE not currently used
+            if (unlikely(old_db_timestamp == rc->db_before)) {
+                // database is stale
+
+                debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database is stale", host->hostname, rc->chart?rc->chart:"NOCHART", rc->name);
+
+                if (unlikely(!(rc->rrdcalc_flags & RRDCALC_FLAG_DB_STALE))) {
+                    rc->rrdcalc_flags |= RRDCALC_FLAG_DB_STALE;
+                    error("Health on host '%s', alarm '%s.%s': database is stale", host->hostname, rc->chart?rc->chart:"NOCHART", rc->name);
+                }
             }
+            else if (unlikely(rc->rrdcalc_flags & RRDCALC_FLAG_DB_STALE))
+                rc->rrdcalc_flags &= ~RRDCALC_FLAG_DB_STALE;
+            */
+
+            if (unlikely(value_is_null)) {
+                // collected value is null
+                rc->value = NAN;
+                rc->run_flags |= RRDCALC_FLAG_DB_NAN;
+
+                debug(D_HEALTH,
+                      "Health on host '%s', alarm '%s.%s': database lookup returned empty value (possibly value is not collected yet)",
+                      rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc)
+                );
+            } else
+                rc->run_flags &= ~RRDCALC_FLAG_DB_NAN;
+
+            debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup gave value " NETDATA_DOUBLE_FORMAT,
+                  rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), rc->value
+            );
         }
 
-#ifdef ENABLE_ACLK
-        if (aclk_alert_reloaded && !marked_aclk_reload_loop)
-            marked_aclk_reload_loop = loop;
-#endif
+        // ------------------------------------------------------------
+        // if there is calculation expression, run it
 
-        worker_is_busy(WORKER_HEALTH_JOB_RRD_LOCK);
-        rrd_rdlock();
+        if (unlikely(rc->calculation)) {
+            worker_is_busy(WORKER_HEALTH_JOB_CALC_EVAL);
 
-        RRDHOST *host;
-        rrdhost_foreach_read(host) {
-            if (unlikely(!host->health_enabled))
+            if (unlikely(!expression_evaluate(rc->calculation))) {
+                // calculation failed
+                rc->value = NAN;
+                rc->run_flags |= RRDCALC_FLAG_CALC_ERROR;
+
+                debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': expression '%s' failed: %s",
+                      rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
+                      rc->calculation->parsed_as, expression_error_msg(rc->calculation)
+                );
+            } else {
+                rc->run_flags &= ~RRDCALC_FLAG_CALC_ERROR;
+
+                debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': expression '%s' gave value "
+                      NETDATA_DOUBLE_FORMAT
+                      ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
+                      rc->calculation->parsed_as, rc->calculation->result,
+                      expression_error_msg(rc->calculation), rrdcalc_source(rc)
+                );
+
+                rc->value = rc->calculation->result;
+            }
+        }
+    }
+    foreach_rrdcalc_in_rrdhost_done(rc);
+
+    if (unlikely(runnable && !netdata_exit)) {
+        foreach_rrdcalc_in_rrdhost_read(host, rc) {
+            if (unlikely(!(rc->run_flags & RRDCALC_FLAG_RUNNABLE)))
+                continue;
+
+            if (rc->run_flags & RRDCALC_FLAG_DISABLED) {
                 continue;
+            }
+            RRDCALC_STATUS warning_status = RRDCALC_STATUS_UNDEFINED;
+            RRDCALC_STATUS critical_status = RRDCALC_STATUS_UNDEFINED;
+
+            // --------------------------------------------------------
+            // check the warning expression
+
+            if (likely(rc->warning)) {
+                worker_is_busy(WORKER_HEALTH_JOB_WARNING_EVAL);
 
-            if (unlikely(apply_hibernation_delay)) {
-                info(
-                    "Postponing health checks for %"PRId64" seconds, on host '%s'.",
-                    (int64_t)hibernation_delay,
-                    rrdhost_hostname(host));
+                if (unlikely(!expression_evaluate(rc->warning))) {
+                    // calculation failed
+                    rc->run_flags |= RRDCALC_FLAG_WARN_ERROR;
 
-                host->health_delay_up_to = now + hibernation_delay;
+                    debug(D_HEALTH,
+                          "Health on host '%s', alarm '%s.%s': warning expression failed with error: %s",
+                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
+                          expression_error_msg(rc->warning)
+                    );
+                } else {
+                    rc->run_flags &= ~RRDCALC_FLAG_WARN_ERROR;
+                    debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': warning expression gave value "
+                          NETDATA_DOUBLE_FORMAT
+                          ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc),
+                          rrdcalc_name(rc), rc->warning->result, expression_error_msg(rc->warning), rrdcalc_source(rc)
+                    );
+                    warning_status = rrdcalc_value2status(rc->warning->result);
+                }
             }
 
-            if (unlikely(host->health_delay_up_to)) {
-                if (unlikely(now < host->health_delay_up_to))
-                    continue;
+            // --------------------------------------------------------
+            // check the critical expression
+
+            if (likely(rc->critical)) {
+                worker_is_busy(WORKER_HEALTH_JOB_CRITICAL_EVAL);
 
-                info("Resuming health checks on host '%s'.", rrdhost_hostname(host));
-                host->health_delay_up_to = 0;
+                if (unlikely(!expression_evaluate(rc->critical))) {
+                    // calculation failed
+                    rc->run_flags |= RRDCALC_FLAG_CRIT_ERROR;
+
+                    debug(D_HEALTH,
+                          "Health on host '%s', alarm '%s.%s': critical expression failed with error: %s",
+                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
+                          expression_error_msg(rc->critical)
+                    );
+                } else {
+                    rc->run_flags &= ~RRDCALC_FLAG_CRIT_ERROR;
+                    debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': critical expression gave value "
+                          NETDATA_DOUBLE_FORMAT
+                          ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc),
+                          rrdcalc_name(rc), rc->critical->result, expression_error_msg(rc->critical),
+                          rrdcalc_source(rc)
+                    );
+                    critical_status = rrdcalc_value2status(rc->critical->result);
+                }
             }
 
-            // wait until cleanup of obsolete charts on children is complete
-            if (host != localhost)
-                if (unlikely(host->trigger_chart_obsoletion_check == 1))
-                    continue;
+            // --------------------------------------------------------
+            // decide the final alarm status
 
-            if(likely(!host->health_log_fp) && (loop == 1 || loop % cleanup_sql_every_loop == 0))
-                sql_health_alarm_log_cleanup(host);
+            RRDCALC_STATUS status = RRDCALC_STATUS_UNDEFINED;
 
-            health_execute_delayed_initializations(host);
+            switch (warning_status) {
+                case RRDCALC_STATUS_CLEAR:
+                    status = RRDCALC_STATUS_CLEAR;
+                    break;
 
-            worker_is_busy(WORKER_HEALTH_JOB_HOST_LOCK);
+                case RRDCALC_STATUS_RAISED:
+                    status = RRDCALC_STATUS_WARNING;
+                    break;
 
-            // the first loop is to lookup values from the db
-            foreach_rrdcalc_in_rrdhost_read(host, rc) {
+                default:
+                    break;
+            }
 
-                rrdcalc_update_info_using_rrdset_labels(rc);
+            switch (critical_status) {
+                case RRDCALC_STATUS_CLEAR:
+                    if (status == RRDCALC_STATUS_UNDEFINED)
+                       status = RRDCALC_STATUS_CLEAR;
+                    break;
 
-                if (update_disabled_silenced(host, rc))
-                    continue;
+                case RRDCALC_STATUS_RAISED:
+                    status = RRDCALC_STATUS_CRITICAL;
+                    break;
 
-                // create an alert removed event if the chart is obsolete and
-                // has stopped being collected for 60 seconds
-                if (unlikely(rc->rrdset && rc->status != RRDCALC_STATUS_REMOVED &&
-                             rrdset_flag_check(rc->rrdset, RRDSET_FLAG_OBSOLETE) &&
-                             now > (rc->rrdset->last_collected_time.tv_sec + 60))) {
-                    if (!rrdcalc_isrepeating(rc)) {
-                        worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
-                        time_t now = now_realtime_sec();
-
-                        ALARM_ENTRY *ae = health_create_alarm_entry(
-                            host,
-                            rc->id,
-                            rc->next_event_id++,
-                            rc->config_hash_id,
-                            now,
-                            rc->name,
-                            rc->rrdset->id,
-                            rc->rrdset->context,
-                            rc->rrdset->family,
-                            rc->classification,
-                            rc->component,
-                            rc->type,
-                            rc->exec,
-                            rc->recipient,
-                            now - rc->last_status_change,
-                            rc->value,
-                            NAN,
-                            rc->status,
-                            RRDCALC_STATUS_REMOVED,
-                            rc->source,
-                            rc->units,
-                            rc->info,
-                            0,
-                            rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0);
-
-                        if (ae) {
-                            health_alarm_log_add_entry(host, ae);
-                            rc->old_status = rc->status;
-                            rc->status = RRDCALC_STATUS_REMOVED;
-                            rc->last_status_change = now;
-                            rc->last_updated = now;
-                            rc->value = NAN;
-#ifdef ENABLE_ACLK
-                            if (netdata_cloud_setting && likely(!aclk_alert_reloaded))
-                                sql_queue_alarm_to_aclk(host, ae, 1);
-#endif
+                default:
+                    break;
+            }
+
+            // --------------------------------------------------------
+            // check if the new status and the old differ
+
+            if (status != rc->status) {
+                worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
+                int delay = 0;
+
+                // apply trigger hysteresis
+
+                if (now > rc->delay_up_to_timestamp) {
+                    rc->delay_up_current = rc->delay_up_duration;
+                    rc->delay_down_current = rc->delay_down_duration;
+                    rc->delay_last = 0;
+                    rc->delay_up_to_timestamp = 0;
+                } else {
+                    rc->delay_up_current = (int) (rc->delay_up_current * rc->delay_multiplier);
+                    if (rc->delay_up_current > rc->delay_max_duration)
+                        rc->delay_up_current = rc->delay_max_duration;
+
+                    rc->delay_down_current = (int) (rc->delay_down_current * rc->delay_multiplier);
+                    if (rc->delay_down_current > rc->delay_max_duration)
+                        rc->delay_down_current = rc->delay_max_duration;
+                }
+
+                if (status > rc->status)
+                    delay = rc->delay_up_current;
+                else
+                    delay = rc->delay_down_current;
+
+                // COMMENTED: because we do need to send raising alarms
+                // if(now + delay < rc->delay_up_to_timestamp)
+                //      delay = (int)(rc->delay_up_to_timestamp - now);
+
+                rc->delay_last = delay;
+                rc->delay_up_to_timestamp = now + delay;
+
+
+                ALARM_ENTRY *ae = health_create_alarm_entry(
+                    host,
+                    rc->id,
+                    rc->next_event_id++,
+                    rc->config_hash_id,
+                    now,
+                    rc->name,
+                    rc->rrdset->id,
+                    rc->rrdset->context,
+                    rc->rrdset->family,
+                    rc->classification,
+                    rc->component,
+                    rc->type,
+                    rc->exec,
+                    rc->recipient,
+                    now - rc->last_status_change,
+                    rc->old_value,
+                    rc->value,
+                    rc->status,
+                    status,
+                    rc->source,
+                    rc->units,
+                    rc->info,
+                    rc->delay_last,
+                    (
+                        ((rc->options & RRDCALC_OPTION_NO_CLEAR_NOTIFICATION)? HEALTH_ENTRY_FLAG_NO_CLEAR_NOTIFICATION : 0) |
+                        ((rc->run_flags & RRDCALC_FLAG_SILENCED)? HEALTH_ENTRY_FLAG_SILENCED : 0) |
+                        (rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0)
+                        )
+                );
+
+                health_alarm_log_add_entry(host, ae);
+
+                rc->last_status_change = now;
+                rc->old_status = rc->status;
+                rc->status = status;
+            }
+
+            rc->last_updated = now;
+            rc->next_update = now + rc->update_every;
+
+            if (next_run > rc->next_update)
+                next_run = rc->next_update;
+        }
+        foreach_rrdcalc_in_rrdhost_done(rc);
+
+        // process repeating alarms
+        foreach_rrdcalc_in_rrdhost_read(host, rc) {
+            int repeat_every = 0;
+            if(unlikely(rrdcalc_isrepeating(rc) && rc->delay_up_to_timestamp <= now)) {
+                if(unlikely(rc->status == RRDCALC_STATUS_WARNING)) {
+                    rc->run_flags &= ~RRDCALC_FLAG_RUN_ONCE;
+                    repeat_every = rc->warn_repeat_every;
+                } else if(unlikely(rc->status == RRDCALC_STATUS_CRITICAL)) {
+                    rc->run_flags &= ~RRDCALC_FLAG_RUN_ONCE;
+                    repeat_every = rc->crit_repeat_every;
+                } else if(unlikely(rc->status == RRDCALC_STATUS_CLEAR)) {
+                    if(!(rc->run_flags & RRDCALC_FLAG_RUN_ONCE)) {
+                        if(rc->old_status == RRDCALC_STATUS_CRITICAL) {
+                            repeat_every = 1;
+                        } else if (rc->old_status == RRDCALC_STATUS_WARNING) {
+                            repeat_every = 1;
                         }
                     }
                 }
+            } else {
+                continue;
+            }
 
-                if (unlikely(!rrdcalc_isrunnable(rc, now, &next_run))) {
-                    if (unlikely(rc->run_flags & RRDCALC_FLAG_RUNNABLE))
-                        rc->run_flags &= ~RRDCALC_FLAG_RUNNABLE;
-                    continue;
+            if(unlikely(repeat_every > 0 && (rc->last_repeat + repeat_every) <= now)) {
+                worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
+                rc->last_repeat = now;
+                if (likely(rc->times_repeat < UINT32_MAX)) rc->times_repeat++;
+
+                ALARM_ENTRY *ae = health_create_alarm_entry(
+                    host,
+                    rc->id,
+                    rc->next_event_id++,
+                    rc->config_hash_id,
+                    now,
+                    rc->name,
+                    rc->rrdset->id,
+                    rc->rrdset->context,
+                    rc->rrdset->family,
+                    rc->classification,
+                    rc->component,
+                    rc->type,
+                    rc->exec,
+                    rc->recipient,
+                    now - rc->last_status_change,
+                    rc->old_value,
+                    rc->value,
+                    rc->old_status,
+                    rc->status,
+                    rc->source,
+                    rc->units,
+                    rc->info,
+                    rc->delay_last,
+                    (
+                        ((rc->options & RRDCALC_OPTION_NO_CLEAR_NOTIFICATION)? HEALTH_ENTRY_FLAG_NO_CLEAR_NOTIFICATION : 0) |
+                        ((rc->run_flags & RRDCALC_FLAG_SILENCED)? HEALTH_ENTRY_FLAG_SILENCED : 0) |
+                        (rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0)
+                        )
+                );
+
+                ae->last_repeat = rc->last_repeat;
+                if (!(rc->run_flags & RRDCALC_FLAG_RUN_ONCE) && rc->status == RRDCALC_STATUS_CLEAR) {
+                    ae->flags |= HEALTH_ENTRY_RUN_ONCE;
                 }
+                rc->run_flags |= RRDCALC_FLAG_RUN_ONCE;
+                health_process_notifications(host, ae);
+                debug(D_HEALTH, "Notification sent for the repeating alarm %u.", ae->alarm_id);
+                health_alarm_wait_for_execution(ae);
+                health_alarm_log_free_one_nochecks_nounlink(ae);
+            }
+        }
+        foreach_rrdcalc_in_rrdhost_done(rc);
+    }
 
-                runnable++;
-                rc->old_value = rc->value;
-                rc->run_flags |= RRDCALC_FLAG_RUNNABLE;
+    if (unlikely(netdata_exit))
+        return next_run;
 
-                // ------------------------------------------------------------
-                // if there is database lookup, do it
+    // execute notifications
+    // and cleanup
+    worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_PROCESS);
+    health_alarm_log_process(host);
 
-                if (unlikely(RRDCALC_HAS_DB_LOOKUP(rc))) {
-                    worker_is_busy(WORKER_HEALTH_JOB_DB_QUERY);
+    return next_run;
+}
 
-                    /* time_t old_db_timestamp = rc->db_before; */
-                    int value_is_null = 0;
+// runs the hosts claimed by this thread and waits for their notifications
+static time_t health_run_hosts(struct health_run *run) {
+    time_t next_run = run->first_next_run;
 
-                    int ret = rrdset2value_api_v1(rc->rrdset, NULL, &rc->value, rrdcalc_dimensions(rc), 1,
-                                                  rc->after, rc->before, rc->group, NULL,
-                                                  0, rc->options,
-                                                  &rc->db_after,&rc->db_before,
-                                                  NULL, NULL, NULL,
-                                                  &value_is_null, NULL, 0, 0);
+    size_t i;
+    while(!netdata_exit && (i = __atomic_fetch_add(&run->next_host, 1, __ATOMIC_RELAXED)) < run->hosts_count)
+        next_run = health_run_host(run->hosts[i], run, next_run);
 
-                    if (unlikely(ret != 200)) {
-                        // database lookup failed
-                        rc->value = NAN;
-                        rc->run_flags |= RRDCALC_FLAG_DB_ERROR;
+    // wait for all notifications to finish before allowing health to be cleaned up
+    ALARM_ENTRY *ae;
+    while (NULL != (ae = alarm_notifications_in_progress.head)) {
+        health_alarm_wait_for_execution(ae);
+    }
 
-                        debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup returned error %d",
-                              rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), ret
-                        );
-                    } else
-                        rc->run_flags &= ~RRDCALC_FLAG_DB_ERROR;
+    return next_run;
+}
 
-                    /* - RRDCALC_FLAG_DB_STALE not currently used
-                    if (unlikely(old_db_timestamp == rc->db_before)) {
-                        // database is stale
+static void *health_worker_main(void *ptr __maybe_unused) {
+    health_worker_register();
 
-                        debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database is stale", host->hostname, rc->chart?rc->chart:"NOCHART", rc->name);
+    netdata_mutex_lock(&health_workers.mutex);
 
-                        if (unlikely(!(rc->rrdcalc_flags & RRDCALC_FLAG_DB_STALE))) {
-                            rc->rrdcalc_flags |= RRDCALC_FLAG_DB_STALE;
-                            error("Health on host '%s', alarm '%s.%s': database is stale", host->hostname, rc->chart?rc->chart:"NOCHART", rc->name);
-                        }
-                    }
-                    else if (unlikely(rc->rrdcalc_flags & RRDCALC_FLAG_DB_STALE))
-                        rc->rrdcalc_flags &= ~RRDCALC_FLAG_DB_STALE;
-                    */
-
-                    if (unlikely(value_is_null)) {
-                        // collected value is null
-                        rc->value = NAN;
-                        rc->run_flags |= RRDCALC_FLAG_DB_NAN;
-
-                        debug(D_HEALTH,
-                              "Health on host '%s', alarm '%s.%s': database lookup returned empty value (possibly value is not collected yet)",
-                              rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc)
-                        );
-                    } else
-                        rc->run_flags &= ~RRDCALC_FLAG_DB_NAN;
+    while(!netdata_exit) {
+        struct health_run *run = health_workers.run;
+        if(!run || !health_workers.helpers_wanted) {
+            worker_is_idle();
+            pthread_cond_wait(&health_workers.cond, &health_workers.mutex);
+            continue;
+        }
 
-                    debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': database lookup gave value " NETDATA_DOUBLE_FORMAT,
-                          rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc), rc->value
-                    );
-                }
+        health_workers.helpers_wanted--;
+        health_workers.helpers_running++;
+        netdata_mutex_unlock(&health_workers.mutex);
 
-                // ------------------------------------------------------------
-                // if there is calculation expression, run it
+        time_t next_run = health_run_hosts(run);
 
-                if (unlikely(rc->calculation)) {
-                    worker_is_busy(WORKER_HEALTH_JOB_CALC_EVAL);
+        netdata_mutex_lock(&health_workers.mutex);
+        if(next_run < run->next_run)
+            run->next_run = next_run;
 
-                    if (unlikely(!expression_evaluate(rc->calculation))) {
-                        // calculation failed
-                        rc->value = NAN;
-                        rc->run_flags |= RRDCALC_FLAG_CALC_ERROR;
+        if(!--health_workers.helpers_running)
+            pthread_cond_signal(&health_workers.done);
+    }
 
-                        debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': expression '%s' failed: %s",
-                              rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
-                              rc->calculation->parsed_as, buffer_tostring(rc->calculation->error_msg)
-                        );
-                    } else {
-                        rc->run_flags &= ~RRDCALC_FLAG_CALC_ERROR;
-
-                        debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': expression '%s' gave value "
-                              NETDATA_DOUBLE_FORMAT
-                              ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
-                              rc->calculation->parsed_as, rc->calculation->result,
-                              buffer_tostring(rc->calculation->error_msg), rrdcalc_source(rc)
-                        );
+    netdata_mutex_unlock(&health_workers.mutex);
 
-                        rc->value = rc->calculation->result;
-                    }
-                }
-            }
-            foreach_rrdcalc_in_rrdhost_done(rc);
+    worker_unregister();
+    return NULL;
+}
 
-            if (unlikely(runnable && !netdata_exit)) {
-                foreach_rrdcalc_in_rrdhost_read(host, rc) {
-                    if (unlikely(!(rc->run_flags & RRDCALC_FLAG_RUNNABLE)))
-                        continue;
+// the threads are started on the first run with more than one host
+static void health_workers_start(void) {
+    size_t started = 0;
 
-                    if (rc->run_flags & RRDCALC_FLAG_DISABLED) {
-                        continue;
-                    }
-                    RRDCALC_STATUS warning_status = RRDCALC_STATUS_UNDEFINED;
-                    RRDCALC_STATUS critical_status = RRDCALC_STATUS_UNDEFINED;
-
-                    // --------------------------------------------------------
-                    // check the warning expression
-
-                    if (likely(rc->warning)) {
-                        worker_is_busy(WORKER_HEALTH_JOB_WARNING_EVAL);
-
-                        if (unlikely(!expression_evaluate(rc->warning))) {
-                            // calculation failed
-                            rc->run_flags |= RRDCALC_FLAG_WARN_ERROR;
-
-                            debug(D_HEALTH,
-                                  "Health on host '%s', alarm '%s.%s': warning expression failed with error: %s",
-                                  rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
-                                  buffer_tostring(rc->warning->error_msg)
-                            );
-                        } else {
-                            rc->run_flags &= ~RRDCALC_FLAG_WARN_ERROR;
-                            debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': warning expression gave value "
-                                  NETDATA_DOUBLE_FORMAT
-                                  ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc),
-                                  rrdcalc_name(rc), rc->warning->result, buffer_tostring(rc->warning->error_msg), rrdcalc_source(rc)
-                            );
-                            warning_status = rrdcalc_value2status(rc->warning->result);
-                        }
-                    }
+    for(size_t i = 0; i < health_workers.threads ; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "HEALTH[%zu]", i + 1);
 
-                    // --------------------------------------------------------
-                    // check the critical expression
-
-                    if (likely(rc->critical)) {
-                        worker_is_busy(WORKER_HEALTH_JOB_CRITICAL_EVAL);
-
-                        if (unlikely(!expression_evaluate(rc->critical))) {
-                            // calculation failed
-                            rc->run_flags |= RRDCALC_FLAG_CRIT_ERROR;
-
-                            debug(D_HEALTH,
-                                  "Health on host '%s', alarm '%s.%s': critical expression failed with error: %s",
-                                  rrdhost_hostname(host), rrdcalc_chart_name(rc), rrdcalc_name(rc),
-                                  buffer_tostring(rc->critical->error_msg)
-                            );
-                        } else {
-                            rc->run_flags &= ~RRDCALC_FLAG_CRIT_ERROR;
-                            debug(D_HEALTH, "Health on host '%s', alarm '%s.%s': critical expression gave value "
-                                  NETDATA_DOUBLE_FORMAT
-                                  ": %s (source: %s)", rrdhost_hostname(host), rrdcalc_chart_name(rc),
-                                  rrdcalc_name(rc), rc->critical->result, buffer_tostring(rc->critical->error_msg),
-                                  rrdcalc_source(rc)
-                            );
-                            critical_status = rrdcalc_value2status(rc->critical->result);
-                        }
-                    }
+        netdata_thread_t thread;
+        if(netdata_thread_create(&thread, tag, NETDATA_THREAD_OPTION_DONT_LOG, health_worker_main, NULL))
+            error("HEALTH: failed to create health thread %zu", i + 1);
+        else
+            started++;
+    }
 
-                    // --------------------------------------------------------
-                    // decide the final alarm status
+    info("HEALTH: started %zu health threads", started);
 
-                    RRDCALC_STATUS status = RRDCALC_STATUS_UNDEFINED;
+    health_workers.threads = started;
+    health_workers.started = true;
+}
 
-                    switch (warning_status) {
-                        case RRDCALC_STATUS_CLEAR:
-                            status = RRDCALC_STATUS_CLEAR;
-                            break;
+static void health_workers_stop(void) {
+    netdata_mutex_lock(&health_workers.mutex);
+    pthread_cond_broadcast(&health_workers.cond);
+    netdata_mutex_unlock(&health_workers.mutex);
+}
 
-                        case RRDCALC_STATUS_RAISED:
-                            status = RRDCALC_STATUS_WARNING;
-                            break;
+/**
+ * Run
+ *
+ * Run all the hosts of a run, sharing them with the helper threads.
+ *
+ * @param run the hosts and the parameters of this run.
+ *
+ * @return the earliest time an alarm has to run again.
+ */
+static time_t health_run(struct health_run *run) {
+    size_t helpers = 0;
 
-                        default:
-                            break;
-                    }
+    if(health_workers.threads && run->hosts_count > 1) {
+        if(unlikely(!health_workers.started))
+            health_workers_start();
 
-                    switch (critical_status) {
-                        case RRDCALC_STATUS_CLEAR:
-                            if (status == RRDCALC_STATUS_UNDEFINED)
-                               status = RRDCALC_STATUS_CLEAR;
-                            break;
+        helpers = MIN(health_workers.threads, run->hosts_count - 1);
+    }
 
-                        case RRDCALC_STATUS_RAISED:
-                            status = RRDCALC_STATUS_CRITICAL;
-                            break;
+    if(helpers) {
+        netdata_mutex_lock(&health_workers.mutex);
+        health_workers.run = run;
+        health_workers.helpers_wanted = helpers;
+        health_workers.helpers_running = 0;
+        pthread_cond_broadcast(&health_workers.cond);
+        netdata_mutex_unlock(&health_workers.mutex);
+    }
 
-                        default:
-                            break;
-                    }
+    time_t next_run = health_run_hosts(run);
 
-                    // --------------------------------------------------------
-                    // check if the new status and the old differ
+    if(helpers) {
+        // all the hosts have been claimed, so the helpers that have not started yet are not needed
+        netdata_mutex_lock(&health_workers.mutex);
+        health_workers.helpers_wanted = 0;
+        while(health_workers.helpers_running)
+            pthread_cond_wait(&health_workers.done, &health_workers.mutex);
 
-                    if (status != rc->status) {
-                        worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
-                        int delay = 0;
+        if(run->next_run < next_run)
+            next_run = run->next_run;
 
-                        // apply trigger hysteresis
+        health_workers.run = NULL;
+        netdata_mutex_unlock(&health_workers.mutex);
+    }
 
-                        if (now > rc->delay_up_to_timestamp) {
-                            rc->delay_up_current = rc->delay_up_duration;
-                            rc->delay_down_current = rc->delay_down_duration;
-                            rc->delay_last = 0;
-                            rc->delay_up_to_timestamp = 0;
-                        } else {
-                            rc->delay_up_current = (int) (rc->delay_up_current * rc->delay_multiplier);
-                            if (rc->delay_up_current > rc->delay_max_duration)
-                                rc->delay_up_current = rc->delay_max_duration;
+    return next_run;
+}
 
-                            rc->delay_down_current = (int) (rc->delay_down_current * rc->delay_multiplier);
-                            if (rc->delay_down_current > rc->delay_max_duration)
-                                rc->delay_down_current = rc->delay_max_duration;
-                        }
+/**
+ * Health Main
+ *
+ * The main thread of the health system. In this function all the alarms will be processed.
+ *
+ * @param ptr is a pointer to the netdata_static_thread structure.
+ *
+ * @return It always returns NULL
+ */
 
-                        if (status > rc->status)
-                            delay = rc->delay_up_current;
-                        else
-                            delay = rc->delay_down_current;
-
-                        // COMMENTED: because we do need to send raising alarms
-                        // if(now + delay < rc->delay_up_to_timestamp)
-                        //      delay = (int)(rc->delay_up_to_timestamp - now);
-
-                        rc->delay_last = delay;
-                        rc->delay_up_to_timestamp = now + delay;
-
-
-                        ALARM_ENTRY *ae = health_create_alarm_entry(
-                            host,
-                            rc->id,
-                            rc->next_event_id++,
-                            rc->config_hash_id,
-                            now,
-                            rc->name,
-                            rc->rrdset->id,
-                            rc->rrdset->context,
-                            rc->rrdset->family,
-                            rc->classification,
-                            rc->component,
-                            rc->type,
-                            rc->exec,
-                            rc->recipient,
-                            now - rc->last_status_change,
-                            rc->old_value,
-                            rc->value,
-                            rc->status,
-                            status,
-                            rc->source,
-                            rc->units,
-                            rc->info,
-                            rc->delay_last,
-                            (
-                                ((rc->options & RRDCALC_OPTION_NO_CLEAR_NOTIFICATION)? HEALTH_ENTRY_FLAG_NO_CLEAR_NOTIFICATION : 0) |
-                                ((rc->run_flags & RRDCALC_FLAG_SILENCED)? HEALTH_ENTRY_FLAG_SILENCED : 0) |
-                                (rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0)
-                                )
-                        );
+void *health_main(void *ptr) {
+    health_worker_register();
 
-                        health_alarm_log_add_entry(host, ae);
+    netdata_thread_cleanup_push(health_main_cleanup, ptr);
 
-                        rc->last_status_change = now;
-                        rc->old_status = rc->status;
-                        rc->status = status;
-                    }
+    int min_run_every = (int)config_get_number(CONFIG_SECTION_HEALTH, "run at least every seconds", 10);
+    if(min_run_every < 1) min_run_every = 1;
 
-                    rc->last_updated = now;
-                    rc->next_update = now + rc->update_every;
+    int cleanup_sql_every_loop = 7200 / min_run_every;
 
-                    if (next_run > rc->next_update)
-                        next_run = rc->next_update;
-                }
-                foreach_rrdcalc_in_rrdhost_done(rc);
-
-                // process repeating alarms
-                foreach_rrdcalc_in_rrdhost_read(host, rc) {
-                    int repeat_every = 0;
-                    if(unlikely(rrdcalc_isrepeating(rc) && rc->delay_up_to_timestamp <= now)) {
-                        if(unlikely(rc->status == RRDCALC_STATUS_WARNING)) {
-                            rc->run_flags &= ~RRDCALC_FLAG_RUN_ONCE;
-                            repeat_every = rc->warn_repeat_every;
-                        } else if(unlikely(rc->status == RRDCALC_STATUS_CRITICAL)) {
-                            rc->run_flags &= ~RRDCALC_FLAG_RUN_ONCE;
-                            repeat_every = rc->crit_repeat_every;
-                        } else if(unlikely(rc->status == RRDCALC_STATUS_CLEAR)) {
-                            if(!(rc->run_flags & RRDCALC_FLAG_RUN_ONCE)) {
-                                if(rc->old_status == RRDCALC_STATUS_CRITICAL) {
-                                    repeat_every = 1;
-                                } else if (rc->old_status == RRDCALC_STATUS_WARNING) {
-                                    repeat_every = 1;
-                                }
-                            }
-                        }
-                    } else {
-                        continue;
-                    }
+    time_t now                = now_realtime_sec();
+    time_t hibernation_delay  = config_get_number(CONFIG_SECTION_HEALTH, "postpone alarms during hibernation for seconds", 60);
 
-                    if(unlikely(repeat_every > 0 && (rc->last_repeat + repeat_every) <= now)) {
-                        worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_ENTRY);
-                        rc->last_repeat = now;
-                        if (likely(rc->times_repeat < UINT32_MAX)) rc->times_repeat++;
-
-                        ALARM_ENTRY *ae = health_create_alarm_entry(
-                            host,
-                            rc->id,
-                            rc->next_event_id++,
-                            rc->config_hash_id,
-                            now,
-                            rc->name,
-                            rc->rrdset->id,
-                            rc->rrdset->context,
-                            rc->rrdset->family,
-                            rc->classification,
-                            rc->component,
-                            rc->type,
-                            rc->exec,
-                            rc->recipient,
-                            now - rc->last_status_change,
-                            rc->old_value,
-                            rc->value,
-                            rc->old_status,
-                            rc->status,
-                            rc->source,
-                            rc->units,
-                            rc->info,
-                            rc->delay_last,
-                            (
-                                ((rc->options & RRDCALC_OPTION_NO_CLEAR_NOTIFICATION)? HEALTH_ENTRY_FLAG_NO_CLEAR_NOTIFICATION : 0) |
-                                ((rc->run_flags & RRDCALC_FLAG_SILENCED)? HEALTH_ENTRY_FLAG_SILENCED : 0) |
-                                (rrdcalc_isrepeating(rc)?HEALTH_ENTRY_FLAG_IS_REPEATING:0)
-                                )
-                        );
+    long long threads = config_get_number(CONFIG_SECTION_HEALTH, "evaluation threads", MIN(get_system_cpus(), 4));
+    health_workers.threads = (threads > 1) ? (size_t)(threads - 1) : 0;
 
-                        ae->last_repeat = rc->last_repeat;
-                        if (!(rc->run_flags & RRDCALC_FLAG_RUN_ONCE) && rc->status == RRDCALC_STATUS_CLEAR) {
-                            ae->flags |= HEALTH_ENTRY_RUN_ONCE;
-                        }
-                        rc->run_flags |= RRDCALC_FLAG_RUN_ONCE;
-                        health_process_notifications(host, ae);
-                        debug(D_HEALTH, "Notification sent for the repeating alarm %u.", ae->alarm_id);
-                        health_alarm_wait_for_execution(ae);
-                        health_alarm_log_free_one_nochecks_nounlink(ae);
-                    }
-                }
-                foreach_rrdcalc_in_rrdhost_done(rc);
-            }
+    RRDHOST **hosts = NULL;
+    size_t hosts_size = 0;
 
-            if (unlikely(netdata_exit))
-                break;
+    rrdcalc_delete_alerts_not_matching_host_labels_from_all_hosts();
+
+    unsigned int loop = 0;
+#ifdef ENABLE_ACLK
+    unsigned int marked_aclk_reload_loop = 0;
+#endif
+    while(!netdata_exit) {
+        loop++;
+        debug(D_HEALTH, "Health monitoring iteration no %u started", loop);
 
-            // execute notifications
-            // and cleanup
-            worker_is_busy(WORKER_HEALTH_JOB_ALARM_LOG_PROCESS);
-            health_alarm_log_process(host);
+        int apply_hibernation_delay = 0;
+        time_t next_run = now + min_run_every;
 
-            if (unlikely(netdata_exit)) {
-                // wait for all notifications to finish before allowing health to be cleaned up
-                ALARM_ENTRY *ae;
-                while (NULL != (ae = alarm_notifications_in_progress.head)) {
-                    health_alarm_wait_for_execution(ae);
-                }
-                break;
+        if (unlikely(check_if_resumed_from_suspension())) {
+            apply_hibernation_delay = 1;
+
+            info(
+                "Postponing alarm checks for %"PRId64" seconds, "
+                "because it seems that the system was just resumed from suspension.",
+                (int64_t)hibernation_delay);
+        }
+
+        if (unlikely(silencers->all_alarms && silencers->stype == STYPE_DISABLE_ALARMS)) {
+            static int logged=0;
+            if (!logged) {
+                info("Skipping health checks, because all alarms are disabled via a %s command.",
+                     HEALTH_CMDAPI_CMD_DISABLEALL);
+                logged = 1;
             }
+        }
+
+#ifdef ENABLE_ACLK
+        if (aclk_alert_reloaded && !marked_aclk_reload_loop)
+            marked_aclk_reload_loop = loop;
+#endif
 
-        } /* rrdhost_foreach */
+        worker_is_busy(WORKER_HEALTH_JOB_RRD_LOCK);
+        rrd_rdlock();
 
-        // wait for all notifications to finish before allowing health to be cleaned up
-        ALARM_ENTRY *ae;
-        while (NULL != (ae = alarm_notifications_in_progress.head)) {
-            health_alarm_wait_for_execution(ae);
+        RRDHOST *host;
+
+        // the hosts of this run, to be shared by the health threads
+        size_t hosts_count = 0;
+        rrdhost_foreach_read(host) {
+            if (unlikely(!host->health_enabled))
+                continue;
+
+            if (unlikely(hosts_count == hosts_size)) {
+                hosts_size = hosts_size ? hosts_size * 2 : 16;
+                hosts = reallocz(hosts, hosts_size * sizeof(RRDHOST *));
+            }
+            hosts[hosts_count++] = host;
         }
 
+        struct health_run run = {
+            .now = now,
+            .loop = loop,
+            .cleanup_sql_every_loop = cleanup_sql_every_loop,
+            .apply_hibernation_delay = apply_hibernation_delay,
+            .hibernation_delay = hibernation_delay,
+            .first_next_run = next_run,
+            .next_run = next_run,
+            .hosts = hosts,
+            .hosts_count = hosts_count,
+            .next_host = 0,
+        };
+        next_run = health_run(&run);
+
 #ifdef ENABLE_ACLK
         if (netdata_cloud_setting && unlikely(aclk_alert_reloaded) && loop > (marked_aclk_reload_loop + 2)) {
                 rrdhost_foreach_read(host) {
@@ -1304,6 +1534,8 @@ void *health_main(void *ptr) {
 
     } // forever
 
+    freez(hosts);
+
     netdata_thread_cleanup_pop(1);
     return NULL;
 }
@@ -39,6 +39,10 @@ void buffer_reset(BUFFER *wb)
     wb->date = 0;
     wb->expires = 0;
 
+    wb->stream_callback = NULL;
+    wb->stream_data = NULL;
+    wb->stream_threshold = 0;
+
     buffer_overflow_check(wb);
 }
 
@@ -377,6 +381,20 @@ void buffer_rrd_value(BUFFER *wb, NETDATA_DOUBLE value)
     buffer_overflow_check(wb);
 }
 
+// the same as buffer_sprintf(wb, NETDATA_DOUBLE_FORMAT, value), but faster
+void buffer_print_netdata_double_fixed(BUFFER *wb, NETDATA_DOUBLE value)
+{
+    if(unlikely(!netdata_double_isnumber(value) || fabsndd(value) >= (NETDATA_DOUBLE)1e18)) {
+        buffer_sprintf(wb, NETDATA_DOUBLE_FORMAT, value);
+        return;
+    }
+
+    buffer_need_bytes(wb, 50);
+    wb->len += print_netdata_double_fixed(&wb->buffer[wb->len], value);
+
+    buffer_overflow_check(wb);
+}
+
 // generate a javascript date, the fastest possible way...
 void buffer_jsdate(BUFFER *wb, int year, int month, int day, int hours, int minutes, int seconds)
 {
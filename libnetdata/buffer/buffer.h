@@ -15,6 +15,11 @@ typedef struct web_buffer {
     uint8_t options;		// options related to the content
     time_t date;    		// the timestamp this content has been generated
     time_t expires;			// the timestamp this content expires
+
+    // the consumer of a streamed buffer, see buffer_stream_checkpoint()
+    void (*stream_callback)(struct web_buffer *wb, void *data);
+    void *stream_data;
+    size_t stream_threshold;
 } BUFFER;
 
 // options
@@ -57,6 +62,7 @@ extern void buffer_reset(BUFFER *wb);
 extern void buffer_strcat(BUFFER *wb, const char *txt);
 extern void buffer_fast_strcat(BUFFER *wb, const char *txt, size_t len);
 extern void buffer_rrd_value(BUFFER *wb, NETDATA_DOUBLE value);
+extern void buffer_print_netdata_double_fixed(BUFFER *wb, NETDATA_DOUBLE value);
 
 extern void buffer_date(BUFFER *wb, int year, int month, int day, int hours, int minutes, int seconds);
 extern void buffer_jsdate(BUFFER *wb, int year, int month, int day, int hours, int minutes, int seconds);
@@ -86,4 +92,11 @@ static inline void buffer_need_bytes(BUFFER *buffer, size_t needed_free_size) {
         buffer_increase(buffer, needed_free_size);
 }
 
+// formatters call this between the items they write, so that when the buffer is streamed,
+// its consumer can take (and remove from the buffer) the content written so far
+static inline void buffer_stream_checkpoint(BUFFER *wb) {
+    if(unlikely(wb->stream_callback && wb->len >= wb->stream_threshold))
+        wb->stream_callback(wb, wb->stream_data);
+}
+
 #endif /* NETDATA_WEB_BUFFER_H */
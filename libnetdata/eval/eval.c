@@ -49,321 +49,152 @@ typedef struct eval_node {
 #define EVAL_OPERATOR_IF_THEN_ELSE          '?'
 
 // ----------------------------------------------------------------------------
-// forward function definitions
+// data structures for storing the compiled expression in memory
+//
+// The parsed tree is compiled to a flat list of instructions working on
+// registers, so that evaluating an expression does not recurse into the tree.
+// The variables of the expression are resolved to slots, which are kept until
+// the variables of the alarm change.
+
+typedef enum eval_opcode {
+    EVAL_OPCODE_ERROR = 0,                  // r[dst] = 0, the error is set to error
+    EVAL_OPCODE_CONSTANT,                   // r[dst] = number
+    EVAL_OPCODE_NAMED_CONSTANT,             // r[dst] = number, e.g. $WARNING
+    EVAL_OPCODE_VARIABLE,                   // r[dst] = the value of the variable in slot
+    EVAL_OPCODE_THIS,                       // r[dst] = $this
+    EVAL_OPCODE_AFTER,                      // r[dst] = $after
+    EVAL_OPCODE_BEFORE,                     // r[dst] = $before
+    EVAL_OPCODE_NOW,                        // r[dst] = $now
+    EVAL_OPCODE_STATUS,                     // r[dst] = $status
+    EVAL_OPCODE_TRUTH,                      // r[dst] = is_true(r[a])
+    EVAL_OPCODE_JUMP,                       // continue at jump
+    EVAL_OPCODE_JUMP_IF_FALSE,              // continue at jump, if r[a] is false
+    EVAL_OPCODE_JUMP_IF_TRUE,               // continue at jump, if r[a] is true
+    EVAL_OPCODE_NOT,                        // r[dst] = !r[a]
+    EVAL_OPCODE_SIGN_MINUS,                 // r[dst] = -r[a]
+    EVAL_OPCODE_ABS,                        // r[dst] = abs(r[a])
+    EVAL_OPCODE_GREATER_THAN_OR_EQUAL,      // r[dst] = r[a] >= r[b]
+    EVAL_OPCODE_LESS_THAN_OR_EQUAL,         // r[dst] = r[a] <= r[b]
+    EVAL_OPCODE_EQUAL,                      // r[dst] = r[a] == r[b]
+    EVAL_OPCODE_NOT_EQUAL,                  // r[dst] = r[a] != r[b]
+    EVAL_OPCODE_LESS,                       // r[dst] = r[a] < r[b]
+    EVAL_OPCODE_GREATER,                    // r[dst] = r[a] > r[b]
+    EVAL_OPCODE_PLUS,                       // r[dst] = r[a] + r[b]
+    EVAL_OPCODE_MINUS,                      // r[dst] = r[a] - r[b]
+    EVAL_OPCODE_MULTIPLY,                   // r[dst] = r[a] * r[b]
+    EVAL_OPCODE_DIVIDE,                     // r[dst] = r[a] / r[b]
+} EVAL_OPCODE;
+
+typedef struct eval_instruction {
+    EVAL_OPCODE opcode;
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
 
-static inline void eval_node_free(EVAL_NODE *op);
-static inline EVAL_NODE *parse_full_expression(const char **string, int *error);
-static inline EVAL_NODE *parse_one_full_operand(const char **string, int *error);
-static inline NETDATA_DOUBLE eval_node(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error);
-static inline void print_parsed_as_node(BUFFER *out, EVAL_NODE *op, int *error);
-static inline void print_parsed_as_constant(BUFFER *out, NETDATA_DOUBLE n);
+    union {
+        NETDATA_DOUBLE number;              // constants
+        uint32_t slot;                      // variables
+        uint32_t jump;                      // jumps
+        int error;                          // errors
+    };
 
-// ----------------------------------------------------------------------------
-// evaluation of expressions
-
-static inline NETDATA_DOUBLE eval_variable(EVAL_EXPRESSION *exp, EVAL_VARIABLE *v, int *error) {
-    static STRING
-        *this_string = NULL,
-        *now_string = NULL,
-        *after_string = NULL,
-        *before_string = NULL,
-        *status_string = NULL,
-        *removed_string = NULL,
-        *uninitialized_string = NULL,
-        *undefined_string = NULL,
-        *clear_string = NULL,
-        *warning_string = NULL,
-        *critical_string = NULL;
-
-    NETDATA_DOUBLE n;
-
-    if(unlikely(this_string == NULL)) {
-        this_string = string_strdupz("this");
-        now_string = string_strdupz("now");
-        after_string = string_strdupz("after");
-        before_string = string_strdupz("before");
-        status_string = string_strdupz("status");
-        removed_string = string_strdupz("REMOVED");
-        uninitialized_string = string_strdupz("UNINITIALIZED");
-        undefined_string = string_strdupz("UNDEFINED");
-        clear_string = string_strdupz("CLEAR");
-        warning_string = string_strdupz("WARNING");
-        critical_string = string_strdupz("CRITICAL");
-    }
-
-    if(unlikely(v->name == this_string)) {
-        n = (exp->myself)?*exp->myself:NAN;
-        buffer_strcat(exp->error_msg, "[ $this = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == after_string)) {
-        n = (exp->after && *exp->after)?*exp->after:NAN;
-        buffer_strcat(exp->error_msg, "[ $after = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == before_string)) {
-        n = (exp->before && *exp->before)?*exp->before:NAN;
-        buffer_strcat(exp->error_msg, "[ $before = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == now_string)) {
-        n = (NETDATA_DOUBLE)now_realtime_sec();
-        buffer_strcat(exp->error_msg, "[ $now = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == status_string)) {
-        n = (exp->status)?*exp->status:RRDCALC_STATUS_UNINITIALIZED;
-        buffer_strcat(exp->error_msg, "[ $status = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == removed_string)) {
-        n = RRDCALC_STATUS_REMOVED;
-        buffer_strcat(exp->error_msg, "[ $REMOVED = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == uninitialized_string)) {
-        n = RRDCALC_STATUS_UNINITIALIZED;
-        buffer_strcat(exp->error_msg, "[ $UNINITIALIZED = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == undefined_string)) {
-        n = RRDCALC_STATUS_UNDEFINED;
-        buffer_strcat(exp->error_msg, "[ $UNDEFINED = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == clear_string)) {
-        n = RRDCALC_STATUS_CLEAR;
-        buffer_strcat(exp->error_msg, "[ $CLEAR = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
-
-    if(unlikely(v->name == warning_string)) {
-        n = RRDCALC_STATUS_WARNING;
-        buffer_strcat(exp->error_msg, "[ $WARNING = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
+    STRING *name;                           // the name of named constants and special variables, for the trace
+} EVAL_INSTRUCTION;
 
-    if(unlikely(v->name == critical_string)) {
-        n = RRDCALC_STATUS_CRITICAL;
-        buffer_strcat(exp->error_msg, "[ $CRITICAL = ");
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
+typedef enum eval_slot_state {
+    EVAL_SLOT_UNRESOLVED = 0,
+    EVAL_SLOT_FOUND,
+    EVAL_SLOT_NOT_FOUND,
+} EVAL_SLOT_STATE;
 
-    if(exp->rrdcalc && health_variable_lookup(v->name, exp->rrdcalc, &n)) {
-        buffer_sprintf(exp->error_msg, "[ ${%s} = ", string2str(v->name));
-        print_parsed_as_constant(exp->error_msg, n);
-        buffer_strcat(exp->error_msg, " ] ");
-        return n;
-    }
+typedef struct eval_slot {
+    STRING *name;
+    EVAL_SLOT_STATE state;
 
-    *error = EVAL_ERROR_UNKNOWN_VARIABLE;
-    buffer_sprintf(exp->error_msg, "[ undefined variable '%s' ] ", string2str(v->name));
-    return NAN;
-}
+    // when found, the acquired variable and the index it was found in
+    DICTIONARY *dict;
+    DICT_ITEM_CONST DICTIONARY_ITEM *item;
+} EVAL_SLOT;
 
-static inline NETDATA_DOUBLE eval_value(EVAL_EXPRESSION *exp, EVAL_VALUE *v, int *error) {
-    NETDATA_DOUBLE n;
+// a value loaded by the last evaluation, for its trace
+typedef struct eval_trace_entry {
+    uint32_t instruction;                   // the instruction that loaded it
+    bool undefined;                         // the variable was not found
+    NETDATA_DOUBLE value;
+} EVAL_TRACE_ENTRY;
 
-    switch(v->type) {
-        case EVAL_VALUE_EXPRESSION:
-            n = eval_node(exp, v->expression, error);
-            break;
+typedef struct eval_program {
+    EVAL_INSTRUCTION *instructions;
+    uint32_t instructions_count;
+    uint32_t instructions_size;
 
-        case EVAL_VALUE_NUMBER:
-            n = v->number;
-            break;
+    NETDATA_DOUBLE *registers;
+    uint32_t registers_count;
 
-        case EVAL_VALUE_VARIABLE:
-            n = eval_variable(exp, v->variable, error);
-            break;
+    EVAL_SLOT *slots;
+    uint32_t slots_count;
 
-        default:
-            *error = EVAL_ERROR_INVALID_VALUE;
-            n = 0;
-            break;
-    }
+    // the variables of the alarm the slots have been resolved for
+    const void *variables_scope;
+    size_t variables_version;
 
-    return n;
-}
+    // the values loaded by the last evaluation, in the order they were loaded
+    // the program jumps only forward, so there is one entry at most for each instruction loading a value
+    EVAL_TRACE_ENTRY *trace;
+    uint32_t trace_count;
 
-static inline int is_true(NETDATA_DOUBLE n) {
-    if(isnan(n)) return 0;
-    if(isinf(n)) return 1;
-    if(n == 0) return 0;
-    return 1;
-}
+    // the trace of the last evaluation has not been formatted yet
+    bool trace_pending;
+} EVAL_PROGRAM;
 
-NETDATA_DOUBLE eval_and(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return is_true(eval_value(exp, &op->ops[0], error)) && is_true(eval_value(exp, &op->ops[1], error));
-}
-NETDATA_DOUBLE eval_or(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return is_true(eval_value(exp, &op->ops[0], error)) || is_true(eval_value(exp, &op->ops[1], error));
-}
-NETDATA_DOUBLE eval_greater_than_or_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isgreaterequal(n1, n2);
-}
-NETDATA_DOUBLE eval_less_than_or_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return islessequal(n1, n2);
-}
-NETDATA_DOUBLE eval_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) && isnan(n2)) return 1;
-    if(isinf(n1) && isinf(n2)) return 1;
-    if(isnan(n1) || isnan(n2)) return 0;
-    if(isinf(n1) || isinf(n2)) return 0;
-    return considered_equal_ndd(n1, n2);
-}
-NETDATA_DOUBLE eval_not_equal(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return !eval_equal(exp, op, error);
-}
-NETDATA_DOUBLE eval_less(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isless(n1, n2);
-}
-NETDATA_DOUBLE eval_greater(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    return isgreater(n1, n2);
-}
-NETDATA_DOUBLE eval_plus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 + n2;
-}
-NETDATA_DOUBLE eval_minus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 - n2;
-}
-NETDATA_DOUBLE eval_multiply(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 * n2;
-}
-NETDATA_DOUBLE eval_divide(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    NETDATA_DOUBLE n2 = eval_value(exp, &op->ops[1], error);
-    if(isnan(n1) || isnan(n2)) return NAN;
-    if(isinf(n1) || isinf(n2)) return INFINITY;
-    return n1 / n2;
-}
-NETDATA_DOUBLE eval_nop(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return eval_value(exp, &op->ops[0], error);
-}
-NETDATA_DOUBLE eval_not(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return !is_true(eval_value(exp, &op->ops[0], error));
-}
-NETDATA_DOUBLE eval_sign_plus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    return eval_value(exp, &op->ops[0], error);
-}
-NETDATA_DOUBLE eval_sign_minus(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    if(isnan(n1)) return NAN;
-    if(isinf(n1)) return INFINITY;
-    return -n1;
-}
-NETDATA_DOUBLE eval_abs(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    NETDATA_DOUBLE n1 = eval_value(exp, &op->ops[0], error);
-    if(isnan(n1)) return NAN;
-    if(isinf(n1)) return INFINITY;
-    return ABS(n1);
-}
-NETDATA_DOUBLE eval_if_then_else(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    if(is_true(eval_value(exp, &op->ops[0], error)))
-        return eval_value(exp, &op->ops[1], error);
-    else
-        return eval_value(exp, &op->ops[2], error);
-}
+// ----------------------------------------------------------------------------
+// forward function definitions
+
+static inline void eval_node_free(EVAL_NODE *op);
+static inline EVAL_NODE *parse_full_expression(const char **string, int *error);
+static inline EVAL_NODE *parse_one_full_operand(const char **string, int *error);
+static void eval_compile_node(EVAL_PROGRAM *p, EVAL_NODE *op, uint32_t dst);
+static inline void print_parsed_as_node(BUFFER *out, EVAL_NODE *op, int *error);
+static inline void print_parsed_as_constant(BUFFER *out, NETDATA_DOUBLE n);
+
+// ----------------------------------------------------------------------------
+// operators
 
 static struct operator {
     const char *print_as;
     char precedence;
     char parameters;
     char isfunction;
-    NETDATA_DOUBLE (*eval)(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error);
 } operators[256] = {
         // this is a random access array
         // we always access it with a known EVAL_OPERATOR_X
 
-        [EVAL_OPERATOR_AND]                   = { "&&", 2, 2, 0, eval_and },
-        [EVAL_OPERATOR_OR]                    = { "||", 2, 2, 0, eval_or },
-        [EVAL_OPERATOR_GREATER_THAN_OR_EQUAL] = { ">=", 3, 2, 0, eval_greater_than_or_equal },
-        [EVAL_OPERATOR_LESS_THAN_OR_EQUAL]    = { "<=", 3, 2, 0, eval_less_than_or_equal },
-        [EVAL_OPERATOR_NOT_EQUAL]             = { "!=", 3, 2, 0, eval_not_equal },
-        [EVAL_OPERATOR_EQUAL]                 = { "==", 3, 2, 0, eval_equal },
-        [EVAL_OPERATOR_LESS]                  = { "<",  3, 2, 0, eval_less },
-        [EVAL_OPERATOR_GREATER]               = { ">",  3, 2, 0, eval_greater },
-        [EVAL_OPERATOR_PLUS]                  = { "+",  4, 2, 0, eval_plus },
-        [EVAL_OPERATOR_MINUS]                 = { "-",  4, 2, 0, eval_minus },
-        [EVAL_OPERATOR_MULTIPLY]              = { "*",  5, 2, 0, eval_multiply },
-        [EVAL_OPERATOR_DIVIDE]                = { "/",  5, 2, 0, eval_divide },
-        [EVAL_OPERATOR_NOT]                   = { "!",  6, 1, 0, eval_not },
-        [EVAL_OPERATOR_SIGN_PLUS]             = { "+",  6, 1, 0, eval_sign_plus },
-        [EVAL_OPERATOR_SIGN_MINUS]            = { "-",  6, 1, 0, eval_sign_minus },
-        [EVAL_OPERATOR_ABS]                   = { "abs(",6,1, 1, eval_abs },
-        [EVAL_OPERATOR_IF_THEN_ELSE]          = { "?",  7, 3, 0, eval_if_then_else },
-        [EVAL_OPERATOR_NOP]                   = { NULL, 8, 1, 0, eval_nop },
-        [EVAL_OPERATOR_EXPRESSION_OPEN]       = { NULL, 8, 1, 0, eval_nop },
+        [EVAL_OPERATOR_AND]                   = { "&&", 2, 2, 0 },
+        [EVAL_OPERATOR_OR]                    = { "||", 2, 2, 0 },
+        [EVAL_OPERATOR_GREATER_THAN_OR_EQUAL] = { ">=", 3, 2, 0 },
+        [EVAL_OPERATOR_LESS_THAN_OR_EQUAL]    = { "<=", 3, 2, 0 },
+        [EVAL_OPERATOR_NOT_EQUAL]             = { "!=", 3, 2, 0 },
+        [EVAL_OPERATOR_EQUAL]                 = { "==", 3, 2, 0 },
+        [EVAL_OPERATOR_LESS]                  = { "<",  3, 2, 0 },
+        [EVAL_OPERATOR_GREATER]               = { ">",  3, 2, 0 },
+        [EVAL_OPERATOR_PLUS]                  = { "+",  4, 2, 0 },
+        [EVAL_OPERATOR_MINUS]                 = { "-",  4, 2, 0 },
+        [EVAL_OPERATOR_MULTIPLY]              = { "*",  5, 2, 0 },
+        [EVAL_OPERATOR_DIVIDE]                = { "/",  5, 2, 0 },
+        [EVAL_OPERATOR_NOT]                   = { "!",  6, 1, 0 },
+        [EVAL_OPERATOR_SIGN_PLUS]             = { "+",  6, 1, 0 },
+        [EVAL_OPERATOR_SIGN_MINUS]            = { "-",  6, 1, 0 },
+        [EVAL_OPERATOR_ABS]                   = { "abs(",6,1, 1 },
+        [EVAL_OPERATOR_IF_THEN_ELSE]          = { "?",  7, 3, 0 },
+        [EVAL_OPERATOR_NOP]                   = { NULL, 8, 1, 0 },
+        [EVAL_OPERATOR_EXPRESSION_OPEN]       = { NULL, 8, 1, 0 },
 
         // this should exist in our evaluation list
-        [EVAL_OPERATOR_EXPRESSION_CLOSE]      = { NULL, 99, 1, 0, eval_nop }
+        [EVAL_OPERATOR_EXPRESSION_CLOSE]      = { NULL, 99, 1, 0 }
 };
 
 #define eval_precedence(operator) (operators[(unsigned char)(operator)].precedence)
 
-static inline NETDATA_DOUBLE eval_node(EVAL_EXPRESSION *exp, EVAL_NODE *op, int *error) {
-    if(unlikely(op->count != operators[op->operator].parameters)) {
-        *error = EVAL_ERROR_INVALID_NUMBER_OF_OPERANDS;
-        return 0;
-    }
-
-    NETDATA_DOUBLE n = operators[op->operator].eval(exp, op, error);
-
-    return n;
-}
-
 // ----------------------------------------------------------------------------
 // parsed-as generation
 
@@ -465,6 +296,246 @@ static inline void print_parsed_as_node(BUFFER *out, EVAL_NODE *op, int *error)
         buffer_strcat(out, ")");
 }
 
+// ----------------------------------------------------------------------------
+// evaluation of compiled expressions
+
+static inline int is_true(NETDATA_DOUBLE n) {
+    if(isnan(n)) return 0;
+    if(isinf(n)) return 1;
+    if(n == 0) return 0;
+    return 1;
+}
+
+static inline NETDATA_DOUBLE eval_equal(NETDATA_DOUBLE n1, NETDATA_DOUBLE n2) {
+    if(isnan(n1) && isnan(n2)) return 1;
+    if(isinf(n1) && isinf(n2)) return 1;
+    if(isnan(n1) || isnan(n2)) return 0;
+    if(isinf(n1) || isinf(n2)) return 0;
+    return considered_equal_ndd(n1, n2);
+}
+
+static inline NETDATA_DOUBLE eval_arithmetic(EVAL_OPCODE opcode, NETDATA_DOUBLE n1, NETDATA_DOUBLE n2) {
+    if(isnan(n1) || isnan(n2)) return NAN;
+    if(isinf(n1) || isinf(n2)) return INFINITY;
+
+    switch(opcode) {
+        case EVAL_OPCODE_PLUS:
+            return n1 + n2;
+
+        case EVAL_OPCODE_MINUS:
+            return n1 - n2;
+
+        case EVAL_OPCODE_MULTIPLY:
+            return n1 * n2;
+
+        default:
+            return n1 / n2;
+    }
+}
+
+static inline void eval_slots_release(EVAL_PROGRAM *p) {
+    uint32_t i;
+    for(i = 0; i < p->slots_count ;i++) {
+        EVAL_SLOT *s = &p->slots[i];
+
+        if(s->item)
+            dictionary_acquired_item_release(s->dict, s->item);
+
+        s->item = NULL;
+        s->dict = NULL;
+        s->state = EVAL_SLOT_UNRESOLVED;
+    }
+}
+
+// the slots are resolved again, only when the variables of the alarm change
+static inline void eval_slots_check_version(EVAL_EXPRESSION *exp, EVAL_PROGRAM *p) {
+    if(!p->slots_count || !exp->rrdcalc)
+        return;
+
+    const void *scope = NULL;
+    size_t version = health_variable_lookup_version(exp->rrdcalc, &scope);
+
+    if(unlikely(version != p->variables_version || scope != p->variables_scope)) {
+        eval_slots_release(p);
+        p->variables_version = version;
+        p->variables_scope = scope;
+    }
+}
+
+static inline void eval_slot_resolve(EVAL_EXPRESSION *exp, EVAL_SLOT *s) {
+    s->item = (exp->rrdcalc) ? health_variable_acquire(s->name, exp->rrdcalc, &s->dict) : NULL;
+    s->state = (s->item) ? EVAL_SLOT_FOUND : EVAL_SLOT_NOT_FOUND;
+}
+
+static inline void eval_trace_value(BUFFER *trace, const char *prefix, STRING *name, const char *suffix, NETDATA_DOUBLE n) {
+    buffer_sprintf(trace, "[ %s%s%s = ", prefix, string2str(name), suffix);
+    print_parsed_as_constant(trace, n);
+    buffer_strcat(trace, " ] ");
+}
+
+static inline void eval_trace_add(EVAL_PROGRAM *p, uint32_t instruction, bool undefined, NETDATA_DOUBLE value) {
+    EVAL_TRACE_ENTRY *t = &p->trace[p->trace_count++];
+    t->instruction = instruction;
+    t->undefined = undefined;
+    t->value = value;
+}
+
+// formats the values loaded by the last evaluation
+static void eval_trace_format(EVAL_PROGRAM *p, BUFFER *trace) {
+    uint32_t i;
+    for(i = 0; i < p->trace_count ;i++) {
+        EVAL_TRACE_ENTRY *t = &p->trace[i];
+        EVAL_INSTRUCTION *ins = &p->instructions[t->instruction];
+
+        if(ins->opcode == EVAL_OPCODE_VARIABLE) {
+            STRING *name = p->slots[ins->slot].name;
+
+            if(t->undefined)
+                buffer_sprintf(trace, "[ undefined variable '%s' ] ", string2str(name));
+            else
+                eval_trace_value(trace, "${", name, "}", t->value);
+        }
+        else
+            eval_trace_value(trace, "$", ins->name, "", t->value);
+    }
+}
+
+// run the program of an expression
+// the values of all the variables used are kept in the trace of the program
+static NETDATA_DOUBLE eval_program_run(EVAL_EXPRESSION *exp, EVAL_PROGRAM *p, int *error) {
+    NETDATA_DOUBLE *r = p->registers;
+    EVAL_INSTRUCTION *ins;
+    uint32_t pc = 0;
+
+    p->trace_count = 0;
+
+    while(pc < p->instructions_count) {
+        ins = &p->instructions[pc++];
+
+        switch(ins->opcode) {
+            case EVAL_OPCODE_CONSTANT:
+                r[ins->dst] = ins->number;
+                break;
+
+            case EVAL_OPCODE_VARIABLE: {
+                EVAL_SLOT *s = &p->slots[ins->slot];
+
+                if(unlikely(s->state == EVAL_SLOT_UNRESOLVED))
+                    eval_slot_resolve(exp, s);
+
+                if(likely(s->state == EVAL_SLOT_FOUND)) {
+                    r[ins->dst] = health_variable_value(s->item);
+                    eval_trace_add(p, pc - 1, false, r[ins->dst]);
+                }
+                else {
+                    r[ins->dst] = NAN;
+                    *error = EVAL_ERROR_UNKNOWN_VARIABLE;
+                    eval_trace_add(p, pc - 1, true, NAN);
+                }
+                continue;
+            }
+
+            case EVAL_OPCODE_NAMED_CONSTANT:
+                r[ins->dst] = ins->number;
+                goto traced;
+
+            case EVAL_OPCODE_THIS:
+                r[ins->dst] = (exp->myself)?*exp->myself:NAN;
+                goto traced;
+
+            case EVAL_OPCODE_AFTER:
+                r[ins->dst] = (exp->after && *exp->after)?*exp->after:NAN;
+                goto traced;
+
+            case EVAL_OPCODE_BEFORE:
+                r[ins->dst] = (exp->before && *exp->before)?*exp->before:NAN;
+                goto traced;
+
+            case EVAL_OPCODE_NOW:
+                r[ins->dst] = (NETDATA_DOUBLE)now_realtime_sec();
+                goto traced;
+
+            case EVAL_OPCODE_STATUS:
+                r[ins->dst] = (exp->status)?*exp->status:RRDCALC_STATUS_UNINITIALIZED;
+                goto traced;
+
+            case EVAL_OPCODE_TRUTH:
+                r[ins->dst] = is_true(r[ins->a]);
+                break;
+
+            case EVAL_OPCODE_JUMP:
+                pc = ins->jump;
+                break;
+
+            case EVAL_OPCODE_JUMP_IF_FALSE:
+                if(!is_true(r[ins->a]))
+                    pc = ins->jump;
+                break;
+
+            case EVAL_OPCODE_JUMP_IF_TRUE:
+                if(is_true(r[ins->a]))
+                    pc = ins->jump;
+                break;
+
+            case EVAL_OPCODE_NOT:
+                r[ins->dst] = !is_true(r[ins->a]);
+                break;
+
+            case EVAL_OPCODE_SIGN_MINUS:
+            case EVAL_OPCODE_ABS: {
+                NETDATA_DOUBLE n1 = r[ins->a];
+                if(isnan(n1)) r[ins->dst] = NAN;
+                else if(isinf(n1)) r[ins->dst] = INFINITY;
+                else r[ins->dst] = (ins->opcode == EVAL_OPCODE_ABS) ? ABS(n1) : -n1;
+                break;
+            }
+
+            case EVAL_OPCODE_GREATER_THAN_OR_EQUAL:
+                r[ins->dst] = isgreaterequal(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_LESS_THAN_OR_EQUAL:
+                r[ins->dst] = islessequal(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_EQUAL:
+                r[ins->dst] = eval_equal(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_NOT_EQUAL:
+                r[ins->dst] = !eval_equal(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_LESS:
+                r[ins->dst] = isless(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_GREATER:
+                r[ins->dst] = isgreater(r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_PLUS:
+            case EVAL_OPCODE_MINUS:
+            case EVAL_OPCODE_MULTIPLY:
+            case EVAL_OPCODE_DIVIDE:
+                r[ins->dst] = eval_arithmetic(ins->opcode, r[ins->a], r[ins->b]);
+                break;
+
+            case EVAL_OPCODE_ERROR:
+            default:
+                r[ins->dst] = 0;
+                *error = ins->error;
+                break;
+        }
+        continue;
+
+    traced:
+        eval_trace_add(p, pc - 1, false, r[ins->dst]);
+    }
+
+    return r[0];
+}
+
 // ----------------------------------------------------------------------------
 // parsing expressions
 
@@ -1067,14 +1138,242 @@ static inline EVAL_NODE *parse_full_expression(const char **string, int *error)
     return parse_rest_of_expression(string, error, op1);
 }
 
+// ----------------------------------------------------------------------------
+// compiling the parsed expression
+
+static inline EVAL_INSTRUCTION *eval_program_add(EVAL_PROGRAM *p, EVAL_OPCODE opcode, uint32_t dst) {
+    if(unlikely(p->instructions_count == p->instructions_size)) {
+        p->instructions_size = (p->instructions_size) ? p->instructions_size * 2 : 8;
+        p->instructions = reallocz(p->instructions, p->instructions_size * sizeof(EVAL_INSTRUCTION));
+    }
+
+    if(dst >= p->registers_count)
+        p->registers_count = dst + 1;
+
+    EVAL_INSTRUCTION *ins = &p->instructions[p->instructions_count++];
+    memset(ins, 0, sizeof(*ins));
+    ins->opcode = opcode;
+    ins->dst = dst;
+    return ins;
+}
+
+static inline void eval_program_add_error(EVAL_PROGRAM *p, uint32_t dst, int error) {
+    eval_program_add(p, EVAL_OPCODE_ERROR, dst)->error = error;
+}
+
+// jumps are added before their target is known, so they are referred to by their position
+static inline uint32_t eval_program_add_jump(EVAL_PROGRAM *p, EVAL_OPCODE opcode, uint32_t a) {
+    EVAL_INSTRUCTION *ins = eval_program_add(p, opcode, 0);
+    ins->a = a;
+    return p->instructions_count - 1;
+}
+
+static inline void eval_program_set_jump_target(EVAL_PROGRAM *p, uint32_t jump) {
+    p->instructions[jump].jump = p->instructions_count;
+}
+
+static inline uint32_t eval_program_slot(EVAL_PROGRAM *p, STRING *name) {
+    uint32_t i;
+    for(i = 0; i < p->slots_count ;i++)
+        if(p->slots[i].name == name)
+            return i;
+
+    p->slots = reallocz(p->slots, (p->slots_count + 1) * sizeof(EVAL_SLOT));
+    memset(&p->slots[p->slots_count], 0, sizeof(EVAL_SLOT));
+    p->slots[p->slots_count].name = string_dup(name);
+    return p->slots_count++;
+}
+
+static struct special_variable {
+    const char *name;
+    EVAL_OPCODE opcode;
+    NETDATA_DOUBLE number;
+} special_variables[] = {
+        { "this",          EVAL_OPCODE_THIS,           0 },
+        { "after",         EVAL_OPCODE_AFTER,          0 },
+        { "before",        EVAL_OPCODE_BEFORE,         0 },
+        { "now",           EVAL_OPCODE_NOW,            0 },
+        { "status",        EVAL_OPCODE_STATUS,         0 },
+        { "REMOVED",       EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_REMOVED },
+        { "UNINITIALIZED", EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_UNINITIALIZED },
+        { "UNDEFINED",     EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_UNDEFINED },
+        { "CLEAR",         EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_CLEAR },
+        { "WARNING",       EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_WARNING },
+        { "CRITICAL",      EVAL_OPCODE_NAMED_CONSTANT, RRDCALC_STATUS_CRITICAL },
+
+        // terminator
+        { NULL,            EVAL_OPCODE_ERROR,          0 },
+};
+
+static inline void eval_compile_variable(EVAL_PROGRAM *p, EVAL_VARIABLE *v, uint32_t dst) {
+    const char *name = string2str(v->name);
+
+    int i;
+    for(i = 0; special_variables[i].name ;i++) {
+        if(!strcmp(name, special_variables[i].name)) {
+            EVAL_INSTRUCTION *ins = eval_program_add(p, special_variables[i].opcode, dst);
+            ins->number = special_variables[i].number;
+            ins->name = string_dup(v->name);
+            return;
+        }
+    }
+
+    uint32_t slot = eval_program_slot(p, v->name);
+    eval_program_add(p, EVAL_OPCODE_VARIABLE, dst)->slot = slot;
+}
+
+static inline void eval_compile_value(EVAL_PROGRAM *p, EVAL_VALUE *v, uint32_t dst) {
+    switch(v->type) {
+        case EVAL_VALUE_EXPRESSION:
+            eval_compile_node(p, v->expression, dst);
+            break;
+
+        case EVAL_VALUE_NUMBER:
+            eval_program_add(p, EVAL_OPCODE_CONSTANT, dst)->number = v->number;
+            break;
+
+        case EVAL_VALUE_VARIABLE:
+            eval_compile_variable(p, v->variable, dst);
+            break;
+
+        default:
+            eval_program_add_error(p, dst, EVAL_ERROR_INVALID_VALUE);
+            break;
+    }
+}
+
+// the result of the node is left in register dst
+// the registers after dst are free to be used by its operands
+static void eval_compile_node(EVAL_PROGRAM *p, EVAL_NODE *op, uint32_t dst) {
+    if(unlikely(op->count != operators[op->operator].parameters)) {
+        eval_program_add_error(p, dst, EVAL_ERROR_INVALID_NUMBER_OF_OPERANDS);
+        return;
+    }
+
+    EVAL_OPCODE opcode;
+    uint32_t jump, jump_to_end;
+
+    switch(op->operator) {
+        case EVAL_OPERATOR_NOP:
+        case EVAL_OPERATOR_EXPRESSION_OPEN:
+        case EVAL_OPERATOR_EXPRESSION_CLOSE:
+        case EVAL_OPERATOR_SIGN_PLUS:
+            eval_compile_value(p, &op->ops[0], dst);
+            return;
+
+        case EVAL_OPERATOR_AND:
+        case EVAL_OPERATOR_OR:
+            // the second operand is evaluated only when the first does not decide the result
+            eval_compile_value(p, &op->ops[0], dst);
+            eval_program_add(p, EVAL_OPCODE_TRUTH, dst)->a = dst;
+            jump = eval_program_add_jump(p, (op->operator == EVAL_OPERATOR_AND) ? EVAL_OPCODE_JUMP_IF_FALSE : EVAL_OPCODE_JUMP_IF_TRUE, dst);
+            eval_compile_value(p, &op->ops[1], dst);
+            eval_program_add(p, EVAL_OPCODE_TRUTH, dst)->a = dst;
+            eval_program_set_jump_target(p, jump);
+            return;
+
+        case EVAL_OPERATOR_IF_THEN_ELSE:
+            eval_compile_value(p, &op->ops[0], dst);
+            jump = eval_program_add_jump(p, EVAL_OPCODE_JUMP_IF_FALSE, dst);
+            eval_compile_value(p, &op->ops[1], dst);
+            jump_to_end = eval_program_add_jump(p, EVAL_OPCODE_JUMP, dst);
+            eval_program_set_jump_target(p, jump);
+            eval_compile_value(p, &op->ops[2], dst);
+            eval_program_set_jump_target(p, jump_to_end);
+            return;
+
+        case EVAL_OPERATOR_NOT:        opcode = EVAL_OPCODE_NOT;        break;
+        case EVAL_OPERATOR_SIGN_MINUS: opcode = EVAL_OPCODE_SIGN_MINUS; break;
+        case EVAL_OPERATOR_ABS:        opcode = EVAL_OPCODE_ABS;        break;
+
+        case EVAL_OPERATOR_GREATER_THAN_OR_EQUAL: opcode = EVAL_OPCODE_GREATER_THAN_OR_EQUAL; break;
+        case EVAL_OPERATOR_LESS_THAN_OR_EQUAL:    opcode = EVAL_OPCODE_LESS_THAN_OR_EQUAL;    break;
+        case EVAL_OPERATOR_EQUAL:                 opcode = EVAL_OPCODE_EQUAL;                 break;
+        case EVAL_OPERATOR_NOT_EQUAL:             opcode = EVAL_OPCODE_NOT_EQUAL;             break;
+        case EVAL_OPERATOR_LESS:                  opcode = EVAL_OPCODE_LESS;                  break;
+        case EVAL_OPERATOR_GREATER:               opcode = EVAL_OPCODE_GREATER;               break;
+        case EVAL_OPERATOR_PLUS:                  opcode = EVAL_OPCODE_PLUS;                  break;
+        case EVAL_OPERATOR_MINUS:                 opcode = EVAL_OPCODE_MINUS;                 break;
+        case EVAL_OPERATOR_MULTIPLY:              opcode = EVAL_OPCODE_MULTIPLY;              break;
+        case EVAL_OPERATOR_DIVIDE:                opcode = EVAL_OPCODE_DIVIDE;                break;
+
+        default:
+            eval_program_add_error(p, dst, EVAL_ERROR_INVALID_VALUE);
+            return;
+    }
+
+    EVAL_INSTRUCTION *ins;
+    if(op->count == 1) {
+        eval_compile_value(p, &op->ops[0], dst);
+        ins = eval_program_add(p, opcode, dst);
+        ins->a = dst;
+    }
+    else {
+        eval_compile_value(p, &op->ops[0], dst);
+        eval_compile_value(p, &op->ops[1], dst + 1);
+        ins = eval_program_add(p, opcode, dst);
+        ins->a = dst;
+        ins->b = dst + 1;
+    }
+}
+
+static EVAL_PROGRAM *eval_compile(EVAL_NODE *op) {
+    EVAL_PROGRAM *p = callocz(1, sizeof(EVAL_PROGRAM));
+
+    eval_compile_node(p, op, 0);
+
+    p->registers = callocz(p->registers_count, sizeof(NETDATA_DOUBLE));
+
+    uint32_t i, loads = 0;
+    for(i = 0; i < p->instructions_count ;i++) {
+        switch(p->instructions[i].opcode) {
+            case EVAL_OPCODE_VARIABLE:
+            case EVAL_OPCODE_NAMED_CONSTANT:
+            case EVAL_OPCODE_THIS:
+            case EVAL_OPCODE_AFTER:
+            case EVAL_OPCODE_BEFORE:
+            case EVAL_OPCODE_NOW:
+            case EVAL_OPCODE_STATUS:
+                loads++;
+                break;
+
+            default:
+                break;
+        }
+    }
+    p->trace = callocz(loads ? loads : 1, sizeof(EVAL_TRACE_ENTRY));
+
+    return p;
+}
+
+static void eval_program_free(EVAL_PROGRAM *p) {
+    eval_slots_release(p);
+
+    uint32_t i;
+    for(i = 0; i < p->slots_count ;i++)
+        string_freez(p->slots[i].name);
+
+    for(i = 0; i < p->instructions_count ;i++)
+        string_freez(p->instructions[i].name);
+
+    freez(p->slots);
+    freez(p->instructions);
+    freez(p->registers);
+    freez(p->trace);
+    freez(p);
+}
+
 // ----------------------------------------------------------------------------
 // public API
 
 int expression_evaluate(EVAL_EXPRESSION *expression) {
+    EVAL_PROGRAM *p = (EVAL_PROGRAM *)expression->program;
+
     expression->error = EVAL_ERROR_OK;
 
-    buffer_reset(expression->error_msg);
-    expression->result = eval_node(expression, (EVAL_NODE *)expression->nodes, &expression->error);
+    eval_slots_check_version(expression, p);
+    expression->result = eval_program_run(expression, p, &expression->error);
+    p->trace_pending = true;
 
     if(unlikely(isnan(expression->result))) {
         if(expression->error == EVAL_ERROR_OK)
@@ -1092,17 +1391,31 @@ int expression_evaluate(EVAL_EXPRESSION *expression) {
 
     if(expression->error != EVAL_ERROR_OK) {
         expression->result = NAN;
-
-        if(buffer_strlen(expression->error_msg))
-            buffer_strcat(expression->error_msg, "; ");
-
-        buffer_sprintf(expression->error_msg, "failed to evaluate expression with error %d (%s)", expression->error, expression_strerror(expression->error));
         return 0;
     }
 
     return 1;
 }
 
+const char *expression_error_msg(EVAL_EXPRESSION *expression) {
+    EVAL_PROGRAM *p = (EVAL_PROGRAM *)expression->program;
+
+    if(p->trace_pending) {
+        buffer_reset(expression->error_msg);
+        eval_trace_format(p, expression->error_msg);
+        p->trace_pending = false;
+
+        if(expression->error != EVAL_ERROR_OK) {
+            if(buffer_strlen(expression->error_msg))
+                buffer_strcat(expression->error_msg, "; ");
+
+            buffer_sprintf(expression->error_msg, "failed to evaluate expression with error %d (%s)", expression->error, expression_strerror(expression->error));
+        }
+    }
+
+    return buffer_tostring(expression->error_msg);
+}
+
 EVAL_EXPRESSION *expression_parse(const char *string, const char **failed_at, int *error) {
     const char *s = string;
     int err = EVAL_ERROR_OK;
@@ -1142,15 +1455,25 @@ EVAL_EXPRESSION *expression_parse(const char *string, const char **failed_at, in
     buffer_free(out);
 
     exp->error_msg = buffer_create(100);
-    exp->nodes = (void *)op;
+    exp->program = (void *)eval_compile(op);
+    eval_node_free(op);
 
     return exp;
 }
 
+void expression_release_variables(EVAL_EXPRESSION *expression) {
+    if(!expression) return;
+
+    EVAL_PROGRAM *p = (EVAL_PROGRAM *)expression->program;
+    eval_slots_release(p);
+    p->variables_scope = NULL;
+    p->variables_version = 0;
+}
+
 void expression_free(EVAL_EXPRESSION *expression) {
     if(!expression) return;
 
-    if(expression->nodes) eval_node_free((EVAL_NODE *)expression->nodes);
+    if(expression->program) eval_program_free((EVAL_PROGRAM *)expression->program);
     freez((void *)expression->source);
     freez((void *)expression->parsed_as);
     buffer_free(expression->error_msg);
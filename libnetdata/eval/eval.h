@@ -34,10 +34,10 @@ typedef struct eval_expression {
     NETDATA_DOUBLE result;
 
     int error;
-    BUFFER *error_msg;
+    BUFFER *error_msg;      // generated on demand, use expression_error_msg()
 
-    // hidden EVAL_NODE *
-    void *nodes;
+    // hidden EVAL_PROGRAM *
+    void *program;
 
     // custom data to be used for looking up variables
     struct rrdcalc *rrdcalc;
@@ -79,9 +79,19 @@ extern const char *expression_strerror(int error);
 
 // evaluate an expression and return
 // 1 = OK, the result is in: expression->result
-// 2 = FAILED, the error message is in: buffer_tostring(expression->error_msg)
+// 0 = FAILED, the error code is in: expression->error
 extern int expression_evaluate(EVAL_EXPRESSION *expression);
 
-extern int health_variable_lookup(STRING *variable, struct rrdcalc *rc, NETDATA_DOUBLE *result);
+// the values of the variables used by the last evaluation and its error, if any
+extern const char *expression_error_msg(EVAL_EXPRESSION *expression);
+
+// release the variables the expression keeps acquired, they are looked up again on the next evaluation
+extern void expression_release_variables(EVAL_EXPRESSION *expression);
+
+// callbacks required by eval(), for looking up the variables of an alarm
+// the variables are looked up once and kept acquired, until the version changes
+extern size_t health_variable_lookup_version(struct rrdcalc *rc, const void **scope);
+extern DICT_ITEM_CONST DICTIONARY_ITEM *health_variable_acquire(STRING *variable, struct rrdcalc *rc, DICTIONARY **dict);
+extern NETDATA_DOUBLE health_variable_value(DICT_ITEM_CONST DICTIONARY_ITEM *item);
 
 #endif //NETDATA_EVAL_H
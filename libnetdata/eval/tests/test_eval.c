@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../../libnetdata.h"
+#include "../../required_dummies.h"
+#include <setjmp.h>
+#include <cmocka.h>
+
+// the variables of the alarm, looked up by the callbacks of eval()
+static DICTIONARY *variables = NULL;
+static struct rrdcalc *rrdcalc = (struct rrdcalc *)&variables;
+
+size_t health_variable_lookup_version(struct rrdcalc *rc, const void **scope)
+{
+    (void)rc;
+    *scope = variables;
+    return dictionary_version(variables);
+}
+
+DICT_ITEM_CONST DICTIONARY_ITEM *health_variable_acquire(STRING *variable, struct rrdcalc *rc, DICTIONARY **dict)
+{
+    (void)rc;
+    *dict = variables;
+    return dictionary_get_and_acquire_item(variables, string2str(variable));
+}
+
+NETDATA_DOUBLE health_variable_value(DICT_ITEM_CONST DICTIONARY_ITEM *item)
+{
+    return *(NETDATA_DOUBLE *)dictionary_acquired_item_value(item);
+}
+
+static void set_variable(const char *name, NETDATA_DOUBLE value)
+{
+    dictionary_set(variables, name, &value, sizeof(value));
+}
+
+static NETDATA_DOUBLE value_of_this = 7;
+static RRDCALC_STATUS value_of_status = RRDCALC_STATUS_WARNING;
+static time_t after = 900;
+static time_t before = 0;
+
+static EVAL_EXPRESSION *parse(const char *source)
+{
+    EVAL_EXPRESSION *exp = expression_parse(source, NULL, NULL);
+    assert_non_null(exp);
+
+    exp->myself = &value_of_this;
+    exp->status = &value_of_status;
+    exp->after = &after;
+    exp->before = &before;
+    exp->rrdcalc = rrdcalc;
+    return exp;
+}
+
+static int setup(void **state)
+{
+    (void)state;
+
+    variables = dictionary_create(DICT_OPTION_NONE);
+    set_variable("x", 5);
+    set_variable("y", 0);
+    set_variable("z", NAN);
+    set_variable("w", INFINITY);
+    set_variable("neg", -2.5);
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    (void)state;
+
+    dictionary_destroy(variables);
+    variables = NULL;
+    return 0;
+}
+
+// the results of the evaluator that walked the parsed tree, before expressions were compiled
+static struct {
+    const char *source;
+    const char *parsed_as;
+    int ok;
+    NETDATA_DOUBLE result;
+    int error;
+    const char *error_msg;
+} expressions[] = {
+    { "2.5", "2.5", 1, 2.5, EVAL_ERROR_OK, "" },
+    { "!1", "!1", 1, 0, EVAL_ERROR_OK, "" },
+    { "abs(0)", "abs(0)", 1, 0, EVAL_ERROR_OK, "" },
+    { "$x", "${x}", 1, 5, EVAL_ERROR_OK, "[ ${x} = 5 ] " },
+    { "((${x}))", "${x}", 1, 5, EVAL_ERROR_OK, "[ ${x} = 5 ] " },
+    { "$neg", "${neg}", 1, -2.5, EVAL_ERROR_OK, "[ ${neg} = -2.5 ] " },
+    { "!$status", "!${status}", 1, 0, EVAL_ERROR_OK, "[ $status = 3 ] " },
+    { "$CRITICAL", "${CRITICAL}", 1, 4, EVAL_ERROR_OK, "[ $CRITICAL = 4 ] " },
+    { "${x} == (2.5)", "(${x} == 2.5)", 1, 0, EVAL_ERROR_OK, "[ ${x} = 5 ] " },
+    { "$WARNING > inf", "(${WARNING} > inf)", 1, 0, EVAL_ERROR_OK, "[ $WARNING = 3 ] " },
+    { "$this && $after", "(${this} && ${after})", 1, 1, EVAL_ERROR_OK, "[ $this = 7 ] [ $after = 900 ] " },
+    { "(($this = $WARNING))", "(${this} == ${WARNING})", 1, 0, EVAL_ERROR_OK, "[ $this = 7 ] [ $WARNING = 3 ] " },
+    { "+(!$y AND inf)", "+(!${y} && inf)", 1, 1, EVAL_ERROR_OK, "[ ${y} = 0 ] " },
+    { "!($missing)", "!${missing}", 1, 1, EVAL_ERROR_OK, "[ undefined variable 'missing' ] " },
+    { "$CLEAR >= $missing", "(${CLEAR} >= ${missing})", 1, 0, EVAL_ERROR_OK, "[ $CLEAR = 1 ] [ undefined variable 'missing' ] " },
+    { "-$WARNING < $w == 1", "((-${WARNING} < ${w}) == 1)", 1, 1, EVAL_ERROR_OK, "[ $WARNING = 3 ] [ ${w} = inf ] " },
+    { "$z == inf < -nan", "((${z} == inf) < -nan)", 1, 0, EVAL_ERROR_OK, "[ ${z} = nan ] " },
+    { "((0) ? (inf) : (2.5)) > nan = $after = nan", "((((0 ? inf : 2.5) > nan) == ${after}) == nan)", 1, 0, EVAL_ERROR_OK, "[ $after = 900 ] " },
+    { "inf AND $before >= +$z", "(inf && (${before} >= +${z}))", 1, 0, EVAL_ERROR_OK, "[ $before = nan ] [ ${z} = nan ] " },
+    { "(((nan) ? ($CRITICAL) : ($w))) == -$status < ${x}", "(((nan ? ${CRITICAL} : ${w}) == -${status}) < ${x})", 1, 1, EVAL_ERROR_OK,
+      "[ ${w} = inf ] [ $status = 3 ] [ ${x} = 5 ] " },
+    { "$y || (($CLEAR) ? ($this) : (-3)) > $missing > $CLEAR", "(${y} || (((${CLEAR} ? ${this} : -3) > ${missing}) > ${CLEAR}))", 1, 0, EVAL_ERROR_OK,
+      "[ ${y} = 0 ] [ $CLEAR = 1 ] [ $this = 7 ] [ undefined variable 'missing' ] [ $CLEAR = 1 ] " },
+    { "(($this >= (!($y) AND $after)) ? (((${x} && !${x} || nan) ? (inf) : (((($missing) ? ($x / $x) : (nan))))) <= $CRITICAL) : ($this))",
+      "((${this} >= (!${y} && ${after})) ? ((((${x} && !${x}) || nan) ? inf : (${missing} ? (${x} / ${x}) : nan)) <= ${CRITICAL}) : ${this})", 1, 0, EVAL_ERROR_OK,
+      "[ $this = 7 ] [ ${y} = 0 ] [ $after = 900 ] [ ${x} = 5 ] [ ${x} = 5 ] [ undefined variable 'missing' ] [ $CRITICAL = 4 ] " },
+    { "nan", "nan", 0, NAN, EVAL_ERROR_VALUE_IS_NAN, "failed to evaluate expression with error 103 (value is unset)" },
+    { "inf", "inf", 0, NAN, EVAL_ERROR_VALUE_IS_INFINITE, "failed to evaluate expression with error 104 (computed value is infinite)" },
+    { "$z", "${z}", 0, NAN, EVAL_ERROR_VALUE_IS_NAN, "[ ${z} = nan ] ; failed to evaluate expression with error 103 (value is unset)" },
+    { "$w", "${w}", 0, NAN, EVAL_ERROR_VALUE_IS_INFINITE, "[ ${w} = inf ] ; failed to evaluate expression with error 104 (computed value is infinite)" },
+    { "${x} + $before", "(${x} + ${before})", 0, NAN, EVAL_ERROR_VALUE_IS_NAN,
+      "[ ${x} = 5 ] [ $before = nan ] ; failed to evaluate expression with error 103 (value is unset)" },
+    { "($missing)", "${missing}", 0, NAN, EVAL_ERROR_UNKNOWN_VARIABLE,
+      "[ undefined variable 'missing' ] ; failed to evaluate expression with error 105 (undefined variable)" },
+
+    // terminator
+    { NULL, NULL, 0, 0, 0, NULL },
+};
+
+static void test_expressions(void **state)
+{
+    (void)state;
+
+    for(size_t i = 0; expressions[i].source ;i++) {
+        EVAL_EXPRESSION *exp = parse(expressions[i].source);
+        assert_string_equal(exp->parsed_as, expressions[i].parsed_as);
+
+        // the second evaluation uses the variables looked up by the first
+        for(int run = 0; run < 2 ;run++) {
+            int ok = expression_evaluate(exp);
+
+            assert_int_equal(ok, expressions[i].ok);
+            assert_int_equal(exp->error, expressions[i].error);
+            if(ok)
+                assert_true(exp->result == expressions[i].result);
+            else
+                assert_true(isnan(exp->result));
+
+            assert_string_equal(expression_error_msg(exp), expressions[i].error_msg);
+        }
+
+        expression_free(exp);
+        assert_int_equal(dictionary_referenced_items(variables), 0);
+    }
+}
+
+static void test_error_msg_has_the_evaluated_values(void **state)
+{
+    (void)state;
+
+    EVAL_EXPRESSION *exp = parse("($status >= $WARNING) ? ($this > 5) : ($this > 10)");
+
+    assert_int_equal(expression_evaluate(exp), 1);
+    assert_true(exp->result == 1);
+
+    // the values change before the message is generated, like they do before an alarm notification is sent
+    value_of_status = RRDCALC_STATUS_CLEAR;
+    value_of_this = 1;
+
+    assert_string_equal(expression_error_msg(exp), "[ $status = 3 ] [ $WARNING = 3 ] [ $this = 7 ] ");
+
+    assert_int_equal(expression_evaluate(exp), 1);
+    assert_true(exp->result == 0);
+    assert_string_equal(expression_error_msg(exp), "[ $status = 1 ] [ $WARNING = 3 ] [ $this = 1 ] ");
+
+    value_of_status = RRDCALC_STATUS_WARNING;
+    value_of_this = 7;
+    expression_free(exp);
+}
+
+static void test_variables_are_released(void **state)
+{
+    (void)state;
+
+    EVAL_EXPRESSION *exp = parse("($missing > 0) + $x + $neg");
+
+    assert_int_equal(expression_evaluate(exp), 1);
+    assert_true(exp->result == 2.5);
+    assert_int_equal(dictionary_referenced_items(variables), 2);
+
+    // the variables are kept acquired between evaluations
+    set_variable("x", 10);
+    assert_int_equal(expression_evaluate(exp), 1);
+    assert_true(exp->result == 7.5);
+    assert_int_equal(dictionary_referenced_items(variables), 2);
+
+    expression_release_variables(exp);
+    assert_int_equal(dictionary_referenced_items(variables), 0);
+
+    // and looked up again by the next evaluation
+    set_variable("missing", 1);
+    assert_int_equal(expression_evaluate(exp), 1);
+    assert_true(exp->result == 8.5);
+    assert_int_equal(dictionary_referenced_items(variables), 3);
+
+    expression_free(exp);
+    assert_int_equal(dictionary_referenced_items(variables), 0);
+
+    dictionary_del(variables, "missing");
+    set_variable("x", 5);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_expressions),
+        cmocka_unit_test(test_error_msg_has_the_evaluated_values),
+        cmocka_unit_test(test_variables_are_released),
+    };
+
+    return cmocka_run_group_tests_name("eval", tests, setup, teardown);
+}
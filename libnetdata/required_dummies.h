@@ -23,14 +23,27 @@ void signals_unblock(void){};
 void signals_reset(void){};
 
 #ifndef UNIT_TESTING
-// callback required by eval()
-int health_variable_lookup(STRING *variable, struct rrdcalc *rc, NETDATA_DOUBLE *result)
+// callbacks required by eval()
+size_t health_variable_lookup_version(struct rrdcalc *rc, const void **scope)
 {
-    (void)variable;
     (void)rc;
-    (void)result;
+    *scope = NULL;
     return 0;
 };
+
+DICT_ITEM_CONST DICTIONARY_ITEM *health_variable_acquire(STRING *variable, struct rrdcalc *rc, DICTIONARY **dict)
+{
+    (void)variable;
+    (void)rc;
+    (void)dict;
+    return NULL;
+};
+
+NETDATA_DOUBLE health_variable_value(DICT_ITEM_CONST DICTIONARY_ITEM *item)
+{
+    (void)item;
+    return NAN;
+};
 #endif
 
 void rrdset_thread_rda_free(void){};
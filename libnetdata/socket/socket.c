@@ -301,6 +301,64 @@ void listen_sockets_close(LISTEN_SOCKETS *sockets) {
     sockets->failed = 0;
 }
 
+/*
+ * Opens for the TCP sockets of 'from', new sockets bound to the same addresses, that share the incoming
+ * connections of 'from' (SO_REUSEPORT), so that each thread can accept connections on its own sockets.
+ * UNIX and UDP sockets cannot be shared this way and are skipped.
+ *
+ * Returns the number of sockets opened.
+ */
+int listen_sockets_setup_reuse_port(LISTEN_SOCKETS *sockets, LISTEN_SOCKETS *from) {
+    listen_sockets_init(sockets);
+
+    sockets->config = from->config;
+    sockets->config_section = from->config_section;
+    sockets->default_bind_to = from->default_bind_to;
+    sockets->default_port = from->default_port;
+    sockets->backlog = from->backlog;
+
+#ifdef SO_REUSEPORT
+    size_t i;
+    for(i = 0; i < from->opened ;i++) {
+        if(from->fds_types[i] != SOCK_STREAM || (from->fds_families[i] != AF_INET && from->fds_families[i] != AF_INET6))
+            continue;
+
+        struct sockaddr_storage ss;
+        socklen_t len = sizeof(ss);
+        if(getsockname(from->fds[i], (struct sockaddr *)&ss, &len) == -1) {
+            error("LISTENER: getsockname() failed on listen socket %s", from->fds_names[i]);
+            continue;
+        }
+
+        char rip[INET_ADDRSTRLEN + INET6_ADDRSTRLEN] = "INVALID";
+        uint16_t rport;
+        int fd;
+
+        if(ss.ss_family == AF_INET) {
+            struct sockaddr_in *sin = (struct sockaddr_in *)&ss;
+            inet_ntop(AF_INET, &sin->sin_addr, rip, INET_ADDRSTRLEN);
+            rport = ntohs(sin->sin_port);
+            fd = create_listen_socket4(SOCK_STREAM, rip, rport, from->backlog);
+        }
+        else {
+            struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&ss;
+            inet_ntop(AF_INET6, &sin6->sin6_addr, rip, INET6_ADDRSTRLEN);
+            rport = ntohs(sin6->sin6_port);
+            fd = create_listen_socket6(SOCK_STREAM, sin6->sin6_scope_id, rip, rport, from->backlog);
+        }
+
+        if(fd == -1) {
+            error("LISTENER: Cannot bind another socket to ip '%s', port %d", rip, rport);
+            sockets->failed++;
+        }
+        else
+            listen_sockets_add(sockets, fd, ss.ss_family, SOCK_STREAM, "tcp", rip, rport, from->fds_acl_flags[i]);
+    }
+#endif
+
+    return (int)sockets->opened;
+}
+
 /*
  *  SSL ACL
  *
@@ -1201,10 +1259,317 @@ int accept_socket(int fd, int flags, char *client_ip, size_t ipsize, char *clien
 // --------------------------------------------------------------------------------------------------------------------
 // poll() based listener
 // this should be the fastest possible listener for up to 100 sockets
-// above 100, an epoll() interface is needed on Linux
+// above 100, an epoll() interface is needed on Linux, so on Linux epoll() is used when available
 
 #define POLL_FDS_INCREASE_STEP 10
 
+// --------------------------------------------------------------------------------------------------------------------
+// epoll() backend
+//
+// p->fds[] keeps the events each slot waits for with both backends, so the callbacks work unchanged.
+// The fds are registered edge-triggered and every slot that received events is re-armed (EPOLL_CTL_MOD)
+// after its callbacks run, with the events the callbacks requested. Re-arming reports again any data
+// the callbacks did not consume, so a wakeup costs O(active sockets) instead of O(total sockets).
+
+#ifdef __linux__
+#include <sys/epoll.h>
+
+#define POLL_EPOLL_MAX_EVENTS 512
+
+static inline uint32_t poll_events_to_epoll(short int events) {
+    uint32_t ev = EPOLLET;
+
+    if(events & POLLIN)  ev |= EPOLLIN;
+    if(events & POLLPRI) ev |= EPOLLPRI;
+    if(events & POLLOUT) ev |= EPOLLOUT;
+
+    return ev;
+}
+
+static inline short int poll_events_from_epoll(uint32_t ev) {
+    short int events = 0;
+
+    if(ev & EPOLLIN)  events |= POLLIN;
+    if(ev & EPOLLPRI) events |= POLLPRI;
+    if(ev & EPOLLOUT) events |= POLLOUT;
+    if(ev & EPOLLERR) events |= POLLERR;
+    if(ev & EPOLLHUP) events |= POLLHUP;
+
+    return events;
+}
+
+static void poll_backend_init(POLLJOB *p) {
+    p->epoll_events = NULL;
+    p->always_ready = NULL;
+    p->always_ready_used = 0;
+    p->always_ready_size = 0;
+
+    p->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(unlikely(p->epoll_fd == -1)) {
+        error("POLLFD: epoll_create1() failed, falling back to poll()");
+        return;
+    }
+
+    p->epoll_events = mallocz(sizeof(struct epoll_event) * POLL_EPOLL_MAX_EVENTS);
+}
+
+static void poll_backend_free(POLLJOB *p) {
+    if(p->epoll_fd != -1) {
+        close(p->epoll_fd);
+        p->epoll_fd = -1;
+    }
+
+    freez(p->epoll_events);
+    p->epoll_events = NULL;
+
+    freez(p->always_ready);
+    p->always_ready = NULL;
+    p->always_ready_used = 0;
+    p->always_ready_size = 0;
+}
+
+// epoll() refuses regular files (the web server adds the files it sends),
+// which poll() reports as always ready, so they are served on every loop
+static void poll_backend_add_always_ready(POLLJOB *p, POLLINFO *pi) {
+    if(p->always_ready_used == p->always_ready_size) {
+        p->always_ready_size += POLL_FDS_INCREASE_STEP;
+        p->always_ready = reallocz(p->always_ready, sizeof(size_t) * p->always_ready_size);
+
+        // the ready list of a loop is the epoll events, plus the always ready slots
+        p->epoll_events = reallocz(p->epoll_events, sizeof(struct epoll_event) * (POLL_EPOLL_MAX_EVENTS + p->always_ready_size));
+    }
+
+    pi->flags |= POLLINFO_FLAG_ALWAYS_READY;
+    p->always_ready[p->always_ready_used++] = pi->slot;
+}
+
+static void poll_backend_add(POLLJOB *p, POLLINFO *pi) {
+    if(p->epoll_fd == -1) return;
+
+    struct epoll_event ev = {
+            .events = poll_events_to_epoll(p->fds[pi->slot].events),
+            .data.u64 = pi->slot
+    };
+
+    if(unlikely(epoll_ctl(p->epoll_fd, EPOLL_CTL_ADD, pi->fd, &ev) == -1)) {
+        if(errno == EPERM)
+            poll_backend_add_always_ready(p, pi);
+        else
+            error("POLLFD: epoll_ctl() failed to add slot %zu (fd %d)", pi->slot, pi->fd);
+    }
+}
+
+static void poll_backend_update(POLLJOB *p, POLLINFO *pi) {
+    if(p->epoll_fd == -1 || (pi->flags & POLLINFO_FLAG_ALWAYS_READY)) return;
+
+    struct epoll_event ev = {
+            .events = poll_events_to_epoll(p->fds[pi->slot].events),
+            .data.u64 = pi->slot
+    };
+
+    if(unlikely(epoll_ctl(p->epoll_fd, EPOLL_CTL_MOD, pi->fd, &ev) == -1))
+        error("POLLFD: epoll_ctl() failed to re-arm slot %zu (fd %d)", pi->slot, pi->fd);
+}
+
+static void poll_backend_del(POLLJOB *p, POLLINFO *pi) {
+    if(p->epoll_fd == -1) return;
+
+    if(pi->flags & POLLINFO_FLAG_ALWAYS_READY) {
+        size_t i;
+        for(i = 0; i < p->always_ready_used ; i++) {
+            if(p->always_ready[i] == pi->slot) {
+                p->always_ready[i] = p->always_ready[--p->always_ready_used];
+                break;
+            }
+        }
+        return;
+    }
+
+    // sockets given to other threads (POLLINFO_FLAG_DONT_CLOSE) are not closed,
+    // so they have to be removed explicitly
+    if(unlikely(epoll_ctl(p->epoll_fd, EPOLL_CTL_DEL, pi->fd, NULL) == -1))
+        error("POLLFD: epoll_ctl() failed to delete slot %zu (fd %d)", pi->slot, pi->fd);
+}
+
+// waits for events, sets the revents of the ready slots and lists them in p->epoll_events
+// returns the number of ready slots, or -1 on failure
+static int poll_backend_wait(POLLJOB *p, int timeout_ms) {
+    size_t i, ready;
+
+    for(i = 0; i < p->always_ready_used ; i++) {
+        if(p->fds[p->always_ready[i]].events & (POLLIN | POLLOUT)) {
+            timeout_ms = 0;
+            break;
+        }
+    }
+
+    int retval = epoll_wait(p->epoll_fd, p->epoll_events, POLL_EPOLL_MAX_EVENTS, timeout_ms);
+    if(unlikely(retval == -1))
+        return -1;
+
+    for(ready = 0; ready < (size_t)retval ; ready++) {
+        struct epoll_event *ev = &p->epoll_events[ready];
+        p->fds[ev->data.u64].revents = poll_events_from_epoll(ev->events);
+    }
+
+    for(i = 0; i < p->always_ready_used ; i++) {
+        struct pollfd *pf = &p->fds[p->always_ready[i]];
+        short int revents = (short int)(pf->events & (POLLIN | POLLOUT));
+
+        if(revents) {
+            pf->revents = revents;
+            p->epoll_events[ready++].data.u64 = p->always_ready[i];
+        }
+    }
+
+    return (int)ready;
+}
+
+// re-arms the ready slots of the last wait that are still open
+static void poll_backend_rearm(POLLJOB *p, size_t ready) {
+    size_t i;
+    for(i = 0; i < ready ; i++) {
+        POLLINFO *pi = &p->inf[p->epoll_events[i].data.u64];
+        if(likely(pi->fd != -1))
+            poll_backend_update(p, pi);
+    }
+}
+
+static inline int poll_backend_is_epoll(POLLJOB *p) {
+    return p->epoll_fd != -1;
+}
+
+static inline size_t poll_backend_ready_slot(POLLJOB *p, size_t idx) {
+    return (size_t)p->epoll_events[idx].data.u64;
+}
+
+#else // !__linux__
+
+static inline void poll_backend_init(POLLJOB *p __maybe_unused) { ; }
+static inline void poll_backend_free(POLLJOB *p __maybe_unused) { ; }
+static inline void poll_backend_add(POLLJOB *p __maybe_unused, POLLINFO *pi __maybe_unused) { ; }
+static inline void poll_backend_update(POLLJOB *p __maybe_unused, POLLINFO *pi __maybe_unused) { ; }
+static inline void poll_backend_del(POLLJOB *p __maybe_unused, POLLINFO *pi __maybe_unused) { ; }
+static inline int poll_backend_wait(POLLJOB *p __maybe_unused, int timeout_ms __maybe_unused) { return -1; }
+static inline void poll_backend_rearm(POLLJOB *p __maybe_unused, size_t ready __maybe_unused) { ; }
+static inline int poll_backend_is_epoll(POLLJOB *p __maybe_unused) { return 0; }
+static inline size_t poll_backend_ready_slot(POLLJOB *p __maybe_unused, size_t idx) { return idx; }
+
+#endif // __linux__
+
+// --------------------------------------------------------------------------------------------------------------------
+// timer wheel of the idle and request timeouts
+//
+// Client sockets are linked to the bucket of the second their timeouts have to be checked.
+// Traffic does not move them: when their bucket is due, the timeouts are checked and the sockets that
+// have not timed out are scheduled again, so every socket is visited about once per timeout period.
+
+static time_t poll_timer_next_check(POLLJOB *p, POLLINFO *pi) {
+    time_t expires = 0;
+
+    if(pi->send_count == 0 && p->complete_request_timeout > 0)
+        expires = pi->connected_t + p->complete_request_timeout;
+
+    if(p->idle_timeout > 0) {
+        time_t last = pi->connected_t;
+        if(pi->last_received_t > last) last = pi->last_received_t;
+        if(pi->last_sent_t > last) last = pi->last_sent_t;
+
+        if(!expires || last + p->idle_timeout < expires)
+            expires = last + p->idle_timeout;
+    }
+
+    return expires;
+}
+
+static void poll_timer_add(POLLJOB *p, POLLINFO *pi) {
+    time_t expires = poll_timer_next_check(p, pi);
+    if(!expires) return;
+
+    if(expires <= p->timer_wheel_time)
+        expires = p->timer_wheel_time + 1;
+
+    size_t *head = &p->timer_wheel[expires & (POLL_TIMER_WHEEL_SLOTS - 1)];
+
+    pi->timer_expires = expires;
+    pi->timer_prev = POLLINFO_NO_SLOT;
+    pi->timer_next = *head;
+
+    if(*head != POLLINFO_NO_SLOT)
+        p->inf[*head].timer_prev = pi->slot;
+
+    *head = pi->slot;
+}
+
+static void poll_timer_del(POLLJOB *p, POLLINFO *pi) {
+    if(!pi->timer_expires) return;
+
+    if(pi->timer_prev != POLLINFO_NO_SLOT)
+        p->inf[pi->timer_prev].timer_next = pi->timer_next;
+    else
+        p->timer_wheel[pi->timer_expires & (POLL_TIMER_WHEEL_SLOTS - 1)] = pi->timer_next;
+
+    if(pi->timer_next != POLLINFO_NO_SLOT)
+        p->inf[pi->timer_next].timer_prev = pi->timer_prev;
+
+    pi->timer_expires = 0;
+    pi->timer_prev = POLLINFO_NO_SLOT;
+    pi->timer_next = POLLINFO_NO_SLOT;
+}
+
+static void poll_timer_init(POLLJOB *p, time_t now) {
+    size_t i;
+    for(i = 0; i < POLL_TIMER_WHEEL_SLOTS ; i++)
+        p->timer_wheel[i] = POLLINFO_NO_SLOT;
+
+    p->timer_wheel_time = now;
+}
+
+static void poll_timer_run(POLLJOB *p, time_t now) {
+    // after a long pause, every bucket is run once
+    if(unlikely(now - p->timer_wheel_time > POLL_TIMER_WHEEL_SLOTS))
+        p->timer_wheel_time = now - POLL_TIMER_WHEEL_SLOTS;
+
+    while(p->timer_wheel_time < now) {
+        time_t t = ++p->timer_wheel_time;
+        size_t slot = p->timer_wheel[t & (POLL_TIMER_WHEEL_SLOTS - 1)];
+
+        while(slot != POLLINFO_NO_SLOT) {
+            POLLINFO *pi = &p->inf[slot];
+            slot = pi->timer_next;
+
+            // it is for a later round of the wheel
+            if(pi->timer_expires > t)
+                continue;
+
+            poll_timer_del(p, pi);
+
+            if (unlikely(pi->send_count == 0 && p->complete_request_timeout > 0 && (now - pi->connected_t) >= p->complete_request_timeout)) {
+                info("POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s has not sent a complete request in %zu seconds - closing it. "
+                      , pi->slot
+                      , pi->fd
+                      , pi->client_ip ? pi->client_ip : "<undefined-ip>"
+                      , pi->client_port ? pi->client_port : "<undefined-port>"
+                      , (size_t) p->complete_request_timeout
+                );
+                poll_close_fd(pi);
+            }
+            else if(unlikely(pi->recv_count && p->idle_timeout > 0 && now - ((pi->last_received_t > pi->last_sent_t) ? pi->last_received_t : pi->last_sent_t) >= p->idle_timeout )) {
+                info("POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s is idle for more than %zu seconds - closing it. "
+                      , pi->slot
+                      , pi->fd
+                      , pi->client_ip ? pi->client_ip : "<undefined-ip>"
+                      , pi->client_port ? pi->client_port : "<undefined-port>"
+                      , (size_t) p->idle_timeout
+                );
+                poll_close_fd(pi);
+            }
+            else
+                poll_timer_add(p, pi);
+        }
+    }
+}
+
 inline POLLINFO *poll_add_fd(POLLJOB *p
                              , int fd
                              , int socktype
@@ -1258,6 +1623,10 @@ inline POLLINFO *poll_add_fd(POLLJOB *p
             p->inf[i].snd_callback = p->snd_callback;
             p->inf[i].data = NULL;
 
+            p->inf[i].timer_expires = 0;
+            p->inf[i].timer_prev = POLLINFO_NO_SLOT;
+            p->inf[i].timer_next = POLLINFO_NO_SLOT;
+
             // link them so that the first free will be earlier in the array
             // (we loop decrementing i)
             p->inf[i].next = p->first_free;
@@ -1310,6 +1679,11 @@ inline POLLINFO *poll_add_fd(POLLJOB *p
     if(pi->flags & POLLINFO_FLAG_SERVER_SOCKET) {
         p->min = pi->slot;
     }
+
+    poll_backend_add(p, pi);
+
+    if(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET)
+        poll_timer_add(p, pi);
     netdata_thread_enable_cancelability();
 
     debug(D_POLLFD, "POLLFD: ADD: completed, slots = %zu, used = %zu, min = %zu, max = %zu, next free = %zd", p->slots, p->used, p->min, p->max, p->first_free?(ssize_t)p->first_free->slot:(ssize_t)-1);
@@ -1327,6 +1701,9 @@ inline void poll_close_fd(POLLINFO *pi) {
 
     netdata_thread_disable_cancelability();
 
+    poll_backend_del(p, pi);
+    poll_timer_del(p, pi);
+
     if(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET) {
         pi->del_callback(pi);
 
@@ -1377,6 +1754,17 @@ inline void poll_close_fd(POLLINFO *pi) {
     debug(D_POLLFD, "POLLFD: DEL: completed, slots = %zu, used = %zu, min = %zu, max = %zu, next free = %zd", p->slots, p->used, p->min, p->max, p->first_free?(ssize_t)p->first_free->slot:(ssize_t)-1);
 }
 
+// changes the events of a slot other than the one a callback is called for
+void poll_set_events(POLLINFO *pi, short int events) {
+    POLLJOB *p = pi->p;
+    struct pollfd *pf = &p->fds[pi->slot];
+
+    if(unlikely(pf->fd == -1 || pf->events == events)) return;
+
+    pf->events = events;
+    poll_backend_update(p, pi);
+}
+
 void *poll_default_add_callback(POLLINFO *pi, short int *events, void *data) {
     (void)pi;
     (void)events;
@@ -1435,6 +1823,8 @@ static void poll_events_cleanup(void *data) {
         poll_close_fd(pi);
     }
 
+    poll_backend_free(p);
+
     freez(p->fds);
     freez(p->inf);
 }
@@ -1612,7 +2002,6 @@ void poll_events(LISTEN_SOCKETS *sockets
 
             .complete_request_timeout = tcp_request_timeout_seconds,
             .idle_timeout = tcp_idle_timeout_seconds,
-            .checks_every = (tcp_idle_timeout_seconds / 3) + 1,
 
             .access_list = access_list,
             .allow_dns   = allow_dns,
@@ -1627,6 +2016,9 @@ void poll_events(LISTEN_SOCKETS *sockets
             .tmr_callback = tmr_callback?tmr_callback:poll_default_tmr_callback
     };
 
+    poll_timer_init(&p, now_boottime_sec());
+    poll_backend_init(&p);
+
     size_t i;
     for(i = 0; i < sockets->opened ;i++) {
 
@@ -1652,7 +2044,6 @@ void poll_events(LISTEN_SOCKETS *sockets
     int listen_sockets_active = 1;
 
     int timeout_ms = 1000; // in milliseconds
-    time_t last_check = now_boottime_sec();
 
     usec_t timer_usec = timer_milliseconds * USEC_PER_MS;
     usec_t now_usec = 0, next_timer_usec = 0, last_timer_usec = 0;
@@ -1690,13 +2081,24 @@ void poll_events(LISTEN_SOCKETS *sockets
             info("%s listening sockets (used TCP sockets %zu, max allowed for this worker %zu)", (listen_sockets_active)?"ENABLING":"DISABLING", p.used, p.limit);
             for (i = 0; i <= p.max; i++) {
                 if(p.inf[i].flags & POLLINFO_FLAG_SERVER_SOCKET && p.inf[i].socktype == SOCK_STREAM) {
-                    p.fds[i].events = (short int) ((listen_sockets_active) ? POLLIN : 0);
+                    poll_set_events(&p.inf[i], (short int) ((listen_sockets_active) ? POLLIN : 0));
                 }
             }
         }
 
-        debug(D_POLLFD, "POLLFD: LISTENER: Waiting on %zu sockets for %zu ms...", p.max + 1, (size_t)timeout_ms);
-        retval = poll(p.fds, p.max + 1, timeout_ms);
+        // the slots to check for events
+        size_t candidates;
+
+        if(poll_backend_is_epoll(&p)) {
+            debug(D_POLLFD, "POLLFD: LISTENER: Waiting on %zu sockets with epoll() for %zu ms...", p.used, (size_t)timeout_ms);
+            retval = poll_backend_wait(&p, timeout_ms);
+            candidates = (retval > 0) ? (size_t)retval : 0;
+        }
+        else {
+            debug(D_POLLFD, "POLLFD: LISTENER: Waiting on %zu sockets for %zu ms...", p.max + 1, (size_t)timeout_ms);
+            retval = poll(p.fds, p.max + 1, timeout_ms);
+            candidates = p.max + 1;
+        }
         time_t now = now_boottime_sec();
 
         if(unlikely(retval == -1)) {
@@ -1714,12 +2116,13 @@ void poll_events(LISTEN_SOCKETS *sockets
 
             // keep fast lookup arrays per function
             // to avoid looping through the entire list every time
-            size_t sends[p.max + 1], sends_max = 0;
-            size_t reads[p.max + 1], reads_max = 0;
-            size_t conns[p.max + 1], conns_max = 0;
-            size_t udprd[p.max + 1], udprd_max = 0;
+            size_t sends[candidates], sends_max = 0;
+            size_t reads[candidates], reads_max = 0;
+            size_t conns[candidates], conns_max = 0;
+            size_t udprd[candidates], udprd_max = 0;
 
-            for (i = 0; i <= p.max; i++) {
+            for (idx = 0; idx < candidates; idx++) {
+                i = poll_backend_ready_slot(&p, idx);
                 pi = &p.inf[i];
                 pf = &p.fds[i];
                 revents = pf->revents;
@@ -1790,6 +2193,11 @@ void poll_events(LISTEN_SOCKETS *sockets
                 i = sends[idx];
                 pi = &p.inf[i];
                 pf = &p.fds[i];
+
+                // the slot has been closed by an earlier callback
+                if(unlikely(!pf->revents || pf->fd == -1))
+                    continue;
+
                 pf->revents = 0;
                 processed += poll_process_send(&p, pi, pf, now);
             }
@@ -1799,6 +2207,11 @@ void poll_events(LISTEN_SOCKETS *sockets
                 i = udprd[idx];
                 pi = &p.inf[i];
                 pf = &p.fds[i];
+
+                // the slot has been closed by an earlier callback
+                if(unlikely(!pf->revents || pf->fd == -1))
+                    continue;
+
                 pf->revents = 0;
                 processed += poll_process_udp_read(pi, pf, now);
             }
@@ -1808,6 +2221,11 @@ void poll_events(LISTEN_SOCKETS *sockets
                 i = reads[idx];
                 pi = &p.inf[i];
                 pf = &p.fds[i];
+
+                // the slot has been closed by an earlier callback
+                if(unlikely(!pf->revents || pf->fd == -1))
+                    continue;
+
                 pf->revents = 0;
                 processed += poll_process_tcp_read(&p, pi, pf, now);
             }
@@ -1826,37 +2244,10 @@ void poll_events(LISTEN_SOCKETS *sockets
             }
         }
 
-        if(unlikely(p.checks_every > 0 && now - last_check > p.checks_every)) {
-            last_check = now;
-
-            // cleanup old sockets
-            for(i = 0; i <= p.max; i++) {
-                POLLINFO *pi = &p.inf[i];
+        if(poll_backend_is_epoll(&p))
+            poll_backend_rearm(&p, candidates);
 
-                if(likely(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET)) {
-                    if (unlikely(pi->send_count == 0 && p.complete_request_timeout > 0 && (now - pi->connected_t) >= p.complete_request_timeout)) {
-                        info("POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s has not sent a complete request in %zu seconds - closing it. "
-                              , i
-                              , pi->fd
-                              , pi->client_ip ? pi->client_ip : "<undefined-ip>"
-                              , pi->client_port ? pi->client_port : "<undefined-port>"
-                              , (size_t) p.complete_request_timeout
-                        );
-                        poll_close_fd(pi);
-                    }
-                    else if(unlikely(pi->recv_count && p.idle_timeout > 0 && now - ((pi->last_received_t > pi->last_sent_t) ? pi->last_received_t : pi->last_sent_t) >= p.idle_timeout )) {
-                        info("POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s is idle for more than %zu seconds - closing it. "
-                              , i
-                              , pi->fd
-                              , pi->client_ip ? pi->client_ip : "<undefined-ip>"
-                              , pi->client_port ? pi->client_port : "<undefined-port>"
-                              , (size_t) p.idle_timeout
-                        );
-                        poll_close_fd(pi);
-                    }
-                }
-            }
-        }
+        poll_timer_run(&p, now);
     }
 
     netdata_thread_cleanup_pop(1);
@@ -55,6 +55,7 @@ typedef struct listen_sockets {
 extern char *strdup_client_description(int family, const char *protocol, const char *ip, uint16_t port);
 
 extern int listen_sockets_setup(LISTEN_SOCKETS *sockets);
+extern int listen_sockets_setup_reuse_port(LISTEN_SOCKETS *sockets, LISTEN_SOCKETS *from);
 extern void listen_sockets_close(LISTEN_SOCKETS *sockets);
 
 extern void foreach_entry_in_connection_string(const char *destination, bool (*callback)(char *entry, void *data), void *data);
@@ -104,6 +105,12 @@ extern int accept4(int sock, struct sockaddr *addr, socklen_t *addrlen, int flag
 #define POLLINFO_FLAG_SERVER_SOCKET 0x00000001
 #define POLLINFO_FLAG_CLIENT_SOCKET 0x00000002
 #define POLLINFO_FLAG_DONT_CLOSE    0x00000004
+#define POLLINFO_FLAG_ALWAYS_READY  0x00000008 // the fd cannot be added to epoll (i.e. a regular file)
+
+#define POLLINFO_NO_SLOT ((size_t)-1)
+
+// the timer wheel of the idle and request timeouts, one bucket per second (power of 2)
+#define POLL_TIMER_WHEEL_SLOTS 64
 
 typedef struct poll POLLJOB;
 
@@ -140,6 +147,12 @@ typedef struct pollinfo {
     // this is like a stack, it grows and shrinks
     // (with gaps - lower empty slots are preferred)
     struct pollinfo *next;
+
+    // linking in the timer wheel, by slot id
+    // (pointers are not stable, the array is reallocated)
+    time_t timer_expires;   // the time the timeouts of the socket have to be checked, 0 when not scheduled
+    size_t timer_prev;
+    size_t timer_next;
 } POLLINFO;
 
 struct poll {
@@ -152,15 +165,26 @@ struct poll {
 
     time_t complete_request_timeout;
     time_t idle_timeout;
-    time_t checks_every;
 
     time_t timer_milliseconds;
     void *timer_data;
 
-    struct pollfd *fds;
+    struct pollfd *fds;     // the events each slot waits for, with both backends
     struct pollinfo *inf;
     struct pollinfo *first_free;
 
+    size_t timer_wheel[POLL_TIMER_WHEEL_SLOTS];
+    time_t timer_wheel_time; // the last second the timer wheel has been run for
+
+#ifdef __linux__
+    int epoll_fd;           // -1 when poll() is used
+    struct epoll_event *epoll_events;
+
+    size_t *always_ready;   // the slots of POLLINFO_FLAG_ALWAYS_READY fds
+    size_t always_ready_used;
+    size_t always_ready_size;
+#endif
+
     SIMPLE_PATTERN *access_list;
     int allow_dns;
 
@@ -193,6 +217,7 @@ extern POLLINFO *poll_add_fd(POLLJOB *p
                              , void *data
 );
 extern void poll_close_fd(POLLINFO *pi);
+extern void poll_set_events(POLLINFO *pi, short int events);
 
 extern void poll_events(LISTEN_SOCKETS *sockets
         , void *(*add_callback)(POLLINFO *pi, short int *events, void *data)
@@ -160,71 +160,107 @@ int print_netdata_double(char *str, NETDATA_DOUBLE value)
 }
 */
 
-int print_netdata_double(char *str, NETDATA_DOUBLE value) {
-    // info("printing number " NETDATA_DOUBLE_FORMAT, value);
-    char integral_str[50], fractional_str[50];
+// ----------------------------------------------------------------------------
+// printing of NETDATA_DOUBLE with 7 fractional digits
+//
+// The integral and the fractional parts are converted to integers once, and their
+// digits are written forward, two at a time, from a lookup table. This gives the
+// same output as printf("%0.7f") (or print_netdata_double() with the trailing zeros
+// removed), without the generic formatting machinery of printf().
+
+static const char print_digits_lut[200] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// values up to this are printed with integer arithmetic
+#define PRINT_NETDATA_DOUBLE_MAX ((NETDATA_DOUBLE)1e18)
+
+static inline char *print_digits_llu(char *dst, unsigned long long v) {
+    char tmp[24], *p = &tmp[sizeof(tmp)];
+
+    while(v >= 100) {
+        const char *d = &print_digits_lut[(v % 100) * 2];
+        v /= 100;
+        *--p = d[1];
+        *--p = d[0];
+    }
+
+    if(v >= 10) {
+        const char *d = &print_digits_lut[v * 2];
+        *--p = d[1];
+        *--p = d[0];
+    }
+    else
+        *--p = (char)('0' + v);
+
+    size_t len = (size_t)(&tmp[sizeof(tmp)] - p);
+    memcpy(dst, p, len);
+    return dst + len;
+}
 
+// writes the 7 digits of v (0 to 9999999), with leading zeros
+static inline void print_digits_fractional(char *dst, unsigned long long v) {
+    unsigned int f = (unsigned int)v;
+    memcpy(&dst[0], &print_digits_lut[(f / 100000) * 2], 2);
+    memcpy(&dst[2], &print_digits_lut[(f / 1000 % 100) * 2], 2);
+    memcpy(&dst[4], &print_digits_lut[(f / 10 % 100) * 2], 2);
+    dst[6] = (char)('0' + f % 10);
+}
+
+static inline int print_netdata_double_internal(char *str, NETDATA_DOUBLE value, int fixed) {
     char *wstr = str;
 
-    if(unlikely(value < 0)) {
+    // printf() prints the sign of negative zero
+    if(unlikely(fixed ? signbit(value) : value < 0)) {
         *wstr++ = '-';
         value = -value;
     }
 
-    NETDATA_DOUBLE integral, fractional;
-
-#ifdef STORAGE_WITH_MATH
-    fractional = modfndd(value, &integral) * 10000000.0;
-#else
-    fractional = ((unsigned long long)(value * 10000000ULL) % 10000000ULL);
-#endif
+    if(unlikely(!(value < PRINT_NETDATA_DOUBLE_MAX))) {
+        // too big for integer arithmetic, or not a number
+        snprintfz(wstr, 48, (fixed) ? NETDATA_DOUBLE_FORMAT : NETDATA_DOUBLE_FORMAT_ZERO, value);
+        return (int)(wstr - str + strlen(wstr));
+    }
 
-    unsigned long long integral_int = (unsigned long long)integral;
+    unsigned long long integral_int = (unsigned long long)value;
+    NETDATA_DOUBLE fractional = (value - (NETDATA_DOUBLE)integral_int) * 10000000.0;
     unsigned long long fractional_int = (unsigned long long)llrintndd(fractional);
+
+    if(unlikely(fixed && fabsndd(fractional - (NETDATA_DOUBLE)fractional_int) > 0.4999)) {
+        // the scaling above is rounded too, so it may turn a value just above or below
+        // a halfway point into an exact tie - printf() decides these from the exact value
+        snprintfz(wstr, 48, NETDATA_DOUBLE_FORMAT, value);
+        return (int)(wstr - str + strlen(wstr));
+    }
+
     if(unlikely(fractional_int >= 10000000)) {
         integral_int += 1;
         fractional_int -= 10000000;
     }
 
-    // info("integral " NETDATA_DOUBLE_FORMAT " (%llu), fractional " NETDATA_DOUBLE_FORMAT " (%llu)", integral, integral_int, fractional, fractional_int);
-
-    char *istre;
-    if(unlikely(integral_int == 0)) {
-        integral_str[0] = '0';
-        istre = &integral_str[1];
-    }
-    else
-        // convert the integral part to string (reversed)
-        istre = print_number_llu_r_smart(integral_str, integral_int);
-
-    // copy reversed the integral string
-    istre--;
-    while( istre >= integral_str ) *wstr++ = *istre--;
+    wstr = print_digits_llu(wstr, integral_int);
 
-    if(likely(fractional_int != 0)) {
-        // add a dot
+    if(fixed || fractional_int) {
         *wstr++ = '.';
+        print_digits_fractional(wstr, fractional_int);
+        wstr += 7;
 
-        // convert the fractional part to string (reversed)
-        char *fstre = print_number_llu_r_smart(fractional_str, fractional_int);
-
-        // prepend zeros to reach 7 digits length
-        int decimal = 7;
-        int len = (int)(fstre - fractional_str);
-        while(len < decimal) {
-            *wstr++ = '0';
-            len++;
-        }
-
-        char *begin = fractional_str;
-        while(begin < fstre && *begin == '0') begin++;
-
-        // copy reversed the fractional string
-        fstre--;
-        while( fstre >= begin ) *wstr++ = *fstre--;
+        // remove the trailing zeros
+        if(!fixed)
+            while(wstr[-1] == '0') wstr--;
     }
 
     *wstr = '\0';
-    // info("printed number '%s'", str);
     return (int)(wstr - str);
 }
+
+int print_netdata_double(char *str, NETDATA_DOUBLE value) {
+    return print_netdata_double_internal(str, value, 0);
+}
+
+int print_netdata_double_fixed(char *str, NETDATA_DOUBLE value) {
+    return print_netdata_double_internal(str, value, 1);
+}
@@ -104,7 +104,10 @@ typedef enum {
 storage_number pack_storage_number(NETDATA_DOUBLE value, SN_FLAGS flags) __attribute__((const));
 static inline NETDATA_DOUBLE unpack_storage_number(storage_number value) __attribute__((const));
 
+// print value to str (at least 50 bytes), with up to 7 fractional digits, without trailing zeros
 int print_netdata_double(char *str, NETDATA_DOUBLE value);
+// print value to str (at least 50 bytes), like NETDATA_DOUBLE_FORMAT does
+int print_netdata_double_fixed(char *str, NETDATA_DOUBLE value);
 
 //                                                          sign       div/mul      <--- multiplier / divider --->     10/100       RESET      EXISTS     VALUE
 #define STORAGE_NUMBER_POSITIVE_MAX_RAW (storage_number)( (0 << 31) | (1 << 30) | (1 << 29) | (1 << 28) | (1 << 27) | (1 << 26) | (0 << 25) | (1 << 24) | 0x00ffffff )
@@ -42,10 +42,34 @@ static void test_number_printing(void **state)
     assert_string_equal(value, "16.77722");
 }
 
+static void test_number_printing_fixed(void **state)
+{
+    (void)state;
+
+    NETDATA_DOUBLE values[] = {
+        0, -0.0, 0.0000001, 0.00000009, 0.000000001, -0.000000001, 99.99999999999999999, -99.99999999999999999,
+        123.4567890123456789, 9999.9999999, -9999.9999999, 690565856, 0.5, 1e17, -123456789.987654321,
+
+        // halfway between two printed values
+        7.72154585, -7.72154585, 0.00000005, 0.00000015, 0.00000025, 1.00000025, 2.50000005, 123.45678905,
+        9999.99999995, 690565856.00000005
+    };
+
+    char value[50], expected[50];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        snprintfz(expected, 49, NETDATA_DOUBLE_FORMAT, values[i]);
+
+        int len = print_netdata_double_fixed(value, values[i]);
+        assert_string_equal(value, expected);
+        assert_int_equal(len, strlen(expected));
+    }
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
-        cmocka_unit_test(test_number_printing)
+        cmocka_unit_test(test_number_printing),
+        cmocka_unit_test(test_number_printing_fixed)
     };
 
     return cmocka_run_group_tests_name("storage_number", tests, NULL, NULL);
@@ -73,6 +73,7 @@ typedef struct parser {
     RRDHOST *host;
     void *input;                    // Input source e.g. stream
     void *output;                   // Stream to send commands to plugin
+    bool (*send_function)(struct parser *parser, const char *txt); // when set, commands are sent with it, not to output
     PARSER_DATA    *data;           // extra input
     PARSER_KEYWORD  *keyword;       // List of parse keywords and functions
     PLUGINSD_ACTION *plugins_action;
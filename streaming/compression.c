@@ -2,6 +2,9 @@
 
 #ifdef ENABLE_COMPRESSION
 #include "lz4.h"
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
 
 #define STREAM_COMPRESSION_MSG "STREAM_COMPRESSION"
 
@@ -9,6 +12,16 @@
 #define SIGNATURE_MASK ((uint32_t)0xff | (0x80 << 8) | (0x80 << 16) | (0xff << 24))
 #define SIGNATURE_SIZE 4
 
+// the signature has 14 bits for the size of the compressed block
+#define SIGNATURE_MAX_BLOCK_SIZE 0x3fff
+
+// the history both ends keep for zstd, 1MiB per connection
+#define ZSTD_WINDOW_LOG 20
+
+// the adaptive level of zstd goes down by 1 every second while the sender buffer is more than 1/4 full,
+// and back up by 1 every 10 seconds while it is less than 1/16 full
+#define ZSTD_ADAPT_DOWN_EVERY_SECS 1
+#define ZSTD_ADAPT_UP_EVERY_SECS 10
 
 /*
  * LZ4 streaming API compressor specific data
@@ -18,8 +31,42 @@ struct compressor_data {
     char *input_ring_buffer;
     size_t input_ring_buffer_size;
     size_t input_ring_buffer_pos;
+
+#ifdef ENABLE_ZSTD
+    // zstd streaming API, a single frame per level - the level changes on frame boundaries
+    ZSTD_CCtx *zstd;
+    int level;                  // the level of the current frame
+    int wanted_level;           // the level of the next frame
+    time_t level_changed_t;
+#endif
 };
 
+/*
+ * Make room for a compressed block of up to size bytes, after its signature
+ */
+static void compressor_result_buffer_resize(struct compressor_state *state, size_t size)
+{
+    size_t data_size = size + SIGNATURE_SIZE;
+
+    if (!state->compression_result_buffer) {
+        state->compression_result_buffer = mallocz(data_size);
+        state->compression_result_buffer_size = data_size;
+    }
+    else if(unlikely(state->compression_result_buffer_size < data_size)) {
+        state->compression_result_buffer = reallocz(state->compression_result_buffer, data_size);
+        state->compression_result_buffer_size = data_size;
+    }
+}
+
+/*
+ * Write the signature header of a compressed block of the given size
+ */
+static void compressor_set_signature(struct compressor_state *state, size_t compressed_data_size)
+{
+    uint32_t len = ((compressed_data_size & 0x7f) | 0x80 | (((compressed_data_size & (0x7f << 7)) << 1) | 0x8000)) << 8;
+    *(uint32_t *)state->compression_result_buffer = len | SIGNATURE;
+}
+
 
 /*
  * Reset compressor state for a new stream
@@ -72,16 +119,7 @@ static size_t lz4_compressor_compress(struct compressor_state *state, const char
     }
 
     size_t max_dst_size = LZ4_COMPRESSBOUND(size);
-    size_t data_size = max_dst_size + SIGNATURE_SIZE;
-
-    if (!state->compression_result_buffer) {
-        state->compression_result_buffer = mallocz(data_size);
-        state->compression_result_buffer_size = data_size;
-    }
-    else if(unlikely(state->compression_result_buffer_size < data_size)) {
-        state->compression_result_buffer = reallocz(state->compression_result_buffer, data_size);
-        state->compression_result_buffer_size = data_size;
-    }
+    compressor_result_buffer_resize(state, max_dst_size);
 
     // the ring buffer always has space for LZ4_MAX_MSG_SIZE
     memcpy(state->data->input_ring_buffer + state->data->input_ring_buffer_pos, data, size);
@@ -107,21 +145,152 @@ static size_t lz4_compressor_compress(struct compressor_state *state, const char
         state->data->input_ring_buffer_pos = 0;
 
     // update the signature header
-    uint32_t len = ((compressed_data_size & 0x7f) | 0x80 | (((compressed_data_size & (0x7f << 7)) << 1) | 0x8000)) << 8;
-    *(uint32_t *)state->compression_result_buffer = len | SIGNATURE;
+    compressor_set_signature(state, compressed_data_size);
     *out = state->compression_result_buffer;
     debug(D_STREAM, "%s: Compressed data header: %ld", STREAM_COMPRESSION_MSG, compressed_data_size);
     return compressed_data_size + SIGNATURE_SIZE;
 }
 
+#ifdef ENABLE_ZSTD
+/*
+ * zstd streaming API compressor
+ *
+ * Every block is flushed, so that the receiver can decompress it as soon as it gets it, while the history of
+ * the stream is kept on both ends, like with lz4. A level change ends the current frame and starts a new one,
+ * since zstd cannot change the level of a frame.
+ */
+
+static void zstd_compressor_reset(struct compressor_state *state)
+{
+    if (state->data && state->data->zstd) {
+        ZSTD_CCtx_reset(state->data->zstd, ZSTD_reset_session_only);
+        state->data->level = state->data->wanted_level = default_compression_zstd_level;
+        ZSTD_CCtx_setParameter(state->data->zstd, ZSTD_c_compressionLevel, state->data->level);
+        info("%s: Compressor Reset (zstd level %d)", STREAM_COMPRESSION_MSG, state->data->level);
+    }
+}
+
+static void zstd_compressor_destroy(struct compressor_state **state)
+{
+    if (state && *state) {
+        struct compressor_state *s = *state;
+        if (s->data) {
+            ZSTD_freeCCtx(s->data->zstd);
+            freez(s->data);
+        }
+        freez(s->compression_result_buffer);
+        freez(s);
+        *state = NULL;
+        debug(D_STREAM, "%s: Compressor Destroyed.", STREAM_COMPRESSION_MSG);
+    }
+}
+
+static size_t zstd_compressor_compress(struct compressor_state *state, const char *data, size_t size, char **out)
+{
+    if(unlikely(!state || !size || !out))
+        return 0;
+
+    if(unlikely(size > COMPRESSION_MAX_MSG_SIZE)) {
+        error("%s: Compression Failed - Message size %lu above compression buffer limit: %d", STREAM_COMPRESSION_MSG, (long unsigned int)size, COMPRESSION_MAX_MSG_SIZE);
+        return 0;
+    }
+
+    struct compressor_data *d = state->data;
+    size_t max_dst_size = ZSTD_compressBound(size);
+    compressor_result_buffer_resize(state, max_dst_size);
+
+    ZSTD_EndDirective mode = (d->level != d->wanted_level) ? ZSTD_e_end : ZSTD_e_flush;
+    ZSTD_inBuffer input = { .src = data, .size = size, .pos = 0 };
+    ZSTD_outBuffer output = { .dst = state->compression_result_buffer + SIGNATURE_SIZE, .size = max_dst_size, .pos = 0 };
+
+    size_t remaining;
+    do {
+        remaining = ZSTD_compressStream2(d->zstd, &output, &input, mode);
+        if (ZSTD_isError(remaining)) {
+            error("%s: zstd compression error: %s", STREAM_COMPRESSION_MSG, ZSTD_getErrorName(remaining));
+            return 0;
+        }
+    } while (remaining && output.pos < output.size);
+
+    if (unlikely(remaining || output.pos > SIGNATURE_MAX_BLOCK_SIZE)) {
+        error("%s: zstd compressed %lu bytes to %lu, above the block limit %d", STREAM_COMPRESSION_MSG,
+              (long unsigned int)size, (long unsigned int)output.pos, SIGNATURE_MAX_BLOCK_SIZE);
+        return 0;
+    }
+
+    // the frame has ended, the next one starts with the new level
+    if (mode == ZSTD_e_end) {
+        debug(D_STREAM, "%s: zstd level changed from %d to %d", STREAM_COMPRESSION_MSG, d->level, d->wanted_level);
+        d->level = d->wanted_level;
+        ZSTD_CCtx_setParameter(d->zstd, ZSTD_c_compressionLevel, d->level);
+    }
+
+    compressor_set_signature(state, output.pos);
+    *out = state->compression_result_buffer;
+    return output.pos + SIGNATURE_SIZE;
+}
+
 /*
- * Create and initialize compressor state
+ * Lower the level when the sender buffer backs up, and raise it back to the configured one when it drains
+ */
+static void zstd_compressor_adapt(struct compressor_state *state, size_t buffered, size_t buffer_size)
+{
+    struct compressor_data *d = state->data;
+    time_t now = now_monotonic_sec();
+
+    if (buffered > buffer_size / 4) {
+        if (d->wanted_level > 1 && now - d->level_changed_t >= ZSTD_ADAPT_DOWN_EVERY_SECS) {
+            d->wanted_level--;
+            d->level_changed_t = now;
+        }
+    }
+    else if (buffered < buffer_size / 16) {
+        if (d->wanted_level < default_compression_zstd_level && now - d->level_changed_t >= ZSTD_ADAPT_UP_EVERY_SECS) {
+            d->wanted_level++;
+            d->level_changed_t = now;
+        }
+    }
+}
+
+static struct compressor_state *zstd_create_compressor(void)
+{
+    struct compressor_state *state = callocz(1, sizeof(struct compressor_state));
+
+    state->algorithm = STREAM_CAP_ZSTD;
+    state->reset = zstd_compressor_reset;
+    state->compress = zstd_compressor_compress;
+    state->adapt = default_compression_adaptive ? zstd_compressor_adapt : NULL;
+    state->destroy = zstd_compressor_destroy;
+
+    state->data = callocz(1, sizeof(struct compressor_data));
+    state->data->zstd = ZSTD_createCCtx();
+    if (!state->data->zstd)
+        fatal("%s: Cannot create zstd compression context", STREAM_COMPRESSION_MSG);
+    ZSTD_CCtx_setParameter(state->data->zstd, ZSTD_c_windowLog, ZSTD_WINDOW_LOG);
+    ZSTD_CCtx_setParameter(state->data->zstd, ZSTD_c_checksumFlag, 0);
+    state->compression_result_buffer_size = 0;
+    state->reset(state);
+    debug(D_STREAM, "%s: Initialize streaming zstd compression!", STREAM_COMPRESSION_MSG);
+    return state;
+}
+#endif
+
+/*
+ * Create and initialize compressor state for the negotiated capabilities
  * Return the pointer to compressor_state structure created
  */
-struct compressor_state *create_compressor()
+struct compressor_state *create_compressor(STREAM_CAPABILITIES capabilities)
 {
+#ifdef ENABLE_ZSTD
+    if (capabilities & STREAM_CAP_ZSTD)
+        return zstd_create_compressor();
+#else
+    UNUSED(capabilities);
+#endif
+
     struct compressor_state *state = callocz(1, sizeof(struct compressor_state));
 
+    state->algorithm = STREAM_CAP_COMPRESSION;
     state->reset = lz4_compressor_reset;
     state->compress = lz4_compressor_compress;
     state->destroy = lz4_compressor_destroy;
@@ -144,6 +313,11 @@ struct decompressor_data {
     char *stream_buffer;
     size_t stream_buffer_size;
     size_t stream_buffer_pos;
+
+#ifdef ENABLE_ZSTD
+    // zstd streaming API, it keeps the history itself, so stream_buffer only holds the last block
+    ZSTD_DCtx *zstd;
+#endif
 };
 
 /*
@@ -257,6 +431,30 @@ static size_t saving_percent(size_t comp_len, size_t src_len)
     return 100 - comp_len * 100 / src_len;
 }
 
+/*
+ * Some compression statistics
+ */
+static void decompressor_update_statistics(struct decompressor_state *state, size_t decompressed_size)
+{
+    size_t old_avg_saving = saving_percent(state->total_compressed, state->total_uncompressed);
+    size_t old_avg_size = state->packet_count ? state->total_uncompressed / state->packet_count : 0;
+
+    state->total_compressed += state->buffer_len + SIGNATURE_SIZE;
+    state->total_uncompressed += decompressed_size;
+    state->packet_count++;
+
+    size_t saving = saving_percent(state->buffer_len, decompressed_size);
+    size_t avg_saving = saving_percent(state->total_compressed, state->total_uncompressed);
+    size_t avg_size = state->total_uncompressed / state->packet_count;
+
+    (void)saving;
+
+    if (old_avg_saving != avg_saving || old_avg_size != avg_size){
+        debug(D_STREAM, "%s: Saving: %lu%% (avg. %lu%%), avg.size: %lu", STREAM_COMPRESSION_MSG,
+              (long unsigned int) saving, (long unsigned int) avg_saving, (long unsigned int) avg_size);
+    }
+}
+
 /*
  * Decompress the compressed data in the internal buffer
  * Return the size of uncompressed data or 0 for error
@@ -285,24 +483,7 @@ static size_t lz4_decompressor_decompress(struct decompressor_state *state)
     state->out_buffer_len = decompressed_size;
     state->out_buffer_pos = 0;
 
-    // Some compression statistics
-    size_t old_avg_saving = saving_percent(state->total_compressed, state->total_uncompressed);
-    size_t old_avg_size = state->packet_count ? state->total_uncompressed / state->packet_count : 0;
-
-    state->total_compressed += state->buffer_len + SIGNATURE_SIZE;
-    state->total_uncompressed += decompressed_size;
-    state->packet_count++;
-
-    size_t saving = saving_percent(state->buffer_len, decompressed_size);
-    size_t avg_saving = saving_percent(state->total_compressed, state->total_uncompressed);
-    size_t avg_size = state->total_uncompressed / state->packet_count;
-
-    (void)saving;
-
-    if (old_avg_saving != avg_saving || old_avg_size != avg_size){
-        debug(D_STREAM, "%s: Saving: %lu%% (avg. %lu%%), avg.size: %lu", STREAM_COMPRESSION_MSG,
-              (long unsigned int) saving, (long unsigned int) avg_saving, (long unsigned int) avg_size);
-    }
+    decompressor_update_statistics(state, decompressed_size);
     return decompressed_size;
 }
 
@@ -340,13 +521,114 @@ static size_t lz4_decompressor_get(struct decompressor_state *state, char *data,
     return size;
 }
 
+#ifdef ENABLE_ZSTD
 /*
- * Create and initialize decompressor state
+ * zstd streaming API decompressor
+ * It shares the collection of the compressed blocks and the line oriented output with lz4
+ */
+
+static void zstd_decompressor_reset(struct decompressor_state *state)
+{
+    if (state->data) {
+        if (state->data->zstd)
+            ZSTD_DCtx_reset(state->data->zstd, ZSTD_reset_session_only);
+        state->buffer_len = 0;
+        state->out_buffer_len = 0;
+    }
+}
+
+static void zstd_decompressor_destroy(struct decompressor_state **state)
+{
+    if (state && *state) {
+        struct decompressor_state *s = *state;
+        if (s->data) {
+            debug(D_STREAM, "%s: Destroying decompressor.", STREAM_COMPRESSION_MSG);
+            ZSTD_freeDCtx(s->data->zstd);
+            freez(s->data->stream_buffer);
+            freez(s->data);
+        }
+        freez(s->buffer);
+        freez(s);
+        *state = NULL;
+    }
+}
+
+static size_t zstd_decompressor_decompress(struct decompressor_state *state)
+{
+    if (!state)
+        return 0;
+    if (!state->buffer) {
+        error("%s: No decompressor buffer allocated", STREAM_COMPRESSION_MSG);
+        return 0;
+    }
+
+    // every block is flushed by the sender, so all of it is decompressed at once
+    ZSTD_inBuffer input = { .src = state->buffer, .size = state->buffer_len, .pos = 0 };
+    ZSTD_outBuffer output = { .dst = state->data->stream_buffer, .size = state->data->stream_buffer_size, .pos = 0 };
+
+    while (input.pos < input.size) {
+        size_t ret = ZSTD_decompressStream(state->data->zstd, &output, &input);
+        if (ZSTD_isError(ret)) {
+            error("%s: zstd decompressor error: %s", STREAM_COMPRESSION_MSG, ZSTD_getErrorName(ret));
+            return 0;
+        }
+        if (output.pos == output.size && input.pos < input.size) {
+            error("%s: zstd decompressed block is above the limit of %lu bytes", STREAM_COMPRESSION_MSG,
+                  (long unsigned int)output.size);
+            return 0;
+        }
+    }
+
+    state->out_buffer = state->data->stream_buffer;
+    state->out_buffer_len = output.pos;
+    state->out_buffer_pos = 0;
+
+    decompressor_update_statistics(state, output.pos);
+    return output.pos;
+}
+
+static struct decompressor_state *zstd_create_decompressor(void)
+{
+    struct decompressor_state *state = callocz(1, sizeof(struct decompressor_state));
+    state->algorithm = STREAM_CAP_ZSTD;
+    state->reset = zstd_decompressor_reset;
+    state->start = lz4_decompressor_start;
+    state->put = lz4_decompressor_put;
+    state->decompress = zstd_decompressor_decompress;
+    state->get = lz4_decompressor_get;
+    state->decompressed_bytes_in_buffer = lz4_decompressor_decompressed_bytes_in_buffer;
+    state->destroy = zstd_decompressor_destroy;
+
+    state->data = callocz(1, sizeof(struct decompressor_data));
+    state->data->zstd = ZSTD_createDCtx();
+    if (!state->data->zstd)
+        fatal("%s: Cannot create zstd decompression context", STREAM_COMPRESSION_MSG);
+    // do not let the sender make us keep a larger history
+    ZSTD_DCtx_setParameter(state->data->zstd, ZSTD_d_windowLogMax, ZSTD_WINDOW_LOG);
+    // a block decompresses to at most COMPRESSION_MAX_MSG_SIZE, the rest is a margin for the end of a frame
+    state->data->stream_buffer_size = COMPRESSION_MAX_MSG_SIZE * 2;
+    state->data->stream_buffer = mallocz(state->data->stream_buffer_size);
+    state->reset(state);
+    debug(D_STREAM, "%s: Initialize streaming zstd decompression!", STREAM_COMPRESSION_MSG);
+    return state;
+}
+#endif
+
+/*
+ * Create and initialize decompressor state for the negotiated capabilities
  * Return the pointer to decompressor_state structure created
  */
-struct decompressor_state *create_decompressor()
+struct decompressor_state *create_decompressor(STREAM_CAPABILITIES capabilities)
 {
+#ifdef ENABLE_ZSTD
+    if (capabilities & STREAM_CAP_ZSTD)
+        return zstd_create_decompressor();
+#else
+    UNUSED(capabilities);
+#endif
+
     struct decompressor_state *state = callocz(1, sizeof(struct decompressor_state));
+    state->algorithm = STREAM_CAP_COMPRESSION;
     state->reset = lz4_decompressor_reset;
     state->start = lz4_decompressor_start;
     state->put = lz4_decompressor_put;
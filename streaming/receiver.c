@@ -3,6 +3,10 @@
 #include "rrdpush.h"
 #include "parser/parser.h"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
 #define WORKER_RECEIVER_JOB_BYTES_READ (WORKER_PARSER_FIRST_JOB - 1)
 
 #if WORKER_PARSER_FIRST_JOB < 1
@@ -33,38 +37,71 @@ void destroy_receiver_state(struct receiver_state *rpt) {
     if (rpt->decompressor)
         rpt->decompressor->destroy(&rpt->decompressor);
 #endif
+    if(rpt->ingestion.dropped)
+        dictionary_destroy(rpt->ingestion.dropped);
+    netdata_mutex_destroy(&rpt->send_mutex);
     freez(rpt);
 }
 
+// the ingestion charts of the child will not be updated again, until it connects again
+static void streaming_ingestion_charts_obsolete(struct receiver_state *rpt) {
+    if(rpt->ingestion.st_lines)
+        rrdset_is_obsolete(rpt->ingestion.st_lines);
+
+    if(rpt->ingestion.st_definitions)
+        rrdset_is_obsolete(rpt->ingestion.st_definitions);
+
+    if(rpt->ingestion.st_cost)
+        rrdset_is_obsolete(rpt->ingestion.st_cost);
+}
+
+// releases the receiver state when its connection has ended
+static void receiver_state_release(struct receiver_state *rpt) {
+    // If the shutdown sequence has started, and this receiver is still attached to the host then we cannot touch
+    // the host pointer as it is unpredictable when the RRDHOST is deleted. Do the cleanup from rrdhost_free().
+    if (netdata_exit && rpt->host) {
+        rpt->exited = 1;
+        return;
+    }
+
+    // Make sure that we detach this thread and don't kill a freshly arriving receiver
+    if (!netdata_exit && rpt->host) {
+        netdata_mutex_lock(&rpt->host->receiver_lock);
+        if (rpt->host->receiver == rpt) {
+            rpt->host->receiver = NULL;
+
+            // the statistics thread updates them with the lock held, only while the receiver is attached to the host
+            streaming_ingestion_charts_obsolete(rpt);
+        }
+        netdata_mutex_unlock(&rpt->host->receiver_lock);
+    }
+
+    info("STREAM %s [receive from [%s]:%s]: receive thread ended (task id %d)", rpt->hostname, rpt->client_ip, rpt->client_port, gettid());
+    destroy_receiver_state(rpt);
+}
+
+// set when the connection of the receiver thread has been handed over to the receivers pool
+static __thread bool receiver_handed_to_pool = false;
+
 static void rrdpush_receiver_thread_cleanup(void *ptr) {
     worker_unregister();
 
     static __thread int executed = 0;
     if(!executed) {
         executed = 1;
-        struct receiver_state *rpt = (struct receiver_state *) ptr;
-        // If the shutdown sequence has started, and this receiver is still attached to the host then we cannot touch
-        // the host pointer as it is unpredictable when the RRDHOST is deleted. Do the cleanup from rrdhost_free().
-        if (netdata_exit && rpt->host) {
-            rpt->exited = 1;
-            return;
-        }
 
-        // Make sure that we detach this thread and don't kill a freshly arriving receiver
-        if (!netdata_exit && rpt->host) {
-            netdata_mutex_lock(&rpt->host->receiver_lock);
-            if (rpt->host->receiver == rpt)
-                rpt->host->receiver = NULL;
-            netdata_mutex_unlock(&rpt->host->receiver_lock);
-        }
+        // the receivers pool releases the receiver state when the connection ends
+        if(receiver_handed_to_pool)
+            return;
 
-        info("STREAM %s [receive from [%s]:%s]: receive thread ended (task id %d)", rpt->hostname, rpt->client_ip, rpt->client_port, gettid());
-        destroy_receiver_state(rpt);
+        receiver_state_release((struct receiver_state *) ptr);
     }
 }
 
 #include "collectors/plugins.d/pluginsd_parser.h"
 
+static bool streaming_send_to_child(struct receiver_state *rpt, const char *message);
+
 PARSER_RC streaming_timestamp(char **words, void *user, PLUGINSD_ACTION *plugins_action)
 {
     UNUSED(plugins_action);
@@ -108,18 +145,7 @@ PARSER_RC streaming_timestamp(char **words, void *user, PLUGINSD_ACTION *plugins
             "REPLICATE %"PRId64" %"PRId64"\n",
             (int64_t)(remote_time - gap),
             (int64_t)remote_time);
-        int ret;
-#ifdef ENABLE_HTTPS
-        SSL *conn = host->receiver->ssl.conn ;
-        if(conn && !host->receiver->ssl.flags) {
-            ret = SSL_write(conn, message, strlen(message));
-        } else {
-            ret = send(host->receiver->fd, message, strlen(message), MSG_DONTWAIT);
-        }
-#else
-        ret = send(host->receiver->fd, message, strlen(message), MSG_DONTWAIT);
-#endif
-        if (ret != (int)strlen(message))
+        if (!streaming_send_to_child(((PARSER_USER_OBJECT *)user)->opaque, message))
             error("Failed to send initial timestamp - gaps may appear in charts");
         return PARSER_RC_OK;
     }
@@ -171,6 +197,778 @@ PARSER_RC streaming_claimed_id(char **words, void *user, PLUGINSD_ACTION *plugin
     return PARSER_RC_OK;
 }
 
+// ----------------------------------------------------------------------------
+// binary chart updates
+
+static void streaming_binary_chart_release(struct receiver_state *rpt, struct receiver_binary_chart *c) {
+    for(uint32_t i = 0; i < c->dimensions; i++) {
+        if(c->rd_items[i])
+            dictionary_acquired_item_release(c->st->rrddim_root_index, c->rd_items[i]);
+    }
+
+    if(c->st_item)
+        dictionary_acquired_item_release(rpt->host->rrdset_root_index, c->st_item);
+
+    c->st_item = NULL;
+    c->st = NULL;
+    c->dropped = false;
+    c->dimensions = 0;
+}
+
+static void streaming_binary_cleanup(struct receiver_state *rpt) {
+    for(uint32_t slot = 0; slot < rpt->binary.size; slot++) {
+        struct receiver_binary_chart *c = &rpt->binary.charts[slot];
+        streaming_binary_chart_release(rpt, c);
+        freez(c->rd_items);
+        freez(c->rd);
+    }
+
+    freez(rpt->binary.charts);
+    rpt->binary.charts = NULL;
+    rpt->binary.size = 0;
+    rpt->binary.defining = NULL;
+}
+
+static struct receiver_binary_chart *streaming_binary_chart_get(struct receiver_state *rpt, uint32_t slot) {
+    if(slot >= rpt->binary.size) {
+        uint32_t size = rpt->binary.size ? rpt->binary.size : 256;
+        while(size <= slot)
+            size *= 2;
+
+        rpt->binary.charts = reallocz(rpt->binary.charts, size * sizeof(struct receiver_binary_chart));
+        memset(&rpt->binary.charts[rpt->binary.size], 0, (size - rpt->binary.size) * sizeof(struct receiver_binary_chart));
+        rpt->binary.size = size;
+    }
+
+    return &rpt->binary.charts[slot];
+}
+
+// the chart of the slot has been dropped by the ingestion budget, its updates are ignored
+static void streaming_binary_slot_dropped(struct receiver_state *rpt, uint32_t slot) {
+    rpt->binary.defining = NULL;
+
+    if(unlikely(!slot || slot >= STREAM_BINARY_MAX_SLOTS))
+        return;
+
+    struct receiver_binary_chart *c = streaming_binary_chart_get(rpt, slot);
+    streaming_binary_chart_release(rpt, c);
+    c->dropped = true;
+}
+
+static void streaming_binary_dimension_add(struct receiver_binary_chart *c, const DICTIONARY_ITEM *item) {
+    if(c->dimensions == c->size) {
+        c->size = c->size ? c->size * 2 : 16;
+        c->rd_items = reallocz(c->rd_items, c->size * sizeof(*c->rd_items));
+        c->rd = reallocz(c->rd, c->size * sizeof(*c->rd));
+    }
+
+    c->rd_items[c->dimensions] = item;
+    c->rd[c->dimensions] = item ? dictionary_acquired_item_value(item) : NULL;
+    c->dimensions++;
+}
+
+// a dimension dropped by the ingestion budget still takes its slot, its values are ignored
+static void streaming_binary_dimension_dropped(struct receiver_state *rpt) {
+    if(rpt->binary.defining)
+        streaming_binary_dimension_add(rpt->binary.defining, NULL);
+}
+
+// SLOT <id>, sent after the CHART line of a definition
+PARSER_RC streaming_binary_slot(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+    RRDSET *st = ((PARSER_USER_OBJECT *)user)->st;
+    uint32_t slot = (words[1] && *words[1]) ? (uint32_t)str2ul(words[1]) : 0;
+
+    rpt->binary.defining = NULL;
+
+    if(unlikely(!st || !slot || slot >= STREAM_BINARY_MAX_SLOTS)) {
+        error("STREAM %s [receive from [%s]:%s]: received SLOT '%s' %s. Disabling it.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port,
+              words[1] ? words[1] : "", st ? "which is invalid" : "without a CHART");
+        ((PARSER_USER_OBJECT *)user)->enabled = 0;
+        return PARSER_RC_ERROR;
+    }
+
+    // keep the chart and its dimensions acquired, so that they cannot be freed while we use them
+    struct receiver_binary_chart *c = streaming_binary_chart_get(rpt, slot);
+    streaming_binary_chart_release(rpt, c);
+    c->st_item = dictionary_get_and_acquire_item(rpt->host->rrdset_root_index, rrdset_id(st));
+    if(likely(c->st_item)) {
+        c->st = st;
+        rpt->binary.defining = c;
+    }
+
+    return PARSER_RC_OK;
+}
+
+// runs after pluginsd_dimension(), to give the dimension the next slot of the chart being defined
+PARSER_RC streaming_binary_dimension(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+    struct receiver_binary_chart *c = rpt->binary.defining;
+
+    if(unlikely(!c || c->st != ((PARSER_USER_OBJECT *)user)->st || !words[1]))
+        return PARSER_RC_OK;
+
+    // slots are given in the order of the DIMENSION lines, so a missing one must still take its slot
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(c->st->rrddim_root_index, words[1]);
+    if(unlikely(!item)) {
+        error("STREAM %s [receive from [%s]:%s]: cannot find dimension '%s' of chart '%s' to give it a slot.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, words[1], rrdset_id(c->st));
+        rpt->binary.defining = NULL;
+        return PARSER_RC_OK;
+    }
+
+    streaming_binary_dimension_add(c, item);
+    return PARSER_RC_OK;
+}
+
+// executes a binary chart update frame, it does what BEGIN, SET and END do, without parsing any text
+static PARSER_RC streaming_binary_frame(struct receiver_state *rpt, PARSER_USER_OBJECT *user, const char *frame)
+{
+    PLUGINSD_ACTION *plugins_action = user->parser->plugins_action;
+    const uint8_t *s = (const uint8_t *)frame + 1;
+    uint64_t slot, type;
+
+    if(unlikely(!stream_binary_get_uint(&s, &slot) || !stream_binary_get_uint(&s, &type)))
+        goto malformed;
+
+    struct receiver_binary_chart *c = (slot < rpt->binary.size) ? &rpt->binary.charts[slot] : NULL;
+    if(unlikely(c && c->dropped))
+        return PARSER_RC_OK;
+
+    if(unlikely(!c || !c->st)) {
+        error("STREAM %s [receive from [%s]:%s]: received an update for chart slot %"PRIu64", which is not defined. Disabling it.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, slot);
+        goto disable;
+    }
+
+    RRDSET *st = c->st;
+    if(type == STREAM_BINARY_BEGIN) {
+        uint64_t microseconds;
+        if(unlikely(!stream_binary_get_uint(&s, &microseconds)))
+            goto malformed;
+
+        user->st = st;
+        if(plugins_action->begin_action) {
+            PARSER_RC rc = plugins_action->begin_action(user, st, microseconds, user->trust_durations);
+            if(unlikely(rc != PARSER_RC_OK))
+                return rc;
+        }
+    }
+    else if(unlikely(type != STREAM_BINARY_CONTINUE || user->st != st))
+        goto malformed;
+
+    while(*s != '\n' && *s) {
+        uint64_t dim_slot;
+        int64_t value;
+
+        if(unlikely(!stream_binary_get_uint(&s, &dim_slot)))
+            goto malformed;
+
+        if(!dim_slot) {
+            user->st = NULL;
+            user->count++;
+            if(plugins_action->end_action)
+                return plugins_action->end_action(user, st);
+            return PARSER_RC_OK;
+        }
+
+        if(unlikely(!stream_binary_get_int(&s, &value)))
+            goto malformed;
+
+        if(unlikely(dim_slot > c->dimensions)) {
+            error("STREAM %s [receive from [%s]:%s]: received a value for dimension slot %"PRIu64" of chart '%s', which has %u dimensions. Disabling it.",
+                  rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, dim_slot, rrdset_id(st), c->dimensions);
+            goto disable;
+        }
+
+        if(plugins_action->set_action && likely(c->rd[dim_slot - 1])) {
+            PARSER_RC rc = plugins_action->set_action(user, st, c->rd[dim_slot - 1], value);
+            if(unlikely(rc != PARSER_RC_OK))
+                return rc;
+        }
+    }
+
+    return PARSER_RC_OK;
+
+malformed:
+    error("STREAM %s [receive from [%s]:%s]: received a malformed binary frame. Disabling it.",
+          rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port);
+
+disable:
+    user->enabled = 0;
+    return PARSER_RC_ERROR;
+}
+
+// ----------------------------------------------------------------------------
+// replication
+
+// all the commands to the child (REPLAY_CHART, THROTTLE, FUNCTION) are sent from here
+// the parser thread and the web threads send them concurrently, so they are serialized
+static bool streaming_send_to_child(struct receiver_state *rpt, const char *message) {
+    size_t length = strlen(message);
+    ssize_t ret;
+
+    netdata_mutex_lock(&rpt->send_mutex);
+
+    if(rpt->pool) {
+        // a thread of the receivers pool serves many children, so it never waits for one of them
+        // the socket is non-blocking; a child that does not read what we send is disconnected
+#ifdef ENABLE_HTTPS
+        if(rpt->ssl.conn && !rpt->ssl.flags)
+            ret = SSL_write(rpt->ssl.conn, message, (int)length);
+        else
+#endif
+            ret = send(rpt->fd, message, length, MSG_DONTWAIT);
+
+        if(ret != (ssize_t)length) {
+            error("STREAM %s [receive from [%s]:%s]: cannot send %zu bytes to the child without blocking (sent %zd). Disconnecting it.",
+                  rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, length, ret);
+            rpt->shutdown = 1;
+        }
+    }
+    else {
+#ifdef ENABLE_HTTPS
+        ret = send_timeout(&rpt->ssl, rpt->fd, (void *)message, length, 0, 60);
+#else
+        ret = send_timeout(rpt->fd, (void *)message, length, 0, 60);
+#endif
+    }
+
+    netdata_mutex_unlock(&rpt->send_mutex);
+
+    return ret == (ssize_t)length;
+}
+
+// the writer of the parser, for the FUNCTION commands it sends to the child
+static bool streaming_parser_send(PARSER *parser, const char *txt) {
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)parser->user)->opaque;
+    return streaming_send_to_child(rpt, txt);
+}
+
+// the child sent the definition of a chart, ask it for the points we miss
+PARSER_RC streaming_replication_chart_definition_end(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+    RRDSET *st = ((PARSER_USER_OBJECT *)user)->st;
+
+    if(unlikely(!st || !words[1] || !words[2])) {
+        error("STREAM %s [receive from [%s]:%s]: received a malformed CHART_DEFINITION_END. Disabling it.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port);
+        ((PARSER_USER_OBJECT *)user)->enabled = 0;
+        return PARSER_RC_ERROR;
+    }
+
+    time_t child_first_entry_t = (time_t)str2l(words[1]);
+    time_t child_last_entry_t = (time_t)str2l(words[2]);
+    time_t after = 0, before = 0;
+
+    if(default_rrdpush_replication_enabled && st->rrd_memory_mode == RRD_MEMORY_MODE_DBENGINE && child_last_entry_t) {
+        time_t first_entry_t, last_entry_t;
+        rrdpush_replication_chart_retention(st, &first_entry_t, &last_entry_t);
+
+        after = last_entry_t ? last_entry_t + st->update_every : child_first_entry_t;
+        if(after < child_first_entry_t)
+            after = child_first_entry_t;
+
+        time_t oldest = now_realtime_sec() - default_rrdpush_replication_period;
+        if(after < oldest)
+            after = oldest;
+
+        before = child_last_entry_t;
+        if(after > before)
+            after = before = 0;
+    }
+
+    char message[RRD_ID_LENGTH_MAX + 100];
+    snprintfz(message, sizeof(message) - 1, "REPLAY_CHART \"%s\" %"PRId64" %"PRId64"\n", rrdset_id(st), (int64_t)after, (int64_t)before);
+
+    // the child does not stream the metrics of the chart until it gets this
+    if(unlikely(!streaming_send_to_child(rpt, message))) {
+        error("STREAM %s [receive from [%s]:%s]: cannot send the replication request of chart '%s'.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, rrdset_id(st));
+        return PARSER_RC_ERROR;
+    }
+
+    if(after)
+        internal_error(true, "STREAM %s [receive from [%s]:%s]: replicating chart '%s' from %"PRId64" to %"PRId64".",
+                       rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, rrdset_id(st), (int64_t)after, (int64_t)before);
+
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_begin(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+    char *id = words[1];
+
+    RRDSET *st = (id && *id) ? rrdset_find(rpt->host, id) : NULL;
+    if(unlikely(!st)) {
+        error("STREAM %s [receive from [%s]:%s]: requested REPLAY_BEGIN on chart '%s', which does not exist. Disabling it.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, id ? id : "(unset)");
+        ((PARSER_USER_OBJECT *)user)->enabled = 0;
+        return PARSER_RC_ERROR;
+    }
+
+    ((PARSER_USER_OBJECT *)user)->st = st;
+    rpt->replication_point_end_time = 0;
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_point(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+
+    rpt->replication_point_end_time = words[1] ? (time_t)str2l(words[1]) : 0;
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_set(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+    RRDSET *st = ((PARSER_USER_OBJECT *)user)->st;
+    char *dimension = words[1];
+    char *value = words[2];
+    char *flags_txt = words[3];
+
+    if(unlikely(!st || !dimension || !value || !rpt->replication_point_end_time)) {
+        error("STREAM %s [receive from [%s]:%s]: received a REPLAY_SET without a REPLAY_BEGIN and REPLAY_POINT. Disabling it.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port);
+        ((PARSER_USER_OBJECT *)user)->enabled = 0;
+        return PARSER_RC_ERROR;
+    }
+
+    RRDDIM *rd = rrddim_find(st, dimension);
+    if(unlikely(!rd || !rd->tiers[0]))
+        return PARSER_RC_OK;
+
+    SN_FLAGS flags = SN_DEFAULT_FLAGS;
+    if(flags_txt) {
+        if(strchr(flags_txt, 'A'))
+            flags &= ~SN_FLAG_NOT_ANOMALOUS;
+        if(strchr(flags_txt, 'R'))
+            flags |= SN_FLAG_RESET;
+    }
+
+    rrddim_store_metric(rd, (usec_t)rpt->replication_point_end_time * USEC_PER_SEC, str2ndd(value, NULL), flags);
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_rrddim_state(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    RRDSET *st = ((PARSER_USER_OBJECT *)user)->st;
+
+    if(unlikely(!st || !words[1] || !words[2] || !words[3] || !words[4] || !words[5]))
+        return PARSER_RC_OK;
+
+    RRDDIM *rd = rrddim_find(st, words[1]);
+    if(unlikely(!rd))
+        return PARSER_RC_OK;
+
+    usec_t last_collected_ut = str2ull(words[2]);
+    rd->last_collected_time.tv_sec = (time_t)(last_collected_ut / USEC_PER_SEC);
+    rd->last_collected_time.tv_usec = (suseconds_t)(last_collected_ut % USEC_PER_SEC);
+    rd->last_collected_value = str2ll(words[3], NULL);
+    rd->last_calculated_value = str2ndd(words[4], NULL);
+    rd->last_stored_value = str2ndd(words[5], NULL);
+
+    // the next collection is calculated against the replicated one
+    if(!rd->collections_counter)
+        rd->collections_counter = 1;
+
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_rrdset_state(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(plugins_action);
+    RRDSET *st = ((PARSER_USER_OBJECT *)user)->st;
+
+    if(unlikely(!st || !words[1] || !words[2]))
+        return PARSER_RC_OK;
+
+    usec_t last_collected_ut = str2ull(words[1]);
+    usec_t last_updated_ut = str2ull(words[2]);
+
+    st->last_collected_time.tv_sec = (time_t)(last_collected_ut / USEC_PER_SEC);
+    st->last_collected_time.tv_usec = (suseconds_t)(last_collected_ut % USEC_PER_SEC);
+    st->last_updated.tv_sec = (time_t)(last_updated_ut / USEC_PER_SEC);
+    st->last_updated.tv_usec = (suseconds_t)(last_updated_ut % USEC_PER_SEC);
+
+    // the next collection continues the replicated ones, it is not the first one
+    if(!st->counter_done)
+        st->counter_done = 1;
+
+    return PARSER_RC_OK;
+}
+
+PARSER_RC streaming_replication_end(char **words, void *user, PLUGINSD_ACTION *plugins_action)
+{
+    UNUSED(words);
+    UNUSED(plugins_action);
+    struct receiver_state *rpt = ((PARSER_USER_OBJECT *)user)->opaque;
+
+    ((PARSER_USER_OBJECT *)user)->st = NULL;
+    rpt->replication_point_end_time = 0;
+    return PARSER_RC_OK;
+}
+
+// ----------------------------------------------------------------------------
+// ingestion budgets
+
+static inline bool streaming_line_keyword(const char *line, const char *keyword, size_t length) {
+    return !strncmp(line, keyword, length) && (line[length] == ' ' || line[length] == '\n' || !line[length]);
+}
+#define streaming_line_is(line, keyword) streaming_line_keyword(line, keyword, sizeof(keyword) - 1)
+
+// copies the first parameter of a line to dst, without its quotes
+static char *streaming_line_parameter(const char *line, char *dst, size_t size) {
+    const char *s = line;
+    size_t length = 0;
+
+    while(*s && *s != ' ' && *s != '\n') s++;
+    while(*s == ' ') s++;
+
+    char quote = (*s == '"' || *s == '\'') ? *s++ : 0;
+    while(*s && *s != '\n' && length < size - 1 && (quote ? *s != quote : *s != ' '))
+        dst[length++] = *s++;
+
+    dst[length] = '\0';
+    return dst;
+}
+
+// dropped dimensions are kept with the id of their chart, as chart|dimension
+static char *streaming_ingestion_dimension_key(RRDSET *st, const char *dimension, char *dst, size_t size) {
+    snprintfz(dst, size - 1, "%s|%s", rrdset_id(st), dimension);
+    return dst;
+}
+
+// asks the child to send less, at most twice per STREAM_THROTTLE_SECONDS
+static void streaming_ingestion_throttle(struct receiver_state *rpt) {
+    time_t now = now_realtime_sec();
+    if(now - rpt->ingestion.throttle_sent_t < STREAM_THROTTLE_SECONDS / 2)
+        return;
+
+    rpt->ingestion.throttle_sent_t = now;
+
+    bool can_throttle = stream_has_capability(rpt, STREAM_CAP_THROTTLE);
+    error("STREAM %s [receive from [%s]:%s]: the child is over its ingestion budgets (%"PRIu64" charts and %"PRIu64" dimensions dropped so far)%s.",
+          rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port,
+          __atomic_load_n(&rpt->ingestion.stats.dropped_charts, __ATOMIC_RELAXED),
+          __atomic_load_n(&rpt->ingestion.stats.dropped_dimensions, __ATOMIC_RELAXED),
+          can_throttle ? ", asking it to throttle" : "");
+
+    if(!can_throttle)
+        return;
+
+    char message[100];
+    snprintfz(message, sizeof(message) - 1, "THROTTLE %d\n", STREAM_THROTTLE_SECONDS);
+    if(!streaming_send_to_child(rpt, message))
+        error("STREAM %s [receive from [%s]:%s]: cannot send the throttling request.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port);
+}
+
+// counts a new chart or dimension against its per minute budget, returns false when it is over the budget
+static bool streaming_ingestion_allow(struct receiver_state *rpt, size_t *counter, size_t budget) {
+    time_t minute = now_realtime_sec() / 60;
+    if(minute != rpt->ingestion.minute) {
+        rpt->ingestion.minute = minute;
+        rpt->ingestion.new_charts = 0;
+        rpt->ingestion.new_dimensions = 0;
+    }
+
+    if(budget && *counter >= budget)
+        return false;
+
+    (*counter)++;
+    return true;
+}
+
+// returns the value of the key in the dropped dictionary, true when it is dropped as a whole
+static bool *streaming_ingestion_drop(struct receiver_state *rpt, const char *key, uint64_t *counter) {
+    if(!rpt->ingestion.dropped)
+        rpt->ingestion.dropped = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_DONT_OVERWRITE_VALUE);
+
+    bool dropped = true;
+    bool *value = dictionary_set(rpt->ingestion.dropped, key, &dropped, sizeof(dropped));
+    *value = true;
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+
+    debug(D_STREAM, "STREAM %s [receive from [%s]:%s]: dropped '%s', it is over the ingestion budget.",
+          rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, key);
+
+    streaming_ingestion_throttle(rpt);
+    return value;
+}
+
+// returns true when the line has to be skipped, because it belongs to a chart or a dimension over the budgets
+// Only CHART and DIMENSION lines are checked against the budgets. Once something has been dropped, BEGIN looks up
+// its chart once per update, and the SET lines are looked up only in the updates of charts with dropped dimensions.
+static bool streaming_ingestion_skip_line(struct receiver_state *rpt, PARSER_USER_OBJECT *user, const char *line) {
+    char id[RRD_ID_LENGTH_MAX + 1];
+    char key[RRD_ID_LENGTH_MAX * 2 + 2];
+
+    if(*line == 'C' && streaming_line_is(line, PLUGINSD_KEYWORD_CHART)) {
+        rpt->ingestion.skipping = false;
+        rpt->ingestion.skipping_dimensions = false;
+        streaming_line_parameter(line, id, sizeof(id));
+
+        if(rrdset_find(rpt->host, id))
+            return false;
+
+        if(streaming_ingestion_allow(rpt, &rpt->ingestion.new_charts, rpt->ingestion.max_new_charts_per_min)) {
+            __atomic_add_fetch(&rpt->ingestion.stats.new_charts, 1, __ATOMIC_RELAXED);
+            if(unlikely(rpt->ingestion.dropped))
+                dictionary_del(rpt->ingestion.dropped, id);
+            return false;
+        }
+
+        streaming_ingestion_drop(rpt, id, &rpt->ingestion.stats.dropped_charts);
+        user->st = NULL;
+        rpt->ingestion.skipping = true;
+        return true;
+    }
+
+    if(*line == 'D' && streaming_line_is(line, PLUGINSD_KEYWORD_DIMENSION)) {
+        RRDSET *st = user->st;
+        if(rpt->ingestion.skipping || !st)
+            return rpt->ingestion.skipping;
+
+        streaming_line_parameter(line, id, sizeof(id));
+        if(rrddim_find(st, id))
+            return false;
+
+        streaming_ingestion_dimension_key(st, id, key, sizeof(key));
+        if(streaming_ingestion_allow(rpt, &rpt->ingestion.new_dimensions, rpt->ingestion.max_new_dimensions_per_min)) {
+            __atomic_add_fetch(&rpt->ingestion.stats.new_dimensions, 1, __ATOMIC_RELAXED);
+            if(unlikely(rpt->ingestion.dropped))
+                dictionary_del(rpt->ingestion.dropped, key);
+            return false;
+        }
+
+        streaming_ingestion_drop(rpt, key, &rpt->ingestion.stats.dropped_dimensions);
+
+        // the chart is kept too, as not dropped, so that its updates look up their dimensions
+        bool dropped = false;
+        dictionary_set(rpt->ingestion.dropped, rrdset_id(st), &dropped, sizeof(dropped));
+
+        streaming_binary_dimension_dropped(rpt);
+        return true;
+    }
+
+    // nothing has been dropped, nothing to skip
+    if(likely(!rpt->ingestion.dropped))
+        return false;
+
+    if(*line == 'B' && streaming_line_is(line, PLUGINSD_KEYWORD_BEGIN)) {
+        streaming_line_parameter(line, id, sizeof(id));
+        bool *dropped = dictionary_get(rpt->ingestion.dropped, id);
+        rpt->ingestion.skipping = (dropped && *dropped);
+        rpt->ingestion.skipping_dimensions = (dropped && !*dropped);
+        return rpt->ingestion.skipping;
+    }
+
+    if(rpt->ingestion.skipping) {
+        if(streaming_line_is(line, PLUGINSD_KEYWORD_END)) {
+            rpt->ingestion.skipping = false;
+            return true;
+        }
+
+        if(streaming_line_is(line, "SLOT")) {
+            streaming_binary_slot_dropped(rpt, (uint32_t)str2ul(streaming_line_parameter(line, id, sizeof(id))));
+            return true;
+        }
+
+        if(streaming_line_is(line, PLUGINSD_KEYWORD_SET) ||
+           streaming_line_is(line, PLUGINSD_KEYWORD_VARIABLE) ||
+           streaming_line_is(line, PLUGINSD_KEYWORD_CLABEL) ||
+           streaming_line_is(line, PLUGINSD_KEYWORD_CLABEL_COMMIT) ||
+           streaming_line_is(line, "CHART_DEFINITION_END"))
+            return true;
+
+        // anything else is not about the dropped chart
+        rpt->ingestion.skipping = false;
+        return false;
+    }
+
+    if(rpt->ingestion.skipping_dimensions) {
+        if(*line == 'S' && user->st && streaming_line_is(line, PLUGINSD_KEYWORD_SET)) {
+            streaming_line_parameter(line, id, sizeof(id));
+            streaming_ingestion_dimension_key(user->st, id, key, sizeof(key));
+            return (dictionary_get(rpt->ingestion.dropped, key) != NULL);
+        }
+
+        if(*line == 'E' && streaming_line_is(line, PLUGINSD_KEYWORD_END))
+            rpt->ingestion.skipping_dimensions = false;
+    }
+
+    return false;
+}
+
+// called after parsing what has been read from the child
+// returns the microseconds to wait before reading again, to keep the child within its lines budget
+static usec_t streaming_ingestion_parsed(struct receiver_state *rpt, usec_t started_ut) {
+    usec_t now_ut = now_monotonic_usec();
+    size_t lines = rpt->ingestion.lines;
+
+    rpt->ingestion.lines = 0;
+    __atomic_add_fetch(&rpt->ingestion.stats.lines, lines, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rpt->ingestion.stats.parse_usec, now_ut - started_ut, __ATOMIC_RELAXED);
+
+    if(!rpt->ingestion.max_lines_per_sec)
+        return 0;
+
+    // a second worth of lines may be received at once
+    if(rpt->ingestion.lines_budget_ut + USEC_PER_SEC < now_ut)
+        rpt->ingestion.lines_budget_ut = now_ut - USEC_PER_SEC;
+
+    rpt->ingestion.lines_budget_ut += (usec_t)lines * USEC_PER_SEC / rpt->ingestion.max_lines_per_sec;
+    if(rpt->ingestion.lines_budget_ut <= now_ut)
+        return 0;
+
+    usec_t delay_ut = rpt->ingestion.lines_budget_ut - now_ut;
+    __atomic_add_fetch(&rpt->ingestion.stats.throttled_usec, delay_ut, __ATOMIC_RELAXED);
+    streaming_ingestion_throttle(rpt);
+    return delay_ut;
+}
+
+static void streaming_ingestion_child_charts(struct receiver_state *rpt) {
+    STREAM_INGESTION_STATISTICS stats = {
+        .lines = __atomic_load_n(&rpt->ingestion.stats.lines, __ATOMIC_RELAXED),
+        .new_charts = __atomic_load_n(&rpt->ingestion.stats.new_charts, __ATOMIC_RELAXED),
+        .new_dimensions = __atomic_load_n(&rpt->ingestion.stats.new_dimensions, __ATOMIC_RELAXED),
+        .dropped_charts = __atomic_load_n(&rpt->ingestion.stats.dropped_charts, __ATOMIC_RELAXED),
+        .dropped_dimensions = __atomic_load_n(&rpt->ingestion.stats.dropped_dimensions, __ATOMIC_RELAXED),
+        .throttled_usec = __atomic_load_n(&rpt->ingestion.stats.throttled_usec, __ATOMIC_RELAXED),
+        .parse_usec = __atomic_load_n(&rpt->ingestion.stats.parse_usec, __ATOMIC_RELAXED),
+    };
+
+    const char *hostname = rrdhost_hostname(rpt->host);
+    char id[RRD_ID_LENGTH_MAX + 1];
+    char title[RRD_ID_LENGTH_MAX + 100];
+
+    if(unlikely(!rpt->ingestion.st_lines)) {
+        snprintfz(id, RRD_ID_LENGTH_MAX, "streaming_ingestion_lines_%s", hostname);
+        snprintfz(title, sizeof(title) - 1, "Netdata Streaming Lines Received from %s", hostname);
+
+        rpt->ingestion.st_lines = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "streaming"
+                , "netdata.streaming_ingestion_lines"
+                , title
+                , "lines/s"
+                , "netdata"
+                , "stats"
+                , 131010
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+        );
+
+        rpt->ingestion.rd_lines = rrddim_add(rpt->ingestion.st_lines, "lines", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+    }
+    else
+        rrdset_next(rpt->ingestion.st_lines);
+
+    rrddim_set_by_pointer(rpt->ingestion.st_lines, rpt->ingestion.rd_lines, (collected_number)stats.lines);
+    rrdset_done(rpt->ingestion.st_lines);
+
+    // ----------------------------------------------------------------
+
+    if(unlikely(!rpt->ingestion.st_definitions)) {
+        snprintfz(id, RRD_ID_LENGTH_MAX, "streaming_ingestion_definitions_%s", hostname);
+        snprintfz(title, sizeof(title) - 1, "Netdata Streaming Definitions Received from %s", hostname);
+
+        rpt->ingestion.st_definitions = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "streaming"
+                , "netdata.streaming_ingestion_definitions"
+                , title
+                , "definitions/min"
+                , "netdata"
+                , "stats"
+                , 131011
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+        );
+
+        rpt->ingestion.rd_new_charts = rrddim_add(rpt->ingestion.st_definitions, "new charts", NULL, 60, 1, RRD_ALGORITHM_INCREMENTAL);
+        rpt->ingestion.rd_new_dimensions = rrddim_add(rpt->ingestion.st_definitions, "new dimensions", NULL, 60, 1, RRD_ALGORITHM_INCREMENTAL);
+        rpt->ingestion.rd_dropped_charts = rrddim_add(rpt->ingestion.st_definitions, "dropped charts", NULL, -60, 1, RRD_ALGORITHM_INCREMENTAL);
+        rpt->ingestion.rd_dropped_dimensions = rrddim_add(rpt->ingestion.st_definitions, "dropped dimensions", NULL, -60, 1, RRD_ALGORITHM_INCREMENTAL);
+    }
+    else
+        rrdset_next(rpt->ingestion.st_definitions);
+
+    rrddim_set_by_pointer(rpt->ingestion.st_definitions, rpt->ingestion.rd_new_charts, (collected_number)stats.new_charts);
+    rrddim_set_by_pointer(rpt->ingestion.st_definitions, rpt->ingestion.rd_new_dimensions, (collected_number)stats.new_dimensions);
+    rrddim_set_by_pointer(rpt->ingestion.st_definitions, rpt->ingestion.rd_dropped_charts, (collected_number)stats.dropped_charts);
+    rrddim_set_by_pointer(rpt->ingestion.st_definitions, rpt->ingestion.rd_dropped_dimensions, (collected_number)stats.dropped_dimensions);
+    rrdset_done(rpt->ingestion.st_definitions);
+
+    // ----------------------------------------------------------------
+
+    if(unlikely(!rpt->ingestion.st_cost)) {
+        snprintfz(id, RRD_ID_LENGTH_MAX, "streaming_ingestion_cost_%s", hostname);
+        snprintfz(title, sizeof(title) - 1, "Netdata Streaming Ingestion Cost of %s", hostname);
+
+        rpt->ingestion.st_cost = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "streaming"
+                , "netdata.streaming_ingestion_cost"
+                , title
+                , "milliseconds/s"
+                , "netdata"
+                , "stats"
+                , 131012
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+        );
+
+        rpt->ingestion.rd_parse = rrddim_add(rpt->ingestion.st_cost, "parsing", NULL, 1, USEC_PER_MS, RRD_ALGORITHM_INCREMENTAL);
+        rpt->ingestion.rd_throttled = rrddim_add(rpt->ingestion.st_cost, "throttled", NULL, -1, USEC_PER_MS, RRD_ALGORITHM_INCREMENTAL);
+    }
+    else
+        rrdset_next(rpt->ingestion.st_cost);
+
+    rrddim_set_by_pointer(rpt->ingestion.st_cost, rpt->ingestion.rd_parse, (collected_number)stats.parse_usec);
+    rrddim_set_by_pointer(rpt->ingestion.st_cost, rpt->ingestion.rd_throttled, (collected_number)stats.throttled_usec);
+    rrdset_done(rpt->ingestion.st_cost);
+}
+
+// the ingestion charts of the connected children, called by the global statistics thread
+void rrdpush_receiver_ingestion_charts(void) {
+    RRDHOST *host;
+
+    if(netdata_rwlock_tryrdlock(&rrd_rwlock) != 0)
+        return;
+
+    rrdhost_foreach_read(host) {
+        if(host == localhost)
+            continue;
+
+        netdata_mutex_lock(&host->receiver_lock);
+        if(host->receiver && !host->receiver->exited)
+            streaming_ingestion_child_charts(host->receiver);
+        netdata_mutex_unlock(&host->receiver_lock);
+    }
+
+    rrd_unlock();
+}
 
 #ifndef ENABLE_COMPRESSION
 /* The receiver socket is blocking, perform a single read into a buffer so that we can reassemble lines for parsing.
@@ -315,7 +1113,7 @@ static int receiver_read(struct receiver_state *r, FILE *fp) {
     }
 
     if (unlikely(!r->decompressor)) 
-        r->decompressor = create_decompressor();
+        r->decompressor = create_decompressor(r->capabilities);
     
     size_t bytes_to_read = r->decompressor->start(r->decompressor, r->read_buffer, ret);
 
@@ -390,17 +1188,69 @@ static char *receiver_next_line(struct receiver_state *r, char *buffer, size_t b
         return buffer;
     }
 
-    // no newline found in the r->read_buffer
-    // move everything to the beginning
-    memmove(r->read_buffer, &r->read_buffer[start], r->read_len - start);
-    r->read_len -= (int)start;
-    return NULL;
-}
+    // no newline found in the r->read_buffer
+    // move everything to the beginning
+    memmove(r->read_buffer, &r->read_buffer[start], r->read_len - start);
+    r->read_len -= (int)start;
+    return NULL;
+}
+
+static void streaming_parser_thread_cleanup(void *ptr) {
+    PARSER *parser = (PARSER *)ptr;
+    rrd_collector_finished();
+    streaming_binary_cleanup(((PARSER_USER_OBJECT *)parser->user)->opaque);
+    parser_destroy(parser);
+}
+
+// all the connections get the same keywords in the same order, so that the parsers of the
+// connections served by a thread of the receivers pool register the same worker jobs
+static void streaming_parser_add_keywords(PARSER *parser) {
+    parser_add_keyword(parser, "TIMESTAMP", streaming_timestamp);
+    parser_add_keyword(parser, "CLAIMED_ID", streaming_claimed_id);
+
+    parser_add_keyword(parser, "SLOT", streaming_binary_slot);
+    parser_add_keyword(parser, PLUGINSD_KEYWORD_DIMENSION, streaming_binary_dimension);
+
+    parser_add_keyword(parser, "CHART_DEFINITION_END", streaming_replication_chart_definition_end);
+    parser_add_keyword(parser, "REPLAY_BEGIN", streaming_replication_begin);
+    parser_add_keyword(parser, "REPLAY_POINT", streaming_replication_point);
+    parser_add_keyword(parser, "REPLAY_SET", streaming_replication_set);
+    parser_add_keyword(parser, "REPLAY_RRDDIM_STATE", streaming_replication_rrddim_state);
+    parser_add_keyword(parser, "REPLAY_RRDSET_STATE", streaming_replication_rrdset_state);
+    parser_add_keyword(parser, "REPLAY_END", streaming_replication_end);
+}
+
+// executes a line received from the child, returns non-zero when the connection has to be closed
+static int streaming_parser_line(struct receiver_state *rpt, PARSER_USER_OBJECT *user, PARSER *parser, char *buffer) {
+    if(unlikely(netdata_exit)) {
+        internal_error(true, "exiting...");
+        return 1;
+    }
+    if(unlikely(rpt->shutdown)) {
+        internal_error(true, "parser shutdown...");
+        return 1;
+    }
+    rpt->ingestion.lines++;
+
+    if(*buffer == STREAM_BINARY_FRAME_MARKER && stream_has_capability(rpt, STREAM_CAP_BINARY) &&
+       !(parser->flags & PARSER_DEFER_UNTIL_KEYWORD)) {
+        if (unlikely(streaming_binary_frame(rpt, user, buffer) == PARSER_RC_ERROR)) {
+            internal_error(true, "streaming_binary_frame() failed...");
+            return 1;
+        }
+        return 0;
+    }
+
+    if((rpt->ingestion.max_new_charts_per_min || rpt->ingestion.max_new_dimensions_per_min || rpt->ingestion.dropped) &&
+       !(parser->flags & PARSER_DEFER_UNTIL_KEYWORD) && streaming_ingestion_skip_line(rpt, user, buffer))
+        return 0;
 
-static void streaming_parser_thread_cleanup(void *ptr) {
-    PARSER *parser = (PARSER *)ptr;
-    rrd_collector_finished();
-    parser_destroy(parser);
+    if (unlikely(parser_action(parser,  buffer))) {
+        internal_error(true, "parser_action() failed...");
+        return 1;
+    }
+
+    return 0;
 }
 
 size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, FILE *fp_in, FILE *fp_out) {
@@ -415,6 +1265,7 @@ size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, FILE *fp
     };
 
     PARSER *parser = parser_init(rpt->host, &user, fp_in, fp_out, PARSER_INPUT_SPLIT);
+    parser->send_function = streaming_parser_send;
 
     rrd_collector_started();
 
@@ -422,8 +1273,7 @@ size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, FILE *fp
     // so, parser needs to be allocated before pushing it
     netdata_thread_cleanup_push(streaming_parser_thread_cleanup, parser);
 
-    parser_add_keyword(parser, "TIMESTAMP", streaming_timestamp);
-    parser_add_keyword(parser, "CLAIMED_ID", streaming_claimed_id);
+    streaming_parser_add_keywords(parser);
 
     user.parser = parser;
 
@@ -436,23 +1286,19 @@ size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, FILE *fp
     do {
         if(receiver_read(rpt, fp_in)) break;
 
+        usec_t started_ut = now_monotonic_usec();
         size_t pos = 0;
         while(receiver_next_line(rpt, buffer, PLUGINSD_LINE_MAX + 2, &pos)) {
-            if(unlikely(netdata_exit)) {
-                internal_error(true, "exiting...");
-                goto done;
-            }
-            if(unlikely(rpt->shutdown)) {
-                internal_error(true, "parser shutdown...");
-                goto done;
-            }
-            if (unlikely(parser_action(parser,  buffer))) {
-                internal_error(true, "parser_action() failed...");
+            if(streaming_parser_line(rpt, &user, parser, buffer))
                 goto done;
-            }
         }
 
         rpt->last_msg_t = now_realtime_sec();
+
+        // the child is over its lines budget, the socket buffers fill up and it has to slow down
+        usec_t delay_ut = streaming_ingestion_parsed(rpt, started_ut);
+        if(unlikely(delay_ut))
+            sleep_usec(delay_ut);
     }
     while(!netdata_exit);
 
@@ -465,6 +1311,577 @@ size_t streaming_parser(struct receiver_state *rpt, struct plugind *cd, FILE *fp
     return result;
 }
 
+// the connection of the child has ended
+static void rrdpush_receive_disconnected(struct receiver_state *rpt, size_t count, int health_enabled) {
+    log_stream_connection(rpt->client_ip, rpt->client_port, rpt->key, rpt->host->machine_guid, rpt->hostname,
+                          "DISCONNECTED");
+    error("STREAM %s [receive from [%s]:%s]: disconnected (completed %zu updates).", rpt->hostname, rpt->client_ip,
+          rpt->client_port, count);
+
+    rrdcontext_host_child_disconnected(rpt->host);
+
+#ifdef ENABLE_ACLK
+    // in case we have cloud connection we inform cloud
+    // new child connected
+    if (netdata_cloud_setting)
+        aclk_host_state_update(rpt->host, 0);
+#endif
+
+    // During a shutdown there is cleanup code in rrdhost that will cancel the sender thread
+    if (!netdata_exit && rpt->host) {
+        rrd_rdlock();
+        rrdhost_wrlock(rpt->host);
+        netdata_mutex_lock(&rpt->host->receiver_lock);
+        if (rpt->host->receiver == rpt) {
+            rpt->host->senders_connect_time = 0;
+            rpt->host->trigger_chart_obsoletion_check = 0;
+            rpt->host->senders_disconnected_time = now_realtime_sec();
+            rrdhost_flag_set(rpt->host, RRDHOST_FLAG_ORPHAN);
+            if(health_enabled == CONFIG_BOOLEAN_AUTO)
+                rpt->host->health_enabled = 0;
+        }
+        rrdhost_unlock(rpt->host);
+        if (rpt->host->receiver == rpt) {
+            rrdpush_sender_thread_stop(rpt->host);
+        }
+        netdata_mutex_unlock(&rpt->host->receiver_lock);
+        rrd_unlock();
+    }
+}
+
+#ifdef __linux__
+// ----------------------------------------------------------------------------
+// receivers pool
+//
+// When [stream].receiver threads is set, the children are served by that many threads, instead of a thread
+// per child. The handshake still runs on the thread spawned for the connection, which then hands the socket
+// over to the pool thread with the fewest connections and exits.
+//
+// Each pool thread waits with epoll for all its sockets. A readable socket is read without blocking into a
+// buffer of its connection, and only complete units are parsed from it: text lines and whole compressed
+// blocks. So a slow or silent child never blocks the other children served by the same thread.
+
+#define RECEIVER_POOL_BUFFER_SIZE (64 * 1024)
+#define RECEIVER_POOL_MAX_EVENTS 64
+#define RECEIVER_POOL_TIMEOUT_SECS 120
+
+// the size of the signature of a compressed block, see compression.c
+#define RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE 4
+
+struct receiver_pool_connection {
+    struct receiver_state *rpt;
+    struct plugind cd;
+    PARSER_USER_OBJECT user;
+    PARSER *parser;
+    FILE *fp_in;
+    FILE *fp_out;
+    int health_enabled;
+    struct rrd_collector *collector;    // the functions collector of this child
+
+    char raw[RECEIVER_POOL_BUFFER_SIZE];   // received and not parsed yet
+    size_t raw_len;
+    bool mid_line;                         // raw does not start at the beginning of a line
+
+    struct receiver_pool_connection *prev;
+    struct receiver_pool_connection *next;
+};
+
+struct receiver_pool_thread {
+    netdata_thread_t thread;
+    int epoll_fd;
+    int wakeup_pipe[2];
+
+    netdata_mutex_t mutex;
+    struct receiver_pool_connection *incoming;      // handed over, not served yet - protected by the mutex
+    struct receiver_pool_connection *connections;   // only touched by the pool thread
+
+    size_t count;                                   // the connections of the thread, incoming included
+    size_t parked;                                  // the connections not watched, they are over their lines budget
+};
+
+static struct {
+    netdata_mutex_t mutex;
+    bool failed;
+    size_t size;
+    struct receiver_pool_thread *threads;
+} receiver_pool = {
+    .mutex = NETDATA_MUTEX_INITIALIZER,
+    .failed = false,
+    .size = 0,
+    .threads = NULL,
+};
+
+static void receiver_pool_adopt(struct receiver_pool_thread *t, struct receiver_pool_connection *c) {
+    struct receiver_state *rpt = c->rpt;
+
+    c->user = (PARSER_USER_OBJECT) {
+        .enabled = c->cd.enabled,
+        .host = rpt->host,
+        .opaque = rpt,
+        .cd = &c->cd,
+        .trust_durations = 1
+    };
+
+    // the parser registers its keywords as jobs of the worker, so it has to be created by the pool thread
+    c->parser = parser_init(rpt->host, &c->user, c->fp_in, c->fp_out, PARSER_INPUT_SPLIT);
+    c->parser->send_function = streaming_parser_send;
+    streaming_parser_add_keywords(c->parser);
+    c->user.parser = c->parser;
+
+    struct rrd_collector *old = rrd_collector_switch(NULL);
+    rrd_collector_started();
+    c->collector = rrd_collector_switch(old);
+
+#ifdef ENABLE_COMPRESSION
+    if (rpt->decompressor)
+        rpt->decompressor->reset(rpt->decompressor);
+#endif
+
+    rpt->read_len = 0;
+    rpt->last_msg_t = now_realtime_sec();
+
+    DOUBLE_LINKED_LIST_APPEND_UNSAFE(t->connections, c, prev, next);
+
+    struct epoll_event ev = {
+        .events = EPOLLIN,
+        .data.ptr = c,
+    };
+    if(epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, rpt->fd, &ev) == -1) {
+        error("STREAM %s [receive from [%s]:%s]: cannot add socket %d to the receivers pool.",
+              rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, rpt->fd);
+        rpt->shutdown = 1;
+    }
+}
+
+static void receiver_pool_close(struct receiver_pool_thread *t, struct receiver_pool_connection *c) {
+    struct receiver_state *rpt = c->rpt;
+
+    (void)epoll_ctl(t->epoll_fd, EPOLL_CTL_DEL, rpt->fd, NULL);
+    if(rpt->ingestion.parked_until_ut)
+        t->parked--;
+
+    DOUBLE_LINKED_LIST_REMOVE_UNSAFE(t->connections, c, prev, next);
+    __atomic_sub_fetch(&t->count, 1, __ATOMIC_RELAXED);
+
+    struct rrd_collector *old = rrd_collector_switch(c->collector);
+    rrd_collector_finished();
+    rrd_collector_switch(old);
+
+    streaming_binary_cleanup(rpt);
+    parser_destroy(c->parser);
+
+    rrdpush_receive_disconnected(rpt, c->user.count, c->health_enabled);
+
+    fclose(c->fp_in);
+    fclose(c->fp_out);
+    freez(c);
+
+    receiver_state_release(rpt);
+}
+
+// reads from the socket until it would block or the buffer is full
+// returns -1 when the connection has ended, 0 when the socket has no more data, 1 when there may be more
+static int receiver_pool_read(struct receiver_pool_connection *c) {
+    struct receiver_state *rpt = c->rpt;
+
+    while(c->raw_len < sizeof(c->raw)) {
+        size_t available = sizeof(c->raw) - c->raw_len;
+        ssize_t bytes;
+
+#ifdef ENABLE_HTTPS
+        if (rpt->ssl.conn && !rpt->ssl.flags) {
+            ERR_clear_error();
+            int ret = SSL_read(rpt->ssl.conn, &c->raw[c->raw_len], (int)available);
+            if(ret <= 0) {
+                int ssl_err = SSL_get_error(rpt->ssl.conn, ret);
+                if(ssl_err == SSL_ERROR_WANT_READ || ssl_err == SSL_ERROR_WANT_WRITE)
+                    return 0;
+
+                u_long err;
+                char buf[256];
+                while ((err = ERR_get_error()) != 0) {
+                    ERR_error_string_n(err, buf, sizeof(buf));
+                    error("STREAM %s [receive from %s] ssl error: %s", rpt->hostname, rpt->client_ip, buf);
+                }
+                return -1;
+            }
+            bytes = ret;
+        }
+        else
+#endif
+        {
+            // the socket is non-blocking, the flag is kept in case it is ever cleared
+            bytes = recv(rpt->fd, &c->raw[c->raw_len], available, MSG_DONTWAIT);
+            if(bytes == 0)
+                return -1;
+
+            if(bytes < 0) {
+                if(errno == EAGAIN || errno == EWOULDBLOCK)
+                    return 0;
+
+                if(errno == EINTR)
+                    continue;
+
+                error("STREAM %s [receive from [%s]:%s]: cannot read from socket %d.",
+                      rpt->hostname, rpt->client_ip, rpt->client_port, rpt->fd);
+                return -1;
+            }
+        }
+
+        c->raw_len += bytes;
+        rpt->last_msg_t = now_realtime_sec();
+        worker_set_metric(WORKER_RECEIVER_JOB_BYTES_READ, (NETDATA_DOUBLE)bytes);
+    }
+
+    return 1;
+}
+
+// parses all the complete lines and compressed blocks of the buffer
+// returns non-zero when the connection has to be closed
+static int receiver_pool_parse(struct receiver_pool_connection *c) {
+    struct receiver_state *rpt = c->rpt;
+    char buffer[PLUGINSD_LINE_MAX + 2];
+    size_t used = 0;
+    bool filled;
+
+    do {
+        filled = false;
+        size_t available = sizeof(rpt->read_buffer) - rpt->read_len - 1;
+
+#ifdef ENABLE_COMPRESSION
+        size_t compressed = 0;
+
+        if (rpt->decompressor && rpt->decompressor->decompressed_bytes_in_buffer(rpt->decompressor)) {
+            if(available)
+                rpt->read_len += rpt->decompressor->get(rpt->decompressor, rpt->read_buffer + rpt->read_len, available);
+            filled = true;
+        }
+        else if(!c->mid_line && (compressed = is_compressed_data(&c->raw[used], c->raw_len - used))) {
+            // the block can only be decompressed when all of it has been received
+            if(c->raw_len - used < RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE + compressed)
+                break;
+
+            if (unlikely(!rpt->decompressor))
+                rpt->decompressor = create_decompressor(rpt->capabilities);
+
+            rpt->decompressor->start(rpt->decompressor, &c->raw[used], RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE);
+            rpt->decompressor->put(rpt->decompressor, &c->raw[used + RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE], compressed);
+            used += RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE + compressed;
+
+            if (!rpt->decompressor->decompress(rpt->decompressor)) {
+                internal_error(true, "no bytes to parse.");
+                return 1;
+            }
+            filled = true;
+        }
+        else if(!c->mid_line && c->raw_len - used < RECEIVER_POOL_COMPRESSION_SIGNATURE_SIZE &&
+                !memchr(&c->raw[used], '\n', c->raw_len - used)) {
+            // it may be the beginning of the signature of a compressed block
+            break;
+        }
+        else
+#endif
+        if(used < c->raw_len) {
+            // copy a single line, a compressed block may follow it
+            if(available) {
+                size_t len = MIN(c->raw_len - used, available);
+                char *newline = memchr(&c->raw[used], '\n', len);
+                if(newline)
+                    len = newline - &c->raw[used] + 1;
+
+                memcpy(rpt->read_buffer + rpt->read_len, &c->raw[used], len);
+                rpt->read_len += (int)len;
+                used += len;
+                c->mid_line = !newline;
+            }
+            filled = true;
+        }
+
+        size_t pos = 0;
+        while(receiver_next_line(rpt, buffer, PLUGINSD_LINE_MAX + 2, &pos)) {
+            if(streaming_parser_line(rpt, &c->user, c->parser, buffer))
+                return 1;
+        }
+    } while(filled);
+
+    c->raw_len -= used;
+    memmove(c->raw, &c->raw[used], c->raw_len);
+    return 0;
+}
+
+// returns non-zero when the connection has to be closed
+static int receiver_pool_process(struct receiver_pool_connection *c) {
+    struct rrd_collector *old = rrd_collector_switch(c->collector);
+    int ret;
+
+    do {
+        ret = receiver_pool_read(c);
+
+        usec_t started_ut = now_monotonic_usec();
+        if(receiver_pool_parse(c)) {
+            ret = -1;
+            break;
+        }
+
+        // the child is over its lines budget, do not read from it for a while
+        usec_t delay_ut = streaming_ingestion_parsed(c->rpt, started_ut);
+        if(unlikely(delay_ut)) {
+            c->rpt->ingestion.parked_until_ut = now_monotonic_usec() + delay_ut;
+            break;
+        }
+
+#ifdef ENABLE_HTTPS
+        // decrypted data kept by openssl does not wake up epoll
+        if(!ret && c->rpt->ssl.conn && !c->rpt->ssl.flags && SSL_pending(c->rpt->ssl.conn) > 0)
+            ret = 1;
+#endif
+    } while(ret > 0);
+
+    rrd_collector_switch(old);
+    return ret < 0;
+}
+
+// serves a connection that has data to read, returns false when the connection has been closed
+static bool receiver_pool_serve(struct receiver_pool_thread *t, struct receiver_pool_connection *c) {
+    if(receiver_pool_process(c)) {
+        receiver_pool_close(t, c);
+        return false;
+    }
+
+    if(unlikely(c->rpt->ingestion.parked_until_ut)) {
+        // the socket is watched again by receiver_pool_unpark()
+        (void)epoll_ctl(t->epoll_fd, EPOLL_CTL_DEL, c->rpt->fd, NULL);
+        t->parked++;
+    }
+
+    return true;
+}
+
+// serves the parked connections whose time has come, returns the milliseconds epoll can wait
+static int receiver_pool_unpark(struct receiver_pool_thread *t) {
+    int timeout_ms = 1000;
+
+    if(likely(!t->parked))
+        return timeout_ms;
+
+    usec_t now_ut = now_monotonic_usec();
+    struct receiver_pool_connection *c, *next;
+    for(c = t->connections; c && t->parked; c = next) {
+        next = c->next;
+
+        if(!c->rpt->ingestion.parked_until_ut)
+            continue;
+
+        if(c->rpt->ingestion.parked_until_ut <= now_ut) {
+            c->rpt->ingestion.parked_until_ut = 0;
+            t->parked--;
+
+            struct epoll_event ev = {
+                .events = EPOLLIN,
+                .data.ptr = c,
+            };
+            if(epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, c->rpt->fd, &ev) == -1) {
+                error("STREAM %s [receive from [%s]:%s]: cannot add socket %d back to the receivers pool.",
+                      rrdhost_hostname(c->rpt->host), c->rpt->client_ip, c->rpt->client_port, c->rpt->fd);
+                c->rpt->shutdown = 1;
+                continue;
+            }
+
+            // openssl may keep decrypted data that does not wake up epoll
+            if(!receiver_pool_serve(t, c) || !c->rpt->ingestion.parked_until_ut)
+                continue;
+        }
+
+        usec_t wait_ut = c->rpt->ingestion.parked_until_ut - now_ut;
+        if(wait_ut < (usec_t)timeout_ms * USEC_PER_MS)
+            timeout_ms = (int)((wait_ut + USEC_PER_MS - 1) / USEC_PER_MS);
+    }
+
+    return timeout_ms;
+}
+
+static void receiver_pool_adopt_incoming(struct receiver_pool_thread *t) {
+    char discard[128];
+    while(read(t->wakeup_pipe[0], discard, sizeof(discard)) > 0) ;
+
+    netdata_mutex_lock(&t->mutex);
+    struct receiver_pool_connection *incoming = t->incoming;
+    t->incoming = NULL;
+    netdata_mutex_unlock(&t->mutex);
+
+    while(incoming) {
+        struct receiver_pool_connection *c = incoming;
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(incoming, c, prev, next);
+        receiver_pool_adopt(t, c);
+    }
+}
+
+static void *receiver_pool_thread(void *ptr) {
+    struct receiver_pool_thread *t = ptr;
+
+    worker_register("STREAMRCV");
+    worker_register_job_custom_metric(WORKER_RECEIVER_JOB_BYTES_READ, "received bytes", "bytes/s", WORKER_METRIC_INCREMENTAL);
+
+    struct epoll_event events[RECEIVER_POOL_MAX_EVENTS];
+    time_t last_check_t = 0;
+
+    while(!netdata_exit) {
+        int timeout_ms = receiver_pool_unpark(t);
+
+        worker_is_idle();
+
+        int n = epoll_wait(t->epoll_fd, events, RECEIVER_POOL_MAX_EVENTS, timeout_ms);
+        if(unlikely(n == -1)) {
+            if(errno != EINTR) {
+                error("STREAM: epoll_wait() of the receivers pool failed.");
+                sleep_usec(100 * USEC_PER_MS);
+            }
+            continue;
+        }
+
+        for(int i = 0; i < n && !netdata_exit; i++) {
+            struct receiver_pool_connection *c = events[i].data.ptr;
+
+            if(!c)
+                receiver_pool_adopt_incoming(t);
+            else
+                receiver_pool_serve(t, c);
+        }
+
+        // the children that are asked to disconnect or have not sent anything for too long
+        time_t now = now_realtime_sec();
+        if(now != last_check_t) {
+            last_check_t = now;
+
+            struct receiver_pool_connection *c, *next;
+            for(c = t->connections; c && !netdata_exit; c = next) {
+                next = c->next;
+
+                if(c->rpt->shutdown)
+                    receiver_pool_close(t, c);
+
+                else if(now - c->rpt->last_msg_t > RECEIVER_POOL_TIMEOUT_SECS) {
+                    error("STREAM %s [receive from [%s]:%s]: nothing received for %d seconds, disconnecting.",
+                          c->rpt->hostname, c->rpt->client_ip, c->rpt->client_port, RECEIVER_POOL_TIMEOUT_SECS);
+                    receiver_pool_close(t, c);
+                }
+            }
+        }
+    }
+
+    // let rrdhost_free() clean up the receivers of the hosts
+    receiver_pool_adopt_incoming(t);
+    while(t->connections)
+        receiver_pool_close(t, t->connections);
+
+    worker_unregister();
+    return NULL;
+}
+
+// called with the pool mutex locked
+static bool receiver_pool_start(void) {
+    size_t size = default_rrdpush_receiver_threads;
+    struct receiver_pool_thread *threads = callocz(size, sizeof(struct receiver_pool_thread));
+    size_t i;
+
+    for(i = 0; i < size; i++) {
+        struct receiver_pool_thread *t = &threads[i];
+
+        t->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if(t->epoll_fd == -1)
+            break;
+
+        if(pipe2(t->wakeup_pipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+            close(t->epoll_fd);
+            break;
+        }
+
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = NULL,
+        };
+        if(epoll_ctl(t->epoll_fd, EPOLL_CTL_ADD, t->wakeup_pipe[0], &ev) == -1) {
+            close(t->wakeup_pipe[0]);
+            close(t->wakeup_pipe[1]);
+            close(t->epoll_fd);
+            break;
+        }
+
+        netdata_mutex_init(&t->mutex);
+    }
+
+    if(i < size) {
+        error("STREAM: cannot create the receivers pool, using a thread per child.");
+        while(i--) {
+            close(threads[i].wakeup_pipe[0]);
+            close(threads[i].wakeup_pipe[1]);
+            close(threads[i].epoll_fd);
+            netdata_mutex_destroy(&threads[i].mutex);
+        }
+        freez(threads);
+        receiver_pool.failed = true;
+        return false;
+    }
+
+    for(i = 0; i < size; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STREAM_RECEIVERS[%zu]", i);
+        netdata_thread_create(&threads[i].thread, tag, NETDATA_THREAD_OPTION_DEFAULT, receiver_pool_thread, &threads[i]);
+    }
+
+    receiver_pool.threads = threads;
+    receiver_pool.size = size;
+    info("STREAM: receiving from the children with %zu threads.", size);
+    return true;
+}
+
+// hands the connection over to the thread of the receivers pool with the fewest connections
+// returns false when the pool is not available
+static bool receiver_pool_add(struct receiver_state *rpt, struct plugind *cd, FILE *fp_in, FILE *fp_out, int health_enabled) {
+    netdata_mutex_lock(&receiver_pool.mutex);
+    if(!receiver_pool.threads && (receiver_pool.failed || !receiver_pool_start())) {
+        netdata_mutex_unlock(&receiver_pool.mutex);
+        return false;
+    }
+
+    struct receiver_pool_thread *t = &receiver_pool.threads[0];
+    for(size_t i = 1; i < receiver_pool.size; i++) {
+        if(__atomic_load_n(&receiver_pool.threads[i].count, __ATOMIC_RELAXED) < __atomic_load_n(&t->count, __ATOMIC_RELAXED))
+            t = &receiver_pool.threads[i];
+    }
+    __atomic_add_fetch(&t->count, 1, __ATOMIC_RELAXED);
+    netdata_mutex_unlock(&receiver_pool.mutex);
+
+    // the pool thread never waits on the socket: SSL_read() may need more data than the socket has,
+    // and the commands sent to the child must not block the parsing of the other children
+    if(sock_setnonblock(rpt->fd) < 0) {
+        error("STREAM %s [receive from [%s]:%s]: cannot set the non-blocking flag to socket %d", rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port, rpt->fd);
+        // undo the accounting above, the caller serves the connection with its own thread
+        __atomic_sub_fetch(&t->count, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    struct receiver_pool_connection *c = callocz(1, sizeof(struct receiver_pool_connection));
+    c->rpt = rpt;
+    c->cd = *cd;
+    c->fp_in = fp_in;
+    c->fp_out = fp_out;
+    c->health_enabled = health_enabled;
+
+    rpt->pool = c;
+    receiver_handed_to_pool = true;
+
+    netdata_mutex_lock(&t->mutex);
+    DOUBLE_LINKED_LIST_APPEND_UNSAFE(t->incoming, c, prev, next);
+    netdata_mutex_unlock(&t->mutex);
+
+    char wakeup = '\n';
+    if(write(t->wakeup_pipe[1], &wakeup, 1) == -1 && errno != EAGAIN)
+        error("STREAM: cannot wake up the receivers pool thread.");
+
+    return true;
+}
+#endif // __linux__
 
 static int rrdpush_receive(struct receiver_state *rpt)
 {
@@ -520,6 +1937,15 @@ static int rrdpush_receive(struct receiver_state *rpt)
     rpt->rrdpush_compression = (rrdpush_compression && default_compression_enabled);
 #endif  //ENABLE_COMPRESSION
 
+    rpt->ingestion.max_lines_per_sec = (size_t)appconfig_get_number(&stream_config, rpt->key, "default ingestion max lines per second", 0);
+    rpt->ingestion.max_lines_per_sec = (size_t)appconfig_get_number(&stream_config, rpt->machine_guid, "ingestion max lines per second", (long long)rpt->ingestion.max_lines_per_sec);
+
+    rpt->ingestion.max_new_charts_per_min = (size_t)appconfig_get_number(&stream_config, rpt->key, "default ingestion max new charts per minute", 0);
+    rpt->ingestion.max_new_charts_per_min = (size_t)appconfig_get_number(&stream_config, rpt->machine_guid, "ingestion max new charts per minute", (long long)rpt->ingestion.max_new_charts_per_min);
+
+    rpt->ingestion.max_new_dimensions_per_min = (size_t)appconfig_get_number(&stream_config, rpt->key, "default ingestion max new dimensions per minute", 0);
+    rpt->ingestion.max_new_dimensions_per_min = (size_t)appconfig_get_number(&stream_config, rpt->machine_guid, "ingestion max new dimensions per minute", (long long)rpt->ingestion.max_new_dimensions_per_min);
+
     (void)appconfig_set_default(&stream_config, rpt->machine_guid, "host tags", (rpt->tags)?rpt->tags:"");
 
     if (strcmp(rpt->machine_guid, localhost->machine_guid) == 0) {
@@ -656,8 +2082,18 @@ static int rrdpush_receive(struct receiver_state *rpt)
         if (!rpt->rrdpush_compression)
             rpt->capabilities &= ~STREAM_CAP_COMPRESSION;
     }
+
+    // zstd is an alternative to lz4, it needs compression enabled
+    if (!stream_has_capability(rpt, STREAM_CAP_COMPRESSION))
+        rpt->capabilities &= ~STREAM_CAP_ZSTD;
 #endif
 
+    if (!default_rrdpush_binary_enabled)
+        rpt->capabilities &= ~STREAM_CAP_BINARY;
+
+    if (!default_rrdpush_replication_enabled)
+        rpt->capabilities &= ~STREAM_CAP_REPLICATION;
+
     info("STREAM %s [receive from [%s]:%s]: initializing communication...", rrdhost_hostname(rpt->host), rpt->client_ip, rpt->client_port);
     char initial_response[HTTP_HEADER_SIZE];
     if (stream_has_capability(rpt, STREAM_CAP_VCAPS)) {
@@ -767,42 +2203,14 @@ static int rrdpush_receive(struct receiver_state *rpt)
 
     rrdcontext_host_child_connected(rpt->host);
 
-    size_t count = streaming_parser(rpt, &cd, fp_in, fp_out);
-
-    log_stream_connection(rpt->client_ip, rpt->client_port, rpt->key, rpt->host->machine_guid, rpt->hostname,
-                          "DISCONNECTED");
-    error("STREAM %s [receive from [%s]:%s]: disconnected (completed %zu updates).", rpt->hostname, rpt->client_ip,
-          rpt->client_port, count);
-
-    rrdcontext_host_child_disconnected(rpt->host);
-
-#ifdef ENABLE_ACLK
-    // in case we have cloud connection we inform cloud
-    // new child connected
-    if (netdata_cloud_setting)
-        aclk_host_state_update(rpt->host, 0);
+#ifdef __linux__
+    if(default_rrdpush_receiver_threads && receiver_pool_add(rpt, &cd, fp_in, fp_out, health_enabled))
+        return 0;
 #endif
 
-    // During a shutdown there is cleanup code in rrdhost that will cancel the sender thread
-    if (!netdata_exit && rpt->host) {
-        rrd_rdlock();
-        rrdhost_wrlock(rpt->host);
-        netdata_mutex_lock(&rpt->host->receiver_lock);
-        if (rpt->host->receiver == rpt) {
-            rpt->host->senders_connect_time = 0;
-            rpt->host->trigger_chart_obsoletion_check = 0;
-            rpt->host->senders_disconnected_time = now_realtime_sec();
-            rrdhost_flag_set(rpt->host, RRDHOST_FLAG_ORPHAN);
-            if(health_enabled == CONFIG_BOOLEAN_AUTO)
-                rpt->host->health_enabled = 0;
-        }
-        rrdhost_unlock(rpt->host);
-        if (rpt->host->receiver == rpt) {
-            rrdpush_sender_thread_stop(rpt->host);
-        }
-        netdata_mutex_unlock(&rpt->host->receiver_lock);
-        rrd_unlock();
-    }
+    size_t count = streaming_parser(rpt, &cd, fp_in, fp_out);
+
+    rrdpush_receive_disconnected(rpt, count, health_enabled);
 
     // cleanup
     fclose(fp_in);
@@ -40,8 +40,21 @@ struct config stream_config = {
 };
 
 unsigned int default_rrdpush_enabled = 0;
+unsigned int default_rrdpush_binary_enabled = 1;
+unsigned int default_rrdpush_replication_enabled = 1;
+time_t default_rrdpush_replication_period = 86400;
+size_t default_rrdpush_replication_step = 600;
+size_t default_rrdpush_replication_max_bytes_per_sec = 5 * 1024 * 1024;
+size_t default_rrdpush_receiver_threads = 0;
+size_t default_rrdpush_sender_threads = 0;
+unsigned int default_rrdpush_zero_copy_enabled = 1;
+unsigned int default_rrdpush_fan_out = 0;
+long default_rrdpush_throttled_priority = 40000;
 #ifdef ENABLE_COMPRESSION
 unsigned int default_compression_enabled = 1;
+STREAM_CAPABILITIES default_compression_algorithm = STREAM_CAP_COMPRESSION;
+int default_compression_zstd_level = 3;
+unsigned int default_compression_adaptive = 1;
 #endif
 char *default_rrdpush_destination = NULL;
 char *default_rrdpush_api_key = NULL;
@@ -80,8 +93,54 @@ int rrdpush_init() {
 #ifdef ENABLE_COMPRESSION
     default_compression_enabled = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
         "enable compression", default_compression_enabled);
+
+    const char *algorithm = appconfig_get(&stream_config, CONFIG_SECTION_STREAM, "compression algorithm", "lz4");
+    if(!strcmp(algorithm, "zstd")) {
+#ifdef ENABLE_ZSTD
+        default_compression_algorithm = STREAM_CAP_ZSTD;
+#else
+        error("STREAM: zstd compression is not available in this build, using lz4.");
+#endif
+    }
+    else if(strcmp(algorithm, "lz4") != 0)
+        error("STREAM: unknown compression algorithm '%s', using lz4.", algorithm);
+
+    default_compression_zstd_level = (int)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "zstd compression level", default_compression_zstd_level);
+    if(default_compression_zstd_level < 1)
+        default_compression_zstd_level = 1;
+    else if(default_compression_zstd_level > 19)
+        default_compression_zstd_level = 19;
+    default_compression_adaptive = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+        "adaptive compression level", default_compression_adaptive);
 #endif
 
+    default_rrdpush_binary_enabled = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+        "enable binary protocol", default_rrdpush_binary_enabled);
+
+    default_rrdpush_replication_enabled = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+        "enable replication", default_rrdpush_replication_enabled);
+    default_rrdpush_replication_period = (time_t)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "replication period seconds", default_rrdpush_replication_period);
+    default_rrdpush_replication_step = (size_t)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "replication step points", (long long)default_rrdpush_replication_step);
+    default_rrdpush_replication_max_bytes_per_sec = (size_t)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "replication max bytes per second", (long long)default_rrdpush_replication_max_bytes_per_sec);
+
+    if(default_rrdpush_replication_step < 1)
+        default_rrdpush_replication_step = 1;
+
+    default_rrdpush_receiver_threads = (size_t)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "receiver threads", (long long)default_rrdpush_receiver_threads);
+    default_rrdpush_sender_threads = (size_t)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "sender threads", (long long)default_rrdpush_sender_threads);
+    default_rrdpush_zero_copy_enabled = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+        "enable zero copy", default_rrdpush_zero_copy_enabled);
+    default_rrdpush_fan_out = (unsigned int)appconfig_get_boolean(&stream_config, CONFIG_SECTION_STREAM,
+        "send to all destinations", default_rrdpush_fan_out);
+    default_rrdpush_throttled_priority = (long)appconfig_get_number(&stream_config, CONFIG_SECTION_STREAM,
+        "throttled charts priority", default_rrdpush_throttled_priority);
+
     if(default_rrdpush_enabled && (!default_rrdpush_destination || !*default_rrdpush_destination || !default_rrdpush_api_key || !*default_rrdpush_api_key)) {
         error("STREAM [send]: cannot enable sending thread - information is missing.");
         default_rrdpush_enabled = 0;
@@ -240,11 +299,29 @@ static inline void rrdpush_send_chart_definition(BUFFER *wb, RRDSET *st) {
             , rrdset_module_name(st)
     );
 
+    // give the chart a slot, for its binary updates
+    // the slots are numbered again on every connection, and the charts that do not get one are sent as text
+    bool binary = stream_has_capability(host->sender, STREAM_CAP_BINARY);
+    if(binary) {
+        if(unlikely(!st->upstream_slot) &&
+           __atomic_load_n(&host->sender->binary_chart_slots, __ATOMIC_RELAXED) < STREAM_BINARY_MAX_SLOTS - 1) {
+            uint32_t slot = __atomic_add_fetch(&host->sender->binary_chart_slots, 1, __ATOMIC_RELAXED);
+            if(likely(slot < STREAM_BINARY_MAX_SLOTS))
+                st->upstream_slot = slot;
+        }
+
+        if(likely(st->upstream_slot))
+            buffer_sprintf(wb, "SLOT %u\n", st->upstream_slot);
+        else
+            binary = false;
+    }
+
     // send the chart labels
     if (stream_has_capability(host->sender, STREAM_CAP_CLABELS))
         rrdpush_send_clabels(wb, st);
 
     // send the dimensions
+    uint32_t dimensions = 0;
     RRDDIM *rd;
     rrddim_foreach_read(rd, st) {
         buffer_sprintf(
@@ -259,6 +336,9 @@ static inline void rrdpush_send_chart_definition(BUFFER *wb, RRDSET *st) {
                 , rrddim_option_check(rd, RRDDIM_OPTION_HIDDEN)?"hidden":""
                 , rrddim_option_check(rd, RRDDIM_OPTION_DONT_DETECT_RESETS_OR_OVERFLOWS)?"noreset":""
         );
+        if(binary)
+            rd->upstream_slot = ++dimensions;
+
         rd->exposed = 1;
     }
     rrddim_foreach_done(rd);
@@ -270,11 +350,67 @@ static inline void rrdpush_send_chart_definition(BUFFER *wb, RRDSET *st) {
     // send the chart local custom variables
     rrdsetvar_print_to_streaming_custom_chart_variables(st, wb);
 
+    // let the parent ask for the history it misses, the metrics of the chart are paused until it gets it
+    if(stream_has_capability(host->sender, STREAM_CAP_REPLICATION) && st->rrd_memory_mode == RRD_MEMORY_MODE_DBENGINE) {
+        time_t first_entry_t, last_entry_t;
+        rrdpush_replication_chart_retention(st, &first_entry_t, &last_entry_t);
+
+        rrdset_flag_set(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS);
+        buffer_sprintf(wb, "CHART_DEFINITION_END %"PRId64" %"PRId64"\n", (int64_t)first_entry_t, (int64_t)last_entry_t);
+    }
+
     st->upstream_resync_time = st->last_collected_time.tv_sec + (remote_clock_resync_iterations * st->update_every);
 }
 
+static inline void rrdpush_send_binary_frame_header(BUFFER *wb, RRDSET *st, uint64_t type) {
+    buffer_need_bytes(wb, 2);
+    wb->buffer[wb->len++] = STREAM_BINARY_FRAME_MARKER;
+    stream_binary_put_uint(wb, st->upstream_slot);
+    stream_binary_put_uint(wb, type);
+}
+
+// sends the current chart dimensions, as binary frames
+static inline void rrdpush_send_chart_metrics_binary(BUFFER *wb, RRDSET *st) {
+    size_t frame_start = wb->len;
+
+    rrdpush_send_binary_frame_header(wb, st, STREAM_BINARY_BEGIN);
+    stream_binary_put_uint(wb, (st->last_collected_time.tv_sec > st->upstream_resync_time)?st->usec_since_last_update:0);
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        if(unlikely(!rd->updated))
+            continue;
+
+        if(likely(rd->exposed)) {
+            if(unlikely(wb->len - frame_start > STREAM_BINARY_FRAME_MAX - 32)) {
+                buffer_fast_strcat(wb, "\n", 1);
+                frame_start = wb->len;
+                rrdpush_send_binary_frame_header(wb, st, STREAM_BINARY_CONTINUE);
+            }
+
+            stream_binary_put_uint(wb, rd->upstream_slot);
+            stream_binary_put_int(wb, rd->collected_value);
+        }
+        else {
+            internal_error(true, "host '%s', chart '%s', dimension '%s' flag 'exposed' is updated but not exposed", rrdhost_hostname(st->rrdhost), rrdset_id(st), rrddim_id(rd));
+            // we will include it in the next iteration
+            rrdset_flag_clear(st, RRDSET_FLAG_UPSTREAM_EXPOSED);
+        }
+    }
+    rrddim_foreach_done(rd);
+
+    // slot 0 is the END of the update
+    stream_binary_put_uint(wb, 0);
+    buffer_fast_strcat(wb, "\n", 1);
+}
+
 // sends the current chart dimensions
 static inline void rrdpush_send_chart_metrics(BUFFER *wb, RRDSET *st, struct sender_state *s) {
+    if(stream_has_capability(s, STREAM_CAP_BINARY) && likely(st->upstream_slot)) {
+        rrdpush_send_chart_metrics_binary(wb, st);
+        return;
+    }
+
     buffer_fast_strcat(wb, "BEGIN \"", 7);
     buffer_fast_strcat(wb, rrdset_id(st), string_strlen(st->id));
     buffer_fast_strcat(wb, "\" ", 2);
@@ -388,16 +524,47 @@ void rrdset_done_push(RRDSET *st) {
     if(unlikely(!should_send_chart_matching(st)))
         return;
 
+    // the parent is overloaded by this child, send only the important charts for a while
+    time_t throttled_until = __atomic_load_n(&host->sender->throttled_until, __ATOMIC_RELAXED);
+    if(unlikely(throttled_until && st->priority >= default_rrdpush_throttled_priority &&
+                now_realtime_sec() < throttled_until))
+        return;
+
     BUFFER *wb = sender_start(host->sender);
 
     if(unlikely(need_to_send_chart_definition(st)))
         rrdpush_send_chart_definition(wb, st);
 
-    rrdpush_send_chart_metrics(wb, st, host->sender);
+    // the metrics collected while the chart is replicated are sent by the replication
+    if(likely(!rrdset_flag_check(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS)))
+        rrdpush_send_chart_metrics(wb, st, host->sender);
 
     sender_commit(host->sender, wb);
 }
 
+// the retention of the chart on tier 0, the only tier that is replicated
+void rrdpush_replication_chart_retention(RRDSET *st, time_t *first_entry_t, time_t *last_entry_t) {
+    *first_entry_t = 0;
+    *last_entry_t = 0;
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        struct rrddim_tier *t = rd->tiers[0];
+        if(unlikely(!t))
+            continue;
+
+        time_t first = t->query_ops.oldest_time(t->db_metric_handle);
+        time_t last = t->query_ops.latest_time(t->db_metric_handle);
+
+        if(first && (!*first_entry_t || first < *first_entry_t))
+            *first_entry_t = first;
+
+        if(last > *last_entry_t)
+            *last_entry_t = last;
+    }
+    rrddim_foreach_done(rd);
+}
+
 // labels
 static int send_labels_callback(const char *name, const char *value, RRDLABEL_SRC ls, void *data) {
     BUFFER *wb = (BUFFER *)data;
@@ -434,47 +601,62 @@ void rrdpush_claimed_id(RRDHOST *host)
     sender_commit(host->sender, wb);
 }
 
-int connect_to_one_of_destinations(
+// connects to a single destination, unless its reconnection has been postponed
+int connect_to_destination(
     RRDHOST *host,
+    struct rrdpush_destinations *d,
     int default_port,
     struct timeval *timeout,
     size_t *reconnects_counter,
     char *connected_to,
-    size_t connected_to_size,
-    struct rrdpush_destinations **destination)
+    size_t connected_to_size)
 {
-    int sock = -1;
-
-    for (struct rrdpush_destinations *d = host->destinations; d; d = d->next) {
-        time_t now = now_realtime_sec();
-
-        if(d->postpone_reconnection_until > now) {
-            info(
-                "STREAM %s: skipping destination '%s' (default port: %d) due to last error (code: %d, %s), will retry it in %d seconds",
-                rrdhost_hostname(host),
-                string2str(d->destination),
-                default_port,
-                d->last_handshake, d->last_error?d->last_error:"unset reason description",
-                (int)(d->postpone_reconnection_until - now));
-
-            continue;
-        }
+    time_t now = now_realtime_sec();
 
+    if(d->postpone_reconnection_until > now) {
         info(
-            "STREAM %s: attempting to connect to '%s' (default port: %d)...",
+            "STREAM %s: skipping destination '%s' (default port: %d) due to last error (code: %d, %s), will retry it in %d seconds",
             rrdhost_hostname(host),
             string2str(d->destination),
-            default_port);
+            default_port,
+            d->last_handshake, d->last_error?d->last_error:"unset reason description",
+            (int)(d->postpone_reconnection_until - now));
 
-        if (reconnects_counter)
-            *reconnects_counter += 1;
+        return -1;
+    }
 
-        sock = connect_to_this(string2str(d->destination), default_port, timeout);
+    info(
+        "STREAM %s: attempting to connect to '%s' (default port: %d)...",
+        rrdhost_hostname(host),
+        string2str(d->destination),
+        default_port);
 
-        if (sock != -1) {
-            if (connected_to && connected_to_size)
-                strncpyz(connected_to, string2str(d->destination), connected_to_size);
+    if (reconnects_counter)
+        *reconnects_counter += 1;
+
+    int sock = connect_to_this(string2str(d->destination), default_port, timeout);
+
+    if (sock != -1 && connected_to && connected_to_size)
+        strncpyz(connected_to, string2str(d->destination), connected_to_size);
+
+    return sock;
+}
 
+int connect_to_one_of_destinations(
+    RRDHOST *host,
+    int default_port,
+    struct timeval *timeout,
+    size_t *reconnects_counter,
+    char *connected_to,
+    size_t connected_to_size,
+    struct rrdpush_destinations **destination)
+{
+    int sock = -1;
+
+    for (struct rrdpush_destinations *d = host->destinations; d; d = d->next) {
+        sock = connect_to_destination(host, d, default_port, timeout, reconnects_counter, connected_to, connected_to_size);
+
+        if (sock != -1) {
             *destination = d;
 
             // move the current item to the end of the list
@@ -550,6 +732,22 @@ void rrdpush_sender_thread_stop(RRDHOST *host) {
     netdata_mutex_lock(&host->sender->mutex);
     netdata_thread_t thr = 0;
 
+    // the members of the group have a sender thread each
+    if(host->sender->fan_out.members) {
+        netdata_mutex_unlock(&host->sender->mutex);
+        rrdpush_sender_fan_out_stop(host->sender);
+        return;
+    }
+
+#ifdef __linux__
+    // the dispatcher clears the spawn flag when it releases the host
+    if(host->sender->dispatch.dispatcher) {
+        netdata_mutex_unlock(&host->sender->mutex);
+        rrdpush_sender_dispatcher_remove(host->sender);
+        return;
+    }
+#endif
+
     if(rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN)) {
         rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
 
@@ -589,6 +787,21 @@ static void rrdpush_sender_thread_spawn(RRDHOST *host) {
     netdata_mutex_lock(&host->sender->mutex);
 
     if(!rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN)) {
+        if(host->sender->fan_out.members) {
+            rrdpush_sender_fan_out_spawn(host->sender);
+            rrdhost_flag_set(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+            netdata_mutex_unlock(&host->sender->mutex);
+            return;
+        }
+
+#ifdef __linux__
+        if(default_rrdpush_sender_threads && rrdpush_sender_dispatcher_add(host->sender)) {
+            rrdhost_flag_set(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+            netdata_mutex_unlock(&host->sender->mutex);
+            return;
+        }
+#endif
+
         char tag[NETDATA_THREAD_TAG_MAX + 1];
         snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STREAM_SENDER[%s]", rrdhost_hostname(host));
 
@@ -802,6 +1015,7 @@ int rrdpush_receiver_thread_spawn(struct web_client *w, char *url) {
      * lookup to the now-attached structure).
      */
     struct receiver_state *rpt = callocz(1, sizeof(*rpt));
+    netdata_mutex_init(&rpt->send_mutex);
 
     rrd_rdlock();
     RRDHOST *host = rrdhost_find_by_guid(machine_guid);
@@ -842,6 +1056,7 @@ int rrdpush_receiver_thread_spawn(struct web_client *w, char *url) {
                 // Have not set WEB_CLIENT_FLAG_DONT_CLOSE_SOCKET - caller should clean up
                 buffer_flush(w->response.data);
                 buffer_strcat(w->response.data, "This GUID is already streaming to this server");
+                netdata_mutex_destroy(&rpt->send_mutex);
                 freez(rpt);
                 return 409;
             }
@@ -925,6 +1140,10 @@ static void stream_capabilities_to_string(BUFFER *wb, STREAM_CAPABILITIES caps)
     if(caps & STREAM_CAP_COMPRESSION) buffer_strcat(wb, "COMPRESSION ");
     if(caps & STREAM_CAP_FUNCTIONS) buffer_strcat(wb, "FUNCTIONS ");
     if(caps & STREAM_CAP_GAP_FILLING) buffer_strcat(wb, "GAP_FILLING ");
+    if(caps & STREAM_CAP_BINARY) buffer_strcat(wb, "BINARY ");
+    if(caps & STREAM_CAP_REPLICATION) buffer_strcat(wb, "REPLICATION ");
+    if(caps & STREAM_CAP_ZSTD) buffer_strcat(wb, "ZSTD ");
+    if(caps & STREAM_CAP_THROTTLE) buffer_strcat(wb, "THROTTLE ");
 }
 
 void log_receiver_capabilities(struct receiver_state *rpt) {
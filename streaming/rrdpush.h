@@ -35,6 +35,10 @@ typedef enum {
     STREAM_CAP_COMPRESSION      = (1 << 10), // lz4 compression supported
     STREAM_CAP_FUNCTIONS        = (1 << 11), // plugin functions supported
     STREAM_CAP_GAP_FILLING      = (1 << 12), // gap filling supported
+    STREAM_CAP_BINARY           = (1 << 13), // binary chart updates supported
+    STREAM_CAP_REPLICATION      = (1 << 14), // replication of the chart history missed while disconnected
+    STREAM_CAP_ZSTD             = (1 << 15), // zstd compression supported (together with STREAM_CAP_COMPRESSION)
+    STREAM_CAP_THROTTLE         = (1 << 16), // the parent may ask the child to send less
 
     // this must be signed int, so don't use the last bit
     // needed for negotiating errors between parent and child
@@ -46,7 +50,13 @@ typedef enum {
 #define STREAM_HAS_COMPRESSION 0
 #endif  //ENABLE_COMPRESSION
 
-#define STREAM_OUR_CAPABILITIES (STREAM_CAP_V1 | STREAM_CAP_V2 | STREAM_CAP_VN | STREAM_CAP_VCAPS | STREAM_CAP_HLABELS | STREAM_CAP_CLAIM | STREAM_CAP_CLABELS | STREAM_HAS_COMPRESSION | STREAM_CAP_FUNCTIONS)
+#if defined(ENABLE_COMPRESSION) && defined(ENABLE_ZSTD)
+#define STREAM_HAS_ZSTD STREAM_CAP_ZSTD
+#else
+#define STREAM_HAS_ZSTD 0
+#endif
+
+#define STREAM_OUR_CAPABILITIES (STREAM_CAP_V1 | STREAM_CAP_V2 | STREAM_CAP_VN | STREAM_CAP_VCAPS | STREAM_CAP_HLABELS | STREAM_CAP_CLAIM | STREAM_CAP_CLABELS | STREAM_HAS_COMPRESSION | STREAM_HAS_ZSTD | STREAM_CAP_FUNCTIONS | STREAM_CAP_BINARY | STREAM_CAP_REPLICATION | STREAM_CAP_THROTTLE)
 
 #define stream_has_capability(rpt, capability) ((rpt) && ((rpt)->capabilities & (capability)))
 
@@ -60,6 +70,118 @@ typedef enum {
 #define START_STREAMING_PROMPT_V2 "Hit me baby, push them over and bring the host labels..."
 #define START_STREAMING_PROMPT_VN "Hit me baby, push them over with the version="
 
+// ----------------------------------------------------------------------------
+// binary chart updates
+//
+// With STREAM_CAP_BINARY, chart definitions are followed by a "SLOT <id>" line that gives the chart
+// a per-connection numeric id, and its dimensions are numbered 1, 2, ... in the order of their
+// DIMENSION lines. Chart updates are then sent as binary frames instead of BEGIN/SET/END:
+//
+// STREAM_BINARY_FRAME_MARKER, chart slot, STREAM_BINARY_BEGIN, microseconds, { dimension slot, value } ..., 0, '\n'
+//
+// All the numbers are variable length and every one of their bytes has the high bit set, so frames
+// never contain '\0' or '\n' and travel through the line oriented receiver (and the compressor) as
+// regular lines. Charts with many dimensions are split into STREAM_BINARY_CONTINUE frames, and the
+// dimension slot 0 ends the update.
+
+#define STREAM_BINARY_FRAME_MARKER 0x01
+#define STREAM_BINARY_FRAME_MAX 4096
+#define STREAM_BINARY_BEGIN 1
+#define STREAM_BINARY_CONTINUE 2
+#define STREAM_BINARY_MAX_SLOTS (1024 * 1024)
+
+static inline void stream_binary_put_uint(BUFFER *wb, uint64_t value) {
+    buffer_need_bytes(wb, 12);
+
+    // 6 bits per byte, 0x40 marks that more bytes follow
+    while(value > 0x3F) {
+        wb->buffer[wb->len++] = (char)(0x80 | 0x40 | (value & 0x3F));
+        value >>= 6;
+    }
+    wb->buffer[wb->len++] = (char)(0x80 | value);
+    wb->buffer[wb->len] = '\0';
+}
+
+static inline void stream_binary_put_int(BUFFER *wb, int64_t value) {
+    // zigzag, so that small negative numbers are small too
+    stream_binary_put_uint(wb, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// returns false when the frame is malformed
+static inline bool stream_binary_get_uint(const uint8_t **ptr, uint64_t *value) {
+    const uint8_t *s = *ptr;
+    uint64_t v = 0;
+    unsigned shift = 0;
+
+    do {
+        if(unlikely(!(*s & 0x80) || shift > 63))
+            return false;
+
+        v |= (uint64_t)(*s & 0x3F) << shift;
+        shift += 6;
+    } while(*s++ & 0x40);
+
+    *value = v;
+    *ptr = s;
+    return true;
+}
+
+static inline bool stream_binary_get_int(const uint8_t **ptr, int64_t *value) {
+    uint64_t v;
+    if(unlikely(!stream_binary_get_uint(ptr, &v)))
+        return false;
+
+    *value = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// replication
+//
+// With STREAM_CAP_REPLICATION, the child ends the definition of every dbengine chart with
+// "CHART_DEFINITION_END <first entry> <last entry>" and stops streaming its metrics. The parent
+// answers with "REPLAY_CHART <chart> <after> <before>", the time range it misses (0 0 when it
+// misses nothing), and the child sends the points it has stored for that range in steps:
+//
+// REPLAY_BEGIN <chart>
+// REPLAY_POINT <end time>
+// REPLAY_SET <dimension> <value> <flags>
+// ...
+// REPLAY_END
+//
+// The last step also carries REPLAY_RRDDIM_STATE and REPLAY_RRDSET_STATE, the collection state of
+// the chart, so that the parent continues from it when the child resumes streaming its metrics.
+// Steps are sent only while the sender buffer is less than half full, and up to
+// "replication max bytes per second", so that they do not delay the metrics of the other charts.
+
+struct replication_request {
+    STRING *chart_id;
+    time_t after;           // the next point to send
+    time_t before;          // the last point to send, it is moved forward while the chart is collected
+    struct replication_request *prev, *next;
+};
+
+// ----------------------------------------------------------------------------
+// ingestion budgets
+//
+// The parent may limit the lines per second, the new charts per minute and the new dimensions per minute
+// it accepts from a child. A child that sends more lines is read slower, and the charts and dimensions
+// over the budgets are dropped for the rest of the connection, unless they are defined again when the
+// budget allows them. With STREAM_CAP_THROTTLE the parent also sends "THROTTLE <seconds>", and for that
+// long the child does not send its charts with priority "throttled charts priority" or above.
+
+#define STREAM_THROTTLE_SECONDS 60
+
+typedef struct stream_ingestion_statistics {
+    uint64_t lines;                 // the text lines and binary frames received
+    uint64_t new_charts;            // the charts created
+    uint64_t new_dimensions;        // the dimensions created
+    uint64_t dropped_charts;        // the chart definitions dropped by the budget
+    uint64_t dropped_dimensions;    // the dimension definitions dropped by the budget
+    uint64_t throttled_usec;        // the time the child was not read, to keep it within the lines budget
+    uint64_t parse_usec;            // the time spent parsing what the child sent
+} STREAM_INGESTION_STATISTICS;
+
 #define START_STREAMING_ERROR_SAME_LOCALHOST "Don't hit me baby, you are trying to stream my localhost back"
 #define START_STREAMING_ERROR_ALREADY_STREAMING "This GUID is already streaming to this server"
 #define START_STREAMING_ERROR_NOT_PERMITTED "You are not permitted to access this. Check the logs for more info."
@@ -94,15 +216,18 @@ typedef struct {
 
 #ifdef ENABLE_COMPRESSION
 struct compressor_state {
+    STREAM_CAPABILITIES algorithm; // STREAM_CAP_COMPRESSION (lz4) or STREAM_CAP_ZSTD
     char *compression_result_buffer;
     size_t compression_result_buffer_size;
     struct compressor_data *data; // Compression API specific data
     void (*reset)(struct compressor_state *state);
     size_t (*compress)(struct compressor_state *state, const char *data, size_t size, char **buffer);
+    void (*adapt)(struct compressor_state *state, size_t buffered, size_t buffer_size); // optional
     void (*destroy)(struct compressor_state **state);
 };
 
 struct decompressor_state {
+    STREAM_CAPABILITIES algorithm; // STREAM_CAP_COMPRESSION (lz4) or STREAM_CAP_ZSTD
     char *buffer;
     size_t buffer_size;
     size_t buffer_len;
@@ -130,8 +255,19 @@ struct decompressor_state {
 typedef enum {
     SENDER_FLAG_OVERFLOW    = (1 << 0), // The buffer has been overflown
     SENDER_FLAG_COMPRESSION = (1 << 1), // The stream needs to have and has compression
+    SENDER_FLAG_ZERO_COPY   = (1 << 2), // The collectors hand their buffers to the sender, instead of copying them
 } SENDER_FLAGS;
 
+// the buffer of a collector, handed to the sender by pointer (SENDER_FLAG_ZERO_COPY)
+struct sender_chunk {
+    BUFFER *wb;                                 // the data, or the spare buffer of a recycled chunk
+    struct sender_chunk *shared;                // fan out: the chunk of the group with the data, instead of wb
+    uint32_t refcount;                          // fan out: the members that have not sent this chunk of the group yet
+    uint32_t zerocopy_seq;                      // the last MSG_ZEROCOPY send that referenced it
+    bool zerocopy;                              // the kernel may still read it
+    struct sender_chunk *next;
+};
+
 struct sender_state {
     RRDHOST *host;
     pid_t tid;                              // the thread id of the sender, from gettid()
@@ -154,10 +290,62 @@ struct sender_state {
     char read_buffer[PLUGINSD_LINE_MAX + 1];
     int read_len;
     STREAM_CAPABILITIES capabilities;
+    uint32_t binary_chart_slots;                    // the last chart slot given for binary chart updates on this connection
+    time_t throttled_until;                         // the parent asked to send only the important charts until then
+
+    struct {
+        struct replication_request *requests;       // the charts the parent asked to replicate, accessed only by the sender thread
+        time_t second;                              // the second of the speed limit
+        size_t bytes;                               // the replication bytes committed in this second
+    } replication;
 
     int rrdpush_sender_pipe[2];                     // collector to sender thread signaling
     int rrdpush_sender_socket;
 
+    struct {
+        struct sender_chunk *head, *tail;           // committed and not sent yet - collectors append under the mutex
+        size_t head_sent;                           // the bytes of the head already sent
+        size_t bytes;                               // the bytes of the queue not sent yet
+        struct sender_chunk *free;                  // recycled chunks - protected by the mutex
+        size_t free_count;
+        struct sender_chunk *inflight_head, *inflight_tail; // sent with MSG_ZEROCOPY, not completed yet - sender thread only
+        bool msg_zerocopy;                          // MSG_ZEROCOPY is enabled on the socket
+        uint32_t next_seq;                          // the sequence of the next MSG_ZEROCOPY send
+        uint32_t completed_seq;                     // all MSG_ZEROCOPY sends before it have been completed
+        uint64_t completed_ahead;                   // the completed sends after completed_seq, as a bitmap
+    } zero_copy;
+
+    struct {
+        struct sender_dispatcher *dispatcher;       // the senders dispatcher thread serving the host, or NULL
+        struct rrdpush_sender_thread_data *data;    // what the sender thread keeps in its stack
+        netdata_thread_t connector;                 // the thread connecting to the parent
+        bool connector_running;                     // the connector has not been joined yet
+        bool connecting;                            // the connector has not finished yet
+        bool queued;                                // in the ready queue of the dispatcher
+        bool stop;                                  // sending has to stop, the dispatcher will release the host
+        time_t connect_after_t;                     // the next connection attempt, in monotonic time
+        int socket;                                 // the socket added to the epoll of the dispatcher, or -1
+        uint32_t events;                            // the epoll events the socket has been added with
+        struct sender_state *prev, *next;           // all the senders of the dispatcher
+        struct sender_state *ready_prev, *ready_next;
+    } dispatch;
+
+    // when sending to all the destinations, the sender of the host is the group: it only serializes the data,
+    // and a member sender for each destination streams it, sharing the chunks of the group
+    struct {
+        struct sender_state *group;                 // the member: the sender of the host
+        struct sender_state *members;               // the group: the senders of the destinations
+        struct sender_state *next;                  // the member: the next member of the group
+        struct rrdpush_destinations *destination;   // the member: the only destination it connects to
+        struct sender_chunk *shared_head, *shared_tail; // the group: the chunks given to the members, in commit order
+        netdata_rwlock_t serializing;               // the group: read locked by the collectors from sender_start() to sender_commit(), write locked by a joining member
+        netdata_thread_t thread;                    // the member: its sender thread
+        bool spawned;                               // the member: the thread is running - protected by the group mutex
+        bool join;                                  // the member: the thread will be joined - protected by the group mutex
+        bool connected;                             // the member: connected to its parent - written with the group mutex
+        bool ready;                                 // the member: streams metrics - protected by the group mutex
+    } fan_out;
+
 #ifdef ENABLE_COMPRESSION
     struct compressor_state *compressor;
 #endif
@@ -166,6 +354,16 @@ struct sender_state {
 #endif
 };
 
+struct receiver_binary_chart {
+    const DICTIONARY_ITEM *st_item;
+    RRDSET *st;
+    bool dropped;                           // the chart has been dropped by the ingestion budget
+    const DICTIONARY_ITEM **rd_items;
+    RRDDIM **rd;                            // NULL for the dimensions dropped by the ingestion budget
+    uint32_t dimensions;
+    uint32_t size;
+};
+
 struct receiver_state {
     RRDHOST *host;
     netdata_thread_t thread;
@@ -189,6 +387,40 @@ struct receiver_state {
     time_t last_msg_t;
     char read_buffer[PLUGINSD_LINE_MAX + 1];
     int read_len;
+    struct {
+        struct receiver_binary_chart *charts;       // indexed by chart slot
+        uint32_t size;
+        struct receiver_binary_chart *defining;     // the chart whose DIMENSION lines are being received
+    } binary;
+    time_t replication_point_end_time;      // the time of the REPLAY_SET values that follow REPLAY_POINT
+    struct {
+        size_t max_lines_per_sec;           // the budgets, 0 for unlimited
+        size_t max_new_charts_per_min;
+        size_t max_new_dimensions_per_min;
+
+        size_t lines;                       // the lines received since the last check of the lines budget
+        usec_t lines_budget_ut;             // the lines received so far are within the budget from then on
+        time_t minute;                      // the minute new_charts and new_dimensions are counted for
+        size_t new_charts;
+        size_t new_dimensions;
+
+        DICTIONARY *dropped;                // the ids of the dropped charts (true) and of the charts with dropped
+                                            // dimensions (false), and of the dropped dimensions as chart|dimension
+        bool skipping;                      // the lines of a dropped chart are received
+        bool skipping_dimensions;           // the update of a chart with dropped dimensions is received
+        time_t throttle_sent_t;             // the last time THROTTLE was sent to the child
+        usec_t parked_until_ut;             // the receivers pool does not read from the child until then
+
+        STREAM_INGESTION_STATISTICS stats;  // updated with atomic operations, read by the statistics thread
+        RRDSET *st_lines;                   // the charts of the child, used only by the statistics thread
+        RRDDIM *rd_lines;
+        RRDSET *st_definitions;
+        RRDDIM *rd_new_charts, *rd_new_dimensions, *rd_dropped_charts, *rd_dropped_dimensions;
+        RRDSET *st_cost;
+        RRDDIM *rd_parse, *rd_throttled;
+    } ingestion;
+    struct receiver_pool_connection *pool;  // set when a thread of the receivers pool serves the connection
+    netdata_mutex_t send_mutex;             // serializes the commands sent to the child
     unsigned int shutdown:1;    // Tell the thread to exit
     unsigned int exited;      // Indicates that the thread has exited  (NOT A BITFIELD!)
 #ifdef ENABLE_HTTPS
@@ -212,8 +444,21 @@ struct rrdpush_destinations {
 };
 
 extern unsigned int default_rrdpush_enabled;
+extern unsigned int default_rrdpush_binary_enabled;
+extern unsigned int default_rrdpush_replication_enabled;
+extern time_t default_rrdpush_replication_period;
+extern size_t default_rrdpush_replication_step;
+extern size_t default_rrdpush_replication_max_bytes_per_sec;
+extern size_t default_rrdpush_receiver_threads;
+extern size_t default_rrdpush_sender_threads;
+extern unsigned int default_rrdpush_zero_copy_enabled;
+extern unsigned int default_rrdpush_fan_out;
+extern long default_rrdpush_throttled_priority;
 #ifdef ENABLE_COMPRESSION
 extern unsigned int default_compression_enabled;
+extern STREAM_CAPABILITIES default_compression_algorithm;
+extern int default_compression_zstd_level;
+extern unsigned int default_compression_adaptive;
 #endif
 extern char *default_rrdpush_destination;
 extern char *default_rrdpush_api_key;
@@ -224,6 +469,9 @@ extern void rrdpush_destinations_init(RRDHOST *host);
 extern void rrdpush_destinations_free(RRDHOST *host);
 
 extern void sender_init(RRDHOST *parent);
+extern void sender_fan_out_init(RRDHOST *host);
+extern void sender_fan_out_free(struct sender_state *s);
+extern void sender_free_chunks(struct sender_state *s);
 BUFFER *sender_start(struct sender_state *s);
 void sender_commit(struct sender_state *s, BUFFER *wb);
 void sender_cancel(struct sender_state *s);
@@ -235,9 +483,17 @@ extern bool rrdpush_incremental_transmission_of_chart_definitions(RRDHOST *host,
 extern void *rrdpush_sender_thread(void *ptr);
 extern void rrdpush_send_host_labels(RRDHOST *host);
 extern void rrdpush_claimed_id(RRDHOST *host);
+extern void rrdpush_replication_chart_retention(RRDSET *st, time_t *first_entry_t, time_t *last_entry_t);
 
 extern int rrdpush_receiver_thread_spawn(struct web_client *w, char *url);
+extern void rrdpush_receiver_ingestion_charts(void);
 extern void rrdpush_sender_thread_stop(RRDHOST *host);
+extern void rrdpush_sender_fan_out_spawn(struct sender_state *group);
+extern void rrdpush_sender_fan_out_stop(struct sender_state *group);
+#ifdef __linux__
+extern bool rrdpush_sender_dispatcher_add(struct sender_state *s);
+extern void rrdpush_sender_dispatcher_remove(struct sender_state *s);
+#endif
 
 extern void rrdpush_sender_send_this_host_variable_now(RRDHOST *host, const RRDVAR_ACQUIRED *rva);
 extern void log_stream_connection(const char *client_ip, const char *client_port, const char *api_key, const char *machine_guid, const char *host, const char *msg);
@@ -249,12 +505,20 @@ extern int connect_to_one_of_destinations(
     char *connected_to,
     size_t connected_to_size,
     struct rrdpush_destinations **destination);
+extern int connect_to_destination(
+    RRDHOST *host,
+    struct rrdpush_destinations *d,
+    int default_port,
+    struct timeval *timeout,
+    size_t *reconnects_counter,
+    char *connected_to,
+    size_t connected_to_size);
 
 extern void rrdpush_signal_sender_to_wake_up(struct sender_state *s);
 
 #ifdef ENABLE_COMPRESSION
-struct compressor_state *create_compressor();
-struct decompressor_state *create_decompressor();
+struct compressor_state *create_compressor(STREAM_CAPABILITIES capabilities);
+struct decompressor_state *create_decompressor(STREAM_CAPABILITIES capabilities);
 size_t is_compressed_data(const char *data, size_t data_size);
 #endif
 
@@ -3,6 +3,15 @@
 #include "rrdpush.h"
 #include "parser/parser.h"
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <linux/errqueue.h>
+#endif
+
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define SENDER_HAVE_MSG_ZEROCOPY 1
+#endif
+
 #define WORKER_SENDER_JOB_CONNECT                    0
 #define WORKER_SENDER_JOB_PIPE_READ                  1
 #define WORKER_SENDER_JOB_SOCKET_RECEIVE             2
@@ -33,6 +42,7 @@ extern char *netdata_ssl_ca_file;
 
 static __thread BUFFER *sender_thread_buffer = NULL;
 static __thread bool sender_thread_buffer_used = false;
+static __thread struct sender_state *sender_thread_buffer_group = NULL;
 
 void sender_thread_buffer_free(void) {
     if(sender_thread_buffer) {
@@ -50,15 +60,344 @@ BUFFER *sender_start(struct sender_state *s __maybe_unused) {
         fatal("STREAMING: thread buffer is used multiple times concurrently.");
 
     sender_thread_buffer_used = true;
+
+    // a member cannot join the group while we serialize, see sender_fan_out_join()
+    if(unlikely(s->fan_out.members)) {
+        netdata_rwlock_rdlock(&s->fan_out.serializing);
+        sender_thread_buffer_group = s;
+    }
+
     buffer_flush(sender_thread_buffer);
     return sender_thread_buffer;
 }
 
+static inline void sender_thread_buffer_release_group(void) {
+    if(unlikely(sender_thread_buffer_group)) {
+        netdata_rwlock_unlock(&sender_thread_buffer_group->fan_out.serializing);
+        sender_thread_buffer_group = NULL;
+    }
+}
+
 void sender_cancel(struct sender_state *s __maybe_unused) {
     sender_thread_buffer_used = false;
+    sender_thread_buffer_release_group();
+}
+
+// ----------------------------------------------------------------------------
+// zero copy
+//
+// When the connection is neither compressed nor encrypted, sender_commit() does not copy the buffer of the
+// collector to the circular buffer. It queues the buffer itself, and gives the collector a recycled one, so the
+// collectors hold the sender mutex only to append a pointer. The sender writes many queued buffers to the socket
+// with a single sendmsg(). Large writes use MSG_ZEROCOPY when the kernel supports it, in which case a buffer is
+// recycled only after the kernel reports it does not need it anymore.
+
+#define SENDER_CHUNKS_MAX_IOV 256
+#define SENDER_CHUNKS_MAX_FREE 256
+#define SENDER_ZEROCOPY_MIN_BYTES (16 * 1024)      // smaller writes are cheaper to copy
+#define SENDER_ZEROCOPY_MAX_INFLIGHT 64            // the bits of zero_copy.completed_ahead
+
+// the bytes committed and not sent yet, called with the sender mutex locked
+static inline size_t sender_buffered_bytes_unsafe(struct sender_state *s) {
+    return s->buffer->max_size - cbuffer_available_size_unsafe(s->buffer) + s->zero_copy.bytes;
+}
+
+// non-zero when there is something to send, called with the sender mutex locked
+static inline size_t sender_outstanding_bytes_unsafe(struct sender_state *s) {
+    return cbuffer_next_unsafe(s->buffer, NULL) + s->zero_copy.bytes;
+}
+
+// the data of a chunk, the one of the group for the chunks the members share
+static inline BUFFER *sender_chunk_buffer(struct sender_chunk *c) {
+    return c->shared ? c->shared->wb : c->wb;
+}
+
+// called with the sender mutex locked
+static void sender_chunk_recycle_unsafe(struct sender_state *s, struct sender_chunk *c) {
+    // the group recycles its chunk when all its members have released it
+    if(c->shared) {
+        __atomic_sub_fetch(&c->shared->refcount, 1, __ATOMIC_RELEASE);
+        c->shared = NULL;
+    }
+
+    if(s->zero_copy.free_count >= SENDER_CHUNKS_MAX_FREE) {
+        buffer_free(c->wb);
+        freez(c);
+        return;
+    }
+
+    c->zerocopy = false;
+    c->next = s->zero_copy.free;
+    s->zero_copy.free = c;
+    s->zero_copy.free_count++;
+}
+
+// a recycled chunk, or a new one, called with the sender mutex locked
+static struct sender_chunk *sender_chunk_get_unsafe(struct sender_state *s) {
+    struct sender_chunk *c = s->zero_copy.free;
+    if(likely(c)) {
+        s->zero_copy.free = c->next;
+        s->zero_copy.free_count--;
+    }
+    else
+        c = callocz(1, sizeof(struct sender_chunk));
+
+    c->next = NULL;
+    return c;
+}
+
+// called with the sender mutex locked
+static void sender_chunk_append_unsafe(struct sender_state *s, struct sender_chunk *c, size_t bytes) {
+    if(s->zero_copy.tail)
+        s->zero_copy.tail->next = c;
+    else
+        s->zero_copy.head = c;
+    s->zero_copy.tail = c;
+    s->zero_copy.bytes += bytes;
+}
+
+// queues the buffer of the collector, and gives it the spare buffer of a recycled chunk
+// called with the sender mutex locked
+static void sender_chunk_commit_unsafe(struct sender_state *s, BUFFER *wb) {
+    struct sender_chunk *c = sender_chunk_get_unsafe(s);
+
+    // NULL for a new chunk, sender_start() will create a buffer
+    sender_thread_buffer = c->wb;
+
+    c->wb = wb;
+    sender_chunk_append_unsafe(s, c, buffer_strlen(wb));
+}
+
+static void sender_chunks_free_list(struct sender_chunk *c) {
+    while(c) {
+        struct sender_chunk *next = c->next;
+        buffer_free(c->wb);
+        freez(c);
+        c = next;
+    }
+}
+
+// drops everything not sent, called by the sender thread with the sender mutex locked
+static void sender_chunks_flush_unsafe(struct sender_state *s) {
+    struct sender_chunk *c, *next;
+
+    for(c = s->zero_copy.head; c; c = next) {
+        next = c->next;
+        sender_chunk_recycle_unsafe(s, c);
+    }
+
+    // the socket has been aborted with SO_LINGER {1, 0}, so its queue has been discarded and nothing
+    // sent from these chunks can reach the parent anymore
+    for(c = s->zero_copy.inflight_head; c; c = next) {
+        next = c->next;
+        sender_chunk_recycle_unsafe(s, c);
+    }
+
+    s->zero_copy.head = s->zero_copy.tail = NULL;
+    s->zero_copy.inflight_head = s->zero_copy.inflight_tail = NULL;
+    s->zero_copy.head_sent = 0;
+    s->zero_copy.bytes = 0;
+    s->zero_copy.next_seq = 0;
+    s->zero_copy.completed_seq = 0;
+    s->zero_copy.completed_ahead = 0;
+}
+
+void sender_free_chunks(struct sender_state *s) {
+    sender_chunks_free_list(s->zero_copy.head);
+    sender_chunks_free_list(s->zero_copy.inflight_head);
+    sender_chunks_free_list(s->zero_copy.free);
+    memset(&s->zero_copy, 0, sizeof(s->zero_copy));
+}
+
+// ----------------------------------------------------------------------------
+// fan out
+//
+// With [stream].send to all destinations, a host streams to all its destinations at the same time, each over
+// its own connection. The sender of the host becomes the group: the collectors serialize their data once and
+// commit it to the group, which keeps the buffer of the collector as a chunk and gives a reference to it to the
+// queue of every connected member. Each member is a sender for a single destination, with its own thread,
+// socket and handshake, that sends the chunks it references the way the zero copy senders do. A chunk of the
+// group is recycled when all the members have released it, so committing costs the same for any number of
+// destinations. Members that cannot send the buffers as they are (TLS) copy them to their circular buffer.
+//
+// The group streams what all the connected members can receive: its capabilities are the ones they have in
+// common. Replication and compression are disabled, since they would make the stream of each parent different.
+//
+// A member joins the group when it connects: with the collectors paused, it starts getting the chunks of the
+// group, the capabilities of the group are recalculated and the charts are reset. So every chunk it gets has
+// been serialized for its capabilities, after the definitions of its charts have been restarted. When a member
+// leaves, the capabilities of the group do not change: the remaining members can receive them.
+
+// releases the chunks the members have sent, called with the mutex of the group locked
+static void sender_fan_out_recycle_unsafe(struct sender_state *group) {
+    struct sender_chunk *c;
+    while((c = group->fan_out.shared_head) && !__atomic_load_n(&c->refcount, __ATOMIC_ACQUIRE)) {
+        group->fan_out.shared_head = c->next;
+        if(!group->fan_out.shared_head)
+            group->fan_out.shared_tail = NULL;
+        sender_chunk_recycle_unsafe(group, c);
+    }
+}
+
+// gives a chunk of the group to a member, called with the mutex of the member locked
+// the chunks a member references are capped to the size of its buffer: a member that cannot keep up overflows,
+// stops getting chunks and is disconnected, releasing the chunks it has not sent
+static void sender_fan_out_share_unsafe(struct sender_state *m, struct sender_chunk *shared, size_t bytes) {
+    if(unlikely(m->flags & SENDER_FLAG_OVERFLOW))
+        return;
+
+    if(sender_buffered_bytes_unsafe(m) + bytes > m->buffer->max_size) {
+        m->flags |= SENDER_FLAG_OVERFLOW;
+        return;
+    }
+
+    if(!(m->flags & SENDER_FLAG_ZERO_COPY)) {
+        if(cbuffer_add_unsafe(m->buffer, buffer_tostring(shared->wb), bytes))
+            m->flags |= SENDER_FLAG_OVERFLOW;
+        return;
+    }
+
+    struct sender_chunk *c = sender_chunk_get_unsafe(m);
+    c->shared = shared;
+    __atomic_add_fetch(&shared->refcount, 1, __ATOMIC_RELAXED);
+    sender_chunk_append_unsafe(m, c, bytes);
+}
+
+// the collector commits to the group, the mutex of the group is never held while locking a member
+// called with the group read locked by sender_start(), it unlocks it
+static void sender_fan_out_commit(struct sender_state *group, BUFFER *wb) {
+    size_t bytes = buffer_strlen(wb);
+
+    netdata_mutex_lock(&group->mutex);
+    sender_fan_out_recycle_unsafe(group);
+
+    struct sender_chunk *c = sender_chunk_get_unsafe(group);
+
+    // NULL for a new chunk, sender_start() will create a buffer
+    sender_thread_buffer = c->wb;
+    c->wb = wb;
+
+    // our own reference, so that it is not recycled before it is given to all the members
+    c->refcount = 1;
+
+    if(group->fan_out.shared_tail)
+        group->fan_out.shared_tail->next = c;
+    else
+        group->fan_out.shared_head = c;
+    group->fan_out.shared_tail = c;
+    netdata_mutex_unlock(&group->mutex);
+
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next) {
+        if(!__atomic_load_n(&m->fan_out.connected, __ATOMIC_ACQUIRE))
+            continue;
+
+        netdata_mutex_lock(&m->mutex);
+        sender_fan_out_share_unsafe(m, c, bytes);
+        netdata_mutex_unlock(&m->mutex);
+    }
+
+    __atomic_sub_fetch(&c->refcount, 1, __ATOMIC_RELEASE);
+    sender_thread_buffer_release_group();
+
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next) {
+        if(__atomic_load_n(&m->fan_out.connected, __ATOMIC_ACQUIRE))
+            rrdpush_signal_sender_to_wake_up(m);
+    }
+}
+
+// the host is connected and ready when any of the members is, called with the mutex of the group locked
+// the capabilities of the group are recalculated only when a member joins
+static void sender_fan_out_update_host_unsafe(struct sender_state *group, bool joined) {
+    STREAM_CAPABILITIES capabilities = STREAM_OUR_CAPABILITIES;
+    bool connected = false, ready = false;
+
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next) {
+        if(m->fan_out.connected) {
+            capabilities &= m->capabilities;
+            connected = true;
+        }
+
+        if(m->fan_out.ready)
+            ready = true;
+    }
+
+    if(connected) {
+        if(joined)
+            group->capabilities = capabilities;
+        rrdhost_flag_set(group->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+    }
+    else
+        rrdhost_flag_clear(group->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+
+    if(ready)
+        rrdhost_flag_set(group->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+    else
+        rrdhost_flag_clear(group->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+}
+
+// the sender is connected to its parent and the collectors can send definitions, or it is not
+static void rrdpush_sender_set_connected(struct sender_state *s, bool connected) {
+    if(likely(!s->fan_out.group)) {
+        if(connected)
+            rrdhost_flag_set(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+        else {
+            rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+            rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+        }
+        return;
+    }
+
+    struct sender_state *group = s->fan_out.group;
+    netdata_mutex_lock(&group->mutex);
+    __atomic_store_n(&s->fan_out.connected, connected, __ATOMIC_RELEASE);
+    if(!connected)
+        s->fan_out.ready = false;
+    sender_fan_out_update_host_unsafe(group, connected);
+    netdata_mutex_unlock(&group->mutex);
+}
+
+// the sender has sent the definitions and the collectors can send metrics
+static void rrdpush_sender_set_ready(struct sender_state *s) {
+    if(likely(!s->fan_out.group)) {
+        rrdhost_flag_set(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+        return;
+    }
+
+    struct sender_state *group = s->fan_out.group;
+    netdata_mutex_lock(&group->mutex);
+    s->fan_out.ready = true;
+    sender_fan_out_update_host_unsafe(group, false);
+    netdata_mutex_unlock(&group->mutex);
+}
+
+static inline bool rrdpush_sender_is_connected(struct sender_state *s) {
+    if(likely(!s->fan_out.group))
+        return rrdhost_flag_check(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+
+    return __atomic_load_n(&s->fan_out.connected, __ATOMIC_ACQUIRE);
+}
+
+static inline bool rrdpush_sender_is_ready(struct sender_state *s) {
+    if(likely(!s->fan_out.group))
+        return rrdhost_flag_check(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
+
+    netdata_mutex_lock(&s->fan_out.group->mutex);
+    bool ready = s->fan_out.ready;
+    netdata_mutex_unlock(&s->fan_out.group->mutex);
+    return ready;
+}
+
+// the destination the sender connects to
+static inline struct rrdpush_destinations *sender_destination(struct sender_state *s) {
+    return s->fan_out.group ? s->fan_out.destination : s->host->destination;
 }
 
-static inline void rrdpush_sender_thread_close_socket(RRDHOST *host);
+static inline void rrdpush_sender_thread_close_socket(struct sender_state *s);
+
+#ifdef __linux__
+static void rrdpush_sender_dispatcher_forget_socket(struct sender_state *s);
+static void rrdpush_sender_dispatcher_queue(struct sender_state *s);
+#endif
 
 #ifdef ENABLE_COMPRESSION
 /*
@@ -71,7 +410,7 @@ static inline void deactivate_compression(struct sender_state *s) {
     error("STREAM_COMPRESSION: Compression returned error, disabling it.");
     s->flags &= ~SENDER_FLAG_COMPRESSION;
     error("STREAM %s [send to %s]: Restarting connection without compression.", rrdhost_hostname(s->host), s->connected_to);
-    rrdpush_sender_thread_close_socket(s->host);
+    rrdpush_sender_thread_close_socket(s);
 }
 #endif
 
@@ -89,13 +428,36 @@ void sender_commit(struct sender_state *s, BUFFER *wb) {
     char *src = (char *)buffer_tostring(wb);
     size_t src_len = buffer_strlen(wb);
 
-    if(unlikely(!src || !src_len))
+    if(unlikely(!src || !src_len)) {
+        sender_thread_buffer_release_group();
+        return;
+    }
+
+    if(unlikely(sender_thread_buffer_group)) {
+        sender_fan_out_commit(s, wb);
         return;
+    }
 
     netdata_mutex_lock(&s->mutex);
 
+    if(s->flags & SENDER_FLAG_ZERO_COPY) {
+        if(sender_buffered_bytes_unsafe(s) + src_len > s->buffer->max_size)
+            s->flags |= SENDER_FLAG_OVERFLOW;
+        else
+            sender_chunk_commit_unsafe(s, wb);
+
+        netdata_mutex_unlock(&s->mutex);
+        rrdpush_signal_sender_to_wake_up(s);
+        return;
+    }
+
 #ifdef ENABLE_COMPRESSION
     if (s->flags & SENDER_FLAG_COMPRESSION && s->compressor) {
+        if(s->compressor->adapt) {
+            struct circular_buffer *cb = s->buffer;
+            s->compressor->adapt(s->compressor, cb->max_size - cbuffer_available_size_unsafe(cb), cb->max_size);
+        }
+
         while(src_len) {
             size_t size_to_compress = src_len;
 
@@ -132,17 +494,17 @@ void sender_commit(struct sender_state *s, BUFFER *wb) {
                 }
             }
 
-            if(cbuffer_add_unsafe(s->host->sender->buffer, dst, dst_len))
+            if(cbuffer_add_unsafe(s->buffer, dst, dst_len))
                 s->flags |= SENDER_FLAG_OVERFLOW;
 
             src = src + size_to_compress;
             src_len -= size_to_compress;
         }
     }
-    else if(cbuffer_add_unsafe(s->host->sender->buffer, src, src_len))
+    else if(cbuffer_add_unsafe(s->buffer, src, src_len))
         s->flags |= SENDER_FLAG_OVERFLOW;
 #else
-    if(cbuffer_add_unsafe(s->host->sender->buffer, src, src_len))
+    if(cbuffer_add_unsafe(s->buffer, src, src_len))
         s->flags |= SENDER_FLAG_OVERFLOW;
 #endif
 
@@ -151,13 +513,31 @@ void sender_commit(struct sender_state *s, BUFFER *wb) {
 }
 
 
-static inline void rrdpush_sender_thread_close_socket(RRDHOST *host) {
-    rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-    rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+static inline void rrdpush_sender_thread_close_socket(struct sender_state *s) {
+    rrdpush_sender_set_connected(s, false);
+
+#ifdef __linux__
+    if(s->dispatch.socket != -1)
+        rrdpush_sender_dispatcher_forget_socket(s);
+#endif
+
+    if(s->rrdpush_sender_socket != -1) {
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+        netdata_mutex_lock(&s->mutex);
+        bool inflight = (s->zero_copy.inflight_head != NULL);
+        netdata_mutex_unlock(&s->mutex);
+
+        // a graceful close() keeps sending the queue of the socket, from the pages of the chunks
+        // in flight - so we abort the connection, which discards the queue, before recycling them
+        if(inflight) {
+            struct linger linger = { .l_onoff = 1, .l_linger = 0 };
+            if(setsockopt(s->rrdpush_sender_socket, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)) != 0)
+                error("STREAM %s [send to %s]: cannot set SO_LINGER on socket %d.", rrdhost_hostname(s->host), s->connected_to, s->rrdpush_sender_socket);
+        }
+#endif
 
-    if(host->sender->rrdpush_sender_socket != -1) {
-        close(host->sender->rrdpush_sender_socket);
-        host->sender->rrdpush_sender_socket = -1;
+        close(s->rrdpush_sender_socket);
+        s->rrdpush_sender_socket = -1;
     }
 }
 
@@ -210,14 +590,246 @@ static void rrdpush_sender_thread_send_custom_host_variables(RRDHOST *host) {
     }
 }
 
+// ----------------------------------------------------------------------------
+// replication
+
+struct replication_dimension {
+    const DICTIONARY_ITEM *item;
+    RRDDIM *rd;
+    struct rrddim_query_handle handle;
+    STORAGE_POINT sp;
+    bool enabled;
+};
+
+static void replication_request_free(struct sender_state *s, struct replication_request *r) {
+    DOUBLE_LINKED_LIST_REMOVE_UNSAFE(s->replication.requests, r, prev, next);
+    string_freez(r->chart_id);
+    freez(r);
+}
+
+static void replication_requests_free(struct sender_state *s) {
+    while(s->replication.requests)
+        replication_request_free(s, s->replication.requests);
+}
+
+// the parent answered the CHART_DEFINITION_END of a chart with the time range it misses
+static void replication_add_request(struct sender_state *s, const char *chart_id, time_t after, time_t before) {
+    RRDSET *st = rrdset_find(s->host, chart_id);
+    if(unlikely(!st)) {
+        error("STREAM %s [send to %s]: cannot find chart '%s' to replicate.", rrdhost_hostname(s->host), s->connected_to, chart_id);
+        return;
+    }
+
+    // a definition sent again while the chart is replicated, the request in progress covers it
+    struct replication_request *r;
+    for(r = s->replication.requests; r ; r = r->next)
+        if(r->chart_id == st->id)
+            return;
+
+    if(!after || !before || after > before) {
+        // the parent does not miss anything, resume streaming the metrics of the chart
+        rrdset_flag_clear(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS);
+        return;
+    }
+
+    r = callocz(1, sizeof(struct replication_request));
+    r->chart_id = string_dup(st->id);
+    r->after = after;
+    r->before = before;
+    DOUBLE_LINKED_LIST_APPEND_UNSAFE(s->replication.requests, r, prev, next);
+}
+
+static void replication_dimension_next(struct replication_dimension *x, time_t before) {
+    struct rrddim_tier *t = x->rd->tiers[0];
+
+    if(t->query_ops.is_finished(&x->handle)) {
+        x->enabled = false;
+        return;
+    }
+
+    x->sp = t->query_ops.next_metric(&x->handle);
+    x->enabled = x->sp.end_time && x->sp.end_time <= before;
+}
+
+static inline void replication_print_double(BUFFER *wb, NETDATA_DOUBLE value) {
+    if(unlikely(!netdata_double_isnumber(value)))
+        buffer_strcat(wb, " nan");
+    else
+        buffer_sprintf(wb, " " NETDATA_DOUBLE_FORMAT, value);
+}
+
+// the collection state of the chart, for the parent to continue from it
+static void replication_send_chart_state(BUFFER *wb, RRDSET *st) {
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        if(unlikely(!rd->exposed))
+            continue;
+
+        buffer_sprintf(wb, "REPLAY_RRDDIM_STATE \"%s\" %llu " COLLECTED_NUMBER_FORMAT
+                       , rrddim_id(rd)
+                       , (unsigned long long)rd->last_collected_time.tv_sec * USEC_PER_SEC + rd->last_collected_time.tv_usec
+                       , rd->last_collected_value);
+        replication_print_double(wb, rd->last_calculated_value);
+        replication_print_double(wb, rd->last_stored_value);
+        buffer_strcat(wb, "\n");
+    }
+    rrddim_foreach_done(rd);
+
+    buffer_sprintf(wb, "REPLAY_RRDSET_STATE %llu %llu\n"
+                   , (unsigned long long)st->last_collected_time.tv_sec * USEC_PER_SEC + st->last_collected_time.tv_usec
+                   , (unsigned long long)st->last_updated.tv_sec * USEC_PER_SEC + st->last_updated.tv_usec);
+}
+
+// sends the next points of a replicated chart, returns the bytes committed to the buffer
+static size_t replication_execute_step(struct sender_state *s, struct replication_request *r) {
+    RRDSET *st = rrdset_find(s->host, string2str(r->chart_id));
+    if(unlikely(!st)) {
+        replication_request_free(s, r);
+        return 0;
+    }
+
+    time_t before = r->after + (time_t)(default_rrdpush_replication_step - 1) * st->update_every;
+    if(before > r->before)
+        before = r->before;
+
+    // a step may not fill the buffer, the check of the caller leaves room for it
+    size_t max_bytes = s->buffer->max_size / 4;
+
+    BUFFER *wb = sender_start(s);
+    buffer_sprintf(wb, "REPLAY_BEGIN \"%s\"\n", rrdset_id(st));
+
+    size_t dimensions = rrdset_number_of_dimensions(st), d = 0;
+    struct replication_dimension *data = callocz(dimensions ? dimensions : 1, sizeof(struct replication_dimension));
+
+    RRDDIM *rd;
+    rrddim_foreach_read(rd, st) {
+        if(unlikely(d >= dimensions))
+            break;
+
+        if(unlikely(!rd->exposed || !rd->tiers[0] || rrddim_flag_check(rd, RRDDIM_FLAG_ARCHIVED)))
+            continue;
+
+        struct replication_dimension *x = &data[d++];
+        x->item = dictionary_acquired_item_dup(st->rrddim_root_index, rd_dfe.item);
+        x->rd = dictionary_acquired_item_value(x->item);
+        x->rd->tiers[0]->query_ops.init(x->rd->tiers[0]->db_metric_handle, &x->handle, r->after, before, TIER_QUERY_FETCH_SUM);
+        replication_dimension_next(x, before);
+    }
+    rrddim_foreach_done(rd);
+    dimensions = d;
+
+    // the dimensions are queried together, to send their points row by row
+    time_t next_after = before + 1;
+    for(;;) {
+        time_t t = 0;
+        for(d = 0; d < dimensions ; d++) {
+            if(data[d].enabled && (!t || data[d].sp.end_time < t))
+                t = data[d].sp.end_time;
+        }
+
+        if(!t)
+            break;
+
+        if(unlikely(buffer_strlen(wb) > max_bytes)) {
+            next_after = t;
+            break;
+        }
+
+        bool point_sent = false;
+        for(d = 0; d < dimensions ; d++) {
+            struct replication_dimension *x = &data[d];
+            if(!x->enabled || x->sp.end_time != t)
+                continue;
+
+            if(t >= r->after && !storage_point_is_empty(x->sp)) {
+                if(!point_sent) {
+                    buffer_sprintf(wb, "REPLAY_POINT %"PRId64"\n", (int64_t)t);
+                    point_sent = true;
+                }
+
+                buffer_sprintf(wb, "REPLAY_SET \"%s\" " NETDATA_DOUBLE_FORMAT " \"%s%s\"\n"
+                               , rrddim_id(x->rd)
+                               , x->sp.sum / (NETDATA_DOUBLE)x->sp.count
+                               , (x->sp.flags & SN_FLAG_RESET) ? "R" : ""
+                               , x->sp.anomaly_count ? "A" : "");
+            }
+
+            replication_dimension_next(x, before);
+        }
+    }
+
+    for(d = 0; d < dimensions ; d++) {
+        data[d].rd->tiers[0]->query_ops.finalize(&data[d].handle);
+        dictionary_acquired_item_release(st->rrddim_root_index, data[d].item);
+    }
+    freez(data);
+
+    r->after = next_after;
+
+    bool finished = false;
+    if(r->after > r->before) {
+        time_t first_entry_t, last_entry_t;
+        rrdpush_replication_chart_retention(st, &first_entry_t, &last_entry_t);
+
+        if(last_entry_t >= r->after)
+            // the chart has been collected meanwhile, replicate these points too
+            r->before = last_entry_t;
+        else {
+            replication_send_chart_state(wb, st);
+            finished = true;
+        }
+    }
+
+    buffer_strcat(wb, "REPLAY_END\n");
+    size_t bytes = buffer_strlen(wb);
+    sender_commit(s, wb);
+
+    if(finished) {
+        // the metrics collected from now on follow the replicated points in the buffer
+        rrdset_flag_clear(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS);
+        replication_request_free(s, r);
+    }
+
+    return bytes;
+}
+
+// sends replication steps while the buffer has room for them and the speed limit allows it
+static void rrdpush_sender_replicate(struct sender_state *s) {
+    while(s->replication.requests && rrdpush_sender_is_connected(s)) {
+        netdata_mutex_lock(&s->mutex);
+        size_t available = s->buffer->max_size - sender_buffered_bytes_unsafe(s);
+        netdata_mutex_unlock(&s->mutex);
+
+        if(available < s->buffer->max_size / 2)
+            break;
+
+        time_t now = now_monotonic_sec();
+        if(now != s->replication.second) {
+            s->replication.second = now;
+            s->replication.bytes = 0;
+        }
+
+        if(default_rrdpush_replication_max_bytes_per_sec && s->replication.bytes >= default_rrdpush_replication_max_bytes_per_sec)
+            break;
+
+        s->replication.bytes += replication_execute_step(s, s->replication.requests);
+    }
+}
+
 // resets all the chart, so that their definitions
 // will be resent to the central netdata
 static void rrdpush_sender_thread_reset_all_charts(RRDHOST *host) {
+    // the charts get new binary slots when they are defined again,
+    // so that the slots of the charts deleted meanwhile are reused
+    __atomic_store_n(&host->sender->binary_chart_slots, 0, __ATOMIC_RELAXED);
+
     RRDSET *st;
     rrdset_foreach_read(st, host) {
         rrdset_flag_clear(st, RRDSET_FLAG_UPSTREAM_EXPOSED);
 
+        rrdset_flag_clear(st, RRDSET_FLAG_SENDER_REPLICATION_IN_PROGRESS);
         st->upstream_resync_time = 0;
+        st->upstream_slot = 0;
 
         RRDDIM *rd;
         rrddim_foreach_read(rd, st)
@@ -227,12 +839,34 @@ static void rrdpush_sender_thread_reset_all_charts(RRDHOST *host) {
     rrdset_foreach_done(st);
 }
 
-static inline void rrdpush_sender_thread_data_flush(RRDHOST *host) {
-    netdata_mutex_lock(&host->sender->mutex);
-    cbuffer_flush(host->sender->buffer);
-    netdata_mutex_unlock(&host->sender->mutex);
+// the member starts getting the chunks of the group and resets the charts, while the collectors do not serialize
+// anything, so that it does not get metrics of charts it has not got the definitions of, or data serialized with
+// capabilities it does not have
+static void sender_fan_out_join(struct sender_state *m) {
+    struct sender_state *group = m->fan_out.group;
+
+    netdata_rwlock_wrlock(&group->fan_out.serializing);
+    rrdpush_sender_set_connected(m, true);
+    rrdpush_sender_thread_reset_all_charts(m->host);
+    netdata_rwlock_unlock(&group->fan_out.serializing);
+}
+
+static inline void rrdpush_sender_thread_data_flush(struct sender_state *s) {
+    RRDHOST *host = s->host;
+
+    netdata_mutex_lock(&s->mutex);
+    cbuffer_flush(s->buffer);
+    sender_chunks_flush_unsafe(s);
+    netdata_mutex_unlock(&s->mutex);
+
+    replication_requests_free(s);
+
+    // in fan out mode, the parents connected before get the definitions again too
+    if(s->fan_out.group)
+        sender_fan_out_join(s);
+    else
+        rrdpush_sender_thread_reset_all_charts(host);
 
-    rrdpush_sender_thread_reset_all_charts(host);
     rrdpush_sender_thread_send_custom_host_variables(host);
 }
 
@@ -362,9 +996,9 @@ static inline bool rrdpush_sender_validate_response(RRDHOST *host, struct sender
     time_t delay = stream_responses[i].postpone_reconnect_seconds;
 
     if(version >= STREAM_HANDSHAKE_OK_V1) {
-        host->destination->last_error = NULL;
-        host->destination->last_handshake = version;
-        host->destination->postpone_reconnection_until = 0;
+        sender_destination(s)->last_error = NULL;
+        sender_destination(s)->last_handshake = version;
+        sender_destination(s)->postpone_reconnection_until = 0;
         s->capabilities = convert_stream_version_to_capabilities(version);
         return true;
     }
@@ -372,10 +1006,10 @@ static inline bool rrdpush_sender_validate_response(RRDHOST *host, struct sender
     error("STREAM %s [send to %s]: %s.", rrdhost_hostname(host), s->connected_to, error);
 
     worker_is_busy(worker_job_id);
-    rrdpush_sender_thread_close_socket(host);
-    host->destination->last_error = error;
-    host->destination->last_handshake = version;
-    host->destination->postpone_reconnection_until = now_realtime_sec() + delay;
+    rrdpush_sender_thread_close_socket(s);
+    sender_destination(s)->last_error = error;
+    sender_destination(s)->last_handshake = version;
+    sender_destination(s)->postpone_reconnection_until = now_realtime_sec() + delay;
     return false;
 }
 
@@ -387,20 +1021,32 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
     };
 
     // make sure the socket is closed
-    rrdpush_sender_thread_close_socket(host);
-
-    s->rrdpush_sender_socket = connect_to_one_of_destinations(
-              host
-            , default_port
-            , &tv
-            , &s->reconnects_counter
-            , s->connected_to
-            , sizeof(s->connected_to)-1
-            , &host->destination
-    );
+    rrdpush_sender_thread_close_socket(s);
+
+    if(s->fan_out.group)
+        s->rrdpush_sender_socket = connect_to_destination(
+                  host
+                , s->fan_out.destination
+                , default_port
+                , &tv
+                , &s->reconnects_counter
+                , s->connected_to
+                , sizeof(s->connected_to)-1
+        );
+    else
+        s->rrdpush_sender_socket = connect_to_one_of_destinations(
+                  host
+                , default_port
+                , &tv
+                , &s->reconnects_counter
+                , s->connected_to
+                , sizeof(s->connected_to)-1
+                , &host->destination
+        );
 
     if(unlikely(s->rrdpush_sender_socket == -1)) {
-        error("STREAM %s [send to %s]: could not connect to parent node at this time.", rrdhost_hostname(host), host->rrdpush_send_destination);
+        error("STREAM %s [send to %s]: could not connect to parent node at this time.", rrdhost_hostname(host),
+              s->fan_out.group ? string2str(s->fan_out.destination->destination) : host->rrdpush_send_destination);
         return false;
     }
 
@@ -408,30 +1054,30 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
 #ifdef ENABLE_HTTPS
     if(netdata_ssl_client_ctx){
-        host->sender->ssl.flags = NETDATA_SSL_START;
-        if (!host->sender->ssl.conn){
-            host->sender->ssl.conn = SSL_new(netdata_ssl_client_ctx);
-            if(!host->sender->ssl.conn){
+        s->ssl.flags = NETDATA_SSL_START;
+        if (!s->ssl.conn){
+            s->ssl.conn = SSL_new(netdata_ssl_client_ctx);
+            if(!s->ssl.conn){
                 error("Failed to allocate SSL structure.");
-                host->sender->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
+                s->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
             }
         }
         else{
-            SSL_clear(host->sender->ssl.conn);
+            SSL_clear(s->ssl.conn);
         }
 
-        if (host->sender->ssl.conn)
+        if (s->ssl.conn)
         {
-            if (SSL_set_fd(host->sender->ssl.conn, s->rrdpush_sender_socket) != 1) {
+            if (SSL_set_fd(s->ssl.conn, s->rrdpush_sender_socket) != 1) {
                 error("Failed to set the socket to the SSL on socket fd %d.", s->rrdpush_sender_socket);
-                host->sender->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
+                s->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
             } else{
-                host->sender->ssl.flags = NETDATA_SSL_HANDSHAKE_COMPLETE;
+                s->ssl.flags = NETDATA_SSL_HANDSHAKE_COMPLETE;
             }
         }
     }
     else {
-        host->sender->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
+        s->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
     }
 #endif
 
@@ -442,8 +1088,19 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
     // If we don't want compression, remove it from our capabilities
     if(!(s->flags & SENDER_FLAG_COMPRESSION) && stream_has_capability(s, STREAM_CAP_COMPRESSION))
         s->capabilities &= ~STREAM_CAP_COMPRESSION;
+
+    // offer zstd only when we want it
+    if(!stream_has_capability(s, STREAM_CAP_COMPRESSION) || default_compression_algorithm != STREAM_CAP_ZSTD)
+        s->capabilities &= ~STREAM_CAP_ZSTD;
 #endif  // ENABLE_COMPRESSION
 
+    if(!default_rrdpush_binary_enabled)
+        s->capabilities &= ~STREAM_CAP_BINARY;
+
+    // the parents of a fan out group get the same stream, each parent would replicate different charts
+    if(!default_rrdpush_replication_enabled || s->fan_out.group)
+        s->capabilities &= ~STREAM_CAP_REPLICATION;
+
     /* TODO: During the implementation of #7265 switch the set of variables to HOST_* and CONTAINER_* if the
              version negotiation resulted in a high enough version.
     */
@@ -549,35 +1206,35 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
     rrdpush_clean_encoded(&se);
 
 #ifdef ENABLE_HTTPS
-    if (!host->sender->ssl.flags) {
+    if (!s->ssl.flags) {
         ERR_clear_error();
-        SSL_set_connect_state(host->sender->ssl.conn);
-        int err = SSL_connect(host->sender->ssl.conn);
+        SSL_set_connect_state(s->ssl.conn);
+        int err = SSL_connect(s->ssl.conn);
         if (err != 1){
-            err = SSL_get_error(host->sender->ssl.conn, err);
-            error("SSL cannot connect with the server:  %s ",ERR_error_string((long)SSL_get_error(host->sender->ssl.conn,err),NULL));
+            err = SSL_get_error(s->ssl.conn, err);
+            error("SSL cannot connect with the server:  %s ",ERR_error_string((long)SSL_get_error(s->ssl.conn,err),NULL));
             if (netdata_use_ssl_on_stream == NETDATA_SSL_FORCE) {
                 worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SSL_ERROR);
-                rrdpush_sender_thread_close_socket(host);
-                host->destination->last_error = "SSL error";
-                host->destination->last_handshake = STREAM_HANDSHAKE_ERROR_SSL_ERROR;
-                host->destination->postpone_reconnection_until = now_realtime_sec() + 5 * 60;
+                rrdpush_sender_thread_close_socket(s);
+                sender_destination(s)->last_error = "SSL error";
+                sender_destination(s)->last_handshake = STREAM_HANDSHAKE_ERROR_SSL_ERROR;
+                sender_destination(s)->postpone_reconnection_until = now_realtime_sec() + 5 * 60;
                 return false;
             }
             else {
-                host->sender->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
+                s->ssl.flags = NETDATA_SSL_NO_HANDSHAKE;
             }
         }
         else {
             if (netdata_use_ssl_on_stream == NETDATA_SSL_FORCE) {
                 if (netdata_ssl_validate_server == NETDATA_SSL_VALID_CERTIFICATE) {
-                    if ( security_test_certificate(host->sender->ssl.conn)) {
+                    if ( security_test_certificate(s->ssl.conn)) {
                         worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SSL_ERROR);
                         error("Closing the stream connection, because the server SSL certificate is not valid.");
-                        rrdpush_sender_thread_close_socket(host);
-                        host->destination->last_error = "invalid SSL certificate";
-                        host->destination->last_handshake = STREAM_HANDSHAKE_ERROR_INVALID_CERTIFICATE;
-                        host->destination->postpone_reconnection_until = now_realtime_sec() + 5 * 60;
+                        rrdpush_sender_thread_close_socket(s);
+                        sender_destination(s)->last_error = "invalid SSL certificate";
+                        sender_destination(s)->last_handshake = STREAM_HANDSHAKE_ERROR_INVALID_CERTIFICATE;
+                        sender_destination(s)->postpone_reconnection_until = now_realtime_sec() + 5 * 60;
                         return false;
                     }
                 }
@@ -590,7 +1247,7 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
     bytes = send_timeout(
 #ifdef ENABLE_HTTPS
-        &host->sender->ssl,
+        &s->ssl,
 #endif
         s->rrdpush_sender_socket,
         http,
@@ -600,11 +1257,11 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
     if(bytes <= 0) { // timeout is 0
         worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
-        rrdpush_sender_thread_close_socket(host);
+        rrdpush_sender_thread_close_socket(s);
         error("STREAM %s [send to %s]: failed to send HTTP header to remote netdata.", rrdhost_hostname(host), s->connected_to);
-        host->destination->last_error = "timeout while sending request";
-        host->destination->last_handshake = STREAM_HANDSHAKE_ERROR_SEND_TIMEOUT;
-        host->destination->postpone_reconnection_until = now_realtime_sec() + 1 * 60;
+        sender_destination(s)->last_error = "timeout while sending request";
+        sender_destination(s)->last_handshake = STREAM_HANDSHAKE_ERROR_SEND_TIMEOUT;
+        sender_destination(s)->postpone_reconnection_until = now_realtime_sec() + 1 * 60;
         return false;
     }
 
@@ -612,7 +1269,7 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
     bytes = recv_timeout(
 #ifdef ENABLE_HTTPS
-        &host->sender->ssl,
+        &s->ssl,
 #endif
         s->rrdpush_sender_socket,
         http,
@@ -622,11 +1279,11 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
     if(bytes <= 0) { // timeout is 0
         worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
-        rrdpush_sender_thread_close_socket(host);
+        rrdpush_sender_thread_close_socket(s);
         error("STREAM %s [send to %s]: remote netdata does not respond.", rrdhost_hostname(host), s->connected_to);
-        host->destination->last_error = "timeout while expecting first response";
-        host->destination->last_handshake = STREAM_HANDSHAKE_ERROR_RECEIVE_TIMEOUT;
-        host->destination->postpone_reconnection_until = now_realtime_sec() + 30;
+        sender_destination(s)->last_error = "timeout while expecting first response";
+        sender_destination(s)->last_handshake = STREAM_HANDSHAKE_ERROR_RECEIVE_TIMEOUT;
+        sender_destination(s)->postpone_reconnection_until = now_realtime_sec() + 30;
         return false;
     }
 
@@ -644,8 +1301,18 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
         s->flags &= ~SENDER_FLAG_COMPRESSION;
 
     if(s->flags & SENDER_FLAG_COMPRESSION) {
-        if(s->compressor)
+        // the parent decides between lz4 and zstd
+        STREAM_CAPABILITIES algorithm = stream_has_capability(s, STREAM_CAP_ZSTD) ? STREAM_CAP_ZSTD : STREAM_CAP_COMPRESSION;
+
+        netdata_mutex_lock(&s->mutex);
+        if(s->compressor && s->compressor->algorithm != algorithm)
+            s->compressor->destroy(&s->compressor);
+
+        if(!s->compressor)
+            s->compressor = create_compressor(algorithm);
+        else
             s->compressor->reset(s->compressor);
+        netdata_mutex_unlock(&s->mutex);
     }
     else
         info("STREAM %s [send to %s]: compression is disabled on this connection.", rrdhost_hostname(host), s->connected_to);
@@ -654,6 +1321,27 @@ static bool rrdpush_sender_thread_connect_to_parent(RRDHOST *host, int default_p
 
     log_sender_capabilities(s);
 
+    // a new parent asks for throttling by itself, if it needs it
+    __atomic_store_n(&s->throttled_until, 0, __ATOMIC_RELAXED);
+
+    // the buffers of the collectors can be sent as they are
+    netdata_mutex_lock(&s->mutex);
+    s->flags &= ~SENDER_FLAG_ZERO_COPY;
+    s->zero_copy.msg_zerocopy = false;
+    if(default_rrdpush_zero_copy_enabled && !(s->flags & SENDER_FLAG_COMPRESSION)
+#ifdef ENABLE_HTTPS
+       && !(s->ssl.conn && s->ssl.flags == NETDATA_SSL_HANDSHAKE_COMPLETE)
+#endif
+        ) {
+        s->flags |= SENDER_FLAG_ZERO_COPY;
+
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+        int enable = 1;
+        s->zero_copy.msg_zerocopy = (setsockopt(s->rrdpush_sender_socket, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0);
+#endif
+    }
+    netdata_mutex_unlock(&s->mutex);
+
     if(sock_setnonblock(s->rrdpush_sender_socket) < 0)
         error("STREAM %s [send to %s]: cannot set non-blocking mode for socket.", rrdhost_hostname(host), s->connected_to);
 
@@ -673,7 +1361,7 @@ static bool attempt_to_connect(struct sender_state *state)
         state->last_sent_t = now_monotonic_sec();
 
         // reset the buffer, to properly send charts and metrics
-        rrdpush_sender_thread_data_flush(state->host);
+        rrdpush_sender_thread_data_flush(state);
 
         // send from the beginning
         state->begin = 0;
@@ -684,8 +1372,9 @@ static bool attempt_to_connect(struct sender_state *state)
         // reset the bytes we have sent for this session
         state->sent_bytes_on_this_connection = 0;
 
-        // let the data collection threads know we are ready
-        rrdhost_flag_set(state->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+        // let the data collection threads know we are ready, fan out members have joined their group already
+        if(!state->fan_out.group)
+            rrdpush_sender_set_connected(state, true);
 
         return true;
     }
@@ -698,37 +1387,203 @@ static bool attempt_to_connect(struct sender_state *state)
     // reset the number of bytes sent
     state->sent_bytes_on_this_connection = 0;
 
-    // slow re-connection on repeating errors
-    sleep_usec(USEC_PER_SEC * state->reconnect_delay); // seconds
-
     return false;
 }
 
-// TCP window is open and we have data to transmit.
-static ssize_t attempt_to_send(struct sender_state *s) {
-    ssize_t ret = 0;
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+// marks the MSG_ZEROCOPY sends from lo to hi as completed, and recycles the chunks the kernel does not need
+static void sender_zerocopy_completed(struct sender_state *s, uint32_t lo, uint32_t hi) {
+    if(hi - lo >= SENDER_ZEROCOPY_MAX_INFLIGHT)
+        hi = lo + SENDER_ZEROCOPY_MAX_INFLIGHT - 1;
+
+    // completions may be reported out of order
+    for(uint32_t seq = lo; (int32_t)(hi - seq) >= 0; seq++) {
+        uint32_t ahead = seq - s->zero_copy.completed_seq;
+        if(ahead < SENDER_ZEROCOPY_MAX_INFLIGHT)
+            s->zero_copy.completed_ahead |= (1ULL << ahead);
+    }
 
-#ifdef NETDATA_INTERNAL_CHECKS
-    struct circular_buffer *cb = s->buffer;
-#endif
+    while(s->zero_copy.completed_ahead & 1) {
+        s->zero_copy.completed_ahead >>= 1;
+        s->zero_copy.completed_seq++;
+    }
 
     netdata_mutex_lock(&s->mutex);
-    char *chunk;
-    size_t outstanding = cbuffer_next_unsafe(s->buffer, &chunk);
-    debug(D_STREAM, "STREAM: Sending data. Buffer r=%zu w=%zu s=%zu, next chunk=%zu", cb->read, cb->write, cb->size, outstanding);
-
+    struct sender_chunk *c;
+    while((c = s->zero_copy.inflight_head) && (int32_t)(c->zerocopy_seq - s->zero_copy.completed_seq) < 0) {
+        s->zero_copy.inflight_head = c->next;
+        if(!s->zero_copy.inflight_head)
+            s->zero_copy.inflight_tail = NULL;
+        sender_chunk_recycle_unsafe(s, c);
+    }
+    netdata_mutex_unlock(&s->mutex);
+}
+
+// reads the MSG_ZEROCOPY completions from the error queue of the socket
+static void sender_zerocopy_read_completions(struct sender_state *s) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+
+    for(;;) {
+        struct msghdr msg = {
+            .msg_control = control,
+            .msg_controllen = sizeof(control),
+        };
+
+        if(recvmsg(s->rrdpush_sender_socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+            break;
+
+        for(struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if(!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                 (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                continue;
+
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if(serr->ee_errno == 0 && serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+                sender_zerocopy_completed(s, serr->ee_info, serr->ee_data);
+        }
+    }
+}
+#endif
+
+// sends the queued buffers of the collectors with a single system call
+static ssize_t attempt_to_send_chunks(struct sender_state *s, size_t max_bytes) {
+    struct iovec iov[SENDER_CHUNKS_MAX_IOV];
+    size_t iovcnt = 0, bytes = 0;
+
+    // only the sender removes chunks from the queue, so they can be read without the lock
+    netdata_mutex_lock(&s->mutex);
+    size_t offset = s->zero_copy.head_sent;
+    for(struct sender_chunk *c = s->zero_copy.head; c && iovcnt < SENDER_CHUNKS_MAX_IOV && (!max_bytes || bytes < max_bytes); c = c->next) {
+        BUFFER *wb = sender_chunk_buffer(c);
+        size_t len = buffer_strlen(wb) - offset;
+        if(max_bytes && bytes + len > max_bytes)
+            len = max_bytes - bytes;
+
+        iov[iovcnt].iov_base = wb->buffer + offset;
+        iov[iovcnt].iov_len = len;
+        iovcnt++;
+        bytes += len;
+        offset = 0;
+    }
+    netdata_mutex_unlock(&s->mutex);
+
+    if(!iovcnt)
+        return 0;
+
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = iovcnt,
+    };
+
+    bool zerocopy = false;
+    int flags = MSG_DONTWAIT;
+
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+    if(s->zero_copy.msg_zerocopy) {
+        sender_zerocopy_read_completions(s);
+
+        zerocopy = (bytes >= SENDER_ZEROCOPY_MIN_BYTES &&
+                    s->zero_copy.next_seq - s->zero_copy.completed_seq < SENDER_ZEROCOPY_MAX_INFLIGHT);
+        if(zerocopy)
+            flags |= MSG_ZEROCOPY;
+    }
+#endif
+
+    ssize_t ret = sendmsg(s->rrdpush_sender_socket, &msg, flags);
+
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+    // the kernel could not pin the pages, let it copy them
+    if(ret == -1 && zerocopy && errno == ENOBUFS) {
+        zerocopy = false;
+        ret = sendmsg(s->rrdpush_sender_socket, &msg, MSG_DONTWAIT);
+    }
+#endif
+
+    if(ret <= 0)
+        return ret;
+
+    netdata_mutex_lock(&s->mutex);
+
+    uint32_t seq = s->zero_copy.next_seq;
+    if(zerocopy)
+        s->zero_copy.next_seq++;
+
+    size_t left = (size_t)ret;
+    while(left) {
+        struct sender_chunk *c = s->zero_copy.head;
+        size_t len = buffer_strlen(sender_chunk_buffer(c)) - s->zero_copy.head_sent;
+
+        if(zerocopy) {
+            c->zerocopy = true;
+            c->zerocopy_seq = seq;
+        }
+
+        if(left < len) {
+            s->zero_copy.head_sent += left;
+            break;
+        }
+
+        left -= len;
+        s->zero_copy.head = c->next;
+        if(!s->zero_copy.head)
+            s->zero_copy.tail = NULL;
+        s->zero_copy.head_sent = 0;
+
+        if(c->zerocopy) {
+            c->next = NULL;
+            if(s->zero_copy.inflight_tail)
+                s->zero_copy.inflight_tail->next = c;
+            else
+                s->zero_copy.inflight_head = c;
+            s->zero_copy.inflight_tail = c;
+        }
+        else
+            sender_chunk_recycle_unsafe(s, c);
+    }
+    s->zero_copy.bytes -= (size_t)ret;
+
+    netdata_mutex_unlock(&s->mutex);
+    return ret;
+}
+
+// TCP window is open and we have data to transmit.
+// A non-zero max_bytes limits the bytes sent, so that a dispatcher thread can serve its hosts in turns.
+static ssize_t attempt_to_send(struct sender_state *s, size_t max_bytes) {
+    ssize_t ret = 0;
+
+#ifdef NETDATA_INTERNAL_CHECKS
+    struct circular_buffer *cb = s->buffer;
+#endif
+
+    netdata_mutex_lock(&s->mutex);
+    char *chunk;
+    size_t outstanding = cbuffer_next_unsafe(s->buffer, &chunk);
+    if(max_bytes && outstanding > max_bytes)
+        outstanding = max_bytes;
+    debug(D_STREAM, "STREAM: Sending data. Buffer r=%zu w=%zu s=%zu, next chunk=%zu", cb->read, cb->write, cb->size, outstanding);
+
+    // in zero copy mode, the circular buffer has only what was committed before connecting
+    if(!outstanding && (s->flags & SENDER_FLAG_ZERO_COPY)) {
+        netdata_mutex_unlock(&s->mutex);
+        ret = attempt_to_send_chunks(s, max_bytes);
+        netdata_mutex_lock(&s->mutex);
+    }
+    else {
 #ifdef ENABLE_HTTPS
-    SSL *conn = s->host->sender->ssl.conn ;
-    if(conn && s->host->sender->ssl.flags == NETDATA_SSL_HANDSHAKE_COMPLETE)
-        ret = SSL_write(conn, chunk, outstanding);
-    else
-        ret = send(s->rrdpush_sender_socket, chunk, outstanding, MSG_DONTWAIT);
+        SSL *conn = s->ssl.conn ;
+        if(conn && s->ssl.flags == NETDATA_SSL_HANDSHAKE_COMPLETE)
+            ret = SSL_write(conn, chunk, outstanding);
+        else
+            ret = send(s->rrdpush_sender_socket, chunk, outstanding, MSG_DONTWAIT);
 #else
-    ret = send(s->rrdpush_sender_socket, chunk, outstanding, MSG_DONTWAIT);
+        ret = send(s->rrdpush_sender_socket, chunk, outstanding, MSG_DONTWAIT);
 #endif
 
+        if (likely(ret > 0))
+            cbuffer_remove_unsafe(s->buffer, ret);
+    }
+
     if (likely(ret > 0)) {
-        cbuffer_remove_unsafe(s->buffer, ret);
         s->sent_bytes_on_this_connection += ret;
         s->sent_bytes += ret;
         debug(D_STREAM, "STREAM %s [send to %s]: Sent %zd bytes", rrdhost_hostname(s->host), s->connected_to, ret);
@@ -740,7 +1595,7 @@ static ssize_t attempt_to_send(struct sender_state *s) {
         worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SEND_ERROR);
         debug(D_STREAM, "STREAM: Send failed - closing socket...");
         error("STREAM %s [send to %s]: failed to send metrics - closing connection - we have sent %zu bytes on this connection.",  rrdhost_hostname(s->host), s->connected_to, s->sent_bytes_on_this_connection);
-        rrdpush_sender_thread_close_socket(s->host);
+        rrdpush_sender_thread_close_socket(s);
     }
     else
         debug(D_STREAM, "STREAM: send() returned 0 -> no error but no transmission");
@@ -754,15 +1609,15 @@ static ssize_t attempt_read(struct sender_state *s) {
     ssize_t ret = 0;
 
 #ifdef ENABLE_HTTPS
-    if (s->host->sender->ssl.conn && s->host->sender->ssl.flags == NETDATA_SSL_HANDSHAKE_COMPLETE) {
+    if (s->ssl.conn && s->ssl.flags == NETDATA_SSL_HANDSHAKE_COMPLETE) {
         ERR_clear_error();
         int desired = sizeof(s->read_buffer) - s->read_len - 1;
-        ret = SSL_read(s->host->sender->ssl.conn, s->read_buffer, desired);
+        ret = SSL_read(s->ssl.conn, s->read_buffer, desired);
         if (ret > 0 ) {
             s->read_len += ret;
             return ret;
         }
-        int sslerrno = SSL_get_error(s->host->sender->ssl.conn, desired);
+        int sslerrno = SSL_get_error(s->ssl.conn, desired);
         if (sslerrno == SSL_ERROR_WANT_READ || sslerrno == SSL_ERROR_WANT_WRITE)
             return ret;
 
@@ -773,7 +1628,7 @@ static ssize_t attempt_read(struct sender_state *s) {
             ERR_error_string_n(err, buf, sizeof(buf));
             error("STREAM %s [send to %s] SSL error: %s", rrdhost_hostname(s->host), s->connected_to, buf);
         }
-        rrdpush_sender_thread_close_socket(s->host);
+        rrdpush_sender_thread_close_socket(s);
         return ret;
     }
 #endif
@@ -794,7 +1649,7 @@ static ssize_t attempt_read(struct sender_state *s) {
         worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_RECEIVE_ERROR);
         error("STREAM %s [send to %s]: error during receive (%zd) - closing connection.", rrdhost_hostname(s->host), s->connected_to, ret);
     }
-    rrdpush_sender_thread_close_socket(s->host);
+    rrdpush_sender_thread_close_socket(s);
 
     return ret;
 }
@@ -880,6 +1735,32 @@ void execute_commands(struct sender_state *s) {
                 }
             }
         }
+        else if(words[0] && strcmp(words[0], "REPLAY_CHART") == 0) {
+            char *chart_id = words[1];
+            char *after_txt = words[2];
+            char *before_txt = words[3];
+
+            if(!chart_id || !*chart_id || !after_txt || !before_txt)
+                error("STREAM %s [send to %s] %s command is incomplete. Ignoring it.",
+                      rrdhost_hostname(s->host), s->connected_to, words[0]);
+            else
+                replication_add_request(s, chart_id, (time_t)str2l(after_txt), (time_t)str2l(before_txt));
+        }
+        else if(words[0] && strcmp(words[0], "THROTTLE") == 0) {
+            time_t seconds = words[1] ? (time_t)str2l(words[1]) : 0;
+            if(seconds <= 0 || seconds > 3600)
+                seconds = STREAM_THROTTLE_SECONDS;
+
+            // the collectors serialize once for all the members of a group, so the group is throttled
+            struct sender_state *serializer = s->fan_out.group ? s->fan_out.group : s;
+
+            time_t now = now_realtime_sec();
+            if(__atomic_load_n(&serializer->throttled_until, __ATOMIC_RELAXED) < now)
+                error("STREAM %s [send to %s] the parent is overloaded, not sending the charts with priority %ld or above for %"PRId64" seconds.",
+                      rrdhost_hostname(s->host), s->connected_to, default_rrdpush_throttled_priority, (int64_t)seconds);
+
+            __atomic_store_n(&serializer->throttled_until, now + seconds, __ATOMIC_RELAXED);
+        }
         else
             error("STREAM %s [send to %s] received unknown command over connection: %s", rrdhost_hostname(s->host), s->connected_to, words[0]?words[0]:"(unset)");
 
@@ -909,14 +1790,14 @@ struct rrdpush_sender_thread_data {
 
 static size_t cbuffer_available_bytes_with_lock(struct rrdpush_sender_thread_data *thread_data) {
     netdata_mutex_lock(&thread_data->sender_state->mutex);
-    size_t outstanding = cbuffer_available_size_unsafe(thread_data->sender_state->host->sender->buffer);
+    size_t outstanding = cbuffer_available_size_unsafe(thread_data->sender_state->buffer);
     netdata_mutex_unlock(&thread_data->sender_state->mutex);
     return outstanding;
 }
 
 static void rrdpush_queue_incremental_definitions(struct rrdpush_sender_thread_data *thread_data) {
 
-    while(rrdhost_flag_check(thread_data->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED)
+    while(rrdpush_sender_is_connected(thread_data->sender_state)
            && thread_data->sending_definitions_status != SENDING_DEFINITIONS_DONE
            && cbuffer_available_bytes_with_lock(thread_data) > (thread_data->sender_state->buffer->max_size / 2)) {
 
@@ -977,6 +1858,13 @@ static bool rrdpush_sender_pipe_close(RRDHOST *host, int *pipe_fds, bool reopen)
 }
 
 void rrdpush_signal_sender_to_wake_up(struct sender_state *s) {
+#ifdef __linux__
+    if(__atomic_load_n(&s->dispatch.dispatcher, __ATOMIC_ACQUIRE)) {
+        rrdpush_sender_dispatcher_queue(s);
+        return;
+    }
+#endif
+
     if(unlikely(s->tid == gettid()))
         return;
 
@@ -995,57 +1883,206 @@ static void rrdpush_sender_thread_cleanup_callback(void *ptr) {
     struct rrdpush_sender_thread_data *data = ptr;
     worker_unregister();
 
+    struct sender_state *s = data->sender_state;
     RRDHOST *host = data->host;
 
     rrdpush_incremental_transmission_of_chart_definitions(host, &data->dictfe, false, true);
+    replication_requests_free(s);
 
-    netdata_mutex_lock(&host->sender->mutex);
+    netdata_mutex_lock(&s->mutex);
 
     info("STREAM %s [send]: sending thread cleans up...", rrdhost_hostname(host));
 
-    rrdpush_sender_thread_close_socket(host);
-    rrdpush_sender_pipe_close(host, host->sender->rrdpush_sender_pipe, false);
+    rrdpush_sender_thread_close_socket(s);
+    rrdpush_sender_pipe_close(host, s->rrdpush_sender_pipe, false);
+
+    if(s->fan_out.group) {
+        // the members are spawned and joined with the mutex of the group locked
+        netdata_mutex_lock(&s->fan_out.group->mutex);
 
-    if(!rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_JOIN)) {
-        info("STREAM %s [send]: sending thread detaches itself.", rrdhost_hostname(host));
-        netdata_thread_detach(netdata_thread_self());
+        if(!s->fan_out.join) {
+            info("STREAM %s [send to %s]: sending thread detaches itself.", rrdhost_hostname(host), string2str(s->fan_out.destination->destination));
+            netdata_thread_detach(netdata_thread_self());
+        }
+
+        s->fan_out.spawned = false;
+        rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+
+        netdata_mutex_unlock(&s->fan_out.group->mutex);
     }
+    else {
+        if(!rrdhost_flag_check(host, RRDHOST_FLAG_RRDPUSH_SENDER_JOIN)) {
+            info("STREAM %s [send]: sending thread detaches itself.", rrdhost_hostname(host));
+            netdata_thread_detach(netdata_thread_self());
+        }
 
-    rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+        rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+    }
 
     info("STREAM %s [send]: sending thread now exits.", rrdhost_hostname(host));
 
-    netdata_mutex_unlock(&host->sender->mutex);
+    netdata_mutex_unlock(&s->mutex);
 
     freez(data->pipe_buffer);
     freez(data);
 }
 
+static struct sender_state *sender_create(RRDHOST *host, bool compression)
+{
+    struct sender_state *s = callocz(1, sizeof(*s));
+    s->host = host;
+    s->buffer = cbuffer_new(1024, 1024*1024);
+    s->capabilities = STREAM_OUR_CAPABILITIES;
+
+    s->rrdpush_sender_pipe[PIPE_READ] = -1;
+    s->rrdpush_sender_pipe[PIPE_WRITE] = -1;
+    s->rrdpush_sender_socket  = -1;
+    s->dispatch.socket = -1;
+
+#ifdef ENABLE_COMPRESSION
+    if(compression && default_compression_enabled) {
+        s->flags |= SENDER_FLAG_COMPRESSION;
+        s->compressor = create_compressor(STREAM_CAP_COMPRESSION);
+    }
+#else
+    UNUSED(compression);
+#endif
+
+    netdata_mutex_init(&s->mutex);
+    return s;
+}
+
 void sender_init(RRDHOST *parent)
 {
     if (parent->sender)
         return;
 
-    parent->sender = callocz(1, sizeof(*parent->sender));
-    parent->sender->host = parent;
-    parent->sender->buffer = cbuffer_new(1024, 1024*1024);
-    parent->sender->capabilities = STREAM_OUR_CAPABILITIES;
+    parent->sender = sender_create(parent, true);
+}
+
+// makes the sender of the host the group of a member sender for each destination, when it streams to all of them
+void sender_fan_out_init(RRDHOST *host)
+{
+    struct sender_state *group = host->sender;
 
-    parent->sender->rrdpush_sender_pipe[PIPE_READ] = -1;
-    parent->sender->rrdpush_sender_pipe[PIPE_WRITE] = -1;
-    parent->sender->rrdpush_sender_socket  = -1;
+    if(!default_rrdpush_fan_out || !group || group->fan_out.members || !host->destinations || !host->destinations->next)
+        return;
 
 #ifdef ENABLE_COMPRESSION
-    if(default_compression_enabled) {
-        parent->sender->flags |= SENDER_FLAG_COMPRESSION;
-        parent->sender->compressor = create_compressor();
+    // the members send the data of the group as it is
+    group->flags &= ~SENDER_FLAG_COMPRESSION;
+    if(group->compressor)
+        group->compressor->destroy(&group->compressor);
+#endif
+
+    netdata_rwlock_init(&group->fan_out.serializing);
+
+    struct sender_state *last = NULL;
+    size_t count = 0;
+    for(struct rrdpush_destinations *d = host->destinations; d; d = d->next) {
+        struct sender_state *m = sender_create(host, false);
+        m->fan_out.group = group;
+        m->fan_out.destination = d;
+
+#ifdef ENABLE_HTTPS
+        m->ssl.conn = NULL;
+        m->ssl.flags = NETDATA_SSL_START;
+#endif
+
+        if(last)
+            last->fan_out.next = m;
+        else
+            group->fan_out.members = m;
+        last = m;
+        count++;
     }
+
+    info("STREAM %s [send]: streaming to all %zu destinations at the same time.", rrdhost_hostname(host), count);
+}
+
+// called when the host is freed, after the members have been stopped
+void sender_fan_out_free(struct sender_state *group)
+{
+    if(!group->fan_out.members)
+        return;
+
+    while(group->fan_out.members) {
+        struct sender_state *m = group->fan_out.members;
+        group->fan_out.members = m->fan_out.next;
+
+        cbuffer_free(m->buffer);
+        sender_free_chunks(m);
+#ifdef ENABLE_HTTPS
+        if(m->ssl.conn)
+            SSL_free(m->ssl.conn);
 #endif
+        netdata_mutex_destroy(&m->mutex);
+        freez(m);
+    }
 
-    netdata_mutex_init(&parent->sender->mutex);
+    sender_chunks_free_list(group->fan_out.shared_head);
+    group->fan_out.shared_head = group->fan_out.shared_tail = NULL;
+    netdata_rwlock_destroy(&group->fan_out.serializing);
 }
 
-void *rrdpush_sender_thread(void *ptr) {
+// creates the threads of the members that do not run, called with the mutex of the group locked
+void rrdpush_sender_fan_out_spawn(struct sender_state *group)
+{
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next) {
+        if(m->fan_out.spawned)
+            continue;
+
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STREAM_SENDER[%s]", rrdhost_hostname(group->host));
+
+        if(netdata_thread_create(&m->fan_out.thread, tag, NETDATA_THREAD_OPTION_JOINABLE, rrdpush_sender_thread, (void *)m))
+            error("STREAM %s [send to %s]: failed to create new thread for client.",
+                  rrdhost_hostname(group->host), string2str(m->fan_out.destination->destination));
+        else
+            m->fan_out.spawned = true;
+    }
+}
+
+// stops the threads of all the members and waits for them
+void rrdpush_sender_fan_out_stop(struct sender_state *group)
+{
+    size_t count = 0;
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next)
+        count++;
+
+    // copy the thread ids, so that we will be waiting for the right ones
+    // even if new ones have been spawn
+    netdata_thread_t *threads = callocz(count, sizeof(netdata_thread_t));
+    size_t joining = 0;
+
+    netdata_mutex_lock(&group->mutex);
+    rrdhost_flag_clear(group->host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+
+    for(struct sender_state *m = group->fan_out.members; m; m = m->fan_out.next) {
+        if(!m->fan_out.spawned)
+            continue;
+
+        m->fan_out.join = true;
+        threads[joining++] = m->fan_out.thread;
+        netdata_thread_cancel(m->fan_out.thread);
+    }
+
+    netdata_mutex_unlock(&group->mutex);
+
+    if(joining) {
+        info("STREAM %s [send]: waiting for %zu sending threads to stop...", rrdhost_hostname(group->host), joining);
+
+        void *result;
+        for(size_t i = 0; i < joining; i++)
+            netdata_thread_join(threads[i], &result);
+
+        info("STREAM %s [send]: sending threads have exited.", rrdhost_hostname(group->host));
+    }
+
+    freez(threads);
+}
+
+static void rrdpush_sender_register_worker(void) {
     worker_register("STREAMSND");
     worker_register_job_name(WORKER_SENDER_JOB_CONNECT, "connect");
     worker_register_job_name(WORKER_SENDER_JOB_PIPE_READ, "pipe read");
@@ -1068,18 +2105,15 @@ void *rrdpush_sender_thread(void *ptr) {
     worker_register_job_custom_metric(WORKER_SENDER_JOB_BUFFER_RATIO, "used buffer ratio", "%", WORKER_METRIC_ABSOLUTE);
     worker_register_job_custom_metric(WORKER_SENDER_JOB_BYTES_RECEIVED, "bytes received", "bytes/s", WORKER_METRIC_INCREMENTAL);
     worker_register_job_custom_metric(WORKER_SENDER_JOB_BYTES_SENT, "bytes sent", "bytes/s", WORKER_METRIC_INCREMENTAL);
+}
 
-    struct sender_state *s = ptr;
-    s->tid = gettid();
-
-    if(!rrdhost_has_rrdpush_sender_enabled(s->host) || !s->host->rrdpush_send_destination ||
-       !*s->host->rrdpush_send_destination || !s->host->rrdpush_send_api_key ||
-       !*s->host->rrdpush_send_api_key) {
-        error("STREAM %s [send]: thread created (task id %d), but host has streaming disabled.",
-              rrdhost_hostname(s->host), s->tid);
-        return NULL;
-    }
+static inline bool rrdpush_sender_host_can_stream(RRDHOST *host) {
+    return rrdhost_has_rrdpush_sender_enabled(host) && host->rrdpush_send_destination &&
+           *host->rrdpush_send_destination && host->rrdpush_send_api_key && *host->rrdpush_send_api_key;
+}
 
+// loads the sending options of the host
+static void rrdpush_sender_thread_init(struct sender_state *s) {
 #ifdef ENABLE_HTTPS
     if (netdata_use_ssl_on_stream & NETDATA_SSL_FORCE ){
         security_start_ssl(NETDATA_SSL_CONTEXT_STREAMING);
@@ -1087,8 +2121,6 @@ void *rrdpush_sender_thread(void *ptr) {
     }
 #endif
 
-    info("STREAM %s [send]: thread created (task id %d)", rrdhost_hostname(s->host), s->tid);
-
     s->timeout = (int)appconfig_get_number(
         &stream_config, CONFIG_SECTION_STREAM, "timeout seconds", 60);
 
@@ -1107,8 +2139,173 @@ void *rrdpush_sender_thread(void *ptr) {
         remote_clock_resync_iterations); // TODO: REMOVE FOR SLEW / GAPFILLING
 
     // initialize rrdpush globals
-    rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-    rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED);
+    rrdpush_sender_set_connected(s, false);
+}
+
+// connects to the parent and queues the first messages of the stream
+// returns false when it could not connect
+static bool rrdpush_sender_thread_connect(struct rrdpush_sender_thread_data *thread_data) {
+    struct sender_state *s = thread_data->sender_state;
+
+    worker_is_busy(WORKER_SENDER_JOB_CONNECT);
+    thread_data->sending_definitions_status = SENDING_DEFINITIONS_RESTART;
+    rrdpush_sender_set_connected(s, false);
+
+    // release what has not been sent on the previous connection now, not after connecting again,
+    // so that the chunks a fan out member references can be recycled by its group
+    netdata_mutex_lock(&s->mutex);
+    sender_chunks_flush_unsafe(s);
+    netdata_mutex_unlock(&s->mutex);
+
+    s->flags &= ~SENDER_FLAG_OVERFLOW;
+    s->read_len = 0;
+    s->buffer->read = 0;
+    s->buffer->write = 0;
+
+    if(unlikely(!attempt_to_connect(s)))
+        return false;
+
+    if (stream_has_capability(s, STREAM_CAP_GAP_FILLING)) {
+        time_t now = now_realtime_sec();
+        BUFFER *wb = sender_start(s);
+        buffer_sprintf(wb, "TIMESTAMP %"PRId64"", (int64_t)now);
+        sender_commit(s, wb);
+    }
+
+    rrdpush_claimed_id(s->host);
+    rrdpush_send_host_labels(s->host);
+
+    // TO PUSH METRICS WITH DEFINITIONS:
+    //if(unlikely(s->rrdpush_sender_socket != -1 && __atomic_load_n(&s->host->rrdpush_sender_connected, __ATOMIC_SEQ_CST))) {
+    //    thread_data->sending_definitions_status = SENDING_DEFINITIONS_DONE;
+    //    rrdhost_flag_set(s->host, RRDHOST_FLAG_STREAM_COLLECTED_METRICS);
+    //}
+
+    return true;
+}
+
+// the work to do before waiting for the socket, it sets the bytes waiting to be sent
+// returns false when the connection has been closed
+static bool rrdpush_sender_thread_prepare(struct rrdpush_sender_thread_data *thread_data, size_t *outstanding) {
+    struct sender_state *s = thread_data->sender_state;
+
+    // If the TCP window never opened then something is wrong, restart connection
+    if(unlikely(now_monotonic_sec() - s->last_sent_t > s->timeout)) {
+        worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
+        error("STREAM %s [send to %s]: could not send metrics for %d seconds - closing connection - we have sent %zu bytes on this connection via %zu send attempts.", rrdhost_hostname(s->host), s->connected_to, s->timeout, s->sent_bytes_on_this_connection, s->send_attempts);
+        rrdpush_sender_thread_close_socket(s);
+        return false;
+    }
+
+    if(unlikely(thread_data->sending_definitions_status != SENDING_DEFINITIONS_DONE))
+        rrdpush_queue_incremental_definitions(thread_data);
+
+    if(unlikely(s->replication.requests))
+        rrdpush_sender_replicate(s);
+
+    netdata_mutex_lock(&s->mutex);
+    *outstanding = sender_outstanding_bytes_unsafe(s);
+    size_t available = s->buffer->max_size - sender_buffered_bytes_unsafe(s);
+    netdata_mutex_unlock(&s->mutex);
+
+    worker_set_metric(WORKER_SENDER_JOB_BUFFER_RATIO, (NETDATA_DOUBLE)(s->buffer->max_size - available) * 100.0 / (NETDATA_DOUBLE)s->buffer->max_size);
+
+    if(*outstanding)
+        s->send_attempts++;
+    else {
+        if(unlikely(thread_data->sending_definitions_status == SENDING_DEFINITIONS_DONE
+                     && rrdpush_sender_is_connected(s)
+                     && !rrdpush_sender_is_ready(s)
+                         )) {
+            // let the data collection threads know we are ready to push metrics
+            rrdpush_sender_set_ready(s);
+            info("STREAM %s [send to %s]: enabling metrics streaming...", rrdhost_hostname(s->host), s->connected_to);
+        }
+    }
+
+    return true;
+}
+
+// handles the poll() events of the socket: sends, receives and executes the commands of the parent
+static void rrdpush_sender_thread_process(struct rrdpush_sender_thread_data *thread_data, short revents, size_t outstanding, size_t max_send_bytes) {
+    struct sender_state *s = thread_data->sender_state;
+
+     // If we have data and have seen the TCP window open then try to close it by a transmission.
+    if(likely(outstanding && (revents & POLLOUT))) {
+        worker_is_busy(WORKER_SENDER_JOB_SOCKET_SEND);
+        ssize_t bytes = attempt_to_send(s, max_send_bytes);
+        if(bytes > 0)
+            worker_set_metric(WORKER_SENDER_JOB_BYTES_SENT, bytes);
+    }
+
+    // Read as much as possible to fill the buffer, split into full lines for execution.
+    if (revents & POLLIN) {
+        worker_is_busy(WORKER_SENDER_JOB_SOCKET_RECEIVE);
+        ssize_t bytes = attempt_read(s);
+        if(bytes > 0)
+            worker_set_metric(WORKER_SENDER_JOB_BYTES_RECEIVED, bytes);
+    }
+
+    if(unlikely(s->read_len)) {
+        worker_is_busy(WORKER_SENDER_JOB_EXECUTE);
+        execute_commands(s);
+    }
+
+#ifdef SENDER_HAVE_MSG_ZEROCOPY
+    // the completions of MSG_ZEROCOPY are reported as errors of the socket
+    if(unlikely((revents & POLLERR) && s->zero_copy.msg_zerocopy && s->rrdpush_sender_socket != -1)) {
+        sender_zerocopy_read_completions(s);
+
+        int err = 0;
+        socklen_t err_len = sizeof(err);
+        if(getsockopt(s->rrdpush_sender_socket, SOL_SOCKET, SO_ERROR, &err, &err_len) == 0 && !err)
+            revents &= ~POLLERR;
+    }
+#endif
+
+    if(unlikely(revents & (POLLERR|POLLHUP|POLLNVAL))) {
+        char *error = NULL;
+
+        if (unlikely(revents & POLLERR))
+            error = "socket reports errors (POLLERR)";
+        else if (unlikely(revents & POLLHUP))
+            error = "connection closed by remote end (POLLHUP)";
+        else if (unlikely(revents & POLLNVAL))
+            error = "connection is invalid (POLLNVAL)";
+
+        if(unlikely(error)) {
+            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SOCKER_ERROR);
+            error("STREAM %s [send to %s]: restarting connection: %s - %zu bytes transmitted.",
+                  rrdhost_hostname(s->host), s->connected_to, error, s->sent_bytes_on_this_connection);
+            rrdpush_sender_thread_close_socket(s);
+        }
+    }
+
+    // protection from overflow
+    if(unlikely(s->flags & SENDER_FLAG_OVERFLOW)) {
+        worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_OVERFLOW);
+        errno = 0;
+        error("STREAM %s [send to %s]: buffer full (allocated %zu bytes) after sending %zu bytes. Restarting connection",
+              rrdhost_hostname(s->host), s->connected_to, s->buffer->size, s->sent_bytes_on_this_connection);
+        rrdpush_sender_thread_close_socket(s);
+    }
+}
+
+void *rrdpush_sender_thread(void *ptr) {
+    rrdpush_sender_register_worker();
+
+    struct sender_state *s = ptr;
+    s->tid = gettid();
+
+    if(!rrdpush_sender_host_can_stream(s->host)) {
+        error("STREAM %s [send]: thread created (task id %d), but host has streaming disabled.",
+              rrdhost_hostname(s->host), s->tid);
+        return NULL;
+    }
+
+    info("STREAM %s [send]: thread created (task id %d)", rrdhost_hostname(s->host), s->tid);
+
+    rrdpush_sender_thread_init(s);
 
     int pipe_buffer_size = 10 * 1024;
 #ifdef F_GETPIPE_SZ
@@ -1130,7 +2327,10 @@ void *rrdpush_sender_thread(void *ptr) {
     thread_data->sending_definitions_status = SENDING_DEFINITIONS_RESTART;
 
     // reset our cleanup flags
-    rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_JOIN);
+    if(s->fan_out.group)
+        s->fan_out.join = false;
+    else
+        rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_JOIN);
 
     netdata_thread_cleanup_push(rrdpush_sender_thread_cleanup_callback, thread_data);
 
@@ -1140,72 +2340,22 @@ void *rrdpush_sender_thread(void *ptr) {
 
         // The connection attempt blocks (after which we use the socket in nonblocking)
         if(unlikely(s->rrdpush_sender_socket == -1)) {
-            worker_is_busy(WORKER_SENDER_JOB_CONNECT);
-            thread_data->sending_definitions_status = SENDING_DEFINITIONS_RESTART;
-            rrdhost_flag_clear(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-            s->flags &= ~SENDER_FLAG_OVERFLOW;
-            s->read_len = 0;
-            s->buffer->read = 0;
-            s->buffer->write = 0;
-
-            if(unlikely(!attempt_to_connect(s)))
-                continue;
-
-            if (stream_has_capability(s, STREAM_CAP_GAP_FILLING)) {
-                time_t now = now_realtime_sec();
-                BUFFER *wb = sender_start(s);
-                buffer_sprintf(wb, "TIMESTAMP %"PRId64"", (int64_t)now);
-                sender_commit(s, wb);
+            if(unlikely(!rrdpush_sender_thread_connect(thread_data))) {
+                // slow re-connection on repeating errors
+                sleep_usec(USEC_PER_SEC * s->reconnect_delay); // seconds
             }
-
-            rrdpush_claimed_id(s->host);
-            rrdpush_send_host_labels(s->host);
-
-            // TO PUSH METRICS WITH DEFINITIONS:
-            //if(unlikely(s->rrdpush_sender_socket != -1 && __atomic_load_n(&s->host->rrdpush_sender_connected, __ATOMIC_SEQ_CST))) {
-            //    thread_data->sending_definitions_status = SENDING_DEFINITIONS_DONE;
-            //    rrdhost_flag_set(s->host, RRDHOST_FLAG_STREAM_COLLECTED_METRICS);
-            //}
-
             continue;
         }
 
-        // If the TCP window never opened then something is wrong, restart connection
-        if(unlikely(now_monotonic_sec() - s->last_sent_t > s->timeout)) {
-            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_TIMEOUT);
-            error("STREAM %s [send to %s]: could not send metrics for %d seconds - closing connection - we have sent %zu bytes on this connection via %zu send attempts.", rrdhost_hostname(s->host), s->connected_to, s->timeout, s->sent_bytes_on_this_connection, s->send_attempts);
-            rrdpush_sender_thread_close_socket(s->host);
+        size_t outstanding;
+        if(unlikely(!rrdpush_sender_thread_prepare(thread_data, &outstanding)))
             continue;
-        }
-
-        if(unlikely(thread_data->sending_definitions_status != SENDING_DEFINITIONS_DONE))
-            rrdpush_queue_incremental_definitions(thread_data);
-
-        netdata_mutex_lock(&s->mutex);
-        size_t outstanding = cbuffer_next_unsafe(s->host->sender->buffer, NULL);
-        size_t available = cbuffer_available_size_unsafe(s->host->sender->buffer);
-        netdata_mutex_unlock(&s->mutex);
-
-        worker_set_metric(WORKER_SENDER_JOB_BUFFER_RATIO, (NETDATA_DOUBLE)(s->host->sender->buffer->max_size - available) * 100.0 / (NETDATA_DOUBLE)s->host->sender->buffer->max_size);
-
-        if(outstanding)
-            s->send_attempts++;
-        else {
-            if(unlikely(thread_data->sending_definitions_status == SENDING_DEFINITIONS_DONE
-                         && rrdhost_flag_check(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_CONNECTED)
-                         && !rrdhost_flag_check(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS)
-                             )) {
-                // let the data collection threads know we are ready to push metrics
-                rrdhost_flag_set(s->host, RRDHOST_FLAG_RRDPUSH_SENDER_READY_4_METRICS);
-                info("STREAM %s [send to %s]: enabling metrics streaming...", rrdhost_hostname(s->host), s->connected_to);
-            }
-        }
 
         if(unlikely(s->rrdpush_sender_pipe[PIPE_READ] == -1)) {
             if(!rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true)) {
                 error("STREAM %s [send]: cannot create inter-thread communication pipe. Disabling streaming.",
                       rrdhost_hostname(s->host));
-                rrdpush_sender_thread_close_socket(s->host);
+                rrdpush_sender_thread_close_socket(s);
                 break;
             }
         }
@@ -1229,7 +2379,8 @@ void *rrdpush_sender_thread(void *ptr) {
                 .revents = 0,
             }
         };
-        int poll_rc = poll(fds, 2, 1000);
+        // wake up sooner while replicating, to continue when the speed limit allows it
+        int poll_rc = poll(fds, 2, s->replication.requests ? 100 : 1000);
 
         debug(D_STREAM, "STREAM: poll() finished collector=%d socket=%d (current chunk %zu bytes)...",
               fds[Collector].revents, fds[Socket].revents, outstanding);
@@ -1253,18 +2404,10 @@ void *rrdpush_sender_thread(void *ptr) {
             worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_POLL_ERROR);
             error("STREAM %s [send to %s]: failed to poll(). Closing socket.", rrdhost_hostname(s->host), s->connected_to);
             rrdpush_sender_pipe_close(s->host, s->rrdpush_sender_pipe, true);
-            rrdpush_sender_thread_close_socket(s->host);
+            rrdpush_sender_thread_close_socket(s);
             continue;
         }
 
-         // If we have data and have seen the TCP window open then try to close it by a transmission.
-        if(likely(outstanding && (fds[Socket].revents & POLLOUT))) {
-            worker_is_busy(WORKER_SENDER_JOB_SOCKET_SEND);
-            ssize_t bytes = attempt_to_send(s);
-            if(bytes > 0)
-                worker_set_metric(WORKER_SENDER_JOB_BYTES_SENT, bytes);
-        }
-
         // If the collector woke us up then empty the pipe to remove the signal
         if (fds[Collector].revents & (POLLIN|POLLPRI)) {
             worker_is_busy(WORKER_SENDER_JOB_PIPE_READ);
@@ -1274,18 +2417,7 @@ void *rrdpush_sender_thread(void *ptr) {
                 error("STREAM %s [send to %s]: cannot read from internal pipe.", rrdhost_hostname(s->host), s->connected_to);
         }
 
-        // Read as much as possible to fill the buffer, split into full lines for execution.
-        if (fds[Socket].revents & POLLIN) {
-            worker_is_busy(WORKER_SENDER_JOB_SOCKET_RECEIVE);
-            ssize_t bytes = attempt_read(s);
-            if(bytes > 0)
-                worker_set_metric(WORKER_SENDER_JOB_BYTES_RECEIVED, bytes);
-        }
-
-        if(unlikely(s->read_len)) {
-            worker_is_busy(WORKER_SENDER_JOB_EXECUTE);
-            execute_commands(s);
-        }
+        rrdpush_sender_thread_process(thread_data, fds[Socket].revents, outstanding, 0);
 
         if(unlikely(fds[Collector].revents & (POLLERR|POLLHUP|POLLNVAL))) {
             char *error = NULL;
@@ -1303,35 +2435,447 @@ void *rrdpush_sender_thread(void *ptr) {
                       rrdhost_hostname(s->host), s->connected_to, error);
             }
         }
+    }
 
-        if(unlikely(fds[Socket].revents & (POLLERR|POLLHUP|POLLNVAL))) {
-            char *error = NULL;
+    netdata_thread_cleanup_pop(1);
+    return NULL;
+}
+
+#ifdef __linux__
+// ----------------------------------------------------------------------------
+// senders dispatcher
+//
+// When [stream].sender threads is set, the hosts do not get a sender thread each. A few dispatcher threads
+// serve all of them, each waiting with epoll for the sockets of its hosts and for a queue of the hosts the
+// collectors have added data to. Each host keeps its own circular buffer, protected by its sender mutex,
+// and the sending state a sender thread keeps in its stack.
+//
+// A single send is limited, so that a host with a lot of data to send (e.g. while replicating) does not delay
+// the others: the hosts with data and an open TCP window are served in turns. Connecting to a parent blocks,
+// so each connection attempt runs on a short-lived thread.
+
+#define SENDER_DISPATCHER_MAX_EVENTS 64
+#define SENDER_DISPATCHER_MAX_SEND_BYTES (64 * 1024)
+
+struct sender_dispatcher {
+    netdata_thread_t thread;
+    pid_t tid;
+    int epoll_fd;
+    int wakeup_pipe[2];
+
+    netdata_mutex_t mutex;
+    struct sender_state *ready;         // the hosts to be served without a socket event - protected by the mutex
+
+    struct sender_state *senders;       // the hosts served by the thread - only touched by the thread
+    size_t count;                       // the hosts given to the thread
+    bool replicating;                   // a host of the thread replicates charts - only touched by the thread
+};
+
+static struct {
+    netdata_mutex_t mutex;
+    bool failed;
+    size_t size;
+    struct sender_dispatcher *threads;
+} sender_dispatchers = {
+    .mutex = NETDATA_MUTEX_INITIALIZER,
+    .failed = false,
+    .size = 0,
+    .threads = NULL,
+};
+
+// called by the threads that add data to the buffer of the host
+static void rrdpush_sender_dispatcher_queue(struct sender_state *s) {
+    struct sender_dispatcher *d = __atomic_load_n(&s->dispatch.dispatcher, __ATOMIC_ACQUIRE);
+
+    // the dispatcher sends the data it adds to the buffer of the host it serves
+    if(unlikely(!d || d->tid == gettid()))
+        return;
+
+    bool wakeup = false;
 
-            if (unlikely(fds[Socket].revents & POLLERR))
-                error = "socket reports errors (POLLERR)";
-            else if (unlikely(fds[Socket].revents & POLLHUP))
-                error = "connection closed by remote end (POLLHUP)";
-            else if (unlikely(fds[Socket].revents & POLLNVAL))
-                error = "connection is invalid (POLLNVAL)";
-
-            if(unlikely(error)) {
-                worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_SOCKER_ERROR);
-                error("STREAM %s [send to %s]: restarting connection: %s - %zu bytes transmitted.",
-                      rrdhost_hostname(s->host), s->connected_to, error, s->sent_bytes_on_this_connection);
-                rrdpush_sender_thread_close_socket(s->host);
+    netdata_mutex_lock(&d->mutex);
+    if(likely(s->dispatch.dispatcher == d && !s->dispatch.queued)) {
+        s->dispatch.queued = true;
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(d->ready, s, dispatch.ready_prev, dispatch.ready_next);
+        wakeup = true;
+    }
+    netdata_mutex_unlock(&d->mutex);
+
+    if(wakeup) {
+        char c = '\n';
+        if(write(d->wakeup_pipe[1], &c, 1) == -1 && errno != EAGAIN)
+            error("STREAM %s [send]: cannot wake up the senders dispatcher.", rrdhost_hostname(s->host));
+    }
+}
+
+static struct sender_state *rrdpush_sender_dispatcher_next_ready(struct sender_dispatcher *d) {
+    netdata_mutex_lock(&d->mutex);
+    struct sender_state *s = d->ready;
+    if(s) {
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(d->ready, s, dispatch.ready_prev, dispatch.ready_next);
+        s->dispatch.queued = false;
+    }
+    netdata_mutex_unlock(&d->mutex);
+    return s;
+}
+
+// called when the socket of the host is closed, by any thread
+static void rrdpush_sender_dispatcher_forget_socket(struct sender_state *s) {
+    struct sender_dispatcher *d = __atomic_load_n(&s->dispatch.dispatcher, __ATOMIC_ACQUIRE);
+    if(d)
+        (void)epoll_ctl(d->epoll_fd, EPOLL_CTL_DEL, s->dispatch.socket, NULL);
+
+    s->dispatch.socket = -1;
+    s->dispatch.events = 0;
+}
+
+// adds the socket to the epoll, or updates the events it waits for
+static void rrdpush_sender_dispatcher_watch_socket(struct sender_dispatcher *d, struct sender_state *s) {
+    netdata_mutex_lock(&s->mutex);
+
+    if(s->rrdpush_sender_socket != -1) {
+        uint32_t events = EPOLLIN | (sender_outstanding_bytes_unsafe(s) ? EPOLLOUT : 0);
+
+        if(s->dispatch.socket != s->rrdpush_sender_socket || s->dispatch.events != events) {
+            struct epoll_event ev = {
+                .events = events,
+                .data.ptr = s,
+            };
+            int op = (s->dispatch.socket == s->rrdpush_sender_socket) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+            if(epoll_ctl(d->epoll_fd, op, s->rrdpush_sender_socket, &ev) == -1) {
+                error("STREAM %s [send to %s]: cannot add the socket to the senders dispatcher - closing connection.",
+                      rrdhost_hostname(s->host), s->connected_to);
+                rrdpush_sender_thread_close_socket(s);
+            }
+            else {
+                s->dispatch.socket = s->rrdpush_sender_socket;
+                s->dispatch.events = events;
             }
         }
+    }
+
+    netdata_mutex_unlock(&s->mutex);
+}
+
+static void rrdpush_sender_dispatcher_connector_cleanup(void *ptr) {
+    struct sender_state *s = ptr;
+
+    __atomic_store_n(&s->dispatch.connecting, false, __ATOMIC_RELEASE);
+    rrdpush_sender_dispatcher_queue(s);
+}
+
+static void *rrdpush_sender_dispatcher_connector(void *ptr) {
+    struct sender_state *s = ptr;
+
+    netdata_thread_cleanup_push(rrdpush_sender_dispatcher_connector_cleanup, s);
+
+    // slow re-connection on repeating errors
+    if(!rrdpush_sender_thread_connect(s->dispatch.data))
+        s->dispatch.connect_after_t = now_monotonic_sec() + (time_t)s->reconnect_delay;
+
+    netdata_thread_cleanup_pop(1);
+    return NULL;
+}
+
+static void rrdpush_sender_dispatcher_connect(struct sender_state *s) {
+    char tag[NETDATA_THREAD_TAG_MAX + 1];
+    snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STREAM_CONNECT[%s]", rrdhost_hostname(s->host));
+
+    __atomic_store_n(&s->dispatch.connecting, true, __ATOMIC_RELEASE);
+
+    if(netdata_thread_create(&s->dispatch.connector, tag, NETDATA_THREAD_OPTION_JOINABLE, rrdpush_sender_dispatcher_connector, (void *)s)) {
+        error("STREAM %s [send]: failed to create a thread to connect to the parent.", rrdhost_hostname(s->host));
+        __atomic_store_n(&s->dispatch.connecting, false, __ATOMIC_RELEASE);
+        s->dispatch.connect_after_t = now_monotonic_sec() + (time_t)s->reconnect_delay;
+        return;
+    }
+
+    s->dispatch.connector_running = true;
+}
+
+// the dispatcher stops serving the host, like rrdpush_sender_thread_cleanup_callback() does for a sender thread
+static void rrdpush_sender_dispatcher_release(struct sender_dispatcher *d, struct sender_state *s) {
+    struct rrdpush_sender_thread_data *thread_data = s->dispatch.data;
+    RRDHOST *host = s->host;
+
+    if(s->dispatch.connector_running) {
+        netdata_thread_cancel(s->dispatch.connector);
+        netdata_thread_join(s->dispatch.connector, NULL);
+        s->dispatch.connector_running = false;
+    }
+
+    rrdpush_incremental_transmission_of_chart_definitions(host, &thread_data->dictfe, false, true);
+    replication_requests_free(s);
+
+    if(s->dispatch.prev)
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(d->senders, s, dispatch.prev, dispatch.next);
+
+    s->dispatch.data = NULL;
+    freez(thread_data->pipe_buffer);
+    freez(thread_data);
+
+    netdata_mutex_lock(&s->mutex);
+
+    info("STREAM %s [send]: the senders dispatcher stops sending.", rrdhost_hostname(host));
 
-        // protection from overflow
-        if(unlikely(s->flags & SENDER_FLAG_OVERFLOW)) {
-            worker_is_busy(WORKER_SENDER_JOB_DISCONNECT_OVERFLOW);
-            errno = 0;
-            error("STREAM %s [send to %s]: buffer full (allocated %zu bytes) after sending %zu bytes. Restarting connection",
-                  rrdhost_hostname(s->host), s->connected_to, s->buffer->size, s->sent_bytes_on_this_connection);
-            rrdpush_sender_thread_close_socket(s->host);
+    rrdpush_sender_thread_close_socket(s);
+    rrdhost_flag_clear(host, RRDHOST_FLAG_RRDPUSH_SENDER_SPAWN);
+
+    netdata_mutex_lock(&d->mutex);
+    if(s->dispatch.queued) {
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(d->ready, s, dispatch.ready_prev, dispatch.ready_next);
+        s->dispatch.queued = false;
+    }
+    __atomic_store_n(&s->dispatch.dispatcher, NULL, __ATOMIC_RELEASE);
+    netdata_mutex_unlock(&d->mutex);
+
+    netdata_mutex_unlock(&s->mutex);
+
+    __atomic_sub_fetch(&d->count, 1, __ATOMIC_RELAXED);
+}
+
+// serves a host: connects it, sends its buffer and executes the commands of its parent
+static void rrdpush_sender_dispatcher_serve(struct sender_dispatcher *d, struct sender_state *s, short revents) {
+    if(unlikely(!s->dispatch.prev))
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(d->senders, s, dispatch.prev, dispatch.next);
+
+    if(unlikely(s->dispatch.connector_running && !__atomic_load_n(&s->dispatch.connecting, __ATOMIC_ACQUIRE))) {
+        netdata_thread_join(s->dispatch.connector, NULL);
+        s->dispatch.connector_running = false;
+    }
+
+    if(unlikely(netdata_exit || __atomic_load_n(&s->dispatch.stop, __ATOMIC_ACQUIRE) ||
+                !rrdhost_has_rrdpush_sender_enabled(s->host))) {
+        rrdpush_sender_dispatcher_release(d, s);
+        return;
+    }
+
+    // the connector thread owns the host until it finishes
+    if(s->dispatch.connector_running)
+        return;
+
+    if(unlikely(s->rrdpush_sender_socket == -1)) {
+        if(now_monotonic_sec() >= s->dispatch.connect_after_t)
+            rrdpush_sender_dispatcher_connect(s);
+        return;
+    }
+
+    size_t outstanding;
+    if(unlikely(!rrdpush_sender_thread_prepare(s->dispatch.data, &outstanding)))
+        return;
+
+    // try to send even without a socket event, the TCP window is usually open
+    if(outstanding)
+        revents |= POLLOUT;
+
+    rrdpush_sender_thread_process(s->dispatch.data, revents, outstanding, SENDER_DISPATCHER_MAX_SEND_BYTES);
+
+    rrdpush_sender_dispatcher_watch_socket(d, s);
+}
+
+static void *rrdpush_sender_dispatcher_thread(void *ptr) {
+    struct sender_dispatcher *d = ptr;
+
+    rrdpush_sender_register_worker();
+    d->tid = gettid();
+
+    struct epoll_event events[SENDER_DISPATCHER_MAX_EVENTS];
+    usec_t last_pass_ut = 0;
+
+    while(!netdata_exit) {
+        // the hosts are also served periodically, for timeouts, reconnections and replication
+        usec_t pass_every_ut = (d->replicating ? 100 : 1000) * USEC_PER_MS;
+        usec_t now_ut = now_monotonic_usec();
+        int timeout_ms = (now_ut - last_pass_ut >= pass_every_ut) ? 0 : (int)((last_pass_ut + pass_every_ut - now_ut) / USEC_PER_MS);
+
+        netdata_mutex_lock(&d->mutex);
+        if(d->ready)
+            timeout_ms = 0;
+        netdata_mutex_unlock(&d->mutex);
+
+        worker_is_idle();
+
+        int n = epoll_wait(d->epoll_fd, events, SENDER_DISPATCHER_MAX_EVENTS, timeout_ms);
+        if(unlikely(n == -1)) {
+            if(errno != EINTR) {
+                error("STREAM: epoll_wait() of the senders dispatcher failed.");
+                sleep_usec(100 * USEC_PER_MS);
+            }
+            continue;
+        }
+
+        for(int i = 0; i < n && !netdata_exit; i++) {
+            struct sender_state *s = events[i].data.ptr;
+
+            if(!s) {
+                char discard[128];
+                while(read(d->wakeup_pipe[0], discard, sizeof(discard)) > 0) ;
+                continue;
+            }
+
+            short revents = 0;
+            if(events[i].events & EPOLLIN)  revents |= POLLIN;
+            if(events[i].events & EPOLLOUT) revents |= POLLOUT;
+            if(events[i].events & EPOLLERR) revents |= POLLERR;
+            if(events[i].events & EPOLLHUP) revents |= POLLHUP;
+
+            rrdpush_sender_dispatcher_serve(d, s, revents);
+        }
+
+        // at most one turn per host, for the hosts the collectors keep adding data to
+        size_t count = __atomic_load_n(&d->count, __ATOMIC_RELAXED);
+        struct sender_state *s;
+        while(count-- && !netdata_exit && (s = rrdpush_sender_dispatcher_next_ready(d)))
+            rrdpush_sender_dispatcher_serve(d, s, 0);
+
+        now_ut = now_monotonic_usec();
+        if(now_ut - last_pass_ut >= pass_every_ut) {
+            last_pass_ut = now_ut;
+            d->replicating = false;
+
+            struct sender_state *next;
+            for(s = d->senders; s && !netdata_exit; s = next) {
+                next = s->dispatch.next;
+
+                if(s->replication.requests)
+                    d->replicating = true;
+
+                rrdpush_sender_dispatcher_serve(d, s, 0);
+            }
         }
     }
 
-    netdata_thread_cleanup_pop(1);
+    // release all the hosts, so that rrdpush_sender_thread_stop() does not wait for them
+    struct sender_state *s;
+    while((s = rrdpush_sender_dispatcher_next_ready(d)))
+        rrdpush_sender_dispatcher_serve(d, s, 0);
+    while(d->senders)
+        rrdpush_sender_dispatcher_serve(d, d->senders, 0);
+
+    worker_unregister();
     return NULL;
 }
+
+// called with the dispatchers mutex locked
+static bool rrdpush_sender_dispatcher_start(void) {
+    size_t size = default_rrdpush_sender_threads;
+    struct sender_dispatcher *threads = callocz(size, sizeof(struct sender_dispatcher));
+    size_t i;
+
+    for(i = 0; i < size; i++) {
+        struct sender_dispatcher *d = &threads[i];
+
+        d->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if(d->epoll_fd == -1)
+            break;
+
+        if(pipe2(d->wakeup_pipe, O_CLOEXEC | O_NONBLOCK) == -1) {
+            close(d->epoll_fd);
+            break;
+        }
+
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = NULL,
+        };
+        if(epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, d->wakeup_pipe[0], &ev) == -1) {
+            close(d->wakeup_pipe[0]);
+            close(d->wakeup_pipe[1]);
+            close(d->epoll_fd);
+            break;
+        }
+
+        netdata_mutex_init(&d->mutex);
+    }
+
+    if(i < size) {
+        error("STREAM: cannot create the senders dispatcher, using a sender thread per host.");
+        while(i--) {
+            close(threads[i].wakeup_pipe[0]);
+            close(threads[i].wakeup_pipe[1]);
+            close(threads[i].epoll_fd);
+            netdata_mutex_destroy(&threads[i].mutex);
+        }
+        freez(threads);
+        sender_dispatchers.failed = true;
+        return false;
+    }
+
+    for(i = 0; i < size; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STREAM_SENDERS[%zu]", i);
+        netdata_thread_create(&threads[i].thread, tag, NETDATA_THREAD_OPTION_DEFAULT, rrdpush_sender_dispatcher_thread, &threads[i]);
+    }
+
+    sender_dispatchers.threads = threads;
+    sender_dispatchers.size = size;
+    info("STREAM: sending the hosts with %zu dispatcher threads.", size);
+    return true;
+}
+
+// gives the host to the dispatcher thread with the fewest hosts, called with the sender mutex locked
+// returns false when the host has to get a sender thread
+bool rrdpush_sender_dispatcher_add(struct sender_state *s) {
+    // a sender thread logs why it cannot stream
+    if(!rrdpush_sender_host_can_stream(s->host))
+        return false;
+
+    netdata_mutex_lock(&sender_dispatchers.mutex);
+    if(!sender_dispatchers.threads && (sender_dispatchers.failed || !rrdpush_sender_dispatcher_start())) {
+        netdata_mutex_unlock(&sender_dispatchers.mutex);
+        return false;
+    }
+
+    struct sender_dispatcher *d = &sender_dispatchers.threads[0];
+    for(size_t i = 1; i < sender_dispatchers.size; i++) {
+        if(__atomic_load_n(&sender_dispatchers.threads[i].count, __ATOMIC_RELAXED) < __atomic_load_n(&d->count, __ATOMIC_RELAXED))
+            d = &sender_dispatchers.threads[i];
+    }
+    __atomic_add_fetch(&d->count, 1, __ATOMIC_RELAXED);
+    netdata_mutex_unlock(&sender_dispatchers.mutex);
+
+    rrdpush_sender_thread_init(s);
+
+    struct rrdpush_sender_thread_data *thread_data = callocz(1, sizeof(struct rrdpush_sender_thread_data));
+    thread_data->sender_state = s;
+    thread_data->host = s->host;
+    thread_data->sending_definitions_status = SENDING_DEFINITIONS_RESTART;
+
+    s->dispatch.data = thread_data;
+    s->dispatch.connector_running = false;
+    s->dispatch.connecting = false;
+    s->dispatch.stop = false;
+    s->dispatch.connect_after_t = 0;
+
+    info("STREAM %s [send]: sending with the senders dispatcher.", rrdhost_hostname(s->host));
+
+    netdata_mutex_lock(&d->mutex);
+    __atomic_store_n(&s->dispatch.dispatcher, d, __ATOMIC_RELEASE);
+    netdata_mutex_unlock(&d->mutex);
+
+    rrdpush_sender_dispatcher_queue(s);
+    return true;
+}
+
+// stops sending the host and waits for the dispatcher to release it
+void rrdpush_sender_dispatcher_remove(struct sender_state *s) {
+    if(!__atomic_load_n(&s->dispatch.dispatcher, __ATOMIC_ACQUIRE))
+        return;
+
+    info("STREAM %s [send]: signaling the senders dispatcher to stop sending...", rrdhost_hostname(s->host));
+
+    __atomic_store_n(&s->dispatch.stop, true, __ATOMIC_RELEASE);
+    rrdpush_sender_dispatcher_queue(s);
+
+    while(__atomic_load_n(&s->dispatch.dispatcher, __ATOMIC_ACQUIRE))
+        sleep_usec(10 * USEC_PER_MS);
+
+    // the dispatcher releases the host with the sender mutex locked, wait for it to unlock it
+    netdata_mutex_lock(&s->mutex);
+    netdata_mutex_unlock(&s->mutex);
+
+    info("STREAM %s [send]: the senders dispatcher has stopped sending.", rrdhost_hostname(s->host));
+}
+
+#endif // __linux__
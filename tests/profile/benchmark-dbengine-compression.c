@@ -0,0 +1,289 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+/*
+ * Compares the compression ratio and the speed of the dbengine extent compression algorithms.
+ *
+ * Usage: benchmark-dbengine-compression [datafile-1-0000000001.ndf ...]
+ *
+ * The extents of the given data files are decompressed and then compressed again with every
+ * algorithm. Without data files, synthetic extents of storage_number pages are used.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <lz4.h>
+#include <zstd.h>
+#include <zdict.h>
+
+#include "database/engine/rrddiskprotocol.h"
+
+#define MAX_EXTENTS 65536
+#define MAX_EXTENT_PAGES 64
+#define SYNTHETIC_EXTENTS 256
+#define DICT_TRAINING_PAGES 256
+
+struct extent {
+    size_t size;
+    size_t pages;
+    size_t page_sizes[MAX_EXTENT_PAGES];
+    char *data;
+};
+
+static struct extent extents[MAX_EXTENTS];
+static size_t extents_count = 0;
+static size_t extents_bytes = 0;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int decompress_extent(uint8_t algorithm, const char *src, size_t src_size, char *dst, size_t dst_size, const ZSTD_DDict *ddict) {
+    switch(algorithm) {
+        case RRD_NO_COMPRESSION:
+            if(src_size != dst_size) return -1;
+            memcpy(dst, src, src_size);
+            return 0;
+
+        case RRD_LZ4:
+            return (LZ4_decompress_safe(src, dst, (int)src_size, (int)dst_size) == (int)dst_size) ? 0 : -1;
+
+        case RRD_ZSTD: {
+            static ZSTD_DCtx *dctx = NULL;
+            if(!dctx) dctx = ZSTD_createDCtx();
+            size_t ret = ZSTD_decompress_usingDDict(dctx, dst, dst_size, src, src_size, ddict);
+            return (ZSTD_isError(ret) || ret != dst_size) ? -1 : 0;
+        }
+
+        default:
+            return -1;
+    }
+}
+
+static void add_extent(char *data, size_t pages, const size_t *page_sizes) {
+    struct extent *e = &extents[extents_count++];
+    e->pages = pages;
+    e->size = 0;
+    for(size_t i = 0; i < pages; i++) {
+        e->page_sizes[i] = page_sizes[i];
+        e->size += page_sizes[i];
+    }
+    e->data = data;
+    extents_bytes += e->size;
+}
+
+static void load_datafile(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if(!fp) {
+        fprintf(stderr, "Cannot open '%s'\n", filename);
+        exit(1);
+    }
+
+    struct rrdeng_df_sb sb;
+    if(fread(&sb, sizeof(sb), 1, fp) != 1 || strncmp(sb.magic_number, RRDENG_DF_MAGIC, RRDENG_MAGIC_SZ) != 0) {
+        fprintf(stderr, "'%s' is not a dbengine data file\n", filename);
+        exit(1);
+    }
+
+    ZSTD_DDict *ddict = NULL;
+    if(sb.dict_size && sb.dict_size <= RRDENG_DF_SB_DICT_SZ) {
+        ddict = ZSTD_createDDict(sb.dict, sb.dict_size);
+        if(!ddict) {
+            fprintf(stderr, "cannot create the zstd dictionary of '%s'\n", filename);
+            exit(1);
+        }
+    }
+
+    size_t pos = RRDENG_BLOCK_SIZE, loaded = 0;
+    char block[RRDENG_BLOCK_SIZE];
+    while(extents_count < MAX_EXTENTS) {
+        if(fseek(fp, (long)pos, SEEK_SET) != 0 || fread(block, RRDENG_BLOCK_SIZE, 1, fp) != 1)
+            break;
+
+        struct rrdeng_df_extent_header *header = (struct rrdeng_df_extent_header *)block;
+        if(!header->number_of_pages || header->number_of_pages > MAX_EXTENT_PAGES || !header->payload_length)
+            break;
+
+        size_t payload_offset = sizeof(*header) + header->number_of_pages * sizeof(header->descr[0]);
+        size_t extent_size = payload_offset + header->payload_length + sizeof(struct rrdeng_df_extent_trailer);
+        char *raw = malloc(extent_size);
+        if(fseek(fp, (long)pos, SEEK_SET) != 0 || fread(raw, extent_size, 1, fp) != 1) {
+            free(raw);
+            break;
+        }
+        header = (struct rrdeng_df_extent_header *)raw;
+
+        size_t page_sizes[MAX_EXTENT_PAGES], uncompressed = 0;
+        for(size_t i = 0; i < header->number_of_pages; i++) {
+            page_sizes[i] = header->descr[i].page_length;
+            uncompressed += page_sizes[i];
+        }
+
+        char *data = malloc(uncompressed);
+        if(decompress_extent(header->compression_algorithm, raw + payload_offset, header->payload_length, data, uncompressed, ddict) == 0) {
+            add_extent(data, header->number_of_pages, page_sizes);
+            loaded++;
+        }
+        else
+            free(data);
+
+        free(raw);
+        pos += (extent_size + RRDENG_BLOCK_SIZE - 1) / RRDENG_BLOCK_SIZE * RRDENG_BLOCK_SIZE;
+    }
+
+    ZSTD_freeDDict(ddict);
+    fclose(fp);
+    fprintf(stderr, "Loaded %zu extents from '%s'\n", loaded, filename);
+}
+
+// collected metrics are mostly counters and slowly changing gauges, packed as storage_number
+static void generate_extents(void) {
+    size_t page_sizes[MAX_EXTENT_PAGES];
+    for(size_t i = 0; i < MAX_EXTENT_PAGES; i++)
+        page_sizes[i] = RRDENG_BLOCK_SIZE;
+
+    for(size_t e = 0; e < SYNTHETIC_EXTENTS; e++) {
+        char *data = malloc(MAX_EXTENT_PAGES * RRDENG_BLOCK_SIZE);
+        uint32_t *sn = (uint32_t *)data;
+        for(size_t p = 0; p < MAX_EXTENT_PAGES; p++) {
+            uint32_t value = (uint32_t)(random() % 100000);
+            int kind = (int)(random() % 3);
+            for(size_t i = 0; i < RRDENG_BLOCK_SIZE / sizeof(uint32_t); i++) {
+                if(kind == 0) value += (uint32_t)(random() % 100);
+                else if(kind == 1 && random() % 10 == 0) value = (uint32_t)(random() % 100000);
+                *sn++ = (1U << 24) | (value & 0x00FFFFFF);
+            }
+        }
+        add_extent(data, MAX_EXTENT_PAGES, page_sizes);
+    }
+}
+
+static void benchmark(const char *name, uint8_t algorithm, int level, const ZSTD_CDict *cdict, const ZSTD_DDict *ddict) {
+    size_t capacity = ZSTD_compressBound(MAX_EXTENT_PAGES * RRDENG_BLOCK_SIZE);
+    if((size_t)LZ4_compressBound(MAX_EXTENT_PAGES * RRDENG_BLOCK_SIZE) > capacity)
+        capacity = (size_t)LZ4_compressBound(MAX_EXTENT_PAGES * RRDENG_BLOCK_SIZE);
+
+    char **compressed = malloc(extents_count * sizeof(char *));
+    size_t *compressed_sizes = malloc(extents_count * sizeof(size_t));
+    char *decompressed = malloc(MAX_EXTENT_PAGES * RRDENG_BLOCK_SIZE);
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+    size_t total = 0, errors = 0;
+
+    double start = now_sec();
+    for(size_t i = 0; i < extents_count; i++) {
+        struct extent *e = &extents[i];
+        compressed[i] = malloc(capacity);
+
+        switch(algorithm) {
+            case RRD_LZ4:
+                compressed_sizes[i] = (size_t)LZ4_compress_default(e->data, compressed[i], (int)e->size, (int)capacity);
+                break;
+
+            case RRD_ZSTD:
+                if(cdict)
+                    compressed_sizes[i] = ZSTD_compress_usingCDict(cctx, compressed[i], capacity, e->data, e->size, cdict);
+                else
+                    compressed_sizes[i] = ZSTD_compressCCtx(cctx, compressed[i], capacity, e->data, e->size, level);
+                break;
+
+            default:
+                memcpy(compressed[i], e->data, e->size);
+                compressed_sizes[i] = e->size;
+                break;
+        }
+        total += compressed_sizes[i];
+    }
+    double compress_secs = now_sec() - start;
+
+    start = now_sec();
+    for(size_t i = 0; i < extents_count; i++) {
+        if(decompress_extent(algorithm, compressed[i], compressed_sizes[i], decompressed, extents[i].size, ddict) != 0 ||
+           memcmp(decompressed, extents[i].data, extents[i].size) != 0)
+            errors++;
+    }
+    double decompress_secs = now_sec() - start;
+
+    printf("%-16s ratio %6.2f, savings %6.2f%%, compress %8.1f MB/s, decompress %8.1f MB/s%s\n",
+           name,
+           (double)extents_bytes / (double)total,
+           100.0 - (double)total * 100.0 / (double)extents_bytes,
+           (double)extents_bytes / 1048576.0 / compress_secs,
+           (double)extents_bytes / 1048576.0 / decompress_secs,
+           errors ? ", ERRORS" : "");
+
+    for(size_t i = 0; i < extents_count; i++)
+        free(compressed[i]);
+    free(compressed);
+    free(compressed_sizes);
+    free(decompressed);
+    ZSTD_freeCCtx(cctx);
+}
+
+int main(int argc, char **argv) {
+    for(int i = 1; i < argc; i++)
+        load_datafile(argv[i]);
+
+    if(!extents_count)
+        generate_extents();
+
+    if(!extents_count) {
+        fprintf(stderr, "No extents found\n");
+        return 1;
+    }
+
+    printf("%zu extents, %zu bytes uncompressed\n", extents_count, extents_bytes);
+
+    benchmark("none", RRD_NO_COMPRESSION, 0, NULL, NULL);
+    benchmark("lz4", RRD_LZ4, 0, NULL, NULL);
+
+    int levels[] = { 1, 3, 6, 9, 19 };
+    for(size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        char name[50];
+        snprintf(name, sizeof(name), "zstd level %d", levels[i]);
+        benchmark(name, RRD_ZSTD, levels[i], NULL, NULL);
+    }
+
+    // train a dictionary the way dbengine does, from the pages of the first extents
+    size_t samples = 0, samples_bytes = 0;
+    size_t *sample_sizes = malloc(DICT_TRAINING_PAGES * sizeof(size_t));
+    char *samples_buffer = malloc(DICT_TRAINING_PAGES * RRDENG_BLOCK_SIZE);
+    for(size_t e = 0; e < extents_count && samples < DICT_TRAINING_PAGES; e++) {
+        size_t offset = 0;
+        for(size_t p = 0; p < extents[e].pages && samples < DICT_TRAINING_PAGES; p++) {
+            memcpy(samples_buffer + samples_bytes, extents[e].data + offset, extents[e].page_sizes[p]);
+            sample_sizes[samples++] = extents[e].page_sizes[p];
+            samples_bytes += extents[e].page_sizes[p];
+            offset += extents[e].page_sizes[p];
+        }
+    }
+
+    char dict[RRDENG_DF_SB_DICT_SZ];
+    size_t dict_size = ZDICT_trainFromBuffer(dict, sizeof(dict), samples_buffer, sample_sizes, (unsigned)samples);
+    if(ZDICT_isError(dict_size))
+        printf("cannot train a zstd dictionary: %s\n", ZDICT_getErrorName(dict_size));
+    else {
+        for(size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+            char name[50];
+            snprintf(name, sizeof(name), "zstd+dict %d", levels[i]);
+            ZSTD_CDict *cdict = ZSTD_createCDict(dict, dict_size, levels[i]);
+            ZSTD_DDict *ddict = ZSTD_createDDict(dict, dict_size);
+            if(cdict && ddict)
+                benchmark(name, RRD_ZSTD, levels[i], cdict, ddict);
+            else
+                printf("cannot create the zstd dictionaries for level %d\n", levels[i]);
+            ZSTD_freeCDict(cdict);
+            ZSTD_freeDDict(ddict);
+        }
+    }
+
+    free(samples_buffer);
+    free(sample_sizes);
+    for(size_t i = 0; i < extents_count; i++)
+        free(extents[i].data);
+
+    return 0;
+}
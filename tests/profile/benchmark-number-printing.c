@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+/*
+ * Compares the speed of print_netdata_double(), print_netdata_double_fixed() and
+ * snprintf(NETDATA_DOUBLE_FORMAT), and verifies that print_netdata_double_fixed()
+ * prints exactly what snprintf() prints.
+ *
+ * 1. build netdata (as normally)
+ * 2. cd tests/profile/
+ * 3. make benchmark-number-printing
+ */
+
+#include "config.h"
+#include "libnetdata/libnetdata.h"
+
+#define VALUES 1000000
+#define LOOPS 10
+
+void netdata_cleanup_and_exit(int ret) { exit(ret); }
+
+static NETDATA_DOUBLE values[VALUES];
+
+// the kinds of values netdata collects: counters, percentages, rates and tiny fractions
+static void generate_values(void) {
+    for(size_t i = 0; i < VALUES; i++) {
+        NETDATA_DOUBLE n;
+
+        switch(random() % 5) {
+            case 0:
+                n = (NETDATA_DOUBLE)(random() % 100000000);
+                break;
+
+            case 1:
+                n = (NETDATA_DOUBLE)(random() % 10000) / 100.0;
+                break;
+
+            case 2:
+                n = ((NETDATA_DOUBLE)random() / RAND_MAX - 0.5) * 1000000.0;
+                break;
+
+            case 3:
+                n = (NETDATA_DOUBLE)random() / RAND_MAX / 1000.0;
+                break;
+
+            default:
+                n = unpack_storage_number(pack_storage_number((NETDATA_DOUBLE)random() / 1000.0, SN_DEFAULT_FLAGS));
+                break;
+        }
+
+        values[i] = n;
+    }
+}
+
+static void benchmark(const char *name, int (*print)(char *str, NETDATA_DOUBLE value)) {
+    char buf[100];
+    size_t bytes = 0;
+
+    usec_t start = now_monotonic_usec();
+    for(int loop = 0; loop < LOOPS; loop++)
+        for(size_t i = 0; i < VALUES; i++)
+            bytes += (size_t)print(buf, values[i]);
+    usec_t dt = now_monotonic_usec() - start;
+
+    fprintf(stderr, "%-28s %8.1f ns per number, %zu bytes\n", name, (double)dt * 1000.0 / (LOOPS * VALUES), bytes);
+}
+
+static int print_with_snprintf(char *str, NETDATA_DOUBLE value) {
+    return snprintf(str, 50, NETDATA_DOUBLE_FORMAT, value);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    generate_values();
+
+    size_t errors = 0;
+    for(size_t i = 0; i < VALUES; i++) {
+        char fast[100], slow[100];
+        print_netdata_double_fixed(fast, values[i]);
+        print_with_snprintf(slow, values[i]);
+
+        if(strcmp(fast, slow) != 0 && errors++ < 10)
+            fprintf(stderr, "MISMATCH: '%s' printed as '%s'\n", slow, fast);
+    }
+    fprintf(stderr, "%zu of %d numbers printed differently than snprintf()\n\n", errors, VALUES);
+
+    benchmark("snprintf()", print_with_snprintf);
+    benchmark("print_netdata_double_fixed()", print_netdata_double_fixed);
+    benchmark("print_netdata_double()", print_netdata_double);
+
+    return errors ? 1 : 0;
+}
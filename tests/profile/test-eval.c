@@ -280,7 +280,7 @@ int main(int argc, char **argv) {
 			printf("\nEvaluates to: %Lf\n\n", exp->result);
 		}
 		else {
-			printf("\nEvaluation failed with code %d and message: %s\n\n", exp->error, buffer_tostring(exp->error_msg));
+			printf("\nEvaluation failed with code %d and message: %s\n\n", exp->error, expression_error_msg(exp));
 		}
 		expression_free(exp);
 	}
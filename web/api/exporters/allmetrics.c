@@ -91,16 +91,19 @@ inline int web_client_api_request_v1_allmetrics(RRDHOST *host, struct web_client
     switch(format) {
         case ALLMETRICS_JSON:
             w->response.data->contenttype = CT_APPLICATION_JSON;
+            web_client_enable_streaming(w);
             rrd_stats_api_v1_charts_allmetrics_json(host, filter, w->response.data);
             return HTTP_RESP_OK;
 
         case ALLMETRICS_SHELL:
             w->response.data->contenttype = CT_TEXT_PLAIN;
+            web_client_enable_streaming(w);
             rrd_stats_api_v1_charts_allmetrics_shell(host, filter, w->response.data);
             return HTTP_RESP_OK;
 
         case ALLMETRICS_PROMETHEUS:
             w->response.data->contenttype = CT_PROMETHEUS;
+            web_client_enable_streaming(w);
             rrd_stats_api_v1_charts_allmetrics_prometheus_single_host(
                     host
                     , filter
@@ -114,6 +117,7 @@ inline int web_client_api_request_v1_allmetrics(RRDHOST *host, struct web_client
 
         case ALLMETRICS_PROMETHEUS_ALL_HOSTS:
             w->response.data->contenttype = CT_PROMETHEUS;
+            web_client_enable_streaming(w);
             rrd_stats_api_v1_charts_allmetrics_prometheus_all_hosts(
                     host
                     , filter
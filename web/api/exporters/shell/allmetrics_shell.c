@@ -29,6 +29,8 @@ void rrd_stats_api_v1_charts_allmetrics_shell(RRDHOST *host, const char *filter_
     // for each chart
     RRDSET *st;
     rrdset_foreach_read(st, host) {
+        buffer_stream_checkpoint(wb);
+
         if (filter && !simple_pattern_matches(filter, rrdset_name(st)))
             continue;
 
@@ -69,6 +71,8 @@ void rrd_stats_api_v1_charts_allmetrics_shell(RRDHOST *host, const char *filter_
 
     RRDCALC *rc;
     foreach_rrdcalc_in_rrdhost_read(host, rc) {
+        buffer_stream_checkpoint(wb);
+
         if(!rc->rrdset) continue;
 
         char chart[SHELL_ELEMENT_MAX + 1];
@@ -107,6 +111,8 @@ void rrd_stats_api_v1_charts_allmetrics_json(RRDHOST *host, const char *filter_s
     // for each chart
     RRDSET *st;
     rrdset_foreach_read(st, host) {
+        buffer_stream_checkpoint(wb);
+
         if (filter && !(simple_pattern_matches(filter, rrdset_id(st)) || simple_pattern_matches(filter, rrdset_name(st))))
             continue;
 
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "libnetdata/libnetdata.h"
+#include "binary.h"
+
+// all the numbers of the payload are little endian
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define binary_le32(x) __builtin_bswap32(x)
+#define binary_le64(x) __builtin_bswap64(x)
+#else
+#define binary_le32(x) (x)
+#define binary_le64(x) (x)
+#endif
+
+#define BINARY_ALIGNMENT 8
+#define binary_padding(len) ((BINARY_ALIGNMENT - ((len) % BINARY_ALIGNMENT)) % BINARY_ALIGNMENT)
+
+static inline char *binary_reserve(BUFFER *wb, size_t len) {
+    buffer_need_bytes(wb, len + 1);
+    char *s = &wb->buffer[wb->len];
+    wb->len += len;
+    wb->buffer[wb->len] = '\0';
+    return s;
+}
+
+static inline void binary_put_u32(BUFFER *wb, uint32_t v) {
+    v = binary_le32(v);
+    memcpy(binary_reserve(wb, sizeof(v)), &v, sizeof(v));
+}
+
+static inline void binary_put_i64(BUFFER *wb, int64_t v) {
+    uint64_t u = binary_le64((uint64_t)v);
+    memcpy(binary_reserve(wb, sizeof(u)), &u, sizeof(u));
+}
+
+static inline void binary_put_string(BUFFER *wb, const char *s) {
+    size_t len = strlen(s);
+    binary_put_u32(wb, (uint32_t)len);
+    memcpy(binary_reserve(wb, len), s, len);
+}
+
+static inline void binary_put_padding(BUFFER *wb) {
+    size_t pad = binary_padding(wb->len);
+    if(pad) memset(binary_reserve(wb, pad), 0, pad);
+}
+
+static inline int binary_dimension_is_visible(RRDR *r, long c, RRDR_OPTIONS options) {
+    if(unlikely(r->od[c] & RRDR_DIMENSION_HIDDEN)) return 0;
+    if(unlikely((options & RRDR_OPTION_NONZERO) && !(r->od[c] & RRDR_DIMENSION_NONZERO))) return 0;
+    return 1;
+}
+
+// a bitmap with one bit per row (least significant bit first), set for the rows having all bits of flags
+// set (or none of them, when inverse is set), padded to the alignment of the payload
+static void binary_put_bitmap(BUFFER *wb, RRDR *r, long c, long start, long step, RRDR_VALUE_FLAGS flags, int inverse) {
+    long rows = rrdr_rows(r);
+    size_t bytes = (size_t)(rows + 7) / 8;
+    uint8_t *bitmap = (uint8_t *)binary_reserve(wb, bytes + binary_padding(bytes));
+    memset(bitmap, 0, bytes + binary_padding(bytes));
+
+    long i, row;
+    for(i = start, row = 0; row < rows ; i += step, row++) {
+        int set = (r->o[i * r->d + c] & flags) ? 1 : 0;
+        if(set != inverse)
+            bitmap[row >> 3] |= (uint8_t)(1 << (row & 7));
+    }
+}
+
+void rrdr2binary(RRDR *r, BUFFER *wb, RRDR_OPTIONS options, RRDDIM *temp_rd) {
+    rrdset_check_rdlock(r->st);
+
+    long c, i, row;
+    RRDDIM *d;
+    long rows = rrdr_rows(r);
+
+    uint32_t columns = 0;
+    for(c = 0, d = temp_rd?temp_rd:r->st->dimensions; d && c < r->d ;c++, d = d->next)
+        if(binary_dimension_is_visible(r, c, options)) columns++;
+
+    // the header
+    memcpy(binary_reserve(wb, 6), RRDR_BINARY_MAGIC, 6);
+    uint16_t version = RRDR_BINARY_VERSION;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    version = __builtin_bswap16(version);
+#endif
+    memcpy(binary_reserve(wb, sizeof(version)), &version, sizeof(version));
+    binary_put_u32(wb, (uint32_t)rows);
+    binary_put_u32(wb, columns);
+    binary_put_i64(wb, (int64_t)r->after);
+    binary_put_i64(wb, (int64_t)r->before);
+    binary_put_i64(wb, (int64_t)r->update_every);
+
+    // the ids and the names of the columns
+    for(c = 0, d = temp_rd?temp_rd:r->st->dimensions; d && c < r->d ;c++, d = d->next) {
+        if(!binary_dimension_is_visible(r, c, options)) continue;
+        binary_put_string(wb, rrddim_id(d));
+        binary_put_string(wb, rrddim_name(d));
+    }
+    binary_put_padding(wb);
+
+    long start = 0, end = rows, step = 1;
+    if(!(options & RRDR_OPTION_REVERSED)) {
+        start = rows - 1;
+        end = -1;
+        step = -1;
+    }
+
+    // the timestamps column
+    int64_t multiplier = (options & RRDR_OPTION_MILLISECONDS) ? 1000 : 1;
+    uint64_t *ts = (uint64_t *)binary_reserve(wb, (size_t)rows * sizeof(uint64_t));
+    for(i = start, row = 0; i != end ; i += step, row++) {
+        uint64_t t = binary_le64((uint64_t)((int64_t)r->t[i] * multiplier));
+        memcpy(&ts[row], &t, sizeof(t));
+    }
+
+    // the row totals, for percentages
+    NETDATA_DOUBLE *totals = NULL;
+    if(unlikely(options & RRDR_OPTION_PERCENTAGE)) {
+        totals = mallocz((size_t)rows * sizeof(NETDATA_DOUBLE));
+        for(i = 0; i < rows ; i++) {
+            NETDATA_DOUBLE total = 0;
+            for(c = 0; c < r->d ; c++) {
+                NETDATA_DOUBLE n = r->v[i * r->d + c];
+
+                if(likely((options & RRDR_OPTION_ABSOLUTE) && n < 0))
+                    n = -n;
+
+                total += n;
+            }
+            // prevent a division by zero
+            totals[i] = (total == 0) ? 1 : total;
+        }
+    }
+
+    // the columns of the dimensions
+    int set_min_max = 1;
+    for(c = 0, d = temp_rd?temp_rd:r->st->dimensions; d && c < r->d ;c++, d = d->next) {
+        if(!binary_dimension_is_visible(r, c, options)) continue;
+
+        if(options & RRDR_OPTION_NULL2ZERO)
+            binary_put_bitmap(wb, r, c, start, step, RRDR_VALUE_NOTHING, 1);
+        else
+            binary_put_bitmap(wb, r, c, start, step, RRDR_VALUE_EMPTY, 1);
+
+        binary_put_bitmap(wb, r, c, start, step, RRDR_VALUE_RESET, 0);
+
+        uint64_t *values = (uint64_t *)binary_reserve(wb, (size_t)rows * sizeof(uint64_t));
+        for(i = start, row = 0; i != end ; i += step, row++) {
+            NETDATA_DOUBLE n = r->v[i * r->d + c];
+            double v;
+
+            if(unlikely(r->o[i * r->d + c] & RRDR_VALUE_EMPTY))
+                v = (options & RRDR_OPTION_NULL2ZERO) ? 0.0 : NAN;
+            else {
+                if(unlikely((options & RRDR_OPTION_ABSOLUTE) && n < 0))
+                    n = -n;
+
+                if(unlikely(totals)) {
+                    n = n * 100 / totals[i];
+
+                    if(unlikely(set_min_max)) {
+                        r->min = r->max = n;
+                        set_min_max = 0;
+                    }
+
+                    if(n < r->min) r->min = n;
+                    if(n > r->max) r->max = n;
+                }
+
+                v = (double)n;
+            }
+
+            uint64_t u;
+            memcpy(&u, &v, sizeof(u));
+            u = binary_le64(u);
+            memcpy(&values[row], &u, sizeof(u));
+        }
+    }
+
+    freez(totals);
+}
@@ -171,6 +171,10 @@ void rrdr_buffer_print_format(BUFFER *wb, uint32_t format)  {
             buffer_strcat(wb, DATASOURCE_FORMAT_SSV_COMMA);
             break;
 
+        case DATASOURCE_BINARY:
+            buffer_strcat(wb, DATASOURCE_FORMAT_BINARY);
+            break;
+
         default:
             buffer_strcat(wb, "unknown");
             break;
@@ -282,7 +286,7 @@ int rrdset2anything_api_v1(
         before,
         group_method,
         group_time,
-        options,
+        options | RRDR_OPTION_INTERNAL_CACHE,
         dimensions ? buffer_tostring(dimensions) : NULL,
         query_params->context_param_list,
         group_options,
@@ -423,6 +427,12 @@ int rrdset2anything_api_v1(
         }
         break;
 
+    case DATASOURCE_BINARY:
+        // there is no JSON wrapper for binary payloads, the metadata are in the payload header
+        wb->contenttype = CT_APPLICATION_OCTET_STREAM;
+        rrdr2binary(r, wb, options, temp_rd);
+        break;
+
     case DATASOURCE_DATATABLE_JSONP:
         wb->contenttype = CT_APPLICATION_X_JAVASCRIPT;
 
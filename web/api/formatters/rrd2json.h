@@ -22,6 +22,7 @@ typedef struct query_params {
 #include "web/api/formatters/ssv/ssv.h"
 #include "web/api/formatters/json/json.h"
 #include "web/api/formatters/value/value.h"
+#include "web/api/formatters/binary/binary.h"
 
 #include "web/api/formatters/rrdset2json.h"
 #include "web/api/formatters/charts2json.h"
@@ -47,6 +48,7 @@ typedef struct query_params {
 #define DATASOURCE_SSV_COMMA 9
 #define DATASOURCE_CSV_JSON_ARRAY 10
 #define DATASOURCE_CSV_MARKDOWN 11
+#define DATASOURCE_BINARY 12
 
 #define DATASOURCE_FORMAT_JSON "json"
 #define DATASOURCE_FORMAT_DATATABLE_JSON "datatable"
@@ -60,6 +62,7 @@ typedef struct query_params {
 #define DATASOURCE_FORMAT_SSV_COMMA "ssvcomma"
 #define DATASOURCE_FORMAT_CSV_JSON_ARRAY "csvjsonarray"
 #define DATASOURCE_FORMAT_CSV_MARKDOWN "markdown"
+#define DATASOURCE_FORMAT_BINARY "binary"
 
 extern void rrd_stats_api_v1_chart(RRDSET *st, BUFFER *wb);
 extern void rrdr_buffer_print_format(BUFFER *wb, uint32_t format);
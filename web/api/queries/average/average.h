@@ -10,6 +10,7 @@ extern void grouping_create_average(RRDR *r, const char *options __maybe_unused)
 extern void grouping_reset_average(RRDR *r);
 extern void grouping_free_average(RRDR *r);
 extern void grouping_add_average(RRDR *r, NETDATA_DOUBLE value);
+extern void grouping_add_array_average(RRDR *r, const NETDATA_DOUBLE *values, size_t count);
 extern NETDATA_DOUBLE grouping_flush_average(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr);
 
 #endif //NETDATA_API_QUERY_AVERAGE_H
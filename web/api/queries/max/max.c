@@ -36,6 +36,25 @@ void grouping_add_max(RRDR *r, NETDATA_DOUBLE value) {
     }
 }
 
+void grouping_add_array_max(RRDR *r, const NETDATA_DOUBLE *values, size_t count) {
+    struct grouping_max *g = (struct grouping_max *)r->internal.grouping_data;
+    size_t i = 0;
+
+    if(unlikely(!count)) return;
+
+    if(!g->count) {
+        g->max = values[i++];
+        g->count++;
+    }
+
+    NETDATA_DOUBLE max = g->max;
+    for( ; i < count ;i++)
+        if(fabsndd(values[i]) > fabsndd(max))
+            max = values[i];
+
+    g->max = max;
+}
+
 NETDATA_DOUBLE grouping_flush_max(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct grouping_max *g = (struct grouping_max *)r->internal.grouping_data;
 
@@ -10,6 +10,7 @@ extern void grouping_create_max(RRDR *r, const char *options __maybe_unused);
 extern void grouping_reset_max(RRDR *r);
 extern void grouping_free_max(RRDR *r);
 extern void grouping_add_max(RRDR *r, NETDATA_DOUBLE value);
+extern void grouping_add_array_max(RRDR *r, const NETDATA_DOUBLE *values, size_t count);
 extern NETDATA_DOUBLE grouping_flush_max(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr);
 
 #endif //NETDATA_API_QUERY_MAX_H
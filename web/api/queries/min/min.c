@@ -36,6 +36,25 @@ void grouping_add_min(RRDR *r, NETDATA_DOUBLE value) {
     }
 }
 
+void grouping_add_array_min(RRDR *r, const NETDATA_DOUBLE *values, size_t count) {
+    struct grouping_min *g = (struct grouping_min *)r->internal.grouping_data;
+    size_t i = 0;
+
+    if(unlikely(!count)) return;
+
+    if(!g->count) {
+        g->min = values[i++];
+        g->count++;
+    }
+
+    NETDATA_DOUBLE min = g->min;
+    for( ; i < count ;i++)
+        if(fabsndd(values[i]) < fabsndd(min))
+            min = values[i];
+
+    g->min = min;
+}
+
 NETDATA_DOUBLE grouping_flush_min(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct grouping_min *g = (struct grouping_min *)r->internal.grouping_data;
 
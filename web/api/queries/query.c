@@ -3,6 +3,7 @@
 #include "query.h"
 #include "web/api/formatters/rrd2json.h"
 #include "rrdr.h"
+#include "query_cache.h"
 
 #include "average/average.h"
 #include "countif/countif.h"
@@ -44,6 +45,12 @@ static struct {
     // The module may decide to cache it, or use it in the fly.
     void (*add)(struct rrdresult *r, NETDATA_DOUBLE value);
 
+    // Add an array of values into the calculation, optional.
+    // When available, the query engine collects the values of a group
+    // and passes them here in batches, instead of calling add() for each one.
+    // Only modules that don't depend on the order of the values can have it.
+    void (*add_array)(struct rrdresult *r, const NETDATA_DOUBLE *values, size_t count);
+
     // Generate a single result for the values added so far.
     // More values and points may be requested later.
     // It is up to the module to reset its internal structures
@@ -62,6 +69,7 @@ static struct {
                 .reset = grouping_reset_average,
                 .free  = grouping_free_average,
                 .add   = grouping_add_average,
+                .add_array = grouping_add_array_average,
                 .flush = grouping_flush_average,
                 .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
         },
@@ -73,6 +81,7 @@ static struct {
                 .reset = grouping_reset_average,
                 .free  = grouping_free_average,
                 .add   = grouping_add_average,
+                .add_array = grouping_add_array_average,
                 .flush = grouping_flush_average,
                 .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
         },
@@ -425,6 +434,7 @@ static struct {
                 .reset = grouping_reset_min,
                 .free  = grouping_free_min,
                 .add   = grouping_add_min,
+                .add_array = grouping_add_array_min,
                 .flush = grouping_flush_min,
                 .tier_query_fetch = TIER_QUERY_FETCH_MIN
         },
@@ -436,6 +446,7 @@ static struct {
                 .reset = grouping_reset_max,
                 .free  = grouping_free_max,
                 .add   = grouping_add_max,
+                .add_array = grouping_add_array_max,
                 .flush = grouping_flush_max,
                 .tier_query_fetch = TIER_QUERY_FETCH_MAX
         },
@@ -447,6 +458,7 @@ static struct {
                 .reset = grouping_reset_sum,
                 .free  = grouping_free_sum,
                 .add   = grouping_add_sum,
+                .add_array = grouping_add_array_sum,
                 .flush = grouping_flush_sum,
                 .tier_query_fetch = TIER_QUERY_FETCH_SUM
         },
@@ -583,6 +595,7 @@ static struct {
                 .reset = grouping_reset_average,
                 .free  = grouping_free_average,
                 .add   = grouping_add_average,
+                .add_array = grouping_add_array_average,
                 .flush = grouping_flush_average,
                 .tier_query_fetch = TIER_QUERY_FETCH_AVERAGE
         }
@@ -640,6 +653,7 @@ static void rrdr_set_grouping_function(RRDR *r, RRDR_GROUPING group_method) {
             r->internal.grouping_reset   = api_v1_data_groups[i].reset;
             r->internal.grouping_free    = api_v1_data_groups[i].free;
             r->internal.grouping_add     = api_v1_data_groups[i].add;
+            r->internal.grouping_add_array = api_v1_data_groups[i].add_array;
             r->internal.grouping_flush   = api_v1_data_groups[i].flush;
             r->internal.tier_query_fetch = api_v1_data_groups[i].tier_query_fetch;
             found = 1;
@@ -652,6 +666,7 @@ static void rrdr_set_grouping_function(RRDR *r, RRDR_GROUPING group_method) {
         r->internal.grouping_reset   = grouping_reset_average;
         r->internal.grouping_free    = grouping_free_average;
         r->internal.grouping_add     = grouping_add_average;
+        r->internal.grouping_add_array = grouping_add_array_average;
         r->internal.grouping_flush   = grouping_flush_average;
         r->internal.tier_query_fetch = TIER_QUERY_FETCH_AVERAGE;
     }
@@ -914,6 +929,10 @@ typedef struct query_plan {
     QUERY_PLAN_ENTRY data[RRD_STORAGE_TIERS*2];
 } QUERY_PLAN;
 
+// the number of points fetched from the db, and the number of values given to the
+// grouping module, per call
+#define QUERY_BATCH_POINTS 128
+
 typedef struct query_engine_ops {
     // configuration
     RRDR *r;
@@ -932,11 +951,20 @@ typedef struct query_engine_ops {
     struct rrddim_tier *tier_ptr;
     struct rrddim_query_handle handle;
     STORAGE_POINT (*next_metric)(struct rrddim_query_handle *handle);
+    size_t (*next_metrics)(struct rrddim_query_handle *handle, STORAGE_POINT *points, size_t max);
     int (*is_finished)(struct rrddim_query_handle *handle);
     void (*finalize)(struct rrddim_query_handle *handle);
 
+    // the points fetched by next_metrics(), not used yet
+    size_t points_count;
+    size_t points_position;
+    STORAGE_POINT points[QUERY_BATCH_POINTS];
+
     // aggregating points over time
     void (*grouping_add)(struct rrdresult *r, NETDATA_DOUBLE value);
+    void (*grouping_add_array)(struct rrdresult *r, const NETDATA_DOUBLE *values, size_t count);
+    size_t group_values_count;
+    NETDATA_DOUBLE group_values[QUERY_BATCH_POINTS];
     NETDATA_DOUBLE (*grouping_flush)(struct rrdresult *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr);
     size_t group_points_non_zero;
     size_t group_points_added;
@@ -968,10 +996,15 @@ static void query_planer_activate_plan(QUERY_ENGINE_OPS *ops, size_t plan_id, ti
     ops->tier_ptr = ops->rd->tiers[ops->tier];
     ops->tier_ptr->query_ops.init(ops->tier_ptr->db_metric_handle, &ops->handle, after, before, ops->r->internal.tier_query_fetch);
     ops->next_metric = ops->tier_ptr->query_ops.next_metric;
+    ops->next_metrics = ops->tier_ptr->query_ops.next_metrics;
     ops->is_finished = ops->tier_ptr->query_ops.is_finished;
     ops->finalize = ops->tier_ptr->query_ops.finalize;
     ops->current_plan = plan_id;
     ops->current_plan_expire_time = ops->plan.data[plan_id].before;
+
+    // the points fetched from the previous plan are not needed any more
+    ops->points_count = 0;
+    ops->points_position = 0;
 }
 
 static void query_planer_next_plan(QUERY_ENGINE_OPS *ops, time_t now, time_t last_point_end_time) {
@@ -1133,6 +1166,14 @@ static void query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         }                                                               \
 } while(0)
 
+// give the values collected so far to the grouping module
+#define query_group_values_flush(r, ops)                          do {  \
+    if((ops).group_values_count) {                                      \
+        (ops).grouping_add_array(r, (ops).group_values, (ops).group_values_count); \
+        (ops).group_values_count = 0;                                   \
+    }                                                                   \
+} while(0)
+
 #define query_add_point_to_group(r, point, ops)                   do {  \
     if(likely(netdata_double_isnumber((point).value))) {                \
         if(likely(fpclassify((point).value) != FP_ZERO))                \
@@ -1141,13 +1182,39 @@ static void query_plan(QUERY_ENGINE_OPS *ops, time_t after_wanted, time_t before
         if(unlikely((point).flags & SN_FLAG_RESET))                     \
             (ops).group_value_flags |= RRDR_VALUE_RESET;                \
                                                                         \
-        (ops).grouping_add(r, (point).value);                           \
+        if(likely((ops).grouping_add_array)) {                          \
+            (ops).group_values[(ops).group_values_count++] = (point).value; \
+            if(unlikely((ops).group_values_count == QUERY_BATCH_POINTS)) \
+                query_group_values_flush(r, ops);                       \
+        }                                                               \
+        else                                                            \
+            (ops).grouping_add(r, (point).value);                       \
     }                                                                   \
                                                                         \
     (ops).group_points_added++;                                         \
     (ops).group_anomaly_rate += (point).anomaly;                        \
 } while(0)
 
+static inline int query_is_finished(QUERY_ENGINE_OPS *ops) {
+    return ops->points_position >= ops->points_count && ops->is_finished(&ops->handle);
+}
+
+// fetch the next point of the db, in batches when the storage engine supports it
+static inline STORAGE_POINT query_next_point(QUERY_ENGINE_OPS *ops) {
+    if(likely(ops->points_position < ops->points_count))
+        return ops->points[ops->points_position++];
+
+    if(likely(ops->next_metrics)) {
+        ops->points_count = ops->next_metrics(&ops->handle, ops->points, QUERY_BATCH_POINTS);
+        ops->points_position = 0;
+
+        if(likely(ops->points_count))
+            return ops->points[ops->points_position++];
+    }
+
+    return ops->next_metric(&ops->handle);
+}
+
 static inline void rrd2rrdr_do_dimension(
     RRDR *r
     , long points_wanted
@@ -1165,6 +1232,7 @@ static inline void rrd2rrdr_do_dimension(
         .r = r,
         .rd = rd,
         .grouping_add = r->internal.grouping_add,
+        .grouping_add_array = r->internal.grouping_add_array,
         .grouping_flush = r->internal.grouping_flush,
         .tier_query_fetch = r->internal.tier_query_fetch,
         .view_update_every = r->update_every,
@@ -1202,7 +1270,7 @@ static inline void rrd2rrdr_do_dimension(
                 last1_point = new_point;
             }
 
-            if(unlikely(ops.is_finished(&ops.handle))) {
+            if(unlikely(query_is_finished(&ops))) {
                 if(count_same_end_time != 0) {
                     last2_point = last1_point;
                     last1_point = new_point;
@@ -1215,7 +1283,7 @@ static inline void rrd2rrdr_do_dimension(
 
             // fetch the new point
             {
-                STORAGE_POINT sp = ops.next_metric(&ops.handle);
+                STORAGE_POINT sp = query_next_point(&ops);
 
                 ops.db_points_read_per_tier[ops.tier]++;
                 ops.db_total_points_read++;
@@ -1379,6 +1447,9 @@ static inline void rrd2rrdr_do_dimension(
             *rrdr_value_options_ptr = ops.group_value_flags;
 
             // store the group value
+            if(likely(ops.grouping_add_array))
+                query_group_values_flush(r, ops);
+
             NETDATA_DOUBLE group_value = ops.grouping_flush(r, rrdr_value_options_ptr);
             r->v[rrdr_o_v_index] = group_value;
 
@@ -1430,6 +1501,294 @@ static inline void rrd2rrdr_do_dimension(
                    rrdset_name(r->st), rrddim_name(rd), (size_t)points_wanted, (size_t)points_added, ops.db_total_points_read);
 }
 
+// ----------------------------------------------------------------------------
+// parallel execution of the dimensions of a query
+//
+// The dimensions of a query are independent until they are merged into the RRDR,
+// so the dimensions of large queries are split across a pool of query threads.
+// The web worker running the query processes dimensions too. The pool threads
+// that become available while the query runs join it, until all its dimensions
+// have been claimed.
+//
+// Every thread runs rrd2rrdr_do_dimension() on its own copy of the RRDR, with
+// its own ONEWAYALLOC and grouping state. The copies share the values of the
+// RRDR, each dimension writes only its own column. The timestamps are the same
+// for all dimensions, so only the web worker writes them, with the first
+// dimension, and the helpers write theirs to a private array. The remaining
+// members of the copies are merged into the RRDR afterwards, in the order of
+// the dimensions.
+
+static struct {
+    size_t threads;                 // the size of the pool, 0 disables parallel queries
+    size_t max_threads_per_query;   // including the thread running the query
+    size_t min_dimensions;          // smaller queries run serially
+
+    bool started;
+    bool stop;                      // the threads have to exit
+    netdata_thread_t *thread_ids;   // the threads started, to be joined
+    netdata_mutex_t mutex;
+    pthread_cond_t cond;
+    struct query_parallel_job *jobs; // the jobs waiting for helpers
+} query_workers = {
+    .threads = 0,
+    .max_threads_per_query = 4,
+    .min_dimensions = 50,
+    .started = false,
+    .stop = false,
+    .thread_ids = NULL,
+    .mutex = NETDATA_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .jobs = NULL,
+};
+
+struct query_dimension_result {
+    bool done;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+    time_t before;
+    time_t after;
+    long rows;
+    size_t result_points_generated;
+    size_t db_points_read;
+    size_t tier_points_read[RRD_STORAGE_TIERS];
+};
+
+struct query_parallel_job {
+    RRDR *r;
+    const char *group_options;
+    long points_wanted;
+    time_t after_wanted;
+    time_t before_wanted;
+    usec_t deadline_ut;             // 0 when the query has no timeout
+
+    size_t dimensions;
+    RRDDIM **rd;
+    long *dim_id;
+    struct query_dimension_result *results;
+
+    size_t next;                    // the next dimension to be claimed, atomic
+    bool cancelled;                 // the timeout has been reached
+
+    // protected by query_workers.mutex
+    size_t helpers_wanted;
+    size_t helpers_running;
+    bool queued;
+    pthread_cond_t helpers_done;
+    struct query_parallel_job *prev, *next_job;
+};
+
+// runs dimension i of the job on the copy of the RRDR of this thread
+// returns false when the query has been cancelled
+static bool query_parallel_job_run_dimension(struct query_parallel_job *job, RRDR *shadow, size_t i) {
+    RRDR *r = job->r;
+
+    if(unlikely(job->deadline_ut && now_realtime_usec() > job->deadline_ut)) {
+        __atomic_store_n(&job->cancelled, true, __ATOMIC_RELAXED);
+        return false;
+    }
+    if(unlikely(__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED)))
+        return false;
+
+    struct query_dimension_result *result = &job->results[i];
+
+    // the first dimension of the RRDR resets min and max with its first point,
+    // all the others have to be merged with the RRDR ones
+    if(job->dim_id[i] == 0) {
+        shadow->min = r->min;
+        shadow->max = r->max;
+    }
+    else {
+        shadow->min = INFINITY;
+        shadow->max = -INFINITY;
+    }
+    shadow->internal.result_points_generated = 0;
+    shadow->internal.db_points_read = 0;
+    memset(shadow->internal.tier_points_read, 0, sizeof(shadow->internal.tier_points_read));
+
+    r->internal.grouping_reset(shadow);
+    rrd2rrdr_do_dimension(shadow, job->points_wanted, job->rd[i], job->dim_id[i], job->after_wanted, job->before_wanted);
+
+    result->min = shadow->min;
+    result->max = shadow->max;
+    result->before = shadow->before;
+    result->after = shadow->after;
+    result->rows = shadow->rows;
+    result->result_points_generated = shadow->internal.result_points_generated;
+    result->db_points_read = shadow->internal.db_points_read;
+    memcpy(result->tier_points_read, shadow->internal.tier_points_read, sizeof(result->tier_points_read));
+    __atomic_store_n(&result->done, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+// the web worker running the query is the owner of the job, it writes the timestamps of the RRDR
+static void query_parallel_job_run(struct query_parallel_job *job, bool owner) {
+    RRDR *r = job->r;
+    RRDR shadow = *r;
+
+    shadow.internal.owa = onewayalloc_create(0);
+    r->internal.grouping_create(&shadow, job->group_options);
+
+    if(!owner)
+        shadow.t = onewayalloc_callocz(shadow.internal.owa, r->n, sizeof(time_t));
+
+    bool ok = true;
+    if(owner)
+        ok = query_parallel_job_run_dimension(job, &shadow, 0);
+
+    size_t i;
+    while(ok && (i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->dimensions)
+        ok = query_parallel_job_run_dimension(job, &shadow, i);
+
+    r->internal.grouping_free(&shadow);
+    onewayalloc_destroy(shadow.internal.owa);
+}
+
+static void *query_worker_main(void *ptr __maybe_unused) {
+    netdata_mutex_lock(&query_workers.mutex);
+
+    while(!query_workers.stop) {
+        struct query_parallel_job *job = query_workers.jobs;
+        if(!job) {
+            pthread_cond_wait(&query_workers.cond, &query_workers.mutex);
+            continue;
+        }
+
+        if(!--job->helpers_wanted) {
+            DOUBLE_LINKED_LIST_REMOVE_UNSAFE(query_workers.jobs, job, prev, next_job);
+            job->queued = false;
+        }
+        job->helpers_running++;
+        netdata_mutex_unlock(&query_workers.mutex);
+
+        query_parallel_job_run(job, false);
+
+        netdata_mutex_lock(&query_workers.mutex);
+        if(!--job->helpers_running)
+            pthread_cond_signal(&job->helpers_done);
+    }
+
+    netdata_mutex_unlock(&query_workers.mutex);
+    return NULL;
+}
+
+void web_client_api_v1_init_query_workers(void) {
+    long long cpus = (long long)get_system_cpus();
+
+    long long threads = config_get_number(CONFIG_SECTION_WEB, "query threads", 0);
+    if(threads < 0)
+        threads = 0;
+    if(threads > cpus) {
+        error("QUERY: [%s].query threads = %lld is more than the %lld cores of the system, using %lld.",
+              CONFIG_SECTION_WEB, threads, cpus, cpus);
+        threads = cpus;
+    }
+
+    query_workers.threads = (size_t)threads;
+    query_workers.max_threads_per_query = (size_t)config_get_number(CONFIG_SECTION_WEB, "query max threads per query", (long long)query_workers.max_threads_per_query);
+    query_workers.min_dimensions = (size_t)config_get_number(CONFIG_SECTION_WEB, "query parallel min dimensions", (long long)query_workers.min_dimensions);
+
+    if(query_workers.max_threads_per_query < 2)
+        query_workers.threads = 0;
+}
+
+// the threads are started on the first parallel query, after netdata has forked
+static void query_workers_start(void) {
+    netdata_mutex_lock(&query_workers.mutex);
+
+    if(!query_workers.started && !query_workers.stop) {
+        size_t started = 0;
+        query_workers.thread_ids = callocz(query_workers.threads, sizeof(netdata_thread_t));
+
+        for(size_t i = 0; i < query_workers.threads ; i++) {
+            char tag[NETDATA_THREAD_TAG_MAX + 1];
+            snprintfz(tag, NETDATA_THREAD_TAG_MAX, "QUERY[%zu]", i);
+
+            if(netdata_thread_create(&query_workers.thread_ids[started], tag,
+                                     NETDATA_THREAD_OPTION_DONT_LOG | NETDATA_THREAD_OPTION_JOINABLE, query_worker_main, NULL))
+                error("QUERY: failed to create query thread %zu", i);
+            else
+                started++;
+        }
+
+        info("QUERY: started %zu query threads, for queries of %zu dimensions or more, using up to %zu threads per query",
+             started, query_workers.min_dimensions, query_workers.max_threads_per_query);
+
+        query_workers.threads = started;
+        query_workers.started = true;
+    }
+
+    netdata_mutex_unlock(&query_workers.mutex);
+}
+
+// called on exit, when the web server threads have been stopped
+void web_client_api_v1_stop_query_workers(void) {
+    netdata_mutex_lock(&query_workers.mutex);
+    query_workers.stop = true;
+    pthread_cond_broadcast(&query_workers.cond);
+    size_t threads = query_workers.started ? query_workers.threads : 0;
+    netdata_mutex_unlock(&query_workers.mutex);
+
+    if(!threads)
+        return;
+
+    info("QUERY: waiting for %zu query threads to exit...", threads);
+
+    for(size_t i = 0; i < threads ; i++)
+        netdata_thread_join(query_workers.thread_ids[i], NULL);
+
+    freez(query_workers.thread_ids);
+    query_workers.thread_ids = NULL;
+    query_workers.threads = 0;
+}
+
+static inline bool query_parallel_wanted(size_t dimensions) {
+    return query_workers.threads && dimensions >= query_workers.min_dimensions && dimensions > 1;
+}
+
+// returns with all the dimensions of the job either done or cancelled
+static void query_parallel_job_execute(struct query_parallel_job *job) {
+    if(unlikely(!query_workers.started))
+        query_workers_start();
+
+    // the owner runs the first dimension, the helpers claim the others
+    job->next = 1;
+
+    size_t helpers = MIN(query_workers.max_threads_per_query - 1, job->dimensions - 1);
+    helpers = MIN(helpers, query_workers.threads);
+
+    job->cancelled = false;
+    job->helpers_running = 0;
+    job->helpers_wanted = helpers;
+    job->queued = false;
+    pthread_cond_init(&job->helpers_done, NULL);
+
+    if(helpers) {
+        netdata_mutex_lock(&query_workers.mutex);
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(query_workers.jobs, job, prev, next_job);
+        job->queued = true;
+        if(helpers == 1)
+            pthread_cond_signal(&query_workers.cond);
+        else
+            pthread_cond_broadcast(&query_workers.cond);
+        netdata_mutex_unlock(&query_workers.mutex);
+    }
+
+    query_parallel_job_run(job, true);
+
+    // all dimensions have been claimed, so the helpers that have not started yet are not needed
+    netdata_mutex_lock(&query_workers.mutex);
+    if(job->queued) {
+        DOUBLE_LINKED_LIST_REMOVE_UNSAFE(query_workers.jobs, job, prev, next_job);
+        job->queued = false;
+        job->helpers_wanted = 0;
+    }
+    while(job->helpers_running)
+        pthread_cond_wait(&job->helpers_done, &query_workers.mutex);
+    netdata_mutex_unlock(&query_workers.mutex);
+
+    pthread_cond_destroy(&job->helpers_done);
+}
+
 // ----------------------------------------------------------------------------
 // fill the gap of a tier
 
@@ -1652,6 +2011,64 @@ int rrdr_relative_window_to_absolute(long long *after, long long *before) {
 #define query_debug_log_free() debug_dummy()
 #endif
 
+// ----------------------------------------------------------------------------
+// merging the points restored from the query cache with the queried ones
+
+static void rrdr_update_min_max(RRDR *r) {
+    NETDATA_DOUBLE min = 0.0, max = 0.0;
+    bool first = true;
+
+    for(int c = 0; c < r->d ; c++) {
+        if(!(r->od[c] & RRDR_DIMENSION_SELECTED))
+            continue;
+
+        for(long i = 0; i < r->rows ; i++) {
+            NETDATA_DOUBLE value = r->v[i * r->d + c];
+
+            if(unlikely(first)) {
+                if(!netdata_double_isnumber(value)) continue;
+                min = max = value;
+                first = false;
+            }
+            else {
+                if(value < min) min = value;
+                if(value > max) max = value;
+            }
+        }
+    }
+
+    r->min = min;
+    r->max = max;
+}
+
+// appends the points of q after the first offset points of r
+static void rrd2rrdr_append_points(RRDR *r, RRDR *q, long offset) {
+    long rows = q->rows;
+    if(offset + rows > r->n)
+        rows = r->n - offset;
+
+    size_t values = (size_t)rows * (size_t)r->d;
+    size_t start = (size_t)offset * (size_t)r->d;
+    memcpy(&r->t[offset], q->t, rows * sizeof(time_t));
+    memcpy(&r->v[start], q->v, values * sizeof(NETDATA_DOUBLE));
+    memcpy(&r->o[start], q->o, values * sizeof(RRDR_VALUE_FLAGS));
+    memcpy(&r->ar[start], q->ar, values * sizeof(NETDATA_DOUBLE));
+
+    for(int c = 0; c < r->d ; c++)
+        r->od[c] |= q->od[c] & RRDR_DIMENSION_NONZERO;
+
+    r->rows = offset + rows;
+    r->before = r->t[r->rows - 1];
+    r->after = r->t[0] - r->update_every + r->update_every / r->group;
+    r->result_options |= q->result_options & RRDR_RESULT_OPTION_CANCEL;
+
+    r->internal.result_points_generated = q->internal.result_points_generated;
+    r->internal.db_points_read = q->internal.db_points_read;
+    memcpy(r->internal.tier_points_read, q->internal.tier_points_read, sizeof(r->internal.tier_points_read));
+
+    rrdr_update_min_max(r);
+}
+
 RRDR *rrd2rrdr(
           ONEWAYALLOC *owa
         , RRDSET *st
@@ -1984,6 +2401,42 @@ RRDR *rrd2rrdr(
 
     query_debug_log_fin();
 
+    // -------------------------------------------------------------------------
+    // reuse the points of a previous query, when they are cached
+
+    BUFFER *cache_key = NULL;
+    bool cacheable = (options & RRDR_OPTION_INTERNAL_CACHE) && !context_param_list && query_cache_enabled();
+    long points_cached = 0;
+
+    if(cacheable) {
+        // relative queries are keyed without their time-frame, so that newer ones reuse the points of older ones
+        cache_key = buffer_create(256);
+        query_cache_key(cache_key, st, relative_period_requested ? 0 : after_wanted,
+                        points_wanted, group, group_method, resampling_time_requested, options,
+                        dimensions, group_options, tier);
+
+        points_cached = query_cache_restore(buffer_tostring(cache_key), r, after_wanted - query_granularity + r->update_every);
+    }
+
+    // the points to be queried, the newest ones when the oldest have been restored from the cache
+    RRDR *q = r;
+    long query_points = points_wanted - points_cached;
+    time_t query_after = after_wanted;
+
+    if(points_cached && query_points) {
+        query_after = before_wanted - (query_points * group * query_granularity) + query_granularity;
+
+        q = rrdr_create_for_x_dimensions(owa, r->d, query_points);
+        q->st = r->st;
+        q->result_options = r->result_options;
+        q->group = r->group;
+        q->update_every = r->update_every;
+        q->before = before_wanted;
+        q->after = query_after;
+        q->internal = r->internal;
+        memcpy(q->od, r->od, r->d * sizeof(RRDR_DIMENSION_FLAGS));
+    }
+
     // -------------------------------------------------------------------------
     // do the work for each dimension
 
@@ -1997,6 +2450,11 @@ RRDR *rrd2rrdr(
     struct timeval query_current_time;
     if (timeout) now_realtime_timeval(&query_start_time);
 
+    // find the dimensions to be queried
+    RRDDIM **query_rd = onewayalloc_mallocz(owa, dimensions_count * sizeof(RRDDIM *));
+    long *query_dim_id = onewayalloc_mallocz(owa, dimensions_count * sizeof(long));
+    size_t query_dimensions = 0;
+
     for(rd = first_rd, c = 0 ; rd && c < dimensions_count ; rd = rd->next, c++) {
 
         // if we need a percentage, we need to calculate all dimensions
@@ -2004,56 +2462,138 @@ RRDR *rrd2rrdr(
             if(unlikely(r->od[c] & RRDR_DIMENSION_SELECTED)) r->od[c] &= ~RRDR_DIMENSION_SELECTED;
             continue;
         }
+
         r->od[c] |= RRDR_DIMENSION_SELECTED;
 
-        // reset the grouping for the new dimension
-        r->internal.grouping_reset(r);
+        query_rd[query_dimensions] = rd;
+        query_dim_id[query_dimensions] = c;
+        query_dimensions++;
+    }
+
+    // run the dimensions in parallel, when the query is large enough
+    struct query_parallel_job *job = NULL;
+    if(query_points && query_parallel_wanted(query_dimensions)) {
+        job = onewayalloc_callocz(owa, 1, sizeof(struct query_parallel_job));
+        job->r = q;
+        job->group_options = group_options;
+        job->points_wanted = query_points;
+        job->after_wanted = query_after;
+        job->before_wanted = before_wanted;
+        job->deadline_ut = timeout ? timeval_usec(&query_start_time) + (usec_t)timeout * USEC_PER_MS : 0;
+        job->dimensions = query_dimensions;
+        job->rd = query_rd;
+        job->dim_id = query_dim_id;
+        job->results = onewayalloc_callocz(owa, query_dimensions, sizeof(struct query_dimension_result));
+
+        query_parallel_job_execute(job);
+    }
+
+    for(size_t qd = 0; query_points && qd < query_dimensions ; qd++) {
+        rd = query_rd[qd];
+        c = query_dim_id[qd];
+
+        if(job) {
+            // merge the results of this dimension into the RRDR
+            struct query_dimension_result *result = &job->results[qd];
+
+            if(unlikely(!result->done)) {
+                now_realtime_timeval(&query_current_time);
+                log_access("QUERY CANCELED RUNTIME EXCEEDED %0.2f ms (LIMIT %d ms)",
+                           (NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0, timeout);
+                q->result_options |= RRDR_RESULT_OPTION_CANCEL;
+                break;
+            }
+
+            if(unlikely(c == 0)) {
+                q->min = result->min;
+                q->max = result->max;
+            }
+            else {
+                if(result->min < q->min) q->min = result->min;
+                if(result->max > q->max) q->max = result->max;
+            }
+
+            q->before = result->before;
+            q->after = result->after;
+            q->rows = result->rows;
+            q->internal.result_points_generated += result->result_points_generated;
+            q->internal.db_points_read += result->db_points_read;
+            for(int tr = 0; tr < storage_tiers ; tr++)
+                q->internal.tier_points_read[tr] += result->tier_points_read[tr];
+        }
+        else {
+            // reset the grouping for the new dimension
+            q->internal.grouping_reset(q);
 
-        rrd2rrdr_do_dimension(r, points_wanted, rd, c, after_wanted, before_wanted);
-        if (timeout)
-            now_realtime_timeval(&query_current_time);
+            rrd2rrdr_do_dimension(q, query_points, rd, c, query_after, before_wanted);
+            if (timeout)
+                now_realtime_timeval(&query_current_time);
+        }
 
-        if(r->od[c] & RRDR_DIMENSION_NONZERO)
+        if(q->od[c] & RRDR_DIMENSION_NONZERO)
             dimensions_nonzero++;
 
         // verify all dimensions are aligned
         if(unlikely(!dimensions_used)) {
-            min_before = r->before;
-            max_after = r->after;
-            max_rows = r->rows;
+            min_before = q->before;
+            max_after = q->after;
+            max_rows = q->rows;
         }
         else {
-            if(r->after != max_after) {
+            if(q->after != max_after) {
                 internal_error(true, "QUERY: 'after' mismatch between dimensions for chart '%s': max is %zu, dimension '%s' has %zu",
-                               rrdset_name(st), (size_t)max_after, rrddim_name(rd), (size_t)r->after);
+                               rrdset_name(st), (size_t)max_after, rrddim_name(rd), (size_t)q->after);
 
-                r->after = (r->after > max_after) ? r->after : max_after;
+                q->after = (q->after > max_after) ? q->after : max_after;
             }
 
-            if(r->before != min_before) {
+            if(q->before != min_before) {
                 internal_error(true, "QUERY: 'before' mismatch between dimensions for chart '%s': max is %zu, dimension '%s' has %zu",
-                               rrdset_name(st), (size_t)min_before, rrddim_name(rd), (size_t)r->before);
+                               rrdset_name(st), (size_t)min_before, rrddim_name(rd), (size_t)q->before);
 
-                r->before = (r->before < min_before) ? r->before : min_before;
+                q->before = (q->before < min_before) ? q->before : min_before;
             }
 
-            if(r->rows != max_rows) {
+            if(q->rows != max_rows) {
                 internal_error(true, "QUERY: 'rows' mismatch between dimensions for chart '%s': max is %zu, dimension '%s' has %zu",
-                               rrdset_name(st), (size_t)max_rows, rrddim_name(rd), (size_t)r->rows);
+                               rrdset_name(st), (size_t)max_rows, rrddim_name(rd), (size_t)q->rows);
 
-                r->rows = (r->rows > max_rows) ? r->rows : max_rows;
+                q->rows = (q->rows > max_rows) ? q->rows : max_rows;
             }
         }
 
         dimensions_used++;
-        if (timeout && ((NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0) > timeout) {
+        if (!job && timeout && ((NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0) > timeout) {
             log_access("QUERY CANCELED RUNTIME EXCEEDED %0.2f ms (LIMIT %d ms)",
                        (NETDATA_DOUBLE)dt_usec(&query_start_time, &query_current_time) / 1000.0, timeout);
-            r->result_options |= RRDR_RESULT_OPTION_CANCEL;
+            q->result_options |= RRDR_RESULT_OPTION_CANCEL;
             break;
         }
     }
 
+    if(points_cached) {
+        if(q != r) {
+            rrd2rrdr_append_points(r, q, points_cached);
+            rrdr_free(owa, q);
+            q = NULL;
+        }
+        else {
+            r->before = r->t[r->rows - 1];
+            r->after = r->t[0] - r->update_every + query_granularity;
+            rrdr_update_min_max(r);
+        }
+
+        dimensions_nonzero = 0;
+        for(c = 0; c < dimensions_count ; c++)
+            if((r->od[c] & RRDR_DIMENSION_SELECTED) && (r->od[c] & RRDR_DIMENSION_NONZERO))
+                dimensions_nonzero++;
+    }
+
+    if(cacheable && query_points && r->rows == points_wanted && !(r->result_options & RRDR_RESULT_OPTION_CANCEL))
+        query_cache_save(buffer_tostring(cache_key), r, before_wanted + st->update_every < rrdset_last_entry_t(st));
+
+    buffer_free(cache_key);
+
 #ifdef NETDATA_INTERNAL_CHECKS
     if (dimensions_used) {
         if(r->internal.log)
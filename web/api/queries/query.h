@@ -49,6 +49,8 @@ typedef enum rrdr_grouping {
 
 extern const char *group_method2string(RRDR_GROUPING group);
 extern void web_client_api_v1_init_grouping(void);
+extern void web_client_api_v1_init_query_workers(void);
+extern void web_client_api_v1_stop_query_workers(void);
 extern RRDR_GROUPING web_client_api_request_v1_data_group(const char *name, RRDR_GROUPING def);
 extern const char *web_client_api_request_v1_data_group_to_string(RRDR_GROUPING group);
 
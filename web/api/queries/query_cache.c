@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "query_cache.h"
+
+// ----------------------------------------------------------------------------
+// query result cache
+//
+// Keeps the points of recent /api/v1/data queries, so that the same query
+// requested by many dashboards is not computed again for each one of them.
+//
+// Results are keyed by the normalized parameters of the query. Relative
+// queries (the last N seconds) are keyed without their time-frame, so that
+// a newer query reuses the points it has in common with an older one, and
+// computes only the points that have been collected since. The newest point
+// of a result that reaches the end of the database may still change, so it is
+// never reused.
+
+typedef struct query_cache_entry {
+    RRDSET *st;
+    int d;
+    int update_every;
+    long rows;
+    bool complete;                  // all the points are final, none of them can change
+    size_t memory;
+    bool referenced;                // atomic, set when the entry is used, cleared by the eviction
+
+    RRDR_DIMENSION_FLAGS *od;
+    time_t *t;
+    NETDATA_DOUBLE *v;
+    RRDR_VALUE_FLAGS *o;
+    NETDATA_DOUBLE *ar;
+
+    char *key;
+    size_t key_length;
+
+    struct query_cache_entry *prev, *next;
+} QUERY_CACHE_ENTRY;
+
+static struct {
+    size_t max_memory;              // 0 disables the cache
+
+    netdata_rwlock_t rwlock;
+    Pvoid_t JudyHSArray;            // the entries, indexed by key
+    QUERY_CACHE_ENTRY *entries;     // all the entries, the eviction clock hand is the head
+    size_t entries_count;
+    size_t memory;
+
+    uint64_t hits;
+    uint64_t partial_hits;
+    uint64_t misses;
+} query_cache = {
+    .max_memory = 32 * 1024 * 1024,
+    .rwlock = NETDATA_RWLOCK_INITIALIZER,
+    .JudyHSArray = NULL,
+    .entries = NULL,
+    .entries_count = 0,
+    .memory = 0,
+    .hits = 0,
+    .partial_hits = 0,
+    .misses = 0,
+};
+
+void query_cache_init(void) {
+    long long mb = config_get_number(CONFIG_SECTION_WEB, "query cache size MB", (long long)(query_cache.max_memory / 1024 / 1024));
+    if(mb < 0) mb = 0;
+    query_cache.max_memory = (size_t)mb * 1024 * 1024;
+}
+
+bool query_cache_enabled(void) {
+    return query_cache.max_memory != 0;
+}
+
+// the key is never truncated, so that queries with long dimensions or group options do not collide
+void query_cache_key(BUFFER *wb, RRDSET *st, time_t after, long points, long group,
+                     RRDR_GROUPING group_method, long resampling_time, RRDR_OPTIONS options,
+                     const char *dimensions, const char *group_options, int tier) {
+    buffer_flush(wb);
+    buffer_sprintf(wb, "%s|%s|%ld|%ld|%ld|%u|%ld|%u|%d|",
+              st->rrdhost->machine_guid, rrdset_id(st),
+              (long)after, points, group, (unsigned)group_method, resampling_time, (unsigned)options, tier);
+
+    // these may be longer than what buffer_sprintf() can print at once
+    buffer_strcat(wb, dimensions ? dimensions : "");
+    buffer_strcat(wb, "|");
+    buffer_strcat(wb, group_options ? group_options : "");
+}
+
+// must be called with the write lock
+static void query_cache_entry_delete(QUERY_CACHE_ENTRY *e) {
+    JError_t J_Error;
+    if(unlikely(JudyHSDel(&query_cache.JudyHSArray, (void *)e->key, e->key_length, &J_Error) != 1))
+        error("QUERY CACHE: cannot delete entry with key '%s' from JudyHS", e->key);
+
+    DOUBLE_LINKED_LIST_REMOVE_UNSAFE(query_cache.entries, e, prev, next);
+    query_cache.entries_count--;
+    query_cache.memory -= e->memory;
+    freez(e);
+}
+
+// must be called with the write lock
+// second chance (clock) eviction: the entries used since the hand passed them
+// are moved to the tail, the first entry not used since is evicted
+static void query_cache_evict(size_t memory_wanted) {
+    while(query_cache.entries && query_cache.memory + memory_wanted > query_cache.max_memory) {
+        QUERY_CACHE_ENTRY *e = query_cache.entries;
+
+        if(__atomic_exchange_n(&e->referenced, false, __ATOMIC_RELAXED) && e->next) {
+            DOUBLE_LINKED_LIST_REMOVE_UNSAFE(query_cache.entries, e, prev, next);
+            DOUBLE_LINKED_LIST_APPEND_UNSAFE(query_cache.entries, e, prev, next);
+            continue;
+        }
+
+        query_cache_entry_delete(e);
+    }
+}
+
+// copies the cached points of the query, starting at the point of first_row_time, to the first rows of r
+// returns the number of rows restored
+long query_cache_restore(const char *key, RRDR *r, time_t first_row_time) {
+    long rows = 0;
+
+    netdata_rwlock_rdlock(&query_cache.rwlock);
+
+    Pvoid_t *PValue = JudyHSGet(query_cache.JudyHSArray, (void *)key, strlen(key) + 1);
+    QUERY_CACHE_ENTRY *e = PValue ? *PValue : NULL;
+
+    if(!e || e->st != r->st || e->d != r->d || e->update_every != r->update_every || !e->rows)
+        goto cleanup;
+
+    if(first_row_time < e->t[0] || (first_row_time - e->t[0]) % e->update_every)
+        goto cleanup;
+
+    long first = (first_row_time - e->t[0]) / e->update_every;
+    if(first >= e->rows || e->t[first] != first_row_time)
+        goto cleanup;
+
+    for(int c = 0; c < r->d ; c++) {
+        // the dimensions have been hidden or shown since the result was cached
+        if((e->od[c] ^ r->od[c]) & RRDR_DIMENSION_HIDDEN)
+            goto cleanup;
+    }
+
+    rows = e->rows - first - (e->complete ? 0 : 1);
+    if(rows > r->n) rows = r->n;
+    if(rows <= 0) {
+        rows = 0;
+        goto cleanup;
+    }
+
+    size_t values = (size_t)rows * (size_t)r->d;
+    size_t offset = (size_t)first * (size_t)r->d;
+    memcpy(r->t, &e->t[first], rows * sizeof(time_t));
+    memcpy(r->v, &e->v[offset], values * sizeof(NETDATA_DOUBLE));
+    memcpy(r->o, &e->o[offset], values * sizeof(RRDR_VALUE_FLAGS));
+    memcpy(r->ar, &e->ar[offset], values * sizeof(NETDATA_DOUBLE));
+
+    // the dimensions that had non-zero values in the points restored
+    for(int c = 0; c < r->d ; c++) {
+        if(!(e->od[c] & RRDR_DIMENSION_SELECTED))
+            continue;
+
+        for(long i = 0; i < rows ; i++) {
+            size_t idx = (size_t)i * (size_t)r->d + c;
+            if(!(r->o[idx] & RRDR_VALUE_EMPTY) && r->v[idx] != 0.0) {
+                r->od[c] |= RRDR_DIMENSION_NONZERO;
+                break;
+            }
+        }
+    }
+
+    r->rows = rows;
+    __atomic_store_n(&e->referenced, true, __ATOMIC_RELAXED);
+
+cleanup:
+    netdata_rwlock_unlock(&query_cache.rwlock);
+
+    if(!rows)
+        __atomic_fetch_add(&query_cache.misses, 1, __ATOMIC_RELAXED);
+    else if(rows == r->n)
+        __atomic_fetch_add(&query_cache.hits, 1, __ATOMIC_RELAXED);
+    else
+        __atomic_fetch_add(&query_cache.partial_hits, 1, __ATOMIC_RELAXED);
+
+    return rows;
+}
+
+// caches the points of r, replacing any previous result with the same key
+void query_cache_save(const char *key, RRDR *r, bool complete) {
+    if(!r->rows || !r->d)
+        return;
+
+    size_t key_length = strlen(key) + 1;
+    size_t values = (size_t)r->rows * (size_t)r->d;
+    size_t memory = sizeof(QUERY_CACHE_ENTRY)
+                    + r->d * sizeof(RRDR_DIMENSION_FLAGS)
+                    + r->rows * sizeof(time_t)
+                    + values * (2 * sizeof(NETDATA_DOUBLE) + sizeof(RRDR_VALUE_FLAGS))
+                    + key_length;
+
+    if(memory > query_cache.max_memory / 4)
+        return;
+
+    // a single allocation, with the arrays following the entry
+    QUERY_CACHE_ENTRY *e = mallocz(memory);
+    char *p = (char *)(e + 1);
+    e->v = (NETDATA_DOUBLE *)p;          p += values * sizeof(NETDATA_DOUBLE);
+    e->ar = (NETDATA_DOUBLE *)p;         p += values * sizeof(NETDATA_DOUBLE);
+    e->t = (time_t *)p;                  p += r->rows * sizeof(time_t);
+    e->od = (RRDR_DIMENSION_FLAGS *)p;   p += r->d * sizeof(RRDR_DIMENSION_FLAGS);
+    e->o = (RRDR_VALUE_FLAGS *)p;        p += values * sizeof(RRDR_VALUE_FLAGS);
+    e->key = p;
+
+    e->st = r->st;
+    e->d = r->d;
+    e->update_every = r->update_every;
+    e->rows = r->rows;
+    e->complete = complete;
+    e->memory = memory;
+    e->referenced = false;
+    e->key_length = key_length;
+    memcpy(e->key, key, key_length);
+    memcpy(e->od, r->od, r->d * sizeof(RRDR_DIMENSION_FLAGS));
+    memcpy(e->t, r->t, r->rows * sizeof(time_t));
+    memcpy(e->v, r->v, values * sizeof(NETDATA_DOUBLE));
+    memcpy(e->o, r->o, values * sizeof(RRDR_VALUE_FLAGS));
+    memcpy(e->ar, r->ar, values * sizeof(NETDATA_DOUBLE));
+
+    netdata_rwlock_wrlock(&query_cache.rwlock);
+
+    Pvoid_t *PValue = JudyHSGet(query_cache.JudyHSArray, (void *)e->key, key_length);
+    if(PValue && *PValue)
+        query_cache_entry_delete(*PValue);
+
+    query_cache_evict(memory);
+
+    JError_t J_Error;
+    PValue = JudyHSIns(&query_cache.JudyHSArray, (void *)e->key, key_length, &J_Error);
+    if(unlikely(PValue == PJERR)) {
+        error("QUERY CACHE: cannot insert entry with key '%s' to JudyHS", e->key);
+        freez(e);
+    }
+    else {
+        *PValue = e;
+        DOUBLE_LINKED_LIST_APPEND_UNSAFE(query_cache.entries, e, prev, next);
+        query_cache.entries_count++;
+        query_cache.memory += memory;
+    }
+
+    netdata_rwlock_unlock(&query_cache.rwlock);
+}
+
+void query_cache_get_statistics(QUERY_CACHE_STATISTICS *stats) {
+    stats->hits = __atomic_load_n(&query_cache.hits, __ATOMIC_RELAXED);
+    stats->partial_hits = __atomic_load_n(&query_cache.partial_hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&query_cache.misses, __ATOMIC_RELAXED);
+
+    netdata_rwlock_rdlock(&query_cache.rwlock);
+    stats->entries = query_cache.entries_count;
+    stats->memory = query_cache.memory;
+    netdata_rwlock_unlock(&query_cache.rwlock);
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_QUERY_CACHE_H
+#define NETDATA_API_QUERY_CACHE_H
+
+#include "rrdr.h"
+
+typedef struct query_cache_statistics {
+    uint64_t hits;          // queries served entirely from the cache
+    uint64_t partial_hits;  // queries that computed only their newest points
+    uint64_t misses;        // cacheable queries that computed all their points
+    uint64_t entries;       // the number of cached results
+    uint64_t memory;        // the bytes used by the cached results
+} QUERY_CACHE_STATISTICS;
+
+extern void query_cache_init(void);
+extern bool query_cache_enabled(void);
+
+extern void query_cache_key(BUFFER *wb, RRDSET *st, time_t after, long points, long group,
+                            RRDR_GROUPING group_method, long resampling_time, RRDR_OPTIONS options,
+                            const char *dimensions, const char *group_options, int tier);
+extern long query_cache_restore(const char *key, RRDR *r, time_t first_row_time);
+extern void query_cache_save(const char *key, RRDR *r, bool complete);
+
+extern void query_cache_get_statistics(QUERY_CACHE_STATISTICS *stats);
+
+#endif //NETDATA_API_QUERY_CACHE_H
@@ -44,6 +44,7 @@ typedef enum rrdr_options {
 
     // internal ones - not to be exposed to the API
     RRDR_OPTION_INTERNAL_AR    = 0x10000000, // internal use only, to let the formatters we want to render the anomaly rate
+    RRDR_OPTION_INTERNAL_CACHE = 0x20000000, // internal use only, the query may be served by the query cache
     RRDR_OPTION_HEALTH_RSRVD1  = 0x80000000, // reserved for RRDCALC_OPTION_NO_CLEAR_NOTIFICATION
 } RRDR_OPTIONS;
 
@@ -110,6 +111,7 @@ typedef struct rrdresult {
         void (*grouping_reset)(struct rrdresult *r);
         void (*grouping_free)(struct rrdresult *r);
         void (*grouping_add)(struct rrdresult *r, NETDATA_DOUBLE value);
+        void (*grouping_add_array)(struct rrdresult *r, const NETDATA_DOUBLE *values, size_t count);
         NETDATA_DOUBLE (*grouping_flush)(struct rrdresult *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr);
         void *grouping_data;
 
@@ -33,6 +33,17 @@ void grouping_add_sum(RRDR *r, NETDATA_DOUBLE value) {
     g->count++;
 }
 
+void grouping_add_array_sum(RRDR *r, const NETDATA_DOUBLE *values, size_t count) {
+    struct grouping_sum *g = (struct grouping_sum *)r->internal.grouping_data;
+    NETDATA_DOUBLE sum = 0.0;
+
+    for(size_t i = 0; i < count ;i++)
+        sum += values[i];
+
+    g->sum += sum;
+    g->count += count;
+}
+
 NETDATA_DOUBLE grouping_flush_sum(RRDR *r, RRDR_VALUE_FLAGS *rrdr_value_options_ptr) {
     struct grouping_sum *g = (struct grouping_sum *)r->internal.grouping_data;
 
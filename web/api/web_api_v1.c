@@ -62,6 +62,7 @@ static struct {
         , {DATASOURCE_FORMAT_SSV_COMMA      , 0 , DATASOURCE_SSV_COMMA}
         , {DATASOURCE_FORMAT_CSV_JSON_ARRAY , 0 , DATASOURCE_CSV_JSON_ARRAY}
         , {DATASOURCE_FORMAT_CSV_MARKDOWN   , 0 , DATASOURCE_CSV_MARKDOWN}
+        , {DATASOURCE_FORMAT_BINARY         , 0 , DATASOURCE_BINARY}
         , {                                 NULL, 0, 0}
 };
 
@@ -92,6 +93,8 @@ void web_client_api_v1_init(void) {
         api_v1_data_google_formats[i].hash = simple_hash(api_v1_data_google_formats[i].name);
 
     web_client_api_v1_init_grouping();
+    web_client_api_v1_init_query_workers();
+    query_cache_init();
 
 	uuid_t uuid;
 
@@ -55,9 +55,13 @@ struct web_server_static_threaded_worker {
 
     size_t max_sockets;
 
+    // the listening sockets of this thread, when it does not use the shared api_sockets
+    LISTEN_SOCKETS sockets;
+
     volatile size_t connected;
     volatile size_t disconnected;
     volatile size_t receptions;
+    volatile size_t requests;
     volatile size_t sends;
     volatile size_t max_concurrent;
 
@@ -143,7 +147,7 @@ static int web_server_file_read_callback(POLLINFO *pi, short int *events) {
         POLLINFO *wpi = pollinfo_from_slot(p, w->pollinfo_slot);  // POLLINFO of the client socket
 
         debug(D_WEB_CLIENT, "%llu: SIGNALING W TO SEND (iFD %d, oFD %d)", w->id, pi->fd, wpi->fd);
-        p->fds[wpi->slot].events |= POLLOUT;
+        poll_set_events(wpi, (short int)(p->fds[wpi->slot].events | POLLOUT));
     }
 
     if(unlikely(ret <= 0 || w->ifd == w->ofd)) {
@@ -303,6 +307,9 @@ static int web_server_rcv_callback(POLLINFO *pi, short int *events) {
     worker_is_busy(WORKER_JOB_PROCESS);
     web_client_process_request(w);
 
+    if(likely(web_client_has_wait_send(w)))
+        worker_private->requests++;
+
     if (unlikely(w->mode == WEB_CLIENT_MODE_STREAM)) {
         web_client_send(w);
     }
@@ -404,6 +411,9 @@ static void socket_listen_main_static_threaded_worker_cleanup(void *ptr) {
             worker_private->sends
     );
 
+    if(worker_private->sockets.opened)
+        listen_sockets_close(&worker_private->sockets);
+
     worker_private->running = 0;
     worker_unregister();
 }
@@ -424,7 +434,7 @@ void *socket_listen_main_static_threaded_worker(void *ptr) {
 
     netdata_thread_cleanup_push(socket_listen_main_static_threaded_worker_cleanup, ptr);
 
-            poll_events(&api_sockets
+            poll_events(worker_private->sockets.opened ? &worker_private->sockets : &api_sockets
                         , web_server_add_callback
                         , web_server_del_callback
                         , web_server_rcv_callback
@@ -444,6 +454,63 @@ void *socket_listen_main_static_threaded_worker(void *ptr) {
     return NULL;
 }
 
+// ----------------------------------------------------------------------------
+// web server threads statistics
+
+static void web_server_threads_chart(RRDSET **st, RRDDIM ***rd, const char *id, const char *title, const char *units, long priority, size_t offset) {
+    int i;
+
+    if(unlikely(!*st)) {
+        *st = rrdset_create_localhost(
+                "netdata"
+                , id
+                , NULL
+                , "web server"
+                , NULL
+                , title
+                , units
+                , "netdata"
+                , "stats"
+                , priority
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_STACKED
+        );
+
+        *rd = callocz((size_t)static_threaded_workers_count, sizeof(RRDDIM *));
+        for(i = 0; i < static_threaded_workers_count; i++) {
+            char name[50 + 1];
+            snprintfz(name, 50, "thread %d", i + 1);
+            (*rd)[i] = rrddim_add(*st, name, NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+    }
+    else
+        rrdset_next(*st);
+
+    for(i = 0; i < static_threaded_workers_count; i++) {
+        volatile size_t *counter = (volatile size_t *)((char *)&static_workers_private_data[i] + offset);
+        rrddim_set_by_pointer(*st, (*rd)[i], (collected_number)*counter);
+    }
+
+    rrdset_done(*st);
+}
+
+// the connections accepted and the requests served by each web server thread, called by the global statistics thread
+void web_server_threads_charts(void) {
+    static RRDSET *st_connections = NULL, *st_requests = NULL;
+    static RRDDIM **rd_connections = NULL, **rd_requests = NULL;
+
+    if(web_server_mode != WEB_SERVER_MODE_STATIC_THREADED || !static_workers_private_data)
+        return;
+
+    web_server_threads_chart(&st_connections, &rd_connections, "web_thread_connections"
+                             , "Netdata Web Server Connections Accepted per Thread", "connections/s", 130310
+                             , offsetof(struct web_server_static_threaded_worker, connected));
+
+    web_server_threads_chart(&st_requests, &rd_requests, "web_thread_requests"
+                             , "Netdata Web Server Requests per Thread", "requests/s", 130311
+                             , offsetof(struct web_server_static_threaded_worker, requests));
+}
+
 
 // ----------------------------------------------------------------------------
 // web server main thread - also becomes a worker
@@ -528,11 +595,18 @@ void *socket_listen_main_static_threaded(void *ptr) {
 
     web_server_is_multithreaded = (static_threaded_workers_count > 1);
 
+    // give each thread its own listening sockets, so that the kernel spreads
+    // the new connections to them, instead of waking up all threads for each
+    int reuse_port = config_get_boolean(CONFIG_SECTION_WEB, "listen socket per thread", CONFIG_BOOLEAN_NO);
+
     int i;
     for (i = 1; i < static_threaded_workers_count; i++) {
         static_workers_private_data[i].id = i;
         static_workers_private_data[i].max_sockets = max_sockets / static_threaded_workers_count;
 
+        if(reuse_port && !listen_sockets_setup_reuse_port(&static_workers_private_data[i].sockets, &api_sockets))
+            error("LISTENER: cannot open listen sockets for worker %d, it will use the shared ones", i + 1);
+
         char tag[50 + 1];
         snprintfz(tag, 50, "WEB_SERVER[static%d]", i+1);
 
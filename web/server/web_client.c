@@ -77,6 +77,7 @@ void web_client_request_done(struct web_client *w) {
         now_realtime_timeval(&tv);
 
         size_t size = (w->mode == WEB_CLIENT_MODE_FILECOPY)?w->response.rlen:w->response.data->len;
+        if(unlikely(w->response.streaming)) size = w->response.streamed;
         size_t sent = size;
 #ifdef NETDATA_WITH_ZLIB
         if(likely(w->response.zoutput)) sent = (size_t)w->response.zstream.total_out;
@@ -179,6 +180,14 @@ void web_client_request_done(struct web_client *w) {
     w->response.sent = 0;
     w->response.code = 0;
 
+    if(unlikely(w->response.streaming)) {
+        w->response.streaming = 0;
+        w->response.streamed = 0;
+        w->response.stream_sent = 0;
+        buffer_reset(w->response.stream);
+        w->flags &= ~WEB_CLIENT_CHUNKED_TRANSFER;
+    }
+
     w->header_parse_tries = 0;
     w->header_parse_last_size = 0;
 
@@ -1266,6 +1275,175 @@ static inline void web_client_send_http_header(struct web_client *w) {
         w->stats_sent_bytes += bytes;
 }
 
+// ----------------------------------------------------------------------------
+// streaming of large responses
+//
+// The generators of large responses (e.g. allmetrics) call buffer_stream_checkpoint()
+// while they fill w->response.data. Once enough data has been accumulated, the HTTP
+// header is sent with chunked transfer encoding and the data generated so far is
+// moved to w->response.stream as chunks (compressed, if compression is enabled),
+// so that w->response.data does not grow to the size of the whole response.
+//
+// The generators hold locks while they run, so we never block on the socket here.
+// Whatever the client cannot take immediately stays in w->response.stream and is
+// sent by web_client_send() when the response is complete. A slow client that lets
+// the unsent chunks grow above NETDATA_WEB_RESPONSE_STREAM_MAX_BACKLOG is closed.
+
+static inline void web_client_stream_add_chunk(BUFFER *wb, const char *data, size_t len) {
+    if(unlikely(!len)) return;
+
+    buffer_need_bytes(wb, len + 24);
+    wb->len += (size_t)snprintfz(&wb->buffer[wb->len], 20, "%zX\r\n", len);
+    memcpy(&wb->buffer[wb->len], data, len);
+    wb->len += len;
+    wb->buffer[wb->len++] = '\r';
+    wb->buffer[wb->len++] = '\n';
+    wb->buffer[wb->len] = '\0';
+}
+
+static void web_client_stream_encode(struct web_client *w, int finish) {
+    BUFFER *data = w->response.data;
+    BUFFER *out = w->response.stream;
+
+#ifdef NETDATA_WITH_ZLIB
+    if(w->response.zoutput) {
+        w->response.zstream.next_in = (Bytef *)data->buffer;
+        w->response.zstream.avail_in = (uInt)data->len;
+
+        do {
+            w->response.zstream.next_out = w->response.zbuffer;
+            w->response.zstream.avail_out = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE;
+
+            if(unlikely(deflate(&w->response.zstream, (finish)?Z_FINISH:Z_SYNC_FLUSH) == Z_STREAM_ERROR)) {
+                error("%llu: Compression failed while streaming the response. Closing web client.", w->id);
+                WEB_CLIENT_IS_DEAD(w);
+                break;
+            }
+
+            web_client_stream_add_chunk(out, (const char *)w->response.zbuffer, NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE - w->response.zstream.avail_out);
+        } while(w->response.zstream.avail_out == 0);
+    }
+    else
+#endif // NETDATA_WITH_ZLIB
+        web_client_stream_add_chunk(out, data->buffer, data->len);
+
+    if(finish)
+        buffer_strcat(out, "0\r\n\r\n");
+
+    w->response.streamed += data->len;
+    buffer_flush(data);
+}
+
+static void web_client_stream_send(struct web_client *w) {
+    BUFFER *out = w->response.stream;
+
+    while(w->response.stream_sent < out->len) {
+        ssize_t bytes = web_client_send_data(w, &out->buffer[w->response.stream_sent], out->len - w->response.stream_sent, MSG_DONTWAIT);
+        if(likely(bytes > 0)) {
+            w->stats_sent_bytes += bytes;
+            w->response.stream_sent += bytes;
+        }
+        else if(bytes == -1 && errno == EINTR)
+            continue;
+        else if(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if(unlikely(out->len - w->response.stream_sent > NETDATA_WEB_RESPONSE_STREAM_MAX_BACKLOG)) {
+                error("%llu: Client does not read the streamed response, %zu bytes are pending. Closing web client.",
+                      w->id, out->len - w->response.stream_sent);
+                WEB_CLIENT_IS_DEAD(w);
+
+                // the rest of the response is discarded
+                buffer_flush(out);
+                w->response.stream_sent = 0;
+            }
+            break;
+        }
+        else {
+            debug(D_WEB_CLIENT, "%llu: Failed to stream data to client.", w->id);
+            WEB_CLIENT_IS_DEAD(w);
+            break;
+        }
+    }
+
+    // keep only the bytes that have not been sent yet
+    if(w->response.stream_sent) {
+        out->len -= w->response.stream_sent;
+        memmove(out->buffer, &out->buffer[w->response.stream_sent], out->len);
+        out->buffer[out->len] = '\0';
+        w->response.stream_sent = 0;
+    }
+}
+
+static void web_client_stream_callback(BUFFER *wb, void *data) {
+    struct web_client *w = (struct web_client *)data;
+
+    if(unlikely(web_client_check_dead(w))) {
+        // nobody will receive it
+        buffer_flush(wb);
+        return;
+    }
+
+    if(unlikely(!w->response.streaming)) {
+        debug(D_WEB_CLIENT, "%llu: Response is larger than %zu bytes, streaming it.", w->id, wb->stream_threshold);
+
+        w->response.code = HTTP_RESP_OK;
+        now_realtime_timeval(&w->tv_ready);
+        if(unlikely(!wb->date))
+            wb->date = w->tv_ready.tv_sec;
+
+        w->flags |= WEB_CLIENT_CHUNKED_TRANSFER;
+        w->response.streaming = 1;
+
+        web_client_send_http_header(w);
+        if(unlikely(web_client_check_dead(w))) {
+            buffer_flush(wb);
+            return;
+        }
+    }
+
+    web_client_stream_encode(w, 0);
+    web_client_stream_send(w);
+}
+
+void web_client_enable_streaming(struct web_client *w) {
+    // TLS connections use blocking writes, and ACLK requests do not have a socket
+    if(unlikely(w->mode != WEB_CLIENT_MODE_NORMAL || (w->acl & WEB_CLIENT_ACL_ACLK)))
+        return;
+
+#ifdef ENABLE_HTTPS
+    if(w->ssl.conn && !w->ssl.flags)
+        return;
+#endif
+
+    if(unlikely(!w->response.stream))
+        w->response.stream = buffer_create(NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE);
+
+    w->response.data->stream_callback = web_client_stream_callback;
+    w->response.data->stream_data = w;
+    w->response.data->stream_threshold = NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE;
+}
+
+// returns 1 when the response has been streamed and the rest of it is ready in w->response.data
+static int web_client_stream_finish(struct web_client *w) {
+    w->response.data->stream_callback = NULL;
+    w->response.data->stream_data = NULL;
+
+    if(likely(!w->response.streaming))
+        return 0;
+
+    if(likely(!web_client_check_dead(w)))
+        web_client_stream_encode(w, 1);
+
+    // send the rest of the chunks the usual way
+    BUFFER *t = w->response.data;
+    w->response.data = w->response.stream;
+    w->response.stream = t;
+    buffer_flush(w->response.stream);
+    w->response.sent = w->response.stream_sent;
+    w->response.stream_sent = 0;
+
+    return 1;
+}
+
 static inline int web_client_process_url(RRDHOST *host, struct web_client *w, char *url);
 
 static inline int web_client_switch_host(RRDHOST *host, struct web_client *w, char *url) {
@@ -1558,6 +1736,15 @@ void web_client_process_request(struct web_client *w) {
 
     w->response.sent = 0;
 
+    if(unlikely(web_client_stream_finish(w))) {
+        // the HTTP header has already been sent
+        debug(D_WEB_CLIENT, "%llu: Done streaming the response. Sending the last %zu bytes to client.", w->id, w->response.data->len - w->response.sent);
+
+        if(w->response.data->len > w->response.sent) web_client_enable_wait_send(w);
+        else web_client_disable_wait_send(w);
+        return;
+    }
+
     // set a proper last modified date
     if(unlikely(!w->response.data->date))
         w->response.data->date = w->tv_ready.tv_sec;
@@ -1801,7 +1988,8 @@ ssize_t web_client_send_deflate(struct web_client *w)
 
 ssize_t web_client_send(struct web_client *w) {
 #ifdef NETDATA_WITH_ZLIB
-    if(likely(w->response.zoutput)) return web_client_send_deflate(w);
+    // a streamed response has been compressed while it was generated
+    if(likely(w->response.zoutput && !w->response.streaming)) return web_client_send_deflate(w);
 #endif // NETDATA_WITH_ZLIB
 
     ssize_t bytes;
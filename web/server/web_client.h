@@ -106,6 +106,11 @@ typedef enum web_client_flags {
 
 #define NETDATA_WEB_REQUEST_URL_SIZE 8192
 #define NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE 16384
+
+// the plain bytes a streamed response accumulates before it is sent as a chunk
+#define NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE 65536
+// the chunks a client may leave unsent, before it is closed
+#define NETDATA_WEB_RESPONSE_STREAM_MAX_BACKLOG (64 * NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE)
 #define NETDATA_WEB_RESPONSE_HEADER_SIZE 4096
 #define NETDATA_WEB_REQUEST_COOKIE_SIZE 1024
 #define NETDATA_WEB_REQUEST_ORIGIN_HEADER_SIZE 1024
@@ -124,6 +129,11 @@ struct response {
     size_t sent; // current data length sent to output
 
     int zoutput; // if set to 1, web_client_send() will send compressed data
+
+    int streaming;     // if set to 1, data is sent in chunks while it is being generated
+    BUFFER *stream;    // the encoded chunks of a streamed response, not sent yet
+    size_t stream_sent; // the bytes of stream we have sent to the client
+    size_t streamed;   // the plain data bytes that have been streamed
 #ifdef NETDATA_WITH_ZLIB
     z_stream zstream;                                    // zlib stream for sending compressed output to client
     Bytef zbuffer[NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE]; // temporary buffer for storing compressed output
@@ -198,6 +208,7 @@ extern ssize_t web_client_read_file(struct web_client *w);
 
 extern void web_client_process_request(struct web_client *w);
 extern void web_client_request_done(struct web_client *w);
+extern void web_client_enable_streaming(struct web_client *w);
 
 extern void buffer_data_options2string(BUFFER *wb, uint32_t options);
 
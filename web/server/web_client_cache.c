@@ -25,11 +25,13 @@ static void web_client_zero(struct web_client *w) {
     BUFFER *b1 = w->response.data;
     BUFFER *b2 = w->response.header;
     BUFFER *b3 = w->response.header_output;
+    BUFFER *b4 = w->response.stream;
 
     // empty the buffers
     buffer_flush(b1);
     buffer_flush(b2);
     buffer_flush(b3);
+    if(b4) buffer_flush(b4);
 
     freez(w->user_agent);
 
@@ -40,12 +42,14 @@ static void web_client_zero(struct web_client *w) {
     w->response.data = b1;
     w->response.header = b2;
     w->response.header_output = b3;
+    w->response.stream = b4;
 }
 
 static void web_client_free(struct web_client *w) {
     buffer_free(w->response.header_output);
     buffer_free(w->response.header);
     buffer_free(w->response.data);
+    buffer_free(w->response.stream);
     freez(w->user_agent);
 #ifdef ENABLE_HTTPS
     if ((!web_client_check_unix(w)) && (netdata_ssl_srv_ctx)) {